@@ -0,0 +1,208 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file blas_bench.c
+ * @author Richard Preen <rpreen@gmail.com>
+ * @copyright The Authors.
+ * @date 2026.
+ * @brief Compares the linear algebra backends on the shapes used by XCSF.
+ */
+
+#include "../xcsf/blas.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MIN_SECONDS (0.2) //!< Least time spent timing each case
+
+/**
+ * @brief Linear algebra operations benchmarked.
+ */
+enum BenchOp {
+    BENCH_GEMM, //!< Matrix-matrix multiplication
+    BENCH_GEMV, //!< Matrix-vector multiplication
+    BENCH_GER, //!< Rank-1 update
+    BENCH_DOT, //!< Dot product
+    BENCH_AXPY, //!< Scaled vector addition
+    BENCH_SCAL //!< Vector scaling
+};
+
+/**
+ * @brief A benchmark case.
+ */
+struct BenchCase {
+    const char *name; //!< Where XCSF uses the shape
+    enum BenchOp op; //!< Operation
+    int TA; //!< Whether A is transposed
+    int TB; //!< Whether B is transposed
+    int M; //!< Rows of C, or 1 for vector operations
+    int N; //!< Columns of C, or the vector length
+    int K; //!< Depth of the product, or 1 for other operations
+};
+
+/**
+ * @brief Shapes as called by the neural layers and predictions.
+ */
+static const struct BenchCase cases[] = {
+    { "connected forward", BENCH_GEMV, 0, 0, 10, 10, 1 },
+    { "connected forward", BENCH_GEMV, 0, 0, 100, 100, 1 },
+    { "connected forward", BENCH_GEMV, 0, 0, 500, 500, 1 },
+    { "connected weights", BENCH_GER, 0, 0, 100, 100, 1 },
+    { "connected delta", BENCH_GEMV, 1, 0, 100, 100, 1 },
+    { "convolution forward", BENCH_GEMM, 0, 0, 16, 784, 27 },
+    { "convolution weights", BENCH_GEMM, 0, 1, 16, 27, 784 },
+    { "rls gain", BENCH_GEMM, 0, 0, 11, 1, 11 },
+    { "rls matrix", BENCH_GEMM, 0, 0, 11, 11, 11 },
+    { "rls matrix", BENCH_GEMM, 0, 0, 66, 66, 66 },
+    { "block prediction", BENCH_GEMM, 0, 1, 256, 1, 11 },
+    { "block prediction", BENCH_GEMM, 0, 1, 256, 10, 66 },
+    { "nlms prediction", BENCH_DOT, 0, 0, 1, 11, 1 },
+    { "nlms prediction", BENCH_DOT, 0, 0, 1, 1000, 1 },
+    { "nlms update", BENCH_AXPY, 0, 0, 1, 11, 1 },
+    { "layer update", BENCH_AXPY, 0, 0, 1, 10000, 1 },
+    { "layer update", BENCH_SCAL, 0, 0, 1, 10000, 1 },
+};
+
+/**
+ * @brief Returns the current time in seconds.
+ * @return The time.
+ */
+static double
+now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Runs a benchmark case once.
+ * @param [in] c The case.
+ * @param [in] A First operand.
+ * @param [in] B Second operand.
+ * @param [in,out] C Result.
+ * @return A value depending on the result.
+ */
+static double
+run(const struct BenchCase *c, const double *A, const double *B, double *C)
+{
+    switch (c->op) {
+        case BENCH_GEMM:
+            blas_gemm(c->TA, c->TB, c->M, c->N, c->K, 1, A, c->TA ? c->M : c->K,
+                      B, c->TB ? c->K : c->N, 1, C, c->N);
+            return C[0];
+        case BENCH_GEMV:
+            blas_gemv(c->TA, c->M, c->N, 1, A, c->N, B, 1, 1, C, 1);
+            return C[0];
+        case BENCH_GER:
+            blas_ger(c->M, c->N, 1e-9, A, 1, B, 1, C, c->N);
+            return C[0];
+        case BENCH_DOT:
+            return blas_dot(c->N, A, 1, B, 1);
+        case BENCH_AXPY:
+            blas_axpy(c->N, 1e-9, A, 1, C, 1);
+            return C[0];
+        case BENCH_SCAL:
+            blas_scal(c->N, 0.999, C, 1);
+            return C[0];
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Returns the mean time of a benchmark case.
+ * @param [in] c The case.
+ * @param [out] check A value depending on the results.
+ * @return The mean seconds per call.
+ */
+static double
+time_case(const struct BenchCase *c, double *check)
+{
+    const int size_v = c->M > c->N ? c->M : c->N;
+    const int size_m = c->M * c->K > c->M * c->N ? c->M * c->K : c->M * c->N;
+    const int size_a = size_m > size_v ? size_m : size_v;
+    const int size_b = c->K * c->N > size_v ? c->K * c->N : size_v;
+    const int size_c = c->M * c->N;
+    double *A = malloc(sizeof(double) * size_a);
+    double *B = malloc(sizeof(double) * size_b);
+    double *C = malloc(sizeof(double) * size_c);
+    for (int i = 0; i < size_a; ++i) {
+        A[i] = (double) rand() / RAND_MAX;
+    }
+    for (int i = 0; i < size_b; ++i) {
+        B[i] = (double) rand() / RAND_MAX;
+    }
+    for (int i = 0; i < size_c; ++i) {
+        C[i] = 0;
+    }
+    *check = run(c, A, B, C);
+    long calls = 0;
+    long reps = 1;
+    const double start = now();
+    double elapsed = 0;
+    while (elapsed < MIN_SECONDS) {
+        for (long r = 0; r < reps; ++r) {
+            *check += run(c, A, B, C);
+        }
+        calls += reps;
+        reps *= 2;
+        elapsed = now() - start;
+    }
+    free(A);
+    free(B);
+    free(C);
+    return elapsed / calls;
+}
+
+/**
+ * @brief Prints the time of each case for each available backend.
+ * @param [in] argc Number of arguments.
+ * @param [in] argv Optional number of threads for an external library.
+ * @return Exit status.
+ */
+int
+main(int argc, char **argv)
+{
+    if (argc > 1) {
+        blas_set_num_threads(atoi(argv[1]));
+    }
+    const char *names[] = { "builtin", "cblas" };
+    const int backends[] = { BLAS_BACKEND_BUILTIN, BLAS_BACKEND_CBLAS };
+    const int n_cases = sizeof(cases) / sizeof(cases[0]);
+    printf("%-20s %-4s %5s %5s %5s %-8s %12s %9s\n", "case", "op", "M", "N",
+           "K", "backend", "ns/call", "GFLOP/s");
+    double check = 0;
+    for (int i = 0; i < n_cases; ++i) {
+        const struct BenchCase *c = &cases[i];
+        const char *op[] = { "gemm", "gemv", "ger", "dot", "axpy", "scal" };
+        const double flops = (c->op == BENCH_SCAL) ? (double) c->N
+                                                   : 2. * c->M * c->N * c->K;
+        for (int b = 0; b < 2; ++b) {
+            if (!blas_set_backend(backends[b])) {
+                continue;
+            }
+            double result = 0;
+            const double t = time_case(c, &result);
+            check += result;
+            printf("%-20s %-4s %5d %5d %5d %-8s %12.1f %9.2f\n", c->name,
+                   op[c->op], c->M, c->N, c->K, names[b], t * 1e9,
+                   flops / t * 1e-9);
+        }
+    }
+    printf("checksum %g\n", check);
+    return EXIT_SUCCESS;
+}
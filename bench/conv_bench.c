@@ -0,0 +1,197 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file conv_bench.c
+ * @author Richard Preen <rpreen@gmail.com>
+ * @copyright The Authors.
+ * @date 2026.
+ * @brief Compares the convolution algorithms on the layer shapes evolved by
+ * XCSF and reports the fastest for each.
+ */
+
+#include "../xcsf/neural.h"
+#include "../xcsf/neural_activations.h"
+#include "../xcsf/neural_layer.h"
+#include "../xcsf/neural_layer_convolutional.h"
+#include "../xcsf/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MIN_SECONDS (0.2) //!< Least time spent timing each case
+#define N_ALGOS (3) //!< Number of convolution algorithms compared
+
+/**
+ * @brief A benchmark case.
+ */
+struct BenchCase {
+    int width; //!< Image width
+    int height; //!< Image height
+    int channels; //!< Number of image channels
+    int n_filters; //!< Number of filters
+    int size; //!< Kernel size
+    int stride; //!< Kernel stride
+    int pad; //!< Kernel padding
+};
+
+/**
+ * @brief Shapes of convolutional layers evolved on small images.
+ */
+static const struct BenchCase cases[] = {
+    { 8, 8, 1, 4, 3, 1, 1 },      { 8, 8, 4, 8, 3, 1, 1 },
+    { 16, 16, 1, 8, 3, 1, 1 },    { 16, 16, 8, 8, 3, 1, 1 },
+    { 28, 28, 1, 16, 3, 1, 1 },   { 28, 28, 16, 16, 3, 1, 1 },
+    { 28, 28, 32, 32, 3, 1, 1 },  { 32, 32, 3, 16, 3, 1, 1 },
+    { 32, 32, 16, 32, 3, 1, 1 },  { 28, 28, 1, 16, 5, 1, 2 },
+    { 28, 28, 8, 16, 5, 1, 2 },   { 28, 28, 16, 16, 3, 2, 1 },
+    { 28, 28, 48, 48, 3, 1, 1 },  { 16, 16, 64, 64, 3, 1, 1 },
+};
+
+/**
+ * @brief Returns the current time in seconds.
+ * @return The time.
+ */
+static double
+now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Runs one training step of a layer.
+ * @param [in] l The layer.
+ * @param [in] net The network containing the layer.
+ * @param [in] x The layer input.
+ * @param [in] delta The error of the layer input.
+ * @return A value depending on the result.
+ */
+static double
+run(const struct Layer *l, const struct Net *net, const neural_real *x,
+    neural_real *delta)
+{
+    layer_forward(l, net, x);
+    layer_backward(l, net, x, delta);
+    return l->output[0] + delta[0];
+}
+
+/**
+ * @brief Returns the mean time of a benchmark case with an algorithm.
+ * @param [in] c The case.
+ * @param [in] algo The convolution algorithm.
+ * @param [out] check A value depending on the results.
+ * @return The mean seconds per training step.
+ */
+static double
+time_case(const struct BenchCase *c, const int algo, double *check)
+{
+    struct ArgsLayer args;
+    layer_args_init(&args);
+    args.type = CONVOLUTIONAL;
+    args.function = RELU;
+    args.width = c->width;
+    args.height = c->height;
+    args.channels = c->channels;
+    args.n_init = c->n_filters;
+    args.n_max = c->n_filters;
+    args.size = c->size;
+    args.stride = c->stride;
+    args.pad = c->pad;
+    args.eta = 0.01;
+    args.sgd_weights = true;
+    layer_args_validate(&args);
+    struct Layer *l = layer_init(&args);
+    struct Net net;
+    neural_init(&net);
+    neural_layer_convolutional_set_algorithm(algo);
+    neural_real *x = malloc(sizeof(neural_real) * l->n_inputs);
+    neural_real *delta = calloc(l->n_inputs, sizeof(neural_real));
+    for (int i = 0; i < l->n_inputs; ++i) {
+        x[i] = rand_uniform(-1, 1);
+    }
+    for (int i = 0; i < l->n_outputs; ++i) {
+        l->delta[i] = rand_uniform(-1, 1);
+    }
+    *check = run(l, &net, x, delta);
+    long calls = 0;
+    long reps = 1;
+    const double start = now();
+    double elapsed = 0;
+    while (elapsed < MIN_SECONDS) {
+        for (long r = 0; r < reps; ++r) {
+            *check += run(l, &net, x, delta);
+        }
+        calls += reps;
+        reps *= 2;
+        elapsed = now() - start;
+    }
+    free(x);
+    free(delta);
+    layer_delete(l);
+    return elapsed / calls;
+}
+
+/**
+ * @brief Prints the time of each convolution algorithm for each case and the
+ * algorithm that is fastest and that chosen by default.
+ * @return Exit status.
+ */
+int
+main(void)
+{
+    rand_init_seed(1);
+    const char *names[] = { "auto", "im2col", "direct", "winograd" };
+    const int n_cases = sizeof(cases) / sizeof(cases[0]);
+    printf("%5s %5s %4s %4s %2s %2s %-8s %10s %10s %10s %-8s\n", "H", "W", "C",
+           "F", "k", "s", "auto", "im2col us", "direct us", "winogr us",
+           "fastest");
+    double check = 0;
+    for (int i = 0; i < n_cases; ++i) {
+        const struct BenchCase *c = &cases[i];
+        double t[N_ALGOS];
+        int fastest = CONV_ALGO_IM2COL;
+        for (int a = 0; a < N_ALGOS; ++a) {
+            const int algo = CONV_ALGO_IM2COL + a;
+            t[a] = 0;
+            if (algo == CONV_ALGO_WINOGRAD &&
+                (c->size != 3 || c->stride != 1)) {
+                continue;
+            }
+            double result = 0;
+            t[a] = time_case(c, algo, &result);
+            check += result;
+            if (t[a] < t[fastest - CONV_ALGO_IM2COL]) {
+                fastest = algo;
+            }
+        }
+        struct Layer shape;
+        layer_defaults(&shape);
+        shape.size = c->size;
+        shape.stride = c->stride;
+        shape.channels = c->channels;
+        shape.n_filters = c->n_filters;
+        shape.out_w = (c->width + 2 * c->pad - c->size) / c->stride + 1;
+        neural_layer_convolutional_set_algorithm(CONV_ALGO_AUTO);
+        const int chosen = neural_layer_convolutional_algorithm(&shape);
+        printf("%5d %5d %4d %4d %2d %2d %-8s %10.2f %10.2f %10.2f %-8s\n",
+               c->height, c->width, c->channels, c->n_filters, c->size,
+               c->stride, names[chosen], t[0] * 1e6, t[1] * 1e6, t[2] * 1e6,
+               names[fastest]);
+    }
+    printf("checksum %g\n", check);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,260 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file blas_test.cpp
+ * @author Richard Preen <rpreen@gmail.com>
+ * @copyright The Authors.
+ * @date 2026.
+ * @brief Basic linear algebra tests.
+ */
+
+#include "../lib/doctest/doctest/doctest.h"
+
+extern "C" {
+#include "../xcsf/blas.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+}
+
+/**
+ * @brief Fills an array with deterministic values in [-1, 1].
+ * @param [out] X The array to fill.
+ * @param [in] N The number of elements.
+ * @param [in] seed Offset distinguishing arrays.
+ */
+static void
+fill(double *X, const int N, const int seed)
+{
+    for (int i = 0; i < N; ++i) {
+        X[i] = sin(0.37 * i + 1.3 * seed);
+    }
+}
+
+/**
+ * @brief Returns the largest error of blas_gemm() against a triple loop.
+ * @param [in] TA Whether A is transposed.
+ * @param [in] TB Whether B is transposed.
+ * @param [in] M Number of rows of C.
+ * @param [in] N Number of columns of C.
+ * @param [in] K Depth of the product.
+ * @return The largest absolute difference.
+ */
+static double
+gemm_error(const int TA, const int TB, const int M, const int N, const int K)
+{
+    const double ALPHA = 0.75;
+    const double BETA = 0.5;
+    const int lda = TA ? M : K;
+    const int ldb = TB ? K : N;
+    double *A = (double *) malloc(sizeof(double) * M * K);
+    double *B = (double *) malloc(sizeof(double) * K * N);
+    double *C = (double *) malloc(sizeof(double) * M * N);
+    double *R = (double *) malloc(sizeof(double) * M * N);
+    fill(A, M * K, 1);
+    fill(B, K * N, 2);
+    fill(C, M * N, 3);
+    for (int i = 0; i < M; ++i) {
+        for (int j = 0; j < N; ++j) {
+            double sum = 0;
+            for (int k = 0; k < K; ++k) {
+                const double a = TA ? A[k * lda + i] : A[i * lda + k];
+                const double b = TB ? B[j * ldb + k] : B[k * ldb + j];
+                sum += a * b;
+            }
+            R[i * N + j] = ALPHA * sum + BETA * C[i * N + j];
+        }
+    }
+    blas_gemm(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA, C, N);
+    double error = 0;
+    for (int i = 0; i < M * N; ++i) {
+        error = fmax(error, fabs(C[i] - R[i]));
+    }
+    free(A);
+    free(B);
+    free(C);
+    free(R);
+    return error;
+}
+
+TEST_CASE("BLAS")
+{
+    /* test gemm for each transposition over small, blocked and edge shapes */
+    const int shapes[][3] = { { 1, 1, 1 },      { 3, 5, 7 },
+                              { 64, 64, 64 },   { 67, 45, 33 },
+                              { 131, 9, 300 },  { 5, 2100, 4 },
+                              { 20, 400, 75 } };
+    for (int t = 0; t < 4; ++t) {
+        for (const auto &s : shapes) {
+            CHECK(gemm_error(t & 1, t >> 1, s[0], s[1], s[2]) <
+                  1e-12 * s[2]);
+        }
+    }
+    /* test built-in gemm with BETA = 0 rounds the same as dot products */
+    blas_set_backend(BLAS_BACKEND_BUILTIN);
+    const int M = 9;
+    const int N = 33;
+    const int K = 600;
+    double *X = (double *) malloc(sizeof(double) * M * K);
+    double *W = (double *) malloc(sizeof(double) * N * K);
+    double *C = (double *) calloc(M * N, sizeof(double));
+    fill(X, M * K, 4);
+    fill(W, N * K, 5);
+    blas_gemm(0, 1, M, N, K, 1, X, K, W, K, 0, C, N);
+    int mismatches = 0;
+    for (int i = 0; i < M; ++i) {
+        for (int j = 0; j < N; ++j) {
+            if (C[i * N + j] != blas_dot(K, &X[i * K], 1, &W[j * K], 1)) {
+                ++mismatches;
+            }
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+    /* test gemv rounds the same as dot products and matches gemm */
+    double *y = (double *) calloc(K, sizeof(double));
+    double *r = (double *) calloc(K, sizeof(double));
+    blas_gemv(0, N, K, 1, W, K, X, 1, 0, y, 1);
+    mismatches = 0;
+    for (int j = 0; j < N; ++j) {
+        if (y[j] != blas_dot(K, X, 1, &W[j * K], 1)) {
+            ++mismatches;
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+    fill(y, K, 6);
+    memcpy(r, y, sizeof(double) * K);
+    blas_gemv(1, N, K, 0.75, W, K, X, 1, 0.5, y, 1);
+    blas_scal(K, 0.5, r, 1);
+    blas_gemm(0, 0, 1, K, N, 0.75, X, N, W, K, 1, r, K);
+    CHECK(memcmp(y, r, sizeof(double) * K) == 0);
+    /* test BETA = 0 ignores the previous contents of the output */
+    for (int j = 0; j < N; ++j) {
+        y[j] = NAN;
+    }
+    blas_gemv(0, N, K, 1, W, K, X, 1, 0, y, 1);
+    CHECK_EQ(y[N - 1], blas_dot(K, X, 1, &W[(N - 1) * K], 1));
+    C[0] = NAN;
+    blas_gemm(0, 1, 1, N, K, 1, X, K, W, K, 0, C, N);
+    CHECK_EQ(C[0], blas_dot(K, X, 1, W, 1));
+    /* test sparse gemv skips inactive weights */
+    bool *active = (bool *) malloc(sizeof(bool) * N * K);
+    for (int i = 0; i < N * K; ++i) {
+        active[i] = (i % 7 == 0) || (i % 300 < 20);
+        if (!active[i]) {
+            W[i] = 0;
+        }
+    }
+    for (int t = 0; t < 2; ++t) {
+        const int len = t ? K : N;
+        fill(y, len, 7);
+        memcpy(r, y, sizeof(double) * len);
+        blas_gemv(t, N, K, 1, W, K, X, 1, 1, y, 1);
+        blas_gemv_sparse(t, N, K, 1, W, K, active, X, 1, 1, r, 1);
+        mismatches = 0;
+        for (int i = 0; i < len; ++i) {
+            if (y[i] != r[i]) {
+                ++mismatches;
+            }
+        }
+        CHECK_EQ(mismatches, 0);
+    }
+    /* test ger matches gemm of an outer product */
+    memcpy(C, W, sizeof(double) * N * M);
+    blas_ger(M, N, 0.25, X, 1, y, 1, W, N);
+    blas_gemm(1, 0, M, N, 1, 0.25, X, M, y, N, 1, C, N);
+    CHECK(memcmp(W, C, sizeof(double) * M * N) == 0);
+    /* test single-precision kernels against the double-precision ones */
+    for (int t = 0; t < 4; ++t) {
+        const int TA = t & 1;
+        const int TB = t >> 1;
+        float *sa = (float *) malloc(sizeof(float) * M * K);
+        float *sb = (float *) malloc(sizeof(float) * K * N);
+        float *sc = (float *) malloc(sizeof(float) * M * N);
+        fill(X, M * K, 8);
+        fill(W, K * N, 9);
+        fill(C, M * N, 10);
+        for (int i = 0; i < M * K; ++i) {
+            sa[i] = (float) X[i];
+            X[i] = sa[i];
+        }
+        for (int i = 0; i < K * N; ++i) {
+            sb[i] = (float) W[i];
+            W[i] = sb[i];
+        }
+        for (int i = 0; i < M * N; ++i) {
+            sc[i] = (float) C[i];
+            C[i] = sc[i];
+        }
+        const int lda = TA ? M : K;
+        const int ldb = TB ? K : N;
+        blas_gemm(TA, TB, M, N, K, 0.75, X, lda, W, ldb, 0.5, C, N);
+        blas_sgemm(TA, TB, M, N, K, 0.75f, sa, lda, sb, ldb, 0.5f, sc, N);
+        double error = 0;
+        for (int i = 0; i < M * N; ++i) {
+            error = fmax(error, fabs(sc[i] - C[i]));
+        }
+        CHECK(error < 1e-6 * K);
+        free(sa);
+        free(sb);
+        free(sc);
+    }
+    float *sw = (float *) malloc(sizeof(float) * N * K);
+    float *sx = (float *) malloc(sizeof(float) * K);
+    float *sy = (float *) malloc(sizeof(float) * K);
+    for (int i = 0; i < N * K; ++i) {
+        sw[i] = (float) sin(0.11 * i);
+        W[i] = sw[i];
+    }
+    for (int i = 0; i < K; ++i) {
+        sx[i] = (float) cos(0.23 * i);
+        X[i] = sx[i];
+    }
+    for (int t = 0; t < 2; ++t) {
+        const int len = t ? K : N;
+        for (int i = 0; i < len; ++i) {
+            sy[i] = 0.5f;
+            y[i] = 0.5;
+        }
+        blas_gemv(t, N, K, 0.75, W, K, X, 1, 1, y, 1);
+        blas_sgemv(t, N, K, 0.75f, sw, K, sx, 1, 1, sy, 1);
+        double error = 0;
+        for (int i = 0; i < len; ++i) {
+            error = fmax(error, fabs(sy[i] - y[i]));
+        }
+        CHECK(error < 1e-6 * K);
+    }
+    blas_ger(N, K, 0.25, y, 1, X, 1, W, K);
+    blas_sger(N, K, 0.25f, sy, 1, sx, 1, sw, K);
+    double error = 0;
+    for (int i = 0; i < N * K; ++i) {
+        error = fmax(error, fabs(sw[i] - W[i]));
+    }
+    CHECK(error < 1e-3);
+    CHECK_EQ(blas_ssum(sx, K), doctest::Approx(blas_sum(X, K)));
+    free(sw);
+    free(sx);
+    free(sy);
+    free(X);
+    free(W);
+    free(C);
+    free(y);
+    free(r);
+    free(active);
+    /* restore the default backend */
+    blas_set_backend(BLAS_BACKEND_CBLAS);
+}
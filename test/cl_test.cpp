@@ -17,7 +17,7 @@
  * @file cl_test.cpp
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2023--2024.
+ * @date 2023--2026.
  * @brief Classifier tests.
  */
 
@@ -26,8 +26,11 @@
 extern "C" {
 #include "../xcsf/cl.h"
 #include "../xcsf/cond_rectangle.h"
+#include "../xcsf/neural_layer.h"
+#include "../xcsf/neural_layer_args.h"
 #include "../xcsf/param.h"
 #include "../xcsf/pred_nlms.h"
+#include "../xcsf/prediction.h"
 #include "../xcsf/utils.h"
 #include "../xcsf/xcsf.h"
 #include <stdbool.h>
@@ -110,6 +113,19 @@ TEST_CASE("CL")
     CHECK_EQ(w, r);
     fclose(fp);
 
+    /* Test updating on the previous state reuses a prediction still held */
+    xcsf.prev_stamp = 7;
+    c1->pred_stamp = 7;
+    c1->prediction[0] = 0.5;
+    c1->exp = 0;
+    cl_update(&xcsf, c1, x, y, 1, false);
+    const double error = (xcsf.loss_ptr)(&xcsf, c1->prediction, y);
+    CHECK_EQ(doctest::Approx(c1->err), error);
+    CHECK_EQ(c1->prediction[0], 0.5);
+    CHECK_EQ(c1->pred_stamp, 0);
+    cl_update(&xcsf, c1, x, y, 1, false);
+    CHECK(c1->prediction[0] != 0.5);
+
     /* Test clean up */
     cl_free(&xcsf, c1);
     cl_free(&xcsf, c2);
@@ -120,3 +136,52 @@ TEST_CASE("CL")
     cJSON_Delete(json);
     param_free(&xcsf);
 }
+
+TEST_CASE("CL_UPDATE_DROPOUT")
+{
+    /* Test updating on the previous state is unchanged by a held prediction
+     * when the network draws random numbers */
+    struct XCSF xcsf;
+    param_init(&xcsf, 5, 1, 1);
+    param_set_random_state(&xcsf, 1);
+    pred_param_set_type(&xcsf, PRED_TYPE_NEURAL);
+    struct ArgsLayer *hidden = xcsf.pred->largs;
+    struct ArgsLayer *dropout =
+        (struct ArgsLayer *) malloc(sizeof(struct ArgsLayer));
+    layer_args_init(dropout);
+    dropout->type = DROPOUT;
+    dropout->n_inputs = hidden->n_init;
+    dropout->probability = 0.5;
+    dropout->next = hidden->next;
+    hidden->next = dropout;
+    xcsf_init(&xcsf);
+    param_set_explore(&xcsf, true);
+    struct Cl *base = (struct Cl *) malloc(sizeof(struct Cl));
+    struct Cl *held = (struct Cl *) malloc(sizeof(struct Cl));
+    cl_init(&xcsf, base, 1, 1);
+    cl_rand(&xcsf, base);
+    cl_init_copy(&xcsf, held, base);
+    CHECK(!pred_reusable(&xcsf, held));
+    // baseline: the prediction is recomputed on the previous state
+    base->pred_stamp = 0;
+    rand_init_seed(2);
+    cl_update(&xcsf, base, x, y, 1, false);
+    // the prediction held from the previous step used another dropout mask
+    cl_predict(&xcsf, held, x);
+    xcsf.prev_stamp = 7;
+    held->pred_stamp = 7;
+    rand_init_seed(2);
+    cl_update(&xcsf, held, x, y, 1, false);
+    CHECK_EQ(held->err, base->err);
+    CHECK_EQ(held->prediction[0], base->prediction[0]);
+    // both networks were trained with the same dropout mask
+    param_set_explore(&xcsf, false);
+    cl_predict(&xcsf, base, x);
+    cl_predict(&xcsf, held, x);
+    CHECK_EQ(held->prediction[0], base->prediction[0]);
+    /* Test clean up */
+    cl_free(&xcsf, base);
+    cl_free(&xcsf, held);
+    xcsf_free(&xcsf);
+    param_free(&xcsf);
+}
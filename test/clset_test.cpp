@@ -17,7 +17,7 @@
  * @file clset_test.cpp
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2023.
+ * @date 2023--2026.
  * @brief Set tests.
  */
 
@@ -25,8 +25,12 @@
 
 extern "C" {
 #include "../xcsf/clset.h"
+#include "../xcsf/cond_rectangle.h"
+#include "../xcsf/neural_layer.h"
+#include "../xcsf/neural_layer_args.h"
 #include "../xcsf/pa.h"
 #include "../xcsf/param.h"
+#include "../xcsf/prediction.h"
 #include "../xcsf/utils.h"
 #include "../xcsf/xcs_supervised.h"
 #include "../xcsf/xcsf.h"
@@ -66,8 +70,15 @@ TEST_CASE("CLSET")
     cJSON_AddItemToObject(json, "current_prediction", p);
     clset_json_insert_cl(&xcsf, json);
     cJSON_Delete(json);
-    // check the classifier
-    struct Cl *c = xcsf.pset.list->cl;
+    // check the classifier; the population may have been reordered by
+    // deletion, so search for it rather than assuming its position
+    struct Cl *c = NULL;
+    for (int i = 0; i < xcsf.pset.size; ++i) {
+        if (xcsf.pset.cl[i]->exp == 50) {
+            c = xcsf.pset.cl[i];
+        }
+    }
+    REQUIRE(c != NULL);
     CHECK_EQ(c->err, 0.1);
     CHECK_EQ(c->fit, 0.2);
     CHECK_EQ(c->size, 10);
@@ -88,6 +99,30 @@ TEST_CASE("CLSET")
     const double psize = clset_mean_pred_size(&xcsf, &xcsf.pset);
     CHECK_EQ(psize, x_dim + 1);
 
+    /* Test set order */
+    struct Set set;
+    clset_init(&set);
+    for (int i = 0; i < xcsf.pset.size; ++i) {
+        clset_add(&set, xcsf.pset.cl[i]);
+    }
+    // classifiers are appended in the order added
+    REQUIRE_EQ(set.size, xcsf.pset.size);
+    for (int i = 0; i < set.size; ++i) {
+        CHECK_EQ(set.cl[i], xcsf.pset.cl[i]);
+    }
+    // removing a classifier keeps the remainder in order
+    struct Cl *removed = set.cl[1];
+    const int removed_num = removed->num;
+    removed->num = 0;
+    clset_validate(&set);
+    removed->num = removed_num;
+    REQUIRE_EQ(set.size, xcsf.pset.size - 1);
+    CHECK_EQ(set.cl[0], xcsf.pset.cl[0]);
+    for (int i = 1; i < set.size; ++i) {
+        CHECK_EQ(set.cl[i], xcsf.pset.cl[i + 1]);
+    }
+    clset_free(&set);
+
     /* Smoke test export */
     char *json_str = clset_json_export(&xcsf, &xcsf.pset, true, true, true);
     CHECK(json_str != NULL);
@@ -100,3 +135,105 @@ TEST_CASE("CLSET")
     param_free(&xcsf);
     free(json_str);
 }
+
+/**
+ * @brief Updates a population of neural predictions with dropout.
+ * @details The set is updated for the previous state so that each rule
+ * propagates its network, drawing random numbers, within the parallel update.
+ * @param [out] err The error of each rule after updating.
+ * @param [in] n The number of rules.
+ */
+static void
+clset_dropout_update(double *err, const int n)
+{
+    struct XCSF xcsf;
+    param_init(&xcsf, 4, 1, 1);
+    param_set_random_state(&xcsf, 1);
+    param_set_pop_size(&xcsf, n);
+    pred_param_set_type(&xcsf, PRED_TYPE_NEURAL);
+    struct ArgsLayer *hidden = xcsf.pred->largs;
+    struct ArgsLayer *dropout =
+        (struct ArgsLayer *) malloc(sizeof(struct ArgsLayer));
+    layer_args_init(dropout);
+    dropout->type = DROPOUT;
+    dropout->n_inputs = hidden->n_init;
+    dropout->probability = 0.5;
+    dropout->next = hidden->next;
+    hidden->next = dropout;
+    xcsf_init(&xcsf);
+    xcsf.explore = true;
+    struct Set set;
+    clset_init(&set);
+    for (int i = 0; i < xcsf.pset.size; ++i) {
+        clset_add(&set, xcsf.pset.cl[i]);
+    }
+    const double x[4] = { 0.2, 0.4, 0.6, 0.8 };
+    const double y[1] = { 0.5 };
+    for (int t = 0; t < 5; ++t) {
+        clset_update(&xcsf, &set, x, y, false);
+    }
+    for (int i = 0; i < n; ++i) {
+        err[i] = set.cl[i]->err;
+    }
+    clset_free(&set);
+    xcsf_free(&xcsf);
+    param_free(&xcsf);
+}
+
+TEST_CASE("CLSET_UPDATE")
+{
+    /* Test that parallel updates drawing random numbers are reproducible */
+    const int n = 50;
+    double err1[n];
+    double err2[n];
+    clset_dropout_update(err1, n);
+    clset_dropout_update(err2, n);
+    for (int i = 0; i < n; ++i) {
+        CHECK_EQ(err1[i], err2[i]);
+    }
+}
+
+TEST_CASE("CLSET_SUBSUMPTION")
+{
+    struct XCSF xcsf;
+    param_init(&xcsf, 4, 1, 1);
+    param_set_random_state(&xcsf, 1);
+    param_set_pop_size(&xcsf, 100);
+    param_set_set_subsumption(&xcsf, true);
+    param_set_theta_sub(&xcsf, 10);
+    param_set_e0(&xcsf, 1000);
+    xcsf_init(&xcsf);
+    const int num = xcsf.pset.num;
+
+    /* Make the first rule a subsumer covering the whole input space */
+    struct Cl *s = xcsf.pset.cl[0];
+    struct CondRectangle *cond = (struct CondRectangle *) s->cond;
+    for (int i = 0; i < xcsf.x_dim; ++i) {
+        cond->b1[i] = 0.5;
+        cond->b2[i] = 10;
+    }
+    s->exp = 100;
+
+    /* Test that updating the set subsumes every other rule */
+    struct Set set;
+    clset_init(&set);
+    for (int i = 0; i < xcsf.pset.size; ++i) {
+        clset_add(&set, xcsf.pset.cl[i]);
+    }
+    const double x[4] = { 0.2, 0.4, 0.6, 0.8 };
+    const double y[1] = { 0.5 };
+    clset_update(&xcsf, &set, x, y, true);
+    CHECK_EQ(set.size, 1);
+    CHECK_EQ(set.cl[0], s);
+    CHECK_EQ(xcsf.pset.size, 1);
+    CHECK_EQ(xcsf.pset.cl[0], s);
+    CHECK_EQ(s->num, num);
+    CHECK_EQ(xcsf.pset.num, num);
+    CHECK_EQ(xcsf.kset.size, 99);
+
+    /* Test clean up */
+    clset_kill(&xcsf, &xcsf.kset);
+    clset_free(&set);
+    xcsf_free(&xcsf);
+    param_free(&xcsf);
+}
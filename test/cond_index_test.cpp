@@ -0,0 +1,105 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cond_index_test.cpp
+ * @author Richard Preen <rpreen@gmail.com>
+ * @copyright The Authors.
+ * @date 2026.
+ * @brief Condition index tests.
+ */
+
+#include "../lib/doctest/doctest/doctest.h"
+
+extern "C" {
+#include "../xcsf/cl.h"
+#include "../xcsf/clset.h"
+#include "../xcsf/cond_index.h"
+#include "../xcsf/condition.h"
+#include "../xcsf/param.h"
+#include "../xcsf/utils.h"
+#include "../xcsf/xcsf.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+}
+
+/**
+ * @brief Checks that the index agrees with matching each rule.
+ * @details Both the binned and the full scan are checked.
+ * @param [in] xcsf The XCSF data structure.
+ * @return The number of disagreements over a sample of random inputs.
+ */
+static int
+index_mismatches(struct XCSF *xcsf)
+{
+    int mismatches = 0;
+    double x[5];
+    for (int n = 0; n < 200; ++n) {
+        for (int i = 0; i < xcsf->x_dim; ++i) {
+            x[i] = rand_uniform(-0.1, 1.1);
+        }
+        xcsf->mset_size = (n % 2 == 0) ? 0 : xcsf->pset.size;
+        const uint64_t *bitmap = cond_index_match(xcsf, &xcsf->pset, x);
+        for (int j = 0; j < xcsf->pset.size; ++j) {
+            const bool index = (bitmap[j / 64] >> (j % 64)) & 1;
+            if (index != cond_match(xcsf, xcsf->pset.cl[j], x)) {
+                ++mismatches;
+            }
+        }
+    }
+    return mismatches;
+}
+
+TEST_CASE("COND_INDEX")
+{
+    const int types[3] = { COND_TYPE_HYPERRECTANGLE_CSR,
+                           COND_TYPE_HYPERRECTANGLE_UBR,
+                           COND_TYPE_HYPERELLIPSOID };
+    for (int t = 0; t < 3; ++t) {
+        struct XCSF xcsf;
+        param_init(&xcsf, 5, 1, 1);
+        param_set_random_state(&xcsf, 1);
+        param_set_pop_size(&xcsf, 300);
+        cond_param_set_type(&xcsf, types[t]);
+        cond_param_set_min(&xcsf, 0);
+        cond_param_set_max(&xcsf, 1);
+        cond_param_set_spread_min(&xcsf, 0.5);
+        xcsf_init(&xcsf);
+        CHECK(cond_index_supported(&xcsf));
+        CHECK_EQ(index_mismatches(&xcsf), 0);
+
+        /* test after rules are deleted and moved */
+        param_set_pop_size(&xcsf, 130);
+        clset_pset_enforce_limit(&xcsf);
+        CHECK_EQ(index_mismatches(&xcsf), 0);
+
+        /* test after rules are modified in place */
+        for (int j = 0; j + 1 < xcsf.pset.size; j += 7) {
+            cond_crossover(&xcsf, xcsf.pset.cl[j], xcsf.pset.cl[j + 1]);
+        }
+        CHECK_EQ(index_mismatches(&xcsf), 0);
+
+        /* test after the population is replaced */
+        xcsf_free(&xcsf);
+        xcsf_init(&xcsf);
+        CHECK_EQ(index_mismatches(&xcsf), 0);
+
+        /* test clean up */
+        xcsf_free(&xcsf);
+        param_free(&xcsf);
+    }
+}
@@ -17,7 +17,7 @@
  * @file cond_neural_test.cpp
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2023--2024.
+ * @date 2023--2026.
  * @brief Neural condition tests.
  */
 
@@ -25,11 +25,15 @@
 
 extern "C" {
 #include "../xcsf/cl.h"
+#include "../xcsf/clset.h"
 #include "../xcsf/cond_neural.h"
+#include "../xcsf/cond_neural_batch.h"
 #include "../xcsf/condition.h"
+#include "../xcsf/neural_layer.h"
 #include "../xcsf/param.h"
 #include "../xcsf/utils.h"
 #include "../xcsf/xcsf.h"
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -141,3 +145,80 @@ TEST_CASE("COND_NEURAL")
     xcsf_free(&xcsf);
     param_free(&xcsf);
 }
+
+/**
+ * @brief Sets the weights of a neural condition to deterministic values.
+ * @param [in] c The classifier whose condition is to be set.
+ * @param [in] seed Offset distinguishing networks.
+ */
+static void
+fill_net(const struct Cl *c, const int seed)
+{
+    const struct CondNeural *cond = (struct CondNeural *) c->cond;
+    for (const struct Llist *iter = cond->net.tail; iter != NULL;
+         iter = iter->prev) {
+        const struct Layer *l = iter->layer;
+        for (int i = 0; i < l->n_weights; ++i) {
+            l->weights[i] = 2 * sin(0.37 * i + 1.3 * seed);
+        }
+        for (int i = 0; i < l->n_biases; ++i) {
+            l->biases[i] = sin(0.71 * i + 0.9 * seed);
+        }
+    }
+}
+
+/**
+ * @brief Checks that batched matching agrees with matching each rule.
+ * @param [in] xcsf The XCSF data structure.
+ * @return The number of disagreements over a sample of random inputs.
+ */
+static int
+batch_mismatches(struct XCSF *xcsf)
+{
+    int mismatches = 0;
+    double x[5];
+    for (int n = 0; n < 50; ++n) {
+        for (int i = 0; i < xcsf->x_dim; ++i) {
+            x[i] = rand_uniform(0, 1);
+        }
+        const uint64_t *bitmap =
+            cond_neural_batch_match(xcsf, &xcsf->pset, x);
+        for (int j = 0; j < xcsf->pset.size; ++j) {
+            const bool batch = (bitmap[j / 64] >> (j % 64)) & 1;
+            if (batch != cond_neural_match(xcsf, xcsf->pset.cl[j], x)) {
+                ++mismatches;
+            }
+        }
+    }
+    return mismatches;
+}
+
+TEST_CASE("COND_NEURAL_BATCH")
+{
+    struct XCSF xcsf;
+    param_init(&xcsf, 5, 1, 1);
+    param_set_random_state(&xcsf, 1);
+    param_set_pop_size(&xcsf, 200);
+    cond_param_set_type(&xcsf, COND_TYPE_NEURAL);
+    xcsf_init(&xcsf);
+    for (int j = 0; j < xcsf.pset.size; ++j) {
+        fill_net(xcsf.pset.cl[j], j);
+    }
+    CHECK_EQ(batch_mismatches(&xcsf), 0);
+    /* networks with a different topology are batched in another group */
+    xcsf.cond->largs->n_init = 12;
+    xcsf.cond->largs->next->n_inputs = 12;
+    for (int j = 0; j < xcsf.pset.size; j += 3) {
+        cond_neural_free(&xcsf, xcsf.pset.cl[j]);
+        cond_neural_init(&xcsf, xcsf.pset.cl[j]);
+        fill_net(xcsf.pset.cl[j], -j);
+    }
+    CHECK_EQ(batch_mismatches(&xcsf), 0);
+    /* removed rules release their columns */
+    param_set_pop_size(&xcsf, 150);
+    clset_pset_enforce_limit(&xcsf);
+    clset_kill(&xcsf, &xcsf.kset);
+    CHECK_EQ(batch_mismatches(&xcsf), 0);
+    xcsf_free(&xcsf);
+    param_free(&xcsf);
+}
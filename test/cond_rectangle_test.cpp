@@ -17,7 +17,7 @@
  * @file cond_rectangle_test.cpp
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2020--2024.
+ * @date 2020--2026.
  * @brief Hyperrectangle condition tests.
  */
 
@@ -207,3 +207,88 @@ TEST_CASE("COND_RECTANGLE_UBR")
     xcsf_free(&xcsf);
     param_free(&xcsf);
 }
+
+/**
+ * @brief Checks that batched matching agrees with matching each rule.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] batch Batched matching block holding the population bounds.
+ * @return The number of disagreements over a sample of random inputs.
+ */
+static int
+batch_mismatches(struct XCSF *xcsf, const struct CondRectangleBatch *batch)
+{
+    int mismatches = 0;
+    double x[5];
+    for (int n = 0; n < 100; ++n) {
+        for (int i = 0; i < xcsf->x_dim; ++i) {
+            x[i] = rand_uniform(0, 1);
+        }
+        for (int j = 0; j < xcsf->pset.size; ++j) {
+            const int start = j - (j % BATCH_TILE);
+            const uint64_t word = cond_rectangle_batch_tile(batch, x, start);
+            const bool batched = (word >> (j % BATCH_TILE)) & 1;
+            if (batched != cond_rectangle_match(xcsf, xcsf->pset.cl[j], x)) {
+                ++mismatches;
+            }
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * @brief Fills a batched matching block with the population bounds.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] batch Batched matching block.
+ */
+static void
+batch_fill(const struct XCSF *xcsf, struct CondRectangleBatch *batch)
+{
+    double lb[5];
+    double ub[5];
+    const int capacity =
+        BATCH_TILE * ((xcsf->pset.size + BATCH_TILE - 1) / BATCH_TILE);
+    cond_rectangle_batch_resize(batch, xcsf->x_dim, capacity);
+    for (int j = 0; j < xcsf->pset.size; ++j) {
+        cond_rectangle_bounds(xcsf, xcsf->pset.cl[j], lb, ub);
+        cond_rectangle_batch_set(batch, j, lb, ub);
+    }
+}
+
+TEST_CASE("COND_RECTANGLE_BATCH")
+{
+    const int types[2] = { COND_TYPE_HYPERRECTANGLE_CSR,
+                           COND_TYPE_HYPERRECTANGLE_UBR };
+    for (int t = 0; t < 2; ++t) {
+        struct XCSF xcsf;
+        param_init(&xcsf, 5, 1, 1);
+        param_set_random_state(&xcsf, 1);
+        param_set_pop_size(&xcsf, 300);
+        cond_param_set_type(&xcsf, types[t]);
+        cond_param_set_min(&xcsf, 0);
+        cond_param_set_max(&xcsf, 1);
+        cond_param_set_spread_min(&xcsf, 0.5);
+        xcsf_init(&xcsf);
+        struct CondRectangleBatch batch = { NULL, NULL, 0, 0 };
+        batch_fill(&xcsf, &batch);
+        CHECK_EQ(batch_mismatches(&xcsf, &batch), 0);
+
+        /* test after rules are modified in place */
+        for (int j = 0; j < xcsf.pset.size; j += 7) {
+            cond_rectangle_mutate(&xcsf, xcsf.pset.cl[j]);
+        }
+        batch_fill(&xcsf, &batch);
+        CHECK_EQ(batch_mismatches(&xcsf, &batch), 0);
+
+        /* test after the block is grown */
+        param_set_pop_size(&xcsf, 700);
+        xcsf_free(&xcsf);
+        xcsf_init(&xcsf);
+        batch_fill(&xcsf, &batch);
+        CHECK_EQ(batch_mismatches(&xcsf, &batch), 0);
+
+        /* test clean up */
+        cond_rectangle_batch_free(&batch);
+        xcsf_free(&xcsf);
+        param_free(&xcsf);
+    }
+}
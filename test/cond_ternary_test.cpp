@@ -17,7 +17,7 @@
  * @file cond_ternary_test.cpp
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2020--2024.
+ * @date 2020--2026.
  * @brief Ternary condition tests.
  */
 
@@ -37,6 +37,27 @@ extern "C" {
 #include <string.h>
 }
 
+/**
+ * @brief Sets a packed ternary condition from a bitstring.
+ * @param [in] cond The ternary condition to set.
+ * @param [in] string The bitstring of '0', '1', and '#' symbols.
+ */
+static void
+ternary_set_string(struct CondTernary *cond, const char *string)
+{
+    memset(cond->care, 0, sizeof(uint64_t) * cond->n_words);
+    memset(cond->value, 0, sizeof(uint64_t) * cond->n_words);
+    for (int i = 0; i < cond->length; ++i) {
+        const uint64_t bit = UINT64_C(1) << (i % 64);
+        if (string[i] != '#') {
+            cond->care[i / 64] |= bit;
+        }
+        if (string[i] == '1') {
+            cond->value[i / 64] |= bit;
+        }
+    }
+}
+
 TEST_CASE("COND_TERNARY")
 {
     /* Test initialisation */
@@ -60,21 +81,21 @@ TEST_CASE("COND_TERNARY")
 
     /* test for true match condition */
     const char *true_1 = "1100010110";
-    memcpy(p->string, true_1, sizeof(char) * 10);
+    ternary_set_string(p, true_1);
     bool match = cond_ternary_match(&xcsf, c1, x);
     CHECK_EQ(match, true);
     const char *true_2 = "1#00#101#0";
-    memcpy(p->string, true_2, sizeof(char) * 10);
+    ternary_set_string(p, true_2);
     match = cond_ternary_match(&xcsf, c1, x);
     CHECK_EQ(match, true);
 
     /* test for false match condition */
     const char *false_1 = "1100000110";
-    memcpy(p->string, false_1, sizeof(char) * 10);
+    ternary_set_string(p, false_1);
     match = cond_ternary_match(&xcsf, c1, x);
     CHECK_EQ(match, false);
     const char *false_2 = "0#00#101#0";
-    memcpy(p->string, false_2, sizeof(char) * 10);
+    ternary_set_string(p, false_2);
     match = cond_ternary_match(&xcsf, c1, x);
     CHECK_EQ(match, false);
 
@@ -84,7 +105,7 @@ TEST_CASE("COND_TERNARY")
     cl_rand(&xcsf, c2);
     struct CondTernary *p2 = (struct CondTernary *) c2->cond;
     const char *spec = "0000#101#0";
-    memcpy(p2->string, spec, sizeof(char) * 10);
+    ternary_set_string(p2, spec);
     bool general = cond_ternary_general(&xcsf, c1, c2);
     CHECK_EQ(general, true);
     general = cond_ternary_general(&xcsf, c2, c1);
@@ -109,8 +130,9 @@ TEST_CASE("COND_TERNARY")
     struct CondTernary *dest_cond = (struct CondTernary *) dest_cl->cond;
     struct CondTernary *src_cond = (struct CondTernary *) c1->cond;
     CHECK_EQ(dest_cond->length, src_cond->length);
-    for (int i = 0; i < src_cond->length; ++i) {
-        CHECK_EQ(dest_cond->string[i], src_cond->string[i]);
+    for (int i = 0; i < src_cond->n_words; ++i) {
+        CHECK_EQ(dest_cond->care[i], src_cond->care[i]);
+        CHECK_EQ(dest_cond->value[i], src_cond->value[i]);
     }
     for (int i = 0; i < 1; ++i) {
         CHECK_EQ(dest_cond->mu[i], src_cond->mu[i]);
@@ -129,8 +151,9 @@ TEST_CASE("COND_TERNARY")
 
     struct CondTernary *new_cond = (struct CondTernary *) new_cl->cond;
     CHECK_EQ(new_cond->length, src_cond->length);
-    for (int i = 0; i < src_cond->length; ++i) {
-        CHECK_EQ(new_cond->string[i], src_cond->string[i]);
+    for (int i = 0; i < src_cond->n_words; ++i) {
+        CHECK_EQ(new_cond->care[i], src_cond->care[i]);
+        CHECK_EQ(new_cond->value[i], src_cond->value[i]);
     }
     CHECK(check_array_eq(new_cond->mu, src_cond->mu, 1));
     free(json_str);
@@ -139,8 +162,9 @@ TEST_CASE("COND_TERNARY")
     /* test mutation */
     CHECK(cond_ternary_mutate(&xcsf, c1));
     bool equal = true;
-    for (int i = 0; i < src_cond->length; ++i) {
-        if (new_cond->string[i] != src_cond->string[i]) {
+    for (int i = 0; i < src_cond->n_words; ++i) {
+        if (new_cond->care[i] != src_cond->care[i] ||
+            new_cond->value[i] != src_cond->value[i]) {
             equal = false;
         }
     }
@@ -177,3 +201,82 @@ TEST_CASE("COND_TERNARY")
     xcsf_free(&xcsf);
     param_free(&xcsf);
 }
+
+TEST_CASE("COND_TERNARY_MULTIWORD")
+{
+    struct XCSF xcsf;
+    param_init(&xcsf, 70, 1, 1);
+    param_set_random_state(&xcsf, 1);
+    cond_param_set_type(&xcsf, COND_TYPE_TERNARY);
+    cond_param_set_bits(&xcsf, 2);
+    xcsf_init(&xcsf);
+
+    struct Cl *c1 = (struct Cl *) malloc(sizeof(struct Cl));
+    cl_init(&xcsf, c1, 1, 1);
+    cl_rand(&xcsf, c1);
+    struct CondTernary *p1 = (struct CondTernary *) c1->cond;
+    CHECK_EQ(p1->length, 140);
+    CHECK_EQ(p1->n_words, 3);
+
+    double x[70];
+    for (int i = 0; i < 70; ++i) {
+        x[i] = 0.8; // binarised as "11"
+    }
+    char string[141];
+    memset(string, '#', sizeof(char) * 140);
+    string[140] = '\0';
+
+    /* test matching across word boundaries */
+    string[130] = '1';
+    ternary_set_string(p1, string);
+    CHECK(cond_ternary_match(&xcsf, c1, x));
+    string[130] = '0';
+    ternary_set_string(p1, string);
+    CHECK(!cond_ternary_match(&xcsf, c1, x));
+    x[65] = 0.3; // binarised as "01"
+    string[130] = '0';
+    ternary_set_string(p1, string);
+    CHECK(cond_ternary_match(&xcsf, c1, x));
+
+    /* test general across word boundaries */
+    struct Cl *c2 = (struct Cl *) malloc(sizeof(struct Cl));
+    cl_init(&xcsf, c2, 1, 1);
+    cl_rand(&xcsf, c2);
+    struct CondTernary *p2 = (struct CondTernary *) c2->cond;
+    string[70] = '1';
+    ternary_set_string(p2, string);
+    CHECK(cond_ternary_general(&xcsf, c1, c2));
+    CHECK(!cond_ternary_general(&xcsf, c2, c1));
+    CHECK(!cond_ternary_general(&xcsf, c2, c2));
+
+    /* test import and export */
+    char *json_str = cond_ternary_json_export(&xcsf, c2);
+    cJSON *json = cJSON_Parse(json_str);
+    cond_ternary_json_import(&xcsf, c1, json);
+    for (int i = 0; i < p1->n_words; ++i) {
+        CHECK_EQ(p1->care[i], p2->care[i]);
+        CHECK_EQ(p1->value[i], p2->value[i]);
+    }
+    free(json_str);
+    cJSON_Delete(json);
+
+    /* test covering */
+    cond_ternary_cover(&xcsf, c2, x);
+    CHECK(cond_ternary_match(&xcsf, c2, x));
+
+    /* test shared binarised input */
+    string[70] = '#';
+    string[130] = '0';
+    ternary_set_string(p1, string);
+    cond_ternary_set_input(&xcsf, x);
+    CHECK(cond_ternary_match(&xcsf, c1, x));
+    cond_ternary_set_input(&xcsf, NULL);
+    x[65] = 0.8;
+    CHECK(!cond_ternary_match(&xcsf, c1, x));
+
+    /* clean up */
+    cl_free(&xcsf, c1);
+    cl_free(&xcsf, c2);
+    xcsf_free(&xcsf);
+    param_free(&xcsf);
+}
@@ -0,0 +1,160 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file del_index_test.cpp
+ * @author Richard Preen <rpreen@gmail.com>
+ * @copyright The Authors.
+ * @date 2026.
+ * @brief Deletion index tests.
+ */
+
+#include "../lib/doctest/doctest/doctest.h"
+
+extern "C" {
+#include "../xcsf/cl.h"
+#include "../xcsf/clset.h"
+#include "../xcsf/cond_index.h"
+#include "../xcsf/del_index.h"
+#include "../xcsf/param.h"
+#include "../xcsf/utils.h"
+#include "../xcsf/xcsf.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+}
+
+/**
+ * @brief Assigns random deletion parameters to a classifier.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] c The classifier to modify.
+ */
+static void
+randomise(struct XCSF *xcsf, struct Cl *c)
+{
+    xcsf->pset.num -= c->num;
+    c->fit = rand_uniform(0.001, 1);
+    c->num = rand_uniform_int(1, 4);
+    c->exp = rand_uniform_int(0, 2 * xcsf->THETA_DEL);
+    c->size = rand_uniform(1, 50);
+    c->mtotal = (rand_uniform(0, 1) < 0.05) ? 0 : 1;
+    c->age = rand_uniform_int(0, 2 * xcsf->M_PROBATION);
+    xcsf->pset.num += c->num;
+    del_index_update(xcsf, c);
+}
+
+/**
+ * @brief Checks that the index agrees with walking the population.
+ * @param [in] xcsf The XCSF data structure.
+ * @return The number of disagreements over a sample of roulette spins.
+ */
+static int
+index_mismatches(struct XCSF *xcsf)
+{
+    const struct Set *pset = &xcsf->pset;
+    int mismatches = 0;
+    del_index_sync(xcsf);
+    // never matching rules
+    int never = -1;
+    for (int i = 0; i < pset->size && never < 0; ++i) {
+        if (pset->cl[i]->mtotal == 0 &&
+            pset->cl[i]->age > xcsf->M_PROBATION) {
+            never = i;
+        }
+    }
+    if (del_index_never_match(xcsf) != never) {
+        ++mismatches;
+    }
+    // roulette
+    const double avg_fit = clset_total_fit(pset) / pset->num;
+    double total = 0;
+    for (int i = 0; i < pset->size; ++i) {
+        total += cl_del_vote(xcsf, pset->cl[i], avg_fit);
+    }
+    const double index_total = del_index_votes(xcsf);
+    if (fabs(index_total - total) > 1e-9 * total) {
+        ++mismatches;
+    }
+    for (int n = 0; n < 200; ++n) {
+        const double p = rand_uniform(0, total);
+        int j = 0;
+        double sum = cl_del_vote(xcsf, pset->cl[j], avg_fit);
+        while (p > sum && j < pset->size - 1) {
+            ++j;
+            sum += cl_del_vote(xcsf, pset->cl[j], avg_fit);
+        }
+        if (del_index_spin(xcsf, p) != j) {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+TEST_CASE("DEL_INDEX")
+{
+    struct XCSF xcsf;
+    param_init(&xcsf, 5, 1, 1);
+    param_set_random_state(&xcsf, 1);
+    param_set_pop_size(&xcsf, 500);
+    xcsf_init(&xcsf);
+    for (int i = 0; i < xcsf.pset.size; ++i) {
+        randomise(&xcsf, xcsf.pset.cl[i]);
+    }
+    CHECK_EQ(index_mismatches(&xcsf), 0);
+    for (int round = 0; round < 5; ++round) {
+        /* test parameter changes */
+        for (int i = 0; i < 50; ++i) {
+            randomise(&xcsf, xcsf.pset.cl[rand_uniform_int(0, xcsf.pset.size)]);
+        }
+        CHECK_EQ(index_mismatches(&xcsf), 0);
+        /* test indexing the conditions in a different order */
+        struct Set rev;
+        clset_init(&rev);
+        for (int i = xcsf.pset.size - 1; i >= 0; --i) {
+            clset_add(&rev, xcsf.pset.cl[i]);
+        }
+        cond_index_update(&xcsf, &rev);
+        for (int i = 0; i < 50; ++i) {
+            randomise(&xcsf, xcsf.pset.cl[rand_uniform_int(0, xcsf.pset.size)]);
+        }
+        CHECK_EQ(index_mismatches(&xcsf), 0);
+        clset_free(&rev);
+        /* test rules matching without updating the index */
+        for (int i = 0; i < xcsf.pset.size; ++i) {
+            if (rand_uniform(0, 1) < 0.5) {
+                ++(xcsf.pset.cl[i]->mtotal);
+            }
+        }
+        CHECK_EQ(index_mismatches(&xcsf), 0);
+        /* test deletion */
+        param_set_pop_size(&xcsf, xcsf.POP_SIZE - 60);
+        clset_pset_enforce_limit(&xcsf);
+        CHECK_EQ(xcsf.pset.num, xcsf.POP_SIZE);
+        CHECK_EQ(index_mismatches(&xcsf), 0);
+        /* test appending */
+        for (int i = 0; i < 20; ++i) {
+            struct Cl *c = (struct Cl *) malloc(sizeof(struct Cl));
+            cl_init(&xcsf, c, 1, 0);
+            cl_rand(&xcsf, c);
+            clset_add(&xcsf.pset, c);
+            randomise(&xcsf, c);
+        }
+        CHECK_EQ(index_mismatches(&xcsf), 0);
+    }
+    /* test clean up */
+    xcsf_free(&xcsf);
+    param_free(&xcsf);
+}
@@ -17,7 +17,7 @@
  * @file neural_activations_test.cpp
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2023.
+ * @date 2023--2026.
  * @brief Neural activation function tests.
  */
 
@@ -25,6 +25,8 @@
 
 extern "C" {
 #include "../xcsf/neural_activations.h"
+#include "../xcsf/param.h"
+#include "../xcsf/xcsf.h"
 #include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -74,19 +76,86 @@ TEST_CASE("NEURAL_ACTIVATIONS")
 
     /* Test array activation */
     const int x_dim = 4;
-    double state[4] = { 0.1, 0.2, 0.3, 0.4 };
-    double output[4] = { 0, 0, 0, 0 };
-    double active[4] = { 0.524979, 0.549834, 0.574443, 0.598688 };
-    neural_activate_array(state, output, x_dim, LOGISTIC);
+    neural_real state[4] = { 0.1, 0.2, 0.3, 0.4 };
+    neural_real output[4] = { 0, 0, 0, 0 };
+    neural_real active[4] = { 0.524979, 0.549834, 0.574443, 0.598688 };
+    neural_activate_array(state, output, x_dim, LOGISTIC, false);
     for (int i = 0; i < x_dim; ++i) {
         CHECK_EQ(output[i], doctest::Approx(active[i]));
     }
 
     /* Test array gradient */
-    double delta[4] = { 1, 1, 1, 1 };
-    double gradient[4] = { 0.249376, 0.247517, 0.244458, 0.240261 };
-    neural_gradient_array(state, delta, x_dim, LOGISTIC);
+    neural_real delta[4] = { 1, 1, 1, 1 };
+    neural_real gradient[4] = { 0.249376, 0.247517, 0.244458, 0.240261 };
+    neural_gradient_array(state, delta, x_dim, LOGISTIC, false);
     for (int i = 0; i < x_dim; ++i) {
         CHECK_EQ(delta[i], doctest::Approx(gradient[i]));
     }
+
+    /* Test vectorised approximations against the exact functions */
+    const int n = 4001;
+#ifdef NEURAL_FLOAT
+    const double tolerance = 1e-5;
+#else
+    const double tolerance = 1e-14;
+#endif
+    neural_real *x_fast = (neural_real *) malloc(sizeof(neural_real) * n);
+    neural_real *x_exact = (neural_real *) malloc(sizeof(neural_real) * n);
+    neural_real *y_fast = (neural_real *) malloc(sizeof(neural_real) * n);
+    neural_real *y_exact = (neural_real *) malloc(sizeof(neural_real) * n);
+    neural_real *d_fast = (neural_real *) malloc(sizeof(neural_real) * n);
+    neural_real *d_cached = (neural_real *) malloc(sizeof(neural_real) * n);
+    neural_real *d_exact = (neural_real *) malloc(sizeof(neural_real) * n);
+    for (int f = 0; f < NUM_ACTIVATIONS; ++f) {
+        for (int i = 0; i < n; ++i) {
+            x_fast[i] = -110 + 0.055 * i;
+            x_exact[i] = x_fast[i];
+            d_fast[i] = 1;
+            d_cached[i] = 1;
+            d_exact[i] = 1;
+        }
+        neural_activate_array(x_exact, y_exact, n, f, false);
+        neural_gradient_array(x_exact, d_exact, n, f, false);
+        neural_activate_array(x_fast, y_fast, n, f, true);
+        neural_gradient_array(x_fast, d_fast, n, f, true);
+        neural_gradient_array_cached(x_fast, y_fast, d_cached, n, f, true);
+        double error = 0;
+        for (int i = 0; i < n; ++i) {
+            const double scale = fmax(1, fabs(y_exact[i]));
+            error = fmax(error, fabs(y_fast[i] - y_exact[i]) / scale);
+            error = fmax(error, fabs(d_fast[i] - d_exact[i]) / scale);
+            error = fmax(error, fabs(d_cached[i] - d_exact[i]) / scale);
+        }
+        CHECK(error < tolerance);
+    }
+    free(x_fast);
+    free(x_exact);
+    free(y_fast);
+    free(y_exact);
+    free(d_fast);
+    free(d_cached);
+    free(d_exact);
+}
+
+TEST_CASE("NEURAL_ACTIVATIONS_PARAM")
+{
+    /* Test the exact functions are the default */
+    struct XCSF xcsf;
+    param_init(&xcsf, 1, 1, 1);
+    CHECK(!xcsf.FAST_ACTIVATIONS);
+    /* Test selecting the approximations through the parameters */
+    param_json_import(&xcsf, "{\"fast_activations\": true}");
+    CHECK(xcsf.FAST_ACTIVATIONS);
+    char *json_str = param_json_export(&xcsf);
+    CHECK(strstr(json_str, "\"fast_activations\"") != NULL);
+    free(json_str);
+    /* Test the mode belongs to each instance */
+    struct XCSF other;
+    param_init(&other, 1, 1, 1);
+    CHECK(xcsf.FAST_ACTIVATIONS);
+    CHECK(!other.FAST_ACTIVATIONS);
+    param_set_fast_activations(&xcsf, false);
+    CHECK(!xcsf.FAST_ACTIVATIONS);
+    param_free(&other);
+    param_free(&xcsf);
 }
@@ -76,22 +76,23 @@ TEST_CASE("NEURAL_LAYER_CONNECTED")
     CHECK_EQ(l->momentum, 0.9);
 
     /* Test one forward pass of input */
-    const double x[10] = { -0.4792173279, -0.2056298252, -0.1775459629,
-                           -0.0814486626, 0.0923277094,  0.2779675621,
-                           -0.3109822596, -0.6788371120, -0.0714929928,
-                           -0.1332985280 };
+    const neural_real x[10] = { -0.4792173279, -0.2056298252,
+                                -0.1775459629, -0.0814486626,
+                                0.0923277094,  0.2779675621,
+                                -0.3109822596, -0.6788371120,
+                                -0.0714929928, -0.1332985280 };
     const double output[2] = { 0.7936726123, 0.0963342482 };
-    const double orig_weights[20] = {
+    const neural_real orig_weights[20] = {
         0.3326639519,  -0.4446678553, 0.1033557369,  -1.2581317787,
         2.8042169798,  0.2236021733,  -1.2206964138, -0.2022042865,
         -1.5489524535, -2.0932767781, 5.4797621223,  0.3326639519,
         -0.4446678553, 0.1033557369,  -1.2581317787, 2.8042169798,
         0.2236021733,  -1.2206964138, -0.2022042865, -1.5489524535
     };
-    const double orig_biases[2] = { 0.1033557369, -1.2581317787 };
+    const neural_real orig_biases[2] = { 0.1033557369, -1.2581317787 };
 
-    memcpy(l->weights, orig_weights, sizeof(double) * l->n_weights);
-    memcpy(l->biases, orig_biases, sizeof(double) * l->n_outputs);
+    memcpy(l->weights, orig_weights, sizeof(neural_real) * l->n_weights);
+    memcpy(l->biases, orig_biases, sizeof(neural_real) * l->n_outputs);
     neural_layer_connected_forward(l, &net, x);
     double output_error = 0;
     for (int i = 0; i < l->n_outputs; ++i) {
@@ -17,7 +17,7 @@
  * @file neural_layer_convolutional_test.cpp
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2020--2024.
+ * @date 2020--2026.
  * @brief Convolutional neural network layer tests.
  */
 
@@ -90,17 +90,19 @@ TEST_CASE("NEURAL_LAYER_CONVOLUTIONAL")
     CHECK_EQ(l->momentum, 0.9);
 
     /* Test one forward pass of input */
-    const double orig_weights[18] = { -0.3494757, 0.37103638,  0.43885502,
-                                      0.11762521, 0.35432652,  0.17391846,
-                                      0.46650133, -0.00751933, 0.01440367,
-                                      0.3583322,  0.3935847,   0.10529158,
-                                      0.28923538, -0.28357792, 0.14083597,
-                                      0.2338815,  -0.46515846, -0.36625803 };
-    const double orig_biases[2] = { 0, 0 };
-    const double x[16] = { 0.00003019, 0.00263328, 0.04917052, 0.28910958,
-                           0.59115183, 0.38058756, 0.08781348, 0.00530301,
-                           0.00006084, 0.00017717, 0.00943315, 0.13314144,
-                           0.50049726, 0.81313912, 0.8360666,  0.75973192 };
+    const neural_real orig_weights[18] = {
+        -0.3494757, 0.37103638,  0.43885502,  0.11762521, 0.35432652,
+        0.17391846, 0.46650133,  -0.00751933, 0.01440367, 0.3583322,
+        0.3935847,  0.10529158,  0.28923538,  -0.28357792, 0.14083597,
+        0.2338815,  -0.46515846, -0.36625803
+    };
+    const neural_real orig_biases[2] = { 0, 0 };
+    const neural_real x[16] = {
+        0.00003019, 0.00263328, 0.04917052, 0.28910958,
+        0.59115183, 0.38058756, 0.08781348, 0.00530301,
+        0.00006084, 0.00017717, 0.00943315, 0.13314144,
+        0.50049726, 0.81313912, 0.8360666,  0.75973192
+    };
     const double output[32] = { 0.,         0.,         0.20314004, 0.,
                                 0.23570573, 0.,         0.05324797, 0.07956585,
                                 0.15918063, 0.25231227, 0.33003914, 0.14661954,
@@ -119,12 +121,12 @@ TEST_CASE("NEURAL_LAYER_CONVOLUTIONAL")
             }
         }
     }
-    memcpy(l->biases, orig_biases, sizeof(double) * l->n_filters);
+    memcpy(l->biases, orig_biases, sizeof(neural_real) * l->n_filters);
     neural_layer_convolutional_forward(l, &net, x);
     double output_error = 0;
     index = 0;
 
-    const double *out = neural_layer_convolutional_output(l);
+    const neural_real *out = neural_layer_convolutional_output(l);
     for (int k = 0; k < l->out_h; ++k) {
         for (int j = 0; j < l->out_w; ++j) {
             for (int i = 0; i < l->out_c; ++i) {
@@ -238,10 +240,12 @@ TEST_CASE("NEURAL_LAYER_CONVOLUTIONAL")
     int n_filters = l->n_filters;
     int n_weights = l->n_weights;
     int n_biases = l->n_biases;
-    double *wc = (double *) malloc(sizeof(double) * l->n_weights);
-    double *bc = (double *) malloc(sizeof(double) * l->n_biases);
-    memcpy(wc, l->weights, sizeof(double) * l->n_weights);
-    memcpy(bc, l->biases, sizeof(double) * l->n_biases);
+    neural_real *wc =
+        (neural_real *) malloc(sizeof(neural_real) * l->n_weights);
+    neural_real *bc =
+        (neural_real *) malloc(sizeof(neural_real) * l->n_biases);
+    memcpy(wc, l->weights, sizeof(neural_real) * l->n_weights);
+    memcpy(bc, l->biases, sizeof(neural_real) * l->n_biases);
     CHECK(neural_layer_convolutional_mutate(l));
     int n = n_weights ? (n_weights < l->n_weights) : l->n_weights;
     for (int i = 0; i < n; ++i) {
@@ -279,3 +283,88 @@ TEST_CASE("NEURAL_LAYER_CONVOLUTIONAL")
     free(wc);
     free(bc);
 }
+
+/**
+ * @brief Returns the largest difference of each convolution algorithm from
+ * im2col() over one forward and backward pass of a layer.
+ * @param [in] size Kernel size.
+ * @param [in] stride Kernel stride.
+ * @param [in] pad Kernel padding.
+ * @return The largest absolute difference.
+ */
+static double
+conv_algorithm_error(const int size, const int stride, const int pad)
+{
+    struct ArgsLayer args;
+    layer_args_init(&args);
+    args.type = CONVOLUTIONAL;
+    args.function = LINEAR;
+    args.width = 9;
+    args.height = 7;
+    args.channels = 3;
+    args.n_init = 5;
+    args.n_max = 5;
+    args.size = size;
+    args.stride = stride;
+    args.pad = pad;
+    args.eta = 0.1;
+    args.sgd_weights = true;
+    layer_args_validate(&args);
+    struct Layer *l = layer_init(&args);
+    struct Net net;
+    neural_init(&net);
+    neural_real *x = (neural_real *) malloc(sizeof(neural_real) * l->n_inputs);
+    neural_real *err =
+        (neural_real *) malloc(sizeof(neural_real) * l->n_outputs);
+    for (int i = 0; i < l->n_inputs; ++i) {
+        x[i] = sin(0.7 * i);
+    }
+    for (int i = 0; i < l->n_outputs; ++i) {
+        err[i] = cos(0.3 * i);
+    }
+    const int n = l->n_outputs + l->n_weights + l->n_inputs;
+    double *ref = (double *) malloc(sizeof(double) * n);
+    neural_real *delta =
+        (neural_real *) malloc(sizeof(neural_real) * l->n_inputs);
+    double error = 0;
+    for (int algo = CONV_ALGO_IM2COL; algo <= CONV_ALGO_WINOGRAD; ++algo) {
+        neural_layer_convolutional_set_algorithm(algo);
+        memset(l->weight_updates, 0, sizeof(neural_real) * l->n_weights);
+        memset(delta, 0, sizeof(neural_real) * l->n_inputs);
+        neural_layer_convolutional_forward(l, &net, x);
+        memcpy(l->delta, err, sizeof(neural_real) * l->n_outputs);
+        neural_layer_convolutional_backward(l, &net, x, delta);
+        for (int i = 0; i < n; ++i) {
+            double v = 0;
+            if (i < l->n_outputs) {
+                v = l->output[i];
+            } else if (i < l->n_outputs + l->n_weights) {
+                v = l->weight_updates[i - l->n_outputs];
+            } else {
+                v = delta[i - l->n_outputs - l->n_weights];
+            }
+            if (algo == CONV_ALGO_IM2COL) {
+                ref[i] = v;
+            } else {
+                error = fmax(error, fabs(v - ref[i]));
+            }
+        }
+    }
+    neural_layer_convolutional_set_algorithm(CONV_ALGO_AUTO);
+    layer_delete(l);
+    free(x);
+    free(err);
+    free(ref);
+    free(delta);
+    return error;
+}
+
+TEST_CASE("NEURAL_LAYER_CONVOLUTIONAL_ALGORITHMS")
+{
+    /* Test direct and Winograd convolution match im2col */
+    CHECK(conv_algorithm_error(3, 1, 1) < 1e-4);
+    CHECK(conv_algorithm_error(3, 1, 0) < 1e-4);
+    CHECK(conv_algorithm_error(3, 2, 1) < 1e-4);
+    CHECK(conv_algorithm_error(5, 1, 2) < 1e-4);
+    CHECK(conv_algorithm_error(2, 1, 0) < 1e-4);
+}
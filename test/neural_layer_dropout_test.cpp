@@ -68,13 +68,13 @@ TEST_CASE("NEURAL_LAYER_DROPOUT")
     CHECK_EQ(l->max_outputs, 3);
     CHECK_EQ(l->probability, 0.5);
 
-    const double x[3] = { 0.2, 0.5, 0.3 };
+    const neural_real x[3] = { 0.2, 0.5, 0.3 };
 
     /* Test one forward pass of input when predicting */
     net.train = false;
     const double output1[3] = { 0.2, 0.5, 0.3 };
     neural_layer_dropout_forward(l, &net, x);
-    double *out = neural_layer_dropout_output(l);
+    neural_real *out = neural_layer_dropout_output(l);
     for (int i = 0; i < l->n_outputs; ++i) {
         CHECK_EQ(doctest::Approx(out[i]), output1[i]);
     }
@@ -89,7 +89,7 @@ TEST_CASE("NEURAL_LAYER_DROPOUT")
     }
 
     /* Test one backward pass of input */
-    double delta[3] = { 0.2, 0.3, 0 };
+    neural_real delta[3] = { 0.2, 0.3, 0 };
     double delta_prev[3] = { 0, 0.3, 0 };
     neural_layer_dropout_backward(l, &net, x, delta);
     for (int i = 0; i < 3; ++i) {
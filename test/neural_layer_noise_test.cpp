@@ -70,13 +70,13 @@ TEST_CASE("NEURAL_LAYER_NOISE")
     CHECK_EQ(l->probability, 0.5);
     CHECK_EQ(l->scale, 0.2);
 
-    const double x[3] = { 0.2, 0.5, 0.3 };
+    const neural_real x[3] = { 0.2, 0.5, 0.3 };
 
     /* Test one forward pass of input when predicting */
     net.train = false;
     const double output1[3] = { 0.2, 0.5, 0.3 };
     neural_layer_noise_forward(l, &net, x);
-    double *out = neural_layer_noise_output(l);
+    neural_real *out = neural_layer_noise_output(l);
     for (int i = 0; i < l->n_outputs; ++i) {
         CHECK_EQ(doctest::Approx(out[i]), output1[i]);
     }
@@ -91,7 +91,7 @@ TEST_CASE("NEURAL_LAYER_NOISE")
     }
 
     /* Test one backward pass of input */
-    double delta[3] = { 0.2, 0.3, 0.4 };
+    neural_real delta[3] = { 0.2, 0.3, 0.4 };
     double delta_prev[3] = { 0.2, 0.3, 0.4 };
     neural_layer_noise_backward(l, &net, x, delta);
     for (int i = 0; i < 3; ++i) {
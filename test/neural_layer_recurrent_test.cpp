@@ -77,7 +77,7 @@ TEST_CASE("NEURAL_LAYER_RECURRENT")
     CHECK_EQ(l->max_outputs, 1);
 
     /* test forward passing input */
-    const double x[1] = { 0.90598097 };
+    const neural_real x[1] = { 0.90598097 };
     const double orig_weights[2] = { -0.0735234, -1 };
     const double orig_biases[1] = { 0 };
     l->input_layer->weights[0] = orig_weights[0];
@@ -128,9 +128,10 @@ TEST_CASE("NEURAL_LAYER_RECURRENT")
     CHECK_EQ(doctest::Approx(l->output[0]), y[0]);
 
     /* Test mutation */
-    double *lw = (double *) malloc(sizeof(double) * l->input_layer->n_weights);
+    neural_real *lw = (neural_real *) malloc(sizeof(neural_real) *
+                                             l->input_layer->n_weights);
     memcpy(lw, l->input_layer->weights,
-           sizeof(double) * l->input_layer->n_weights);
+           sizeof(neural_real) * l->input_layer->n_weights);
     CHECK(neural_layer_recurrent_mutate(l));
     for (int i = 0; i < l->input_layer->n_weights; ++i) {
         CHECK(l->input_layer->weights[i] != lw[i]);
@@ -17,7 +17,7 @@
  * @file neural_test.cpp
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2020--2024.
+ * @date 2020--2026.
  * @brief Neural network tests.
  */
 
@@ -56,17 +56,17 @@ TEST_CASE("NEURAL")
                            -0.3109822596, -0.6788371120, -0.0714929928,
                            -0.1332985280 };
     const double output[2] = { 0.5804315660, 0.2146193788 };
-    const double orig_weights1[20] = {
+    const neural_real orig_weights1[20] = {
         0.3326639519,  -0.4446678553, 0.1033557369,  -1.2581317787,
         2.8042169798,  0.2236021733,  -1.2206964138, -0.2022042865,
         -1.5489524535, -2.0932767781, 5.4797621223,  0.3326639519,
         -0.4446678553, 0.1033557369,  -1.2581317787, 2.8042169798,
         0.2236021733,  -1.2206964138, -0.2022042865, -1.5489524535
     };
-    const double orig_biases1[2] = { 0.1033557369, -1.2581317787 };
-    const double orig_weights2[4] = { 0.3326639519, -0.4446678553, 0.1033557369,
-                                      -1.2581317787 };
-    const double orig_biases2[2] = { 0.1033557369, -1.2581317787 };
+    const neural_real orig_biases1[2] = { 0.1033557369, -1.2581317787 };
+    const neural_real orig_weights2[4] = { 0.3326639519, -0.4446678553,
+                                           0.1033557369, -1.2581317787 };
+    const neural_real orig_biases2[2] = { 0.1033557369, -1.2581317787 };
 
     neural_init(&net);
 
@@ -83,18 +83,18 @@ TEST_CASE("NEURAL")
     args.sgd_weights = true;
 
     l = layer_init(&args);
-    memcpy(l->weights, orig_weights1, sizeof(double) * l->n_weights);
-    memcpy(l->biases, orig_biases1, sizeof(double) * l->n_outputs);
+    memcpy(l->weights, orig_weights1, sizeof(neural_real) * l->n_weights);
+    memcpy(l->biases, orig_biases1, sizeof(neural_real) * l->n_outputs);
     neural_push(&net, l);
 
     args.n_inputs = 2;
 
     l = layer_init(&args);
-    memcpy(l->weights, orig_weights2, sizeof(double) * l->n_weights);
-    memcpy(l->biases, orig_biases2, sizeof(double) * l->n_outputs);
+    memcpy(l->weights, orig_weights2, sizeof(neural_real) * l->n_weights);
+    memcpy(l->biases, orig_biases2, sizeof(neural_real) * l->n_outputs);
     neural_push(&net, l);
 
-    neural_propagate(&net, x, false);
+    neural_propagate(&net, x, false, false);
     double output_error = 0;
     for (int i = 0; i < net.n_outputs; ++i) {
         output_error += fabs(neural_output(&net, i) - output[i]);
@@ -104,12 +104,29 @@ TEST_CASE("NEURAL")
     /* Test convergence on one input */
     const double y[2] = { 0.7343893899, 0.2289711363 };
     for (int i = 0; i < 200; ++i) {
-        neural_propagate(&net, x, false);
+        neural_propagate(&net, x, false, false);
         neural_learn(&net, y, x);
     }
     CHECK_EQ(doctest::Approx(neural_output(&net, 0)), y[0]);
     CHECK_EQ(doctest::Approx(neural_output(&net, 1)), y[1]);
 
+    /* Test copies packed into an arena and copies of packed networks */
+    struct Net copy;
+    struct Net copy2;
+    neural_copy(&copy, &net);
+    CHECK(copy.arena != NULL);
+    neural_copy(&copy2, &copy);
+    CHECK(copy2.arena != copy.arena);
+    neural_propagate(&net, x, false, false);
+    neural_propagate(&copy, x, false, false);
+    neural_propagate(&copy2, x, false, false);
+    for (int i = 0; i < net.n_outputs; ++i) {
+        CHECK_EQ(neural_output(&copy, i), neural_output(&net, i));
+        CHECK_EQ(neural_output(&copy2, i), neural_output(&net, i));
+    }
+    neural_free(&copy);
+    neural_free(&copy2);
+
     /* Smoke test export */
     char *str = neural_json_export(&net, true);
     CHECK(str != NULL);
@@ -17,17 +17,22 @@
  * @file pa_test.cpp
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2022--2024.
+ * @date 2022--2026.
  * @brief Prediction array tests.
  */
 
 #include "../lib/doctest/doctest/doctest.h"
 
 extern "C" {
+#include "../xcsf/cl.h"
+#include "../xcsf/clset.h"
 #include "../xcsf/pa.h"
 #include "../xcsf/param.h"
+#include "../xcsf/pred_nlms.h"
+#include "../xcsf/prediction.h"
 #include "../xcsf/utils.h"
 #include "../xcsf/xcsf.h"
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -64,3 +69,100 @@ TEST_CASE("PA")
 
     param_free(&xcsf);
 }
+
+TEST_CASE("PA_LINEAR")
+{
+    /* test the predictions of a match set of least squares rules */
+    struct XCSF xcsf;
+    param_init(&xcsf, 3, 2, 1);
+    param_set_random_state(&xcsf, 1);
+    pred_param_set_type(&xcsf, PRED_TYPE_NLMS_QUADRATIC);
+    xcsf_init(&xcsf);
+    const double x[3] = { 0.25, -0.5, 0.75 };
+    /* small sets are fused with the accumulation, large ones may not be */
+    const int sizes[2] = { 7, 300 };
+    for (int s = 0; s < 2; ++s) {
+        const int n_rules = sizes[s];
+        for (int i = 0; i < n_rules; ++i) {
+            struct Cl *c = (struct Cl *) malloc(sizeof(struct Cl));
+            cl_init(&xcsf, c, 1, 1);
+            cl_rand(&xcsf, c);
+            struct PredNLMS *p = (struct PredNLMS *) c->pred;
+            for (int j = 0; j < p->n_weights; ++j) {
+                p->weights[j] = sin(0.7 * j + i);
+            }
+            c->fit = 0.1 + i;
+            clset_add(&xcsf.mset, c);
+        }
+        pa_build(&xcsf, x);
+        double *pred = (double *) malloc(sizeof(double) * n_rules * 2);
+        for (int i = 0; i < n_rules; ++i) {
+            memcpy(&pred[i * 2], xcsf.mset.cl[i]->prediction,
+                   sizeof(double) * 2);
+        }
+        for (int j = 0; j < 2; ++j) {
+            double pa = 0;
+            double nr = 0;
+            for (int i = 0; i < n_rules; ++i) {
+                const struct Cl *c = xcsf.mset.cl[i];
+                pred_compute(&xcsf, c, x);
+                CHECK_EQ(doctest::Approx(pred[i * 2 + j]), c->prediction[j]);
+                pa += c->prediction[j] * c->fit;
+                nr += c->fit;
+            }
+            CHECK_EQ(doctest::Approx(xcsf.pa[j]), pa / nr);
+        }
+        for (int i = 0; i < n_rules; ++i) {
+            cl_free(&xcsf, xcsf.mset.cl[i]);
+        }
+        clset_clear(&xcsf.mset);
+        free(pred);
+    }
+    xcsf_free(&xcsf);
+    param_free(&xcsf);
+}
+
+TEST_CASE("PA_ACCUMULATE")
+{
+    /* test many outputs accumulate exactly as a serial pass in set order */
+    struct XCSF xcsf;
+    const int y_dim = 1000;
+    const int n_rules = 9;
+    param_init(&xcsf, 1, y_dim, 1);
+    param_set_random_state(&xcsf, 1);
+    pred_param_set_type(&xcsf, PRED_TYPE_CONSTANT);
+    xcsf_init(&xcsf);
+    for (int i = 0; i < n_rules; ++i) {
+        struct Cl *c = (struct Cl *) malloc(sizeof(struct Cl));
+        cl_init(&xcsf, c, 1, 1);
+        cl_rand(&xcsf, c);
+        // products are exact so that contracting to FMA cannot round them
+        for (int j = 0; j < y_dim; ++j) {
+            c->prediction[j] = floor(1024 * sin(0.37 * j + 1.3 * i)) / 1024;
+        }
+        c->fit = 1.0 / (1 << i);
+        clset_add(&xcsf.mset, c);
+    }
+    const double x[1] = { 0.5 };
+    pa_build(&xcsf, x);
+    int mismatches = 0;
+    for (int j = 0; j < y_dim; ++j) {
+        double pa = 0;
+        double nr = 0;
+        for (int i = 0; i < n_rules; ++i) {
+            const struct Cl *c = xcsf.mset.cl[i];
+            pa += c->prediction[j] * c->fit;
+            nr += c->fit;
+        }
+        if (xcsf.pa[j] != pa / nr || xcsf.nr[j] != nr) {
+            ++mismatches;
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+    for (int i = 0; i < n_rules; ++i) {
+        cl_free(&xcsf, xcsf.mset.cl[i]);
+    }
+    clset_clear(&xcsf.mset);
+    xcsf_free(&xcsf);
+    param_free(&xcsf);
+}
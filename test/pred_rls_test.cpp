@@ -17,7 +17,7 @@
  * @file pred_rls_test.cpp
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2020--2024.
+ * @date 2020--2026.
  * @brief Recursive least mean squares unit tests.
  */
 
@@ -144,7 +144,11 @@ TEST_CASE("PRED_RLS")
         -107.2811462280, -36.0167269681,  -139.7579702419, 33.3919016747,
         938.8736130242
     };
-    memcpy(p->matrix, orig_matrix, sizeof(double) * 121);
+    for (int i = 0; i < 11; ++i) {
+        for (int j = 0; j < 11; ++j) {
+            p->matrix[pred_rls_matrix_index(11, i, j)] = orig_matrix[i * 11 + j];
+        }
+    }
     pred_rls_update(&xcsf, c, x, y);
     double weight_error = 0;
     for (int i = 0; i < 11; ++i) {
@@ -152,8 +156,11 @@ TEST_CASE("PRED_RLS")
     }
     CHECK_EQ(doctest::Approx(weight_error), 0);
     double matrix_error = 0;
-    for (int i = 0; i < 121; ++i) {
-        matrix_error += fabs(p->matrix[i] - new_matrix[i]);
+    for (int i = 0; i < 11; ++i) {
+        for (int j = 0; j < 11; ++j) {
+            matrix_error += fabs(p->matrix[pred_rls_matrix_index(11, i, j)] -
+                                 new_matrix[i * 11 + j]);
+        }
     }
     CHECK_EQ(doctest::Approx(matrix_error), 0);
 
@@ -17,7 +17,7 @@
  * @file util_test.cpp
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2020--2022.
+ * @date 2020--2026.
  * @brief Utility tests.
  */
 
@@ -31,6 +31,10 @@ extern "C" {
 #include <string.h>
 }
 
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
 TEST_CASE("UTIL")
 {
     rand_init();
@@ -98,3 +102,102 @@ TEST_CASE("UTIL")
     max = argmax(x, 5);
     CHECK_EQ(max, 4);
 }
+
+#ifdef _OPENMP
+/**
+ * @brief Draws random numbers from within a parallel region of two threads.
+ * @param [out] draws The numbers drawn by thread t in draws[t * n].
+ * @param [in] n The number of draws made by each thread.
+ */
+static void
+rand_draw_threads(double *draws, const int n)
+{
+    #pragma omp parallel num_threads(2)
+    {
+        const int t = omp_get_thread_num();
+        for (int i = 0; i < n; ++i) {
+            draws[t * n + i] = rand_uniform(0, 1);
+        }
+    }
+}
+#endif
+
+TEST_CASE("RAND_STREAMS")
+{
+#ifdef _OPENMP
+    const int n = 100;
+    double a[2 * n];
+    double b[2 * n];
+    omp_set_dynamic(0);
+    rand_init_seed(1);
+    const double serial = rand_uniform(0, 1);
+    rand_init_seed(1);
+    rand_draw_threads(a, n);
+    // each thread draws from its own stream
+    CHECK(!check_array_eq(a, &a[n], n));
+    // streams are not shared with the serial generator
+    CHECK_EQ(rand_uniform(0, 1), serial);
+    // streams continue across parallel regions
+    rand_draw_threads(b, n);
+    CHECK(!check_array_eq(a, b, n));
+    CHECK(!check_array_eq(&a[n], &b[n], n));
+    // freeing the thread pools does not restart the streams
+    thread_pool_free();
+    rand_draw_threads(b, n);
+    CHECK(!check_array_eq(a, b, n));
+    CHECK(!check_array_eq(&a[n], &b[n], n));
+    // reseeding restarts the streams
+    rand_init_seed(1);
+    rand_draw_threads(b, n);
+    CHECK(check_array_eq(a, b, 2 * n));
+    // streams depend on the seed
+    rand_init_seed(2);
+    rand_draw_threads(b, n);
+    CHECK(!check_array_eq(a, b, n));
+    CHECK(!check_array_eq(&a[n], &b[n], n));
+#endif
+}
+
+TEST_CASE("THREAD_POOL")
+{
+    // storage is zeroed when allocated and kept while the pool does not grow
+    thread_pool_free();
+    int *p = (int *) thread_pool(THREAD_POOL_PRED, sizeof(int) * 4);
+    CHECK_EQ(p[3], 0);
+    p[3] = 7;
+    CHECK_EQ(thread_pool(THREAD_POOL_PRED, sizeof(int) * 2), p);
+    CHECK_EQ(p[3], 7);
+    // pools are independent of each other
+    CHECK(thread_pool(THREAD_POOL_LAYER, sizeof(int) * 4) != p);
+    // freeing releases the pools and the next request is zeroed
+    thread_pool_free();
+    p = (int *) thread_pool(THREAD_POOL_PRED, sizeof(int) * 4);
+    CHECK_EQ(p[3], 0);
+#ifdef _OPENMP
+    // each thread of a team has its own pool, including within nested regions
+    // where every thread is number 0 of its inner team
+    const int n = 4;
+    void *outer_pools[n];
+    void *inner_pools[n];
+    const int levels = omp_get_max_active_levels();
+    omp_set_dynamic(0);
+    omp_set_max_active_levels(1);
+    #pragma omp parallel num_threads(n)
+    {
+        const int t = omp_get_thread_num();
+        outer_pools[t] = thread_pool(THREAD_POOL_PRED, sizeof(int));
+        #pragma omp parallel num_threads(n)
+        {
+            inner_pools[t] = thread_pool(THREAD_POOL_PRED, sizeof(int));
+        }
+    }
+    omp_set_max_active_levels(levels);
+    for (int i = 0; i < n; ++i) {
+        CHECK_EQ(inner_pools[i], outer_pools[i]);
+        for (int j = i + 1; j < n; ++j) {
+            CHECK(outer_pools[i] != outer_pools[j]);
+        }
+    }
+#endif
+    thread_pool_free();
+}
@@ -17,15 +17,19 @@
  * @file xcs_supervised_test.cpp
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2023--2024.
+ * @date 2023--2026.
  * @brief High-level supervised learning function tests.
  */
 
 #include "../lib/doctest/doctest/doctest.h"
 
 extern "C" {
+#include "../xcsf/blas.h"
+#include "../xcsf/clset.h"
+#include "../xcsf/condition.h"
 #include "../xcsf/pa.h"
 #include "../xcsf/param.h"
+#include "../xcsf/prediction.h"
 #include "../xcsf/utils.h"
 #include "../xcsf/xcs_supervised.h"
 #include "../xcsf/xcsf.h"
@@ -92,3 +96,138 @@ TEST_CASE("SUPERVISED")
     free(cover);
     free(output);
 }
+
+TEST_CASE("SUPERVISED_PREDICT_BLOCK")
+{
+    /* Test that predicting in blocks matches predicting each row */
+    blas_set_backend(BLAS_BACKEND_BUILTIN);
+    const int n_samples = 150;
+    const int x_dim = 3;
+    const int y_dim = 2;
+    const int n_types = 5;
+    const int cond_types[5] = { COND_TYPE_HYPERRECTANGLE_CSR,
+                                COND_TYPE_HYPERRECTANGLE_CSR,
+                                COND_TYPE_HYPERELLIPSOID, COND_TYPE_TERNARY,
+                                COND_TYPE_GP };
+    const int pred_types[5] = { PRED_TYPE_CONSTANT, PRED_TYPE_NLMS_LINEAR,
+                                PRED_TYPE_RLS_QUADRATIC, PRED_TYPE_NLMS_LINEAR,
+                                PRED_TYPE_NLMS_LINEAR };
+    double *x = (double *) malloc(sizeof(double) * n_samples * x_dim);
+    double *y = (double *) malloc(sizeof(double) * n_samples * y_dim);
+    double *output = (double *) malloc(sizeof(double) * n_samples * y_dim);
+    double cover[2] = { -1, -2 };
+    for (int t = 0; t < n_types; ++t) {
+        struct XCSF xcsf;
+        param_init(&xcsf, x_dim, y_dim, 1);
+        param_set_random_state(&xcsf, 1);
+        param_set_pop_size(&xcsf, 200);
+        cond_param_set_type(&xcsf, cond_types[t]);
+        pred_param_set_type(&xcsf, pred_types[t]);
+        xcsf_init(&xcsf);
+        for (int i = 0; i < n_samples * x_dim; ++i) {
+            x[i] = rand_uniform(0, 1);
+        }
+        for (int i = 0; i < n_samples * y_dim; ++i) {
+            y[i] = rand_uniform(0, 1);
+        }
+        struct Input data;
+        data.n_samples = n_samples;
+        data.x_dim = x_dim;
+        data.y_dim = y_dim;
+        data.x = x;
+        data.y = y;
+        xcs_supervised_fit(&xcsf, &data, NULL, true, 0, 500);
+        // shift the inputs so that some rows are not matched
+        for (int i = 0; i < n_samples * x_dim; ++i) {
+            x[i] = rand_uniform(-0.5, 1.5);
+        }
+        const struct Cl *c = xcsf.pset.cl[0];
+        const int age = c->age;
+        const int mtotal = c->mtotal;
+        const double mset_size = xcsf.mset_size;
+        xcs_supervised_predict(&xcsf, x, output, n_samples, cover);
+        const int block_age = c->age;
+        const int block_mtotal = c->mtotal;
+        const double block_mset_size = xcsf.mset_size;
+        xcsf.mset_size = mset_size;
+        int mismatches = 0;
+        for (int row = 0; row < n_samples; ++row) {
+            clset_clear(&xcsf.mset);
+            clset_match(&xcsf, &x[row * x_dim], false);
+            if (xcsf.mset.size < 1) {
+                memcpy(xcsf.pa, cover, sizeof(double) * y_dim);
+            } else {
+                pa_build(&xcsf, &x[row * x_dim]);
+            }
+            for (int j = 0; j < y_dim; ++j) {
+                if (output[row * y_dim + j] != xcsf.pa[j]) {
+                    ++mismatches;
+                }
+            }
+        }
+        clset_clear(&xcsf.mset);
+        CHECK_EQ(mismatches, 0);
+        // statistics are updated as if each row was a trial
+        CHECK_EQ(block_age - age, n_samples);
+        CHECK_EQ(c->age - block_age, n_samples);
+        CHECK_EQ(block_mtotal - mtotal, c->mtotal - block_mtotal);
+        CHECK_EQ(xcsf.mset_size, block_mset_size);
+        xcsf_free(&xcsf);
+        param_free(&xcsf);
+    }
+    free(x);
+    free(y);
+    free(output);
+    /* restore the default backend */
+    blas_set_backend(BLAS_BACKEND_CBLAS);
+}
+
+/**
+ * @brief Fits a population with a fixed seed and predicts the training data.
+ * @param [in] x The input feature variables.
+ * @param [in] y The labelled variables.
+ * @param [in] n_samples The number of instances.
+ * @param [out] output The predictions.
+ */
+static void
+supervised_seeded_run(double *x, double *y, const int n_samples,
+                      double *output)
+{
+    struct XCSF xcsf;
+    param_init(&xcsf, 3, 1, 1);
+    param_set_random_state(&xcsf, 7);
+    param_set_pop_size(&xcsf, 100);
+    xcsf_init(&xcsf);
+    struct Input data;
+    data.n_samples = n_samples;
+    data.x_dim = 3;
+    data.y_dim = 1;
+    data.x = x;
+    data.y = y;
+    xcs_supervised_fit(&xcsf, &data, NULL, true, 0, 300);
+    xcs_supervised_predict(&xcsf, x, output, n_samples, NULL);
+    xcsf_free(&xcsf);
+    param_free(&xcsf);
+}
+
+TEST_CASE("SUPERVISED_REPRODUCIBLE")
+{
+    /* Test that two runs with the same seed agree */
+    const int n_samples = 50;
+    double x[150];
+    double y[50];
+    double output1[50];
+    double output2[50];
+    rand_init_seed(3);
+    for (int i = 0; i < n_samples * 3; ++i) {
+        x[i] = rand_uniform(0, 1);
+    }
+    for (int i = 0; i < n_samples; ++i) {
+        y[i] = x[i * 3] * x[i * 3 + 1];
+    }
+    supervised_seeded_run(x, y, n_samples, output1);
+    supervised_seeded_run(x, y, n_samples, output2);
+    for (int i = 0; i < n_samples; ++i) {
+        CHECK_EQ(output1[i], output2[i]);
+    }
+}
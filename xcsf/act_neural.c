@@ -92,7 +92,7 @@ bool
 act_neural_mutate(const struct XCSF *xcsf, const struct Cl *c)
 {
     (void) xcsf;
-    const struct ActNeural *act = c->act;
+    struct ActNeural *act = c->act;
     return neural_mutate(&act->net);
 }
 
@@ -107,9 +107,15 @@ int
 act_neural_compute(const struct XCSF *xcsf, const struct Cl *c, const double *x)
 {
     struct ActNeural *act = c->act;
-    neural_propagate(&act->net, x, xcsf->explore);
-    const double *outputs = neural_outputs(&act->net);
-    return argmax(outputs, xcsf->n_actions);
+    neural_propagate(&act->net, x, xcsf->explore, xcsf->FAST_ACTIVATIONS);
+    const neural_real *outputs = neural_outputs(&act->net);
+    int action = 0;
+    for (int i = 1; i < xcsf->n_actions; ++i) {
+        if (outputs[i] > outputs[action]) {
+            action = i;
+        }
+    }
+    return action;
 }
 
 /**
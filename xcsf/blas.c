@@ -17,196 +17,1673 @@
  * @file blas.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2020.
+ * @date 2020--2026.
  * @brief Basic linear algebra functions.
  */
 
 #include "blas.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
-static void
+#ifdef CBLAS
+    #ifdef CBLAS_MKL
+        #include <mkl.h>
+    #else
+        #include <cblas.h>
+    #endif
+    #ifdef PARALLEL
+        #include <omp.h>
+    #endif
+#endif
+
+#define GEMM_MR (6) //!< Rows of C computed by the micro-kernel
+#define GEMM_NR (8) //!< Columns of C computed by the micro-kernel
+#define GEMM_KC (256) //!< Depth of the packed panels
+#define GEMM_MC (120) //!< Rows of the packed panel of A
+#define GEMM_NC (2048) //!< Columns of the packed panel of B
+#define GEMM_MIN_BLOCKED (32768) //!< Fewest multiply-adds to use blocking
+#define GEMV_ROWS (8) //!< Rows of A summed together by the GEMV kernel
+#define GEMV_RUN (8) //!< Inactive connections skipped at once by sparse GEMV
+
+#if defined(__FMA__) || defined(__ARM_FEATURE_FMA)
+    #define BLAS_FMA (true) //!< Whether the build targets fused multiply-add
+#else
+    #define BLAS_FMA (false) //!< Whether the build targets fused multiply-add
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define BLAS_DISPATCH
+    #define BLAS_INLINE inline __attribute__((always_inline))
+    #define BLAS_KERNEL __attribute__((noinline))
+    #define BLAS_TARGET(isa) __attribute__((target(isa)))
+#else
+    #define BLAS_INLINE inline
+    #define BLAS_KERNEL
+#endif
+
+#ifdef BLAS_DISPATCH
+/**
+ * @brief Four doubles held in a 256-bit register.
+ */
+typedef double blas_v4d
+    __attribute__((vector_size(4 * sizeof(double)), aligned(sizeof(double))));
+
+/**
+ * @brief Eight doubles held in a 512-bit register.
+ */
+typedef double blas_v8d
+    __attribute__((vector_size(8 * sizeof(double)), aligned(sizeof(double))));
+#endif
+
+/**
+ * @brief Linear algebra backend interface.
+ */
+struct BlasVtbl {
+    void (*blas_impl_gemm)(const int TA, const int TB, const int M,
+                           const int N, const int K, const double ALPHA,
+                           const double *A, const int lda, const double *B,
+                           const int ldb, const double BETA, double *C,
+                           const int ldc);
+    void (*blas_impl_gemv)(const int TA, const int M, const int N,
+                           const double ALPHA, const double *A, const int lda,
+                           const double *X, const int INCX, const double BETA,
+                           double *Y, const int INCY);
+    void (*blas_impl_ger)(const int M, const int N, const double ALPHA,
+                          const double *X, const int INCX, const double *Y,
+                          const int INCY, double *A, const int lda);
+    void (*blas_impl_axpy)(const int N, const double ALPHA, const double *X,
+                           const int INCX, double *Y, const int INCY);
+    double (*blas_impl_dot)(const int N, const double *X, const int INCX,
+                            const double *Y, const int INCY);
+    void (*blas_impl_scal)(const int N, const double ALPHA, double *X,
+                           const int INCX);
+};
+
+/**
+ * @brief Instruction sets for which kernels are compiled.
+ */
+enum BlasIsa {
+    BLAS_ISA_GENERIC, //!< Instructions enabled for the whole build
+    BLAS_ISA_AVX2, //!< AVX2 with FMA
+    BLAS_ISA_AVX512 //!< AVX-512 with FMA
+};
+
+/**
+ * @brief Returns the widest instruction set supported by the processor.
+ * @return The instruction set.
+ */
+static enum BlasIsa
+blas_isa(void)
+{
+#ifdef BLAS_DISPATCH
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("fma")) {
+        return BLAS_ISA_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return BLAS_ISA_AVX2;
+    }
+#endif
+    return BLAS_ISA_GENERIC;
+}
+
+/**
+ * @brief Returns x × y + z.
+ * @details Whether the product is rounded is fixed by the caller rather than
+ * left to the compiler, so that every kernel rounds the same way.
+ * @param [in] x First factor.
+ * @param [in] y Second factor.
+ * @param [in] z Addend.
+ * @param [in] fused Whether to use a fused multiply-add.
+ * @return The result.
+ */
+static BLAS_INLINE double
+madd(const double x, const double y, const double z, const bool fused)
+{
+    if (fused) {
+        return fma(x, y, z);
+    }
+    return z + x * y;
+}
+
+/**
+ * @brief Micro-kernel multiplying a packed row panel by a packed column panel.
+ */
+typedef void (*gemm_kernel_fn)(const int kc, const double *pa,
+                               const double *pb, double *C, const int ldc,
+                               const int mr, const int nr, const bool resume);
+
+static BLAS_INLINE void
 gemm_nn(const int M, const int N, const int K, const double ALPHA,
         const double *A, const int lda, const double *B, const int ldb,
         double *C, const int ldc)
 {
-    for (int i = 0; i < M; ++i) {
-        for (int k = 0; k < K; ++k) {
-            const double A_PART = ALPHA * A[i * lda + k];
-            for (int j = 0; j < N; ++j) {
-                C[i * ldc + j] += A_PART * B[k * ldb + j];
+    for (int i = 0; i < M; ++i) {
+        for (int k = 0; k < K; ++k) {
+            const double A_PART = ALPHA * A[i * lda + k];
+            for (int j = 0; j < N; ++j) {
+                C[i * ldc + j] += A_PART * B[k * ldb + j];
+            }
+        }
+    }
+}
+
+static BLAS_INLINE void
+gemm_nt(const int M, const int N, const int K, const double ALPHA,
+        const double *A, const int lda, const double *B, const int ldb,
+        double *C, const int ldc, const bool fused)
+{
+    for (int i = 0; i < M; ++i) {
+        for (int j = 0; j < N; ++j) {
+            double sum = 0;
+            for (int k = 0; k < K; ++k) {
+                sum = madd(A[i * lda + k], B[j * ldb + k], sum, fused);
+            }
+            C[i * ldc + j] += ALPHA * sum;
+        }
+    }
+}
+
+static BLAS_INLINE void
+gemm_tn(const int M, const int N, const int K, const double ALPHA,
+        const double *A, const int lda, const double *B, const int ldb,
+        double *C, const int ldc)
+{
+    for (int i = 0; i < M; ++i) {
+        for (int k = 0; k < K; ++k) {
+            const double A_PART = ALPHA * A[k * lda + i];
+            for (int j = 0; j < N; ++j) {
+                C[i * ldc + j] += A_PART * B[k * ldb + j];
+            }
+        }
+    }
+}
+
+static BLAS_INLINE void
+gemm_tt(const int M, const int N, const int K, const double ALPHA,
+        const double *A, const int lda, const double *B, const int ldb,
+        double *C, const int ldc, const bool fused)
+{
+    for (int i = 0; i < M; ++i) {
+        for (int j = 0; j < N; ++j) {
+            double sum = 0;
+            for (int k = 0; k < K; ++k) {
+                sum = madd(A[i + k * lda], B[k + j * ldb], sum, fused);
+            }
+            C[i * ldc + j] += ALPHA * sum;
+        }
+    }
+}
+
+/**
+ * @brief Packs a block of op(A), scaled by ALPHA, into row panels.
+ * @details Each panel holds GEMM_MR rows stored column by column; rows beyond
+ * the block are zero.
+ * @param [in] TA Whether A is transposed.
+ * @param [in] mc Number of rows in the block.
+ * @param [in] kc Number of columns in the block.
+ * @param [in] ALPHA Scalar used for multiplication.
+ * @param [in] A The first element of the block.
+ * @param [in] lda Leading dimension of A.
+ * @param [out] pa The packed panels.
+ */
+static BLAS_INLINE void
+gemm_pack_a(const int TA, const int mc, const int kc, const double ALPHA,
+            const double *A, const int lda, double *pa)
+{
+    for (int p = 0; p < mc; p += GEMM_MR) {
+        const int mr = (mc - p < GEMM_MR) ? mc - p : GEMM_MR;
+        for (int k = 0; k < kc; ++k) {
+            for (int i = 0; i < GEMM_MR; ++i) {
+                double v = 0;
+                if (i < mr) {
+                    v = TA ? A[k * lda + p + i] : A[(p + i) * lda + k];
+                }
+                pa[i] = ALPHA * v;
+            }
+            pa += GEMM_MR;
+        }
+    }
+}
+
+/**
+ * @brief Packs a block of op(B) into column panels.
+ * @details Each panel holds GEMM_NR columns stored row by row; columns beyond
+ * the block are zero.
+ * @param [in] TB Whether B is transposed.
+ * @param [in] kc Number of rows in the block.
+ * @param [in] nc Number of columns in the block.
+ * @param [in] B The first element of the block.
+ * @param [in] ldb Leading dimension of B.
+ * @param [out] pb The packed panels.
+ */
+static BLAS_INLINE void
+gemm_pack_b(const int TB, const int kc, const int nc, const double *B,
+            const int ldb, double *pb)
+{
+    for (int p = 0; p < nc; p += GEMM_NR) {
+        const int nr = (nc - p < GEMM_NR) ? nc - p : GEMM_NR;
+        for (int k = 0; k < kc; ++k) {
+            for (int j = 0; j < GEMM_NR; ++j) {
+                double v = 0;
+                if (j < nr) {
+                    v = TB ? B[(p + j) * ldb + k] : B[k * ldb + p + j];
+                }
+                pb[j] = v;
+            }
+            pb += GEMM_NR;
+        }
+    }
+}
+
+/**
+ * @brief Accumulates the product of a packed row panel and a packed column
+ * panel into a tile.
+ * @param [in] kc Depth of the panels.
+ * @param [in] pa Packed row panel.
+ * @param [in] pb Packed column panel.
+ * @param [in,out] tile The GEMM_MR × GEMM_NR tile.
+ */
+static BLAS_INLINE void
+gemm_tile(const int kc, const double *pa, const double *pb,
+          double tile[GEMM_MR][GEMM_NR])
+{
+    for (int k = 0; k < kc; ++k) {
+        for (int i = 0; i < GEMM_MR; ++i) {
+            for (int j = 0; j < GEMM_NR; ++j) {
+                tile[i][j] += pa[k * GEMM_MR + i] * pb[k * GEMM_NR + j];
+            }
+        }
+    }
+}
+
+#ifdef BLAS_DISPATCH
+
+/**
+ * @brief Accumulates a tile in 256-bit registers.
+ * @details Each row of the tile is held in two vectors.
+ * @param [in] kc Depth of the panels.
+ * @param [in] pa Packed row panel.
+ * @param [in] pb Packed column panel.
+ * @param [in,out] tile The GEMM_MR × GEMM_NR tile.
+ */
+static BLAS_INLINE void
+gemm_tile_v4d(const int kc, const double *pa, const double *pb,
+              double tile[GEMM_MR][GEMM_NR])
+{
+    blas_v4d lo[GEMM_MR];
+    blas_v4d hi[GEMM_MR];
+    for (int i = 0; i < GEMM_MR; ++i) {
+        lo[i] = *(const blas_v4d *) &tile[i][0];
+        hi[i] = *(const blas_v4d *) &tile[i][4];
+    }
+    for (int k = 0; k < kc; ++k) {
+        const blas_v4d b0 = *(const blas_v4d *) &pb[k * GEMM_NR];
+        const blas_v4d b1 = *(const blas_v4d *) &pb[k * GEMM_NR + 4];
+        for (int i = 0; i < GEMM_MR; ++i) {
+            lo[i] += pa[k * GEMM_MR + i] * b0;
+            hi[i] += pa[k * GEMM_MR + i] * b1;
+        }
+    }
+    for (int i = 0; i < GEMM_MR; ++i) {
+        *(blas_v4d *) &tile[i][0] = lo[i];
+        *(blas_v4d *) &tile[i][4] = hi[i];
+    }
+}
+
+/**
+ * @brief Accumulates a tile in 512-bit registers.
+ * @details Each row of the tile is held in one vector.
+ * @param [in] kc Depth of the panels.
+ * @param [in] pa Packed row panel.
+ * @param [in] pb Packed column panel.
+ * @param [in,out] tile The GEMM_MR × GEMM_NR tile.
+ */
+static BLAS_INLINE void
+gemm_tile_v8d(const int kc, const double *pa, const double *pb,
+              double tile[GEMM_MR][GEMM_NR])
+{
+    blas_v8d acc[GEMM_MR];
+    for (int i = 0; i < GEMM_MR; ++i) {
+        acc[i] = *(const blas_v8d *) tile[i];
+    }
+    for (int k = 0; k < kc; ++k) {
+        const blas_v8d b = *(const blas_v8d *) &pb[k * GEMM_NR];
+        for (int i = 0; i < GEMM_MR; ++i) {
+            acc[i] += pa[k * GEMM_MR + i] * b;
+        }
+    }
+    for (int i = 0; i < GEMM_MR; ++i) {
+        *(blas_v8d *) tile[i] = acc[i];
+    }
+}
+
+#endif
+
+/**
+ * @brief Multiplies a packed row panel by a packed column panel.
+ * @details The GEMM_MR × GEMM_NR tile is accumulated in registers of the
+ * given width. For the first block of depth the sum starts from zero and is
+ * added to C; later blocks continue from C, so that with BETA = 0 each element
+ * is summed in the same order as a dot product. Where fused multiply-add is
+ * enabled the compiler contracts the multiply-adds, as madd() does.
+ * @param [in] kc Depth of the panels.
+ * @param [in] pa Packed row panel.
+ * @param [in] pb Packed column panel.
+ * @param [in,out] C The first element of the tile.
+ * @param [in] ldc Leading dimension of C.
+ * @param [in] mr Number of rows of the tile within C.
+ * @param [in] nr Number of columns of the tile within C.
+ * @param [in] resume Whether to continue from the values in C.
+ * @param [in] width Number of doubles per vector register, or 1 for scalars.
+ */
+static BLAS_INLINE void
+gemm_kernel_body(const int kc, const double *pa, const double *pb, double *C,
+                 const int ldc, const int mr, const int nr, const bool resume,
+                 const int width)
+{
+    double tile[GEMM_MR][GEMM_NR] = { { 0 } };
+    if (resume) {
+        for (int i = 0; i < mr; ++i) {
+            for (int j = 0; j < nr; ++j) {
+                tile[i][j] = C[i * ldc + j];
+            }
+        }
+    }
+#ifdef BLAS_DISPATCH
+    if (width == 8) {
+        gemm_tile_v8d(kc, pa, pb, tile);
+    } else if (width == 4) {
+        gemm_tile_v4d(kc, pa, pb, tile);
+    } else {
+        gemm_tile(kc, pa, pb, tile);
+    }
+#else
+    (void) width;
+    gemm_tile(kc, pa, pb, tile);
+#endif
+    for (int i = 0; i < mr; ++i) {
+        for (int j = 0; j < nr; ++j) {
+            if (resume) {
+                C[i * ldc + j] = tile[i][j];
+            } else {
+                C[i * ldc + j] += tile[i][j];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Performs C += ALPHA op(A) op(B) with cache blocking.
+ * @details Panels of op(B) sized for the last level cache and of op(A) sized
+ * for the L2 cache are packed so that the micro-kernel streams through
+ * contiguous memory whatever the transposition.
+ */
+static BLAS_INLINE void
+gemm_blocked(const int TA, const int TB, const int M, const int N,
+             const int K, const double ALPHA, const double *A, const int lda,
+             const double *B, const int ldb, double *C, const int ldc,
+             const gemm_kernel_fn kernel)
+{
+    const int mc_max = (M < GEMM_MC) ? M : GEMM_MC;
+    const int kc_max = (K < GEMM_KC) ? K : GEMM_KC;
+    const int nc_max = (N < GEMM_NC) ? N : GEMM_NC;
+    const int mp = (mc_max + GEMM_MR - 1) / GEMM_MR * GEMM_MR;
+    const int np = (nc_max + GEMM_NR - 1) / GEMM_NR * GEMM_NR;
+    double *pa = malloc(sizeof(double) * mp * kc_max);
+    double *pb = malloc(sizeof(double) * np * kc_max);
+    for (int jc = 0; jc < N; jc += GEMM_NC) {
+        const int nc = (N - jc < GEMM_NC) ? N - jc : GEMM_NC;
+        for (int pc = 0; pc < K; pc += GEMM_KC) {
+            const int kc = (K - pc < GEMM_KC) ? K - pc : GEMM_KC;
+            const double *b = TB ? &B[jc * ldb + pc] : &B[pc * ldb + jc];
+            gemm_pack_b(TB, kc, nc, b, ldb, pb);
+            for (int ic = 0; ic < M; ic += GEMM_MC) {
+                const int mc = (M - ic < GEMM_MC) ? M - ic : GEMM_MC;
+                const double *a = TA ? &A[pc * lda + ic] : &A[ic * lda + pc];
+                gemm_pack_a(TA, mc, kc, ALPHA, a, lda, pa);
+                for (int jr = 0; jr < nc; jr += GEMM_NR) {
+                    const int nr = (nc - jr < GEMM_NR) ? nc - jr : GEMM_NR;
+                    for (int ir = 0; ir < mc; ir += GEMM_MR) {
+                        const int mr = (mc - ir < GEMM_MR) ? mc - ir : GEMM_MR;
+                        double *c = &C[(ic + ir) * ldc + jc + jr];
+                        kernel(kc, &pa[ir * kc], &pb[jr * kc], c, ldc, mr, nr,
+                               pc > 0);
+                    }
+                }
+            }
+        }
+    }
+    free(pa);
+    free(pb);
+}
+
+/**
+ * @brief Performs C = ALPHA op(A) op(B) + BETA C for one instruction set.
+ * @details Products too small to repay packing use direct loops.
+ */
+static BLAS_INLINE void
+gemm(const int TA, const int TB, const int M, const int N, const int K,
+     const double ALPHA, const double *A, const int lda, const double *B,
+     const int ldb, const double BETA, double *C, const int ldc,
+     const gemm_kernel_fn kernel, const bool fused)
+{
+    if (BETA == 0) {
+        // C need not be set on input, as in the reference BLAS
+        for (int i = 0; i < M; ++i) {
+            memset(&C[i * ldc], 0, sizeof(double) * N);
+        }
+    } else if (BETA != 1) {
+        for (int i = 0; i < M; ++i) {
+            for (int j = 0; j < N; ++j) {
+                C[i * ldc + j] *= BETA;
+            }
+        }
+    }
+    if (M >= GEMM_MR && N >= GEMM_NR &&
+        (double) M * N * K >= GEMM_MIN_BLOCKED) {
+        gemm_blocked(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, C, ldc, kernel);
+    } else if (!TA && !TB) {
+        gemm_nn(M, N, K, ALPHA, A, lda, B, ldb, C, ldc);
+    } else if (TA && !TB) {
+        gemm_tn(M, N, K, ALPHA, A, lda, B, ldb, C, ldc);
+    } else if (!TA && TB) {
+        gemm_nt(M, N, K, ALPHA, A, lda, B, ldb, C, ldc, fused);
+    } else {
+        gemm_tt(M, N, K, ALPHA, A, lda, B, ldb, C, ldc, fused);
+    }
+}
+
+static BLAS_INLINE double
+dot(const int N, const double *X, const int INCX, const double *Y,
+    const int INCY, const bool fused)
+{
+    double sum = 0;
+    for (int i = 0; i < N; ++i) {
+        sum = madd(X[i * INCX], Y[i * INCY], sum, fused);
+    }
+    return sum;
+}
+
+/**
+ * @brief Performs y = ALPHA A x + y.
+ * @details Rows of A are summed GEMV_ROWS at a time so that their dependency
+ * chains overlap, each in the same order as a dot product.
+ */
+static BLAS_INLINE void
+gemv_n(const int M, const int N, const double ALPHA, const double *A,
+       const int lda, const double *X, const int INCX, double *Y,
+       const int INCY, const bool fused)
+{
+    int i = 0;
+    for (; i + GEMV_ROWS <= M; i += GEMV_ROWS) {
+        double sum[GEMV_ROWS] = { 0 };
+        for (int j = 0; j < N; ++j) {
+            const double x = X[j * INCX];
+            for (int r = 0; r < GEMV_ROWS; ++r) {
+                sum[r] = madd(A[(i + r) * lda + j], x, sum[r], fused);
+            }
+        }
+        for (int r = 0; r < GEMV_ROWS; ++r) {
+            Y[(i + r) * INCY] += ALPHA * sum[r];
+        }
+    }
+    for (; i < M; ++i) {
+        Y[i * INCY] += ALPHA * dot(N, &A[i * lda], 1, X, INCX, fused);
+    }
+}
+
+/**
+ * @brief Performs y = ALPHA A^T x + y.
+ * @details Each row of A is scaled and added to y in turn.
+ */
+static BLAS_INLINE void
+gemv_t(const int M, const int N, const double ALPHA, const double *A,
+       const int lda, const double *X, const int INCX, double *Y,
+       const int INCY, const bool fused)
+{
+    for (int i = 0; i < M; ++i) {
+        const double A_PART = ALPHA * X[i * INCX];
+        for (int j = 0; j < N; ++j) {
+            Y[j * INCY] = madd(A_PART, A[i * lda + j], Y[j * INCY], fused);
+        }
+    }
+}
+
+/**
+ * @brief Returns whether a run of GEMV_RUN connections are all inactive.
+ * @param [in] active Mask of the first connection in the run.
+ * @return Whether none of the connections are active.
+ */
+static BLAS_INLINE bool
+gemv_run_inactive(const bool *active)
+{
+    uint64_t word;
+    memcpy(&word, active, sizeof(word));
+    return word == 0;
+}
+
+/**
+ * @brief Performs y = ALPHA A x + y skipping inactive elements of A.
+ * @details Runs of GEMV_RUN inactive elements are skipped with one test.
+ */
+static BLAS_INLINE void
+gemv_n_sparse(const int M, const int N, const double ALPHA, const double *A,
+              const int lda, const bool *active, const double *X,
+              const int INCX, double *Y, const int INCY, const bool fused)
+{
+    for (int i = 0; i < M; ++i) {
+        const double *a = &A[i * lda];
+        const bool *mask = &active[i * lda];
+        double sum = 0;
+        for (int j = 0; j < N; j += GEMV_RUN) {
+            if (j + GEMV_RUN <= N && gemv_run_inactive(&mask[j])) {
+                continue;
+            }
+            const int end = (j + GEMV_RUN < N) ? j + GEMV_RUN : N;
+            for (int jj = j; jj < end; ++jj) {
+                if (mask[jj]) {
+                    sum = madd(a[jj], X[jj * INCX], sum, fused);
+                }
+            }
+        }
+        Y[i * INCY] += ALPHA * sum;
+    }
+}
+
+/**
+ * @brief Performs y = ALPHA A^T x + y skipping inactive elements of A.
+ * @details Runs of GEMV_RUN inactive elements are skipped with one test.
+ */
+static BLAS_INLINE void
+gemv_t_sparse(const int M, const int N, const double ALPHA, const double *A,
+              const int lda, const bool *active, const double *X,
+              const int INCX, double *Y, const int INCY, const bool fused)
+{
+    for (int i = 0; i < M; ++i) {
+        const double A_PART = ALPHA * X[i * INCX];
+        const double *a = &A[i * lda];
+        const bool *mask = &active[i * lda];
+        for (int j = 0; j < N; j += GEMV_RUN) {
+            if (j + GEMV_RUN <= N && gemv_run_inactive(&mask[j])) {
+                continue;
+            }
+            const int end = (j + GEMV_RUN < N) ? j + GEMV_RUN : N;
+            for (int jj = j; jj < end; ++jj) {
+                if (mask[jj]) {
+                    Y[jj * INCY] = madd(A_PART, a[jj], Y[jj * INCY], fused);
+                }
+            }
+        }
+    }
+}
+
+static BLAS_INLINE void
+gemv(const int TA, const int M, const int N, const double ALPHA,
+     const double *A, const int lda, const bool *active, const double *X,
+     const int INCX, const double BETA, double *Y, const int INCY,
+     const bool fused)
+{
+    const int len = TA ? N : M;
+    if (BETA == 0) {
+        // Y need not be set on input, as in the reference BLAS
+        for (int i = 0; i < len; ++i) {
+            Y[i * INCY] = 0;
+        }
+    } else if (BETA != 1) {
+        for (int i = 0; i < len; ++i) {
+            Y[i * INCY] *= BETA;
+        }
+    }
+    if (active != NULL && !TA) {
+        gemv_n_sparse(M, N, ALPHA, A, lda, active, X, INCX, Y, INCY, fused);
+    } else if (active != NULL) {
+        gemv_t_sparse(M, N, ALPHA, A, lda, active, X, INCX, Y, INCY, fused);
+    } else if (!TA) {
+        gemv_n(M, N, ALPHA, A, lda, X, INCX, Y, INCY, fused);
+    } else if (INCY == 1) {
+        gemv_t(M, N, ALPHA, A, lda, X, INCX, Y, 1, fused);
+    } else {
+        gemv_t(M, N, ALPHA, A, lda, X, INCX, Y, INCY, fused);
+    }
+}
+
+static BLAS_INLINE void
+ger_rows(const int M, const int N, const double ALPHA, const double *X,
+         const int INCX, const double *Y, const int INCY, double *A,
+         const int lda, const bool fused)
+{
+    for (int i = 0; i < M; ++i) {
+        const double A_PART = ALPHA * X[i * INCX];
+        for (int j = 0; j < N; ++j) {
+            A[i * lda + j] = madd(A_PART, Y[j * INCY], A[i * lda + j], fused);
+        }
+    }
+}
+
+static BLAS_INLINE void
+ger(const int M, const int N, const double ALPHA, const double *X,
+    const int INCX, const double *Y, const int INCY, double *A, const int lda,
+    const bool fused)
+{
+    if (INCY == 1) {
+        ger_rows(M, N, ALPHA, X, INCX, Y, 1, A, lda, fused);
+    } else {
+        ger_rows(M, N, ALPHA, X, INCX, Y, INCY, A, lda, fused);
+    }
+}
+
+static void BLAS_KERNEL
+gemm_kernel_generic(const int kc, const double *pa, const double *pb,
+                    double *C, const int ldc, const int mr, const int nr,
+                    const bool resume)
+{
+    gemm_kernel_body(kc, pa, pb, C, ldc, mr, nr, resume, 1);
+}
+
+static void
+gemm_generic(const int TA, const int TB, const int M, const int N,
+             const int K, const double ALPHA, const double *A, const int lda,
+             const double *B, const int ldb, const double BETA, double *C,
+             const int ldc)
+{
+    gemm(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA, C, ldc,
+         gemm_kernel_generic, BLAS_FMA);
+}
+
+static double
+dot_generic(const int N, const double *X, const int INCX, const double *Y,
+            const int INCY)
+{
+    return dot(N, X, INCX, Y, INCY, BLAS_FMA);
+}
+
+static void
+gemv_generic(const int TA, const int M, const int N, const double ALPHA,
+             const double *A, const int lda, const bool *active,
+             const double *X, const int INCX, const double BETA, double *Y,
+             const int INCY)
+{
+    gemv(TA, M, N, ALPHA, A, lda, active, X, INCX, BETA, Y, INCY, BLAS_FMA);
+}
+
+static void
+ger_generic(const int M, const int N, const double ALPHA, const double *X,
+            const int INCX, const double *Y, const int INCY, double *A,
+            const int lda)
+{
+    ger(M, N, ALPHA, X, INCX, Y, INCY, A, lda, BLAS_FMA);
+}
+
+#ifdef BLAS_DISPATCH
+
+static void BLAS_KERNEL BLAS_TARGET("avx2,fma")
+gemm_kernel_avx2(const int kc, const double *pa, const double *pb, double *C,
+                 const int ldc, const int mr, const int nr, const bool resume)
+{
+    gemm_kernel_body(kc, pa, pb, C, ldc, mr, nr, resume, 4);
+}
+
+static void BLAS_KERNEL BLAS_TARGET("avx512f,fma")
+gemm_kernel_avx512(const int kc, const double *pa, const double *pb,
+                   double *C, const int ldc, const int mr, const int nr,
+                   const bool resume)
+{
+    gemm_kernel_body(kc, pa, pb, C, ldc, mr, nr, resume, 8);
+}
+
+static void BLAS_TARGET("avx2,fma")
+gemm_avx2(const int TA, const int TB, const int M, const int N, const int K,
+          const double ALPHA, const double *A, const int lda, const double *B,
+          const int ldb, const double BETA, double *C, const int ldc)
+{
+    gemm(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA, C, ldc,
+         gemm_kernel_avx2, true);
+}
+
+static void BLAS_TARGET("avx512f,fma")
+gemm_avx512(const int TA, const int TB, const int M, const int N, const int K,
+            const double ALPHA, const double *A, const int lda,
+            const double *B, const int ldb, const double BETA, double *C,
+            const int ldc)
+{
+    gemm(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA, C, ldc,
+         gemm_kernel_avx512, true);
+}
+
+static double BLAS_TARGET("avx2,fma")
+dot_avx2(const int N, const double *X, const int INCX, const double *Y,
+         const int INCY)
+{
+    return dot(N, X, INCX, Y, INCY, true);
+}
+
+static double BLAS_TARGET("avx512f,fma")
+dot_avx512(const int N, const double *X, const int INCX, const double *Y,
+           const int INCY)
+{
+    return dot(N, X, INCX, Y, INCY, true);
+}
+
+static void BLAS_TARGET("avx2,fma")
+gemv_avx2(const int TA, const int M, const int N, const double ALPHA,
+          const double *A, const int lda, const bool *active, const double *X,
+          const int INCX, const double BETA, double *Y, const int INCY)
+{
+    gemv(TA, M, N, ALPHA, A, lda, active, X, INCX, BETA, Y, INCY, true);
+}
+
+static void BLAS_TARGET("avx512f,fma")
+gemv_avx512(const int TA, const int M, const int N, const double ALPHA,
+            const double *A, const int lda, const bool *active,
+            const double *X, const int INCX, const double BETA, double *Y,
+            const int INCY)
+{
+    gemv(TA, M, N, ALPHA, A, lda, active, X, INCX, BETA, Y, INCY, true);
+}
+
+static void BLAS_TARGET("avx2,fma")
+ger_avx2(const int M, const int N, const double ALPHA, const double *X,
+         const int INCX, const double *Y, const int INCY, double *A,
+         const int lda)
+{
+    ger(M, N, ALPHA, X, INCX, Y, INCY, A, lda, true);
+}
+
+static void BLAS_TARGET("avx512f,fma")
+ger_avx512(const int M, const int N, const double ALPHA, const double *X,
+           const int INCX, const double *Y, const int INCY, double *A,
+           const int lda)
+{
+    ger(M, N, ALPHA, X, INCX, Y, INCY, A, lda, true);
+}
+
+#endif
+
+static void
+gemm_builtin(const int TA, const int TB, const int M, const int N, const int K,
+             const double ALPHA, const double *A, const int lda,
+             const double *B, const int ldb, const double BETA, double *C,
+             const int ldc)
+{
+    switch (blas_isa()) {
+#ifdef BLAS_DISPATCH
+        case BLAS_ISA_AVX512:
+            gemm_avx512(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA, C, ldc);
+            return;
+        case BLAS_ISA_AVX2:
+            gemm_avx2(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA, C, ldc);
+            return;
+#endif
+        default:
+            gemm_generic(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA, C, ldc);
+            return;
+    }
+}
+
+static void
+axpy_builtin(const int N, const double ALPHA, const double *X, const int INCX,
+             double *Y, const int INCY)
+{
+    if (ALPHA != 1) {
+        for (int i = 0; i < N; ++i) {
+            Y[i * INCY] += ALPHA * X[i * INCX];
+        }
+    } else {
+        for (int i = 0; i < N; ++i) {
+            Y[i * INCY] += X[i * INCX];
+        }
+    }
+}
+
+static double
+dot_builtin(const int N, const double *X, const int INCX, const double *Y,
+            const int INCY)
+{
+    switch (blas_isa()) {
+#ifdef BLAS_DISPATCH
+        case BLAS_ISA_AVX512:
+            return dot_avx512(N, X, INCX, Y, INCY);
+        case BLAS_ISA_AVX2:
+            return dot_avx2(N, X, INCX, Y, INCY);
+#endif
+        default:
+            return dot_generic(N, X, INCX, Y, INCY);
+    }
+}
+
+static void
+gemv_builtin(const int TA, const int M, const int N, const double ALPHA,
+             const double *A, const int lda, const double *X, const int INCX,
+             const double BETA, double *Y, const int INCY)
+{
+    blas_gemv_sparse(TA, M, N, ALPHA, A, lda, NULL, X, INCX, BETA, Y, INCY);
+}
+
+static void
+ger_builtin(const int M, const int N, const double ALPHA, const double *X,
+            const int INCX, const double *Y, const int INCY, double *A,
+            const int lda)
+{
+    switch (blas_isa()) {
+#ifdef BLAS_DISPATCH
+        case BLAS_ISA_AVX512:
+            ger_avx512(M, N, ALPHA, X, INCX, Y, INCY, A, lda);
+            return;
+        case BLAS_ISA_AVX2:
+            ger_avx2(M, N, ALPHA, X, INCX, Y, INCY, A, lda);
+            return;
+#endif
+        default:
+            ger_generic(M, N, ALPHA, X, INCX, Y, INCY, A, lda);
+            return;
+    }
+}
+
+static void
+scal_builtin(const int N, const double ALPHA, double *X, const int INCX)
+{
+    if (ALPHA != 0) {
+        for (int i = 0; i < N; ++i) {
+            X[i * INCX] *= ALPHA;
+        }
+    } else {
+        for (int i = 0; i < N; ++i) {
+            X[i * INCX] = 0;
+        }
+    }
+}
+
+/**
+ * @brief Built-in linear algebra backend.
+ */
+static struct BlasVtbl const blas_builtin_vtbl = {
+    &gemm_builtin, &gemv_builtin, &ger_builtin,
+    &axpy_builtin, &dot_builtin,  &scal_builtin,
+};
+
+#ifdef CBLAS
+
+/**
+ * @brief Returns whether the external library should be bypassed.
+ * @details Within an OpenMP parallel region the threads are already busy with
+ * the population, so the single-threaded built-in kernels are used rather than
+ * letting a threaded library oversubscribe the processors.
+ * @return Whether to use the built-in kernels.
+ */
+static bool
+cblas_bypass(void)
+{
+    #ifdef PARALLEL
+    return omp_in_parallel();
+    #else
+    return false;
+    #endif
+}
+
+static void
+gemm_cblas(const int TA, const int TB, const int M, const int N, const int K,
+           const double ALPHA, const double *A, const int lda, const double *B,
+           const int ldb, const double BETA, double *C, const int ldc)
+{
+    if (M < 1 || N < 1 || K < 1 || cblas_bypass()) {
+        gemm_builtin(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA, C, ldc);
+        return;
+    }
+    cblas_dgemm(CblasRowMajor, TA ? CblasTrans : CblasNoTrans,
+                TB ? CblasTrans : CblasNoTrans, M, N, K, ALPHA, A, lda, B, ldb,
+                BETA, C, ldc);
+}
+
+static void
+gemv_cblas(const int TA, const int M, const int N, const double ALPHA,
+           const double *A, const int lda, const double *X, const int INCX,
+           const double BETA, double *Y, const int INCY)
+{
+    if (M < 1 || N < 1 || cblas_bypass()) {
+        gemv_builtin(TA, M, N, ALPHA, A, lda, X, INCX, BETA, Y, INCY);
+        return;
+    }
+    cblas_dgemv(CblasRowMajor, TA ? CblasTrans : CblasNoTrans, M, N, ALPHA, A,
+                lda, X, INCX, BETA, Y, INCY);
+}
+
+static void
+ger_cblas(const int M, const int N, const double ALPHA, const double *X,
+          const int INCX, const double *Y, const int INCY, double *A,
+          const int lda)
+{
+    if (M < 1 || N < 1 || cblas_bypass()) {
+        ger_builtin(M, N, ALPHA, X, INCX, Y, INCY, A, lda);
+        return;
+    }
+    cblas_dger(CblasRowMajor, M, N, ALPHA, X, INCX, Y, INCY, A, lda);
+}
+
+static void
+axpy_cblas(const int N, const double ALPHA, const double *X, const int INCX,
+           double *Y, const int INCY)
+{
+    if (cblas_bypass()) {
+        axpy_builtin(N, ALPHA, X, INCX, Y, INCY);
+        return;
+    }
+    cblas_daxpy(N, ALPHA, X, INCX, Y, INCY);
+}
+
+static double
+dot_cblas(const int N, const double *X, const int INCX, const double *Y,
+          const int INCY)
+{
+    if (cblas_bypass()) {
+        return dot_builtin(N, X, INCX, Y, INCY);
+    }
+    return cblas_ddot(N, X, INCX, Y, INCY);
+}
+
+static void
+scal_cblas(const int N, const double ALPHA, double *X, const int INCX)
+{
+    // scaling by zero must also clear non-finite values
+    if (ALPHA == 0 || cblas_bypass()) {
+        scal_builtin(N, ALPHA, X, INCX);
+        return;
+    }
+    cblas_dscal(N, ALPHA, X, INCX);
+}
+
+/**
+ * @brief External CBLAS linear algebra backend.
+ */
+static struct BlasVtbl const blas_cblas_vtbl = {
+    &gemm_cblas, &gemv_cblas, &ger_cblas,
+    &axpy_cblas, &dot_cblas,  &scal_cblas,
+};
+
+static const struct BlasVtbl *blas_vptr = &blas_cblas_vtbl; //!< Backend
+
+#else
+
+static const struct BlasVtbl *blas_vptr = &blas_builtin_vtbl; //!< Backend
+
+#endif
+
+/**
+ * @brief Selects the linear algebra backend.
+ * @details The external CBLAS backend is used by default when XCSF is
+ * configured with it. Only the built-in backend guarantees that blas_dot()
+ * and blas_gemm() with BETA = 0 round identically.
+ * @param [in] backend The backend: BLAS_BACKEND_BUILTIN or BLAS_BACKEND_CBLAS.
+ * @return Whether the backend is available.
+ */
+bool
+blas_set_backend(const int backend)
+{
+    switch (backend) {
+        case BLAS_BACKEND_BUILTIN:
+            blas_vptr = &blas_builtin_vtbl;
+            return true;
+#ifdef CBLAS
+        case BLAS_BACKEND_CBLAS:
+            blas_vptr = &blas_cblas_vtbl;
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Sets the number of threads used by the external CBLAS library.
+ * @details Has no effect on the single-threaded built-in kernels or where the
+ * library provides no means to set its threads.
+ * @param [in] n The number of threads.
+ */
+void
+blas_set_num_threads(const int n)
+{
+#if defined(CBLAS_OPENBLAS_THREADS)
+    openblas_set_num_threads(n);
+#elif defined(CBLAS_MKL_THREADS)
+    mkl_set_num_threads(n);
+#else
+    (void) n;
+#endif
+}
+
+/**
+ * @brief Performs the matrix-matrix multiplication:
+ * \f$ C = \alpha \mbox{op}(A) \mbox{op}(B) + \beta C \f$.
+ * @details The built-in kernels are compiled for AVX2 and AVX-512 with FMA
+ * where the compiler supports it and the widest the processor supports is used.
+ * @param [in] TA Operation op(A) that is non- or (conj.) transpose.
+ * @param [in] TB Operation op(B) that is non- or (conj.) transpose.
+ * @param [in] M Number of rows of matrix op(A) and C.
+ * @param [in] N Number of columns of matrix op(B) and C.
+ * @param [in] K Number of columns of op(A) and rows of op(B).
+ * @param [in] ALPHA Scalar used for multiplication.
+ * @param [in] A Array of dimension lda × K with lda >= max(1,M) if TA=0 and lda
+ * × M with lda >= max(1,K) otherwise.
+ * @param [in] lda Leading dimension of a 2-D array used to store the matrix A.
+ * @param [in] B Array of dimension ldb × N with ldb >= max(1,K) if TB=0 and ldb
+ * × K with ldb >= max(1,N) otherwise.
+ * @param [in] ldb Leading dimension of a 2-D array used to store the matrix B.
+ * @param [in] BETA Scalar used for multiplication.
+ * @param [in,out] C Array of dimension ldc × N with ldc >= max(1,M).
+ * @param [in] ldc Leading dimension of a 2-D array used to store the matrix C.
+ */
+void
+blas_gemm(const int TA, const int TB, const int M, const int N, const int K,
+          const double ALPHA, const double *A, const int lda, const double *B,
+          const int ldb, const double BETA, double *C, const int ldc)
+{
+    (*blas_vptr->blas_impl_gemm)(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA,
+                                 C, ldc);
+}
+
+/**
+ * @brief Performs the matrix-vector multiplication:
+ * \f$ y = \alpha \mbox{op}(A) x + \beta y \f$.
+ * @details Each element is summed in the same order as blas_dot() and
+ * blas_gemm() by the built-in kernels.
+ * @param [in] TA Operation op(A) that is non- or (conj.) transpose.
+ * @param [in] M Number of rows of matrix A.
+ * @param [in] N Number of columns of matrix A.
+ * @param [in] ALPHA Scalar used for multiplication.
+ * @param [in] A Array of dimension lda × M with lda >= max(1,N).
+ * @param [in] lda Leading dimension of a 2-D array used to store the matrix A.
+ * @param [in] X Vector with N elements if TA=0 and M elements otherwise.
+ * @param [in] INCX Stride between consecutive elements of X.
+ * @param [in] BETA Scalar used for multiplication.
+ * @param [in,out] Y Vector with M elements if TA=0 and N elements otherwise.
+ * @param [in] INCY Stride between consecutive elements of Y.
+ */
+void
+blas_gemv(const int TA, const int M, const int N, const double ALPHA,
+          const double *A, const int lda, const double *X, const int INCX,
+          const double BETA, double *Y, const int INCY)
+{
+    (*blas_vptr->blas_impl_gemv)(TA, M, N, ALPHA, A, lda, X, INCX, BETA, Y,
+                                 INCY);
+}
+
+/**
+ * @brief Performs the matrix-vector multiplication skipping inactive elements:
+ * \f$ y = \alpha \mbox{op}(A) x + \beta y \f$.
+ * @details Always uses the built-in kernels. Elements of A whose mask is false
+ * are treated as zero, saving their multiply-adds when A is sparse.
+ * @param [in] TA Operation op(A) that is non- or (conj.) transpose.
+ * @param [in] M Number of rows of matrix A.
+ * @param [in] N Number of columns of matrix A.
+ * @param [in] ALPHA Scalar used for multiplication.
+ * @param [in] A Array of dimension lda × M with lda >= max(1,N).
+ * @param [in] lda Leading dimension of a 2-D array used to store the matrix A.
+ * @param [in] active Whether each element of A is active, or NULL if all are.
+ * @param [in] X Vector with N elements if TA=0 and M elements otherwise.
+ * @param [in] INCX Stride between consecutive elements of X.
+ * @param [in] BETA Scalar used for multiplication.
+ * @param [in,out] Y Vector with M elements if TA=0 and N elements otherwise.
+ * @param [in] INCY Stride between consecutive elements of Y.
+ */
+void
+blas_gemv_sparse(const int TA, const int M, const int N, const double ALPHA,
+                 const double *A, const int lda, const bool *active,
+                 const double *X, const int INCX, const double BETA, double *Y,
+                 const int INCY)
+{
+    switch (blas_isa()) {
+#ifdef BLAS_DISPATCH
+        case BLAS_ISA_AVX512:
+            gemv_avx512(TA, M, N, ALPHA, A, lda, active, X, INCX, BETA, Y,
+                        INCY);
+            return;
+        case BLAS_ISA_AVX2:
+            gemv_avx2(TA, M, N, ALPHA, A, lda, active, X, INCX, BETA, Y, INCY);
+            return;
+#endif
+        default:
+            gemv_generic(TA, M, N, ALPHA, A, lda, active, X, INCX, BETA, Y,
+                         INCY);
+            return;
+    }
+}
+
+/**
+ * @brief Performs the rank-1 update: \f$ A = \alpha x y^T + A \f$.
+ * @param [in] M Number of rows of matrix A.
+ * @param [in] N Number of columns of matrix A.
+ * @param [in] ALPHA Scalar used for multiplication.
+ * @param [in] X Vector with M elements.
+ * @param [in] INCX Stride between consecutive elements of X.
+ * @param [in] Y Vector with N elements.
+ * @param [in] INCY Stride between consecutive elements of Y.
+ * @param [in,out] A Array of dimension lda × M with lda >= max(1,N).
+ * @param [in] lda Leading dimension of a 2-D array used to store the matrix A.
+ */
+void
+blas_ger(const int M, const int N, const double ALPHA, const double *X,
+         const int INCX, const double *Y, const int INCY, double *A,
+         const int lda)
+{
+    (*blas_vptr->blas_impl_ger)(M, N, ALPHA, X, INCX, Y, INCY, A, lda);
+}
+
+/**
+ * @brief Multiplies vector X by the scalar ALPHA and adds it to the vector Y.
+ * @param [in] N The number of elements in vectors X and Y.
+ * @param [in] ALPHA Scalar used for multiplication.
+ * @param [in] X Vector with N elements.
+ * @param [in] INCX Stride between consecutive elements of X.
+ * @param [in,out] Y Vector with N elements.
+ * @param [in] INCY Stride between consecutive elements of Y.
+ */
+void
+blas_axpy(const int N, const double ALPHA, const double *X, const int INCX,
+          double *Y, const int INCY)
+{
+    (*blas_vptr->blas_impl_axpy)(N, ALPHA, X, INCX, Y, INCY);
+}
+
+/**
+ * @brief Scales vector X by the scalar ALPHA and overwrites it with the result.
+ * @param [in] N The number of elements in vector X.
+ * @param [in] ALPHA Scalar used for multiplication.
+ * @param [in,out] X Vector with N elements.
+ * @param [in] INCX Stride between consecutive elements of X.
+ */
+void
+blas_scal(const int N, const double ALPHA, double *X, const int INCX)
+{
+    (*blas_vptr->blas_impl_scal)(N, ALPHA, X, INCX);
+}
+
+/**
+ * @brief Fills the vector X with the value ALPHA.
+ * @param [in] N The number of elements in vector X.
+ * @param [in] ALPHA The value to fill the vector.
+ * @param [out] X Vector with N elements.
+ * @param [in] INCX Stride between consecutive elements of X.
+ */
+void
+blas_fill(const int N, const double ALPHA, double *X, const int INCX)
+{
+    for (int i = 0; i < N; ++i) {
+        X[i * INCX] = ALPHA;
+    }
+}
+
+/**
+ * @brief Computes the dot product of two vectors.
+ * @details The built-in kernels are dispatched like blas_gemm() so that a dot
+ * product and the same product computed by blas_gemm() with BETA = 0 round
+ * identically.
+ * @param [in] N The number of elements in vectors X and Y.
+ * @param [in] X Vector with N elements.
+ * @param [in] INCX Stride between consecutive elements of X.
+ * @param [in] Y Vector with N elements.
+ * @param [in] INCY Stride between consecutive elements of Y.
+ * @return The resulting dot product.
+ */
+double
+blas_dot(const int N, const double *X, const int INCX, const double *Y,
+         const int INCY)
+{
+    return (*blas_vptr->blas_impl_dot)(N, X, INCX, Y, INCY);
+}
+
+/**
+ * @brief Multiplies vector X by the vector Y and stores the result in vector Y.
+ * @param [in] N The number of elements in vectors X and Y.
+ * @param [in] X Vector with N elements.
+ * @param [in] INCX Stride between consecutive elements of X.
+ * @param [in,out] Y Vector with N elements.
+ * @param [in] INCY Stride between consecutive elements of Y.
+ */
+void
+blas_mul(const int N, const double *X, const int INCX, double *Y,
+         const int INCY)
+{
+    for (int i = 0; i < N; ++i) {
+        Y[i * INCY] *= X[i * INCX];
+    }
+}
+
+/**
+ * @brief Returns the sum of the vector X.
+ * @param [in] X Vector with N elements.
+ * @param [in] N The number of elements in vector X.
+ * @return The resulting sum.
+ */
+double
+blas_sum(const double *X, const int N)
+{
+    double sum = 0;
+    for (int i = 0; i < N; ++i) {
+        sum += X[i];
+    }
+    return sum;
+}
+
+/*
+ * Single-precision kernels used by neural network layers when the library is
+ * built with NEURAL_FLOAT. Products are summed in single precision, as by the
+ * sgemm family of BLAS, so that twice as many elements fit in each vector
+ * register; whole-vector sums are accumulated in double.
+ */
+
+/**
+ * @brief Performs y = ALPHA A x + y in single precision.
+ * @details Rows of A are summed GEMV_ROWS at a time as by gemv_n().
+ */
+static BLAS_INLINE void
+sgemv_n(const int M, const int N, const float ALPHA, const float *A,
+        const int lda, const float *X, const int INCX, float *Y,
+        const int INCY)
+{
+    int i = 0;
+    for (; i + GEMV_ROWS <= M; i += GEMV_ROWS) {
+        float sum[GEMV_ROWS] = { 0 };
+        for (int j = 0; j < N; ++j) {
+            const float x = X[j * INCX];
+            for (int r = 0; r < GEMV_ROWS; ++r) {
+                sum[r] += A[(i + r) * lda + j] * x;
             }
         }
+        for (int r = 0; r < GEMV_ROWS; ++r) {
+            Y[(i + r) * INCY] += ALPHA * sum[r];
+        }
+    }
+    for (; i < M; ++i) {
+        float sum = 0;
+        for (int j = 0; j < N; ++j) {
+            sum += A[i * lda + j] * X[j * INCX];
+        }
+        Y[i * INCY] += ALPHA * sum;
     }
 }
 
-static void
-gemm_nt(const int M, const int N, const int K, const double ALPHA,
-        const double *A, const int lda, const double *B, const int ldb,
-        double *C, const int ldc)
+/**
+ * @brief Performs y = ALPHA A^T x + y in single precision.
+ */
+static BLAS_INLINE void
+sgemv_t(const int M, const int N, const float ALPHA, const float *A,
+        const int lda, const float *X, const int INCX, float *Y,
+        const int INCY)
 {
     for (int i = 0; i < M; ++i) {
+        const float A_PART = ALPHA * X[i * INCX];
         for (int j = 0; j < N; ++j) {
-            double sum = 0;
-            for (int k = 0; k < K; ++k) {
-                sum += ALPHA * A[i * lda + k] * B[j * ldb + k];
-            }
-            C[i * ldc + j] += sum;
+            Y[j * INCY] += A_PART * A[i * lda + j];
         }
     }
 }
 
-static void
-gemm_tn(const int M, const int N, const int K, const double ALPHA,
-        const double *A, const int lda, const double *B, const int ldb,
-        double *C, const int ldc)
+/**
+ * @brief Performs y = ALPHA op(A) x + y in single precision skipping inactive
+ * elements of A.
+ * @details Runs of GEMV_RUN inactive elements are skipped with one test.
+ */
+static BLAS_INLINE void
+sgemv_sparse(const int TA, const int M, const int N, const float ALPHA,
+             const float *A, const int lda, const bool *active, const float *X,
+             const int INCX, float *Y, const int INCY)
 {
     for (int i = 0; i < M; ++i) {
-        for (int k = 0; k < K; ++k) {
-            const double A_PART = ALPHA * A[k * lda + i];
-            for (int j = 0; j < N; ++j) {
-                C[i * ldc + j] += A_PART * B[k * ldb + j];
+        const float *a = &A[i * lda];
+        const bool *mask = &active[i * lda];
+        const float A_PART = ALPHA * X[i * INCX];
+        float sum = 0;
+        for (int j = 0; j < N; j += GEMV_RUN) {
+            if (j + GEMV_RUN <= N && gemv_run_inactive(&mask[j])) {
+                continue;
             }
+            const int end = (j + GEMV_RUN < N) ? j + GEMV_RUN : N;
+            for (int jj = j; jj < end; ++jj) {
+                if (!mask[jj]) {
+                    continue;
+                }
+                if (TA) {
+                    Y[jj * INCY] += A_PART * a[jj];
+                } else {
+                    sum += a[jj] * X[jj * INCX];
+                }
+            }
+        }
+        if (!TA) {
+            Y[i * INCY] += ALPHA * sum;
         }
     }
 }
 
-static void
-gemm_tt(const int M, const int N, const int K, const double ALPHA,
-        const double *A, const int lda, const double *B, const int ldb,
-        double *C, const int ldc)
+static BLAS_INLINE void
+sgemv(const int TA, const int M, const int N, const float ALPHA,
+      const float *A, const int lda, const bool *active, const float *X,
+      const int INCX, const float BETA, float *Y, const int INCY)
+{
+    const int len = TA ? N : M;
+    if (BETA == 0) {
+        // Y need not be set on input, as in the reference BLAS
+        for (int i = 0; i < len; ++i) {
+            Y[i * INCY] = 0;
+        }
+    } else if (BETA != 1) {
+        for (int i = 0; i < len; ++i) {
+            Y[i * INCY] *= BETA;
+        }
+    }
+    if (active != NULL) {
+        sgemv_sparse(TA, M, N, ALPHA, A, lda, active, X, INCX, Y, INCY);
+    } else if (!TA) {
+        sgemv_n(M, N, ALPHA, A, lda, X, INCX, Y, INCY);
+    } else if (INCY == 1) {
+        sgemv_t(M, N, ALPHA, A, lda, X, INCX, Y, 1);
+    } else {
+        sgemv_t(M, N, ALPHA, A, lda, X, INCX, Y, INCY);
+    }
+}
+
+/**
+ * @brief Performs C = ALPHA op(A) op(B) + BETA C in single precision.
+ * @details Each row of C is computed as a matrix-vector product with B, which
+ * needs no packing for the modest products of neural network layers.
+ */
+static BLAS_INLINE void
+sgemm(const int TA, const int TB, const int M, const int N, const int K,
+      const float ALPHA, const float *A, const int lda, const float *B,
+      const int ldb, const float BETA, float *C, const int ldc)
 {
     for (int i = 0; i < M; ++i) {
-        for (int j = 0; j < N; ++j) {
-            double sum = 0;
-            for (int k = 0; k < K; ++k) {
-                sum += ALPHA * A[i + k * lda] * B[k + j * ldb];
+        const float *a = TA ? &A[i] : &A[i * lda];
+        const int inca = TA ? lda : 1;
+        if (TB) {
+            sgemv(0, N, K, ALPHA, B, ldb, NULL, a, inca, BETA, &C[i * ldc], 1);
+        } else {
+            sgemv(1, K, N, ALPHA, B, ldb, NULL, a, inca, BETA, &C[i * ldc], 1);
+        }
+    }
+}
+
+static BLAS_INLINE void
+sger(const int M, const int N, const float ALPHA, const float *X,
+     const int INCX, const float *Y, const int INCY, float *A, const int lda)
+{
+    for (int i = 0; i < M; ++i) {
+        const float A_PART = ALPHA * X[i * INCX];
+        float *a = &A[i * lda];
+        if (INCY == 1) {
+            for (int j = 0; j < N; ++j) {
+                a[j] += A_PART * Y[j];
+            }
+        } else {
+            for (int j = 0; j < N; ++j) {
+                a[j] += A_PART * Y[j * INCY];
             }
-            C[i * ldc + j] += sum;
         }
     }
 }
 
+static void
+sgemm_generic(const int TA, const int TB, const int M, const int N,
+              const int K, const float ALPHA, const float *A, const int lda,
+              const float *B, const int ldb, const float BETA, float *C,
+              const int ldc)
+{
+    sgemm(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA, C, ldc);
+}
+
+static void
+sgemv_generic(const int TA, const int M, const int N, const float ALPHA,
+              const float *A, const int lda, const bool *active,
+              const float *X, const int INCX, const float BETA, float *Y,
+              const int INCY)
+{
+    sgemv(TA, M, N, ALPHA, A, lda, active, X, INCX, BETA, Y, INCY);
+}
+
+static void
+sger_generic(const int M, const int N, const float ALPHA, const float *X,
+             const int INCX, const float *Y, const int INCY, float *A,
+             const int lda)
+{
+    sger(M, N, ALPHA, X, INCX, Y, INCY, A, lda);
+}
+
+#ifdef BLAS_DISPATCH
+
+static void BLAS_TARGET("avx2,fma")
+sgemm_avx2(const int TA, const int TB, const int M, const int N, const int K,
+           const float ALPHA, const float *A, const int lda, const float *B,
+           const int ldb, const float BETA, float *C, const int ldc)
+{
+    sgemm(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA, C, ldc);
+}
+
+static void BLAS_TARGET("avx512f,fma")
+sgemm_avx512(const int TA, const int TB, const int M, const int N,
+             const int K, const float ALPHA, const float *A, const int lda,
+             const float *B, const int ldb, const float BETA, float *C,
+             const int ldc)
+{
+    sgemm(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA, C, ldc);
+}
+
+static void BLAS_TARGET("avx2,fma")
+sgemv_avx2(const int TA, const int M, const int N, const float ALPHA,
+           const float *A, const int lda, const bool *active, const float *X,
+           const int INCX, const float BETA, float *Y, const int INCY)
+{
+    sgemv(TA, M, N, ALPHA, A, lda, active, X, INCX, BETA, Y, INCY);
+}
+
+static void BLAS_TARGET("avx512f,fma")
+sgemv_avx512(const int TA, const int M, const int N, const float ALPHA,
+             const float *A, const int lda, const bool *active,
+             const float *X, const int INCX, const float BETA, float *Y,
+             const int INCY)
+{
+    sgemv(TA, M, N, ALPHA, A, lda, active, X, INCX, BETA, Y, INCY);
+}
+
+static void BLAS_TARGET("avx2,fma")
+sger_avx2(const int M, const int N, const float ALPHA, const float *X,
+          const int INCX, const float *Y, const int INCY, float *A,
+          const int lda)
+{
+    sger(M, N, ALPHA, X, INCX, Y, INCY, A, lda);
+}
+
+static void BLAS_TARGET("avx512f,fma")
+sger_avx512(const int M, const int N, const float ALPHA, const float *X,
+            const int INCX, const float *Y, const int INCY, float *A,
+            const int lda)
+{
+    sger(M, N, ALPHA, X, INCX, Y, INCY, A, lda);
+}
+
+#endif
+
 /**
- * @brief Performs the matrix-matrix multiplication:
+ * @brief Performs the matrix-matrix multiplication in single precision:
  * \f$ C = \alpha \mbox{op}(A) \mbox{op}(B) + \beta C \f$.
+ * @details Always uses the built-in kernels. Arguments are as blas_gemm().
  * @param [in] TA Operation op(A) that is non- or (conj.) transpose.
  * @param [in] TB Operation op(B) that is non- or (conj.) transpose.
- * @param [in] M Number of rows of matrix op(A) and C.
- * @param [in] N Number of columns of matrix op(B) and C.
- * @param [in] K Number of columns of op(A) and rows of op(B).
+ * @param [in] M Number of rows of matrix op(A) and of matrix C.
+ * @param [in] N Number of columns of matrix op(B) and of matrix C.
+ * @param [in] K Number of columns of matrix op(A) and rows of matrix op(B).
  * @param [in] ALPHA Scalar used for multiplication.
- * @param [in] A Array of dimension lda × K with lda >= max(1,M) if TA=0 and lda
- * × M with lda >= max(1,K) otherwise.
+ * @param [in] A The first matrix.
  * @param [in] lda Leading dimension of a 2-D array used to store the matrix A.
- * @param [in] B Array of dimension ldb × N with ldb >= max(1,K) if TB=0 and ldb
- * × K with ldb >= max(1,N) otherwise.
+ * @param [in] B The second matrix.
  * @param [in] ldb Leading dimension of a 2-D array used to store the matrix B.
  * @param [in] BETA Scalar used for multiplication.
  * @param [in,out] C Array of dimension ldc × N with ldc >= max(1,M).
  * @param [in] ldc Leading dimension of a 2-D array used to store the matrix C.
  */
 void
-blas_gemm(const int TA, const int TB, const int M, const int N, const int K,
-          const double ALPHA, const double *A, const int lda, const double *B,
-          const int ldb, const double BETA, double *C, const int ldc)
+blas_sgemm(const int TA, const int TB, const int M, const int N, const int K,
+           const float ALPHA, const float *A, const int lda, const float *B,
+           const int ldb, const float BETA, float *C, const int ldc)
 {
-    for (int i = 0; i < M; ++i) {
-        for (int j = 0; j < N; ++j) {
-            C[i * ldc + j] *= BETA;
-        }
-    }
-    if (!TA && !TB) {
-        gemm_nn(M, N, K, ALPHA, A, lda, B, ldb, C, ldc);
-    } else if (TA && !TB) {
-        gemm_tn(M, N, K, ALPHA, A, lda, B, ldb, C, ldc);
-    } else if (!TA && TB) {
-        gemm_nt(M, N, K, ALPHA, A, lda, B, ldb, C, ldc);
-    } else {
-        gemm_tt(M, N, K, ALPHA, A, lda, B, ldb, C, ldc);
+    switch (blas_isa()) {
+#ifdef BLAS_DISPATCH
+        case BLAS_ISA_AVX512:
+            sgemm_avx512(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA, C, ldc);
+            return;
+        case BLAS_ISA_AVX2:
+            sgemm_avx2(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA, C, ldc);
+            return;
+#endif
+        default:
+            sgemm_generic(TA, TB, M, N, K, ALPHA, A, lda, B, ldb, BETA, C,
+                          ldc);
+            return;
     }
 }
 
 /**
- * @brief Multiplies vector X by the scalar ALPHA and adds it to the vector Y.
- * @param [in] N The number of elements in vectors X and Y.
+ * @brief Performs the matrix-vector multiplication in single precision,
+ * skipping inactive elements: \f$ y = \alpha \mbox{op}(A) x + \beta y \f$.
+ * @details Always uses the built-in kernels. Arguments are as
+ * blas_gemv_sparse().
+ * @param [in] TA Operation op(A) that is non- or (conj.) transpose.
+ * @param [in] M Number of rows of matrix A.
+ * @param [in] N Number of columns of matrix A.
  * @param [in] ALPHA Scalar used for multiplication.
- * @param [in] X Vector with N elements.
+ * @param [in] A Array of dimension lda × M with lda >= max(1,N).
+ * @param [in] lda Leading dimension of a 2-D array used to store the matrix A.
+ * @param [in] active Whether each element of A is active, or NULL if all are.
+ * @param [in] X Vector with N elements if TA=0 and M elements otherwise.
  * @param [in] INCX Stride between consecutive elements of X.
- * @param [in,out] Y Vector with N elements.
+ * @param [in] BETA Scalar used for multiplication.
+ * @param [in,out] Y Vector with M elements if TA=0 and N elements otherwise.
  * @param [in] INCY Stride between consecutive elements of Y.
  */
 void
-blas_axpy(const int N, const double ALPHA, const double *X, const int INCX,
-          double *Y, const int INCY)
+blas_sgemv_sparse(const int TA, const int M, const int N, const float ALPHA,
+                  const float *A, const int lda, const bool *active,
+                  const float *X, const int INCX, const float BETA, float *Y,
+                  const int INCY)
 {
-    if (ALPHA != 1) {
-        for (int i = 0; i < N; ++i) {
-            Y[i * INCY] += ALPHA * X[i * INCX];
-        }
-    } else {
-        for (int i = 0; i < N; ++i) {
-            Y[i * INCY] += X[i * INCX];
-        }
+    switch (blas_isa()) {
+#ifdef BLAS_DISPATCH
+        case BLAS_ISA_AVX512:
+            sgemv_avx512(TA, M, N, ALPHA, A, lda, active, X, INCX, BETA, Y,
+                         INCY);
+            return;
+        case BLAS_ISA_AVX2:
+            sgemv_avx2(TA, M, N, ALPHA, A, lda, active, X, INCX, BETA, Y,
+                       INCY);
+            return;
+#endif
+        default:
+            sgemv_generic(TA, M, N, ALPHA, A, lda, active, X, INCX, BETA, Y,
+                          INCY);
+            return;
     }
 }
 
 /**
- * @brief Scales vector X by the scalar ALPHA and overwrites it with the result.
- * @param [in] N The number of elements in vector X.
+ * @brief Performs the matrix-vector multiplication in single precision:
+ * \f$ y = \alpha \mbox{op}(A) x + \beta y \f$.
+ * @details Always uses the built-in kernels. Arguments are as blas_gemv().
+ * @param [in] TA Operation op(A) that is non- or (conj.) transpose.
+ * @param [in] M Number of rows of matrix A.
+ * @param [in] N Number of columns of matrix A.
  * @param [in] ALPHA Scalar used for multiplication.
- * @param [in,out] X Vector with N elements.
+ * @param [in] A Array of dimension lda × M with lda >= max(1,N).
+ * @param [in] lda Leading dimension of a 2-D array used to store the matrix A.
+ * @param [in] X Vector with N elements if TA=0 and M elements otherwise.
  * @param [in] INCX Stride between consecutive elements of X.
+ * @param [in] BETA Scalar used for multiplication.
+ * @param [in,out] Y Vector with M elements if TA=0 and N elements otherwise.
+ * @param [in] INCY Stride between consecutive elements of Y.
  */
 void
-blas_scal(const int N, const double ALPHA, double *X, const int INCX)
+blas_sgemv(const int TA, const int M, const int N, const float ALPHA,
+           const float *A, const int lda, const float *X, const int INCX,
+           const float BETA, float *Y, const int INCY)
 {
-    if (ALPHA != 0) {
-        for (int i = 0; i < N; ++i) {
-            X[i * INCX] *= ALPHA;
-        }
-    } else {
-        for (int i = 0; i < N; ++i) {
-            X[i * INCX] = 0;
-        }
-    }
+    blas_sgemv_sparse(TA, M, N, ALPHA, A, lda, NULL, X, INCX, BETA, Y, INCY);
 }
 
 /**
- * @brief Fills the vector X with the value ALPHA.
- * @param [in] N The number of elements in vector X.
- * @param [in] ALPHA The value to fill the vector.
- * @param [out] X Vector with N elements.
+ * @brief Performs the rank-1 update in single precision:
+ * \f$ A = \alpha x y^T + A \f$.
+ * @param [in] M Number of rows of matrix A.
+ * @param [in] N Number of columns of matrix A.
+ * @param [in] ALPHA Scalar used for multiplication.
+ * @param [in] X Vector with M elements.
  * @param [in] INCX Stride between consecutive elements of X.
+ * @param [in] Y Vector with N elements.
+ * @param [in] INCY Stride between consecutive elements of Y.
+ * @param [in,out] A Array of dimension lda × M with lda >= max(1,N).
+ * @param [in] lda Leading dimension of a 2-D array used to store the matrix A.
  */
 void
-blas_fill(const int N, const double ALPHA, double *X, const int INCX)
+blas_sger(const int M, const int N, const float ALPHA, const float *X,
+          const int INCX, const float *Y, const int INCY, float *A,
+          const int lda)
 {
-    for (int i = 0; i < N; ++i) {
-        X[i * INCX] = ALPHA;
+    switch (blas_isa()) {
+#ifdef BLAS_DISPATCH
+        case BLAS_ISA_AVX512:
+            sger_avx512(M, N, ALPHA, X, INCX, Y, INCY, A, lda);
+            return;
+        case BLAS_ISA_AVX2:
+            sger_avx2(M, N, ALPHA, X, INCX, Y, INCY, A, lda);
+            return;
+#endif
+        default:
+            sger_generic(M, N, ALPHA, X, INCX, Y, INCY, A, lda);
+            return;
     }
 }
 
 /**
- * @brief Computes the dot product of two vectors.
+ * @brief Multiplies vector X by the scalar ALPHA and adds it to the vector Y
+ * in single precision.
  * @param [in] N The number of elements in vectors X and Y.
+ * @param [in] ALPHA Scalar used for multiplication.
  * @param [in] X Vector with N elements.
  * @param [in] INCX Stride between consecutive elements of X.
- * @param [in] Y Vector with N elements.
+ * @param [in,out] Y Vector with N elements.
  * @param [in] INCY Stride between consecutive elements of Y.
- * @return The resulting dot product.
  */
-double
-blas_dot(const int N, const double *X, const int INCX, const double *Y,
-         const int INCY)
+void
+blas_saxpy(const int N, const float ALPHA, const float *X, const int INCX,
+           float *Y, const int INCY)
 {
-    double dot = 0;
     for (int i = 0; i < N; ++i) {
-        dot += X[i * INCX] * Y[i * INCY];
+        Y[i * INCY] += ALPHA * X[i * INCX];
     }
-    return dot;
 }
 
 /**
- * @brief Multiplies vector X by the vector Y and stores the result in vector Y.
+ * @brief Scales vector X by the scalar ALPHA in single precision.
+ * @param [in] N The number of elements in vector X.
+ * @param [in] ALPHA Scalar used for multiplication.
+ * @param [in,out] X Vector with N elements.
+ * @param [in] INCX Stride between consecutive elements of X.
+ */
+void
+blas_sscal(const int N, const float ALPHA, float *X, const int INCX)
+{
+    if (ALPHA != 0) {
+        for (int i = 0; i < N; ++i) {
+            X[i * INCX] *= ALPHA;
+        }
+    } else {
+        for (int i = 0; i < N; ++i) {
+            X[i * INCX] = 0;
+        }
+    }
+}
+
+/**
+ * @brief Multiplies vector X by the vector Y in single precision and stores
+ * the result in vector Y.
  * @param [in] N The number of elements in vectors X and Y.
  * @param [in] X Vector with N elements.
  * @param [in] INCX Stride between consecutive elements of X.
@@ -214,8 +1691,8 @@ blas_dot(const int N, const double *X, const int INCX, const double *Y,
  * @param [in] INCY Stride between consecutive elements of Y.
  */
 void
-blas_mul(const int N, const double *X, const int INCX, double *Y,
-         const int INCY)
+blas_smul(const int N, const float *X, const int INCX, float *Y,
+          const int INCY)
 {
     for (int i = 0; i < N; ++i) {
         Y[i * INCY] *= X[i * INCX];
@@ -223,13 +1700,14 @@ blas_mul(const int N, const double *X, const int INCX, double *Y,
 }
 
 /**
- * @brief Returns the sum of the vector X.
+ * @brief Returns the sum of the single-precision vector X.
+ * @details The sum is accumulated in double precision.
  * @param [in] X Vector with N elements.
  * @param [in] N The number of elements in vector X.
  * @return The resulting sum.
  */
 double
-blas_sum(const double *X, const int N)
+blas_ssum(const float *X, const int N)
 {
     double sum = 0;
     for (int i = 0; i < N; ++i) {
@@ -17,17 +17,38 @@
  * @file blas.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2020.
+ * @date 2020--2026.
  * @brief Basic linear algebra functions.
  */
 
 #pragma once
 
+#include <stdbool.h>
+
+#define BLAS_BACKEND_BUILTIN (0) //!< Built-in kernels
+#define BLAS_BACKEND_CBLAS (1) //!< External CBLAS library
+
 void
 blas_gemm(const int TA, const int TB, const int M, const int N, const int K,
           const double ALPHA, const double *A, const int lda, const double *B,
           const int ldb, const double BETA, double *C, const int ldc);
 
+void
+blas_gemv(const int TA, const int M, const int N, const double ALPHA,
+          const double *A, const int lda, const double *X, const int INCX,
+          const double BETA, double *Y, const int INCY);
+
+void
+blas_gemv_sparse(const int TA, const int M, const int N, const double ALPHA,
+                 const double *A, const int lda, const bool *active,
+                 const double *X, const int INCX, const double BETA, double *Y,
+                 const int INCY);
+
+void
+blas_ger(const int M, const int N, const double ALPHA, const double *X,
+         const int INCX, const double *Y, const int INCY, double *A,
+         const int lda);
+
 void
 blas_axpy(const int N, const double ALPHA, const double *X, const int INCX,
           double *Y, const int INCY);
@@ -48,3 +69,44 @@ blas_dot(const int N, const double *X, const int INCX, const double *Y,
 
 double
 blas_sum(const double *X, const int N);
+
+bool
+blas_set_backend(const int backend);
+
+void
+blas_set_num_threads(const int n);
+
+void
+blas_sgemm(const int TA, const int TB, const int M, const int N, const int K,
+           const float ALPHA, const float *A, const int lda, const float *B,
+           const int ldb, const float BETA, float *C, const int ldc);
+
+void
+blas_sgemv(const int TA, const int M, const int N, const float ALPHA,
+           const float *A, const int lda, const float *X, const int INCX,
+           const float BETA, float *Y, const int INCY);
+
+void
+blas_sgemv_sparse(const int TA, const int M, const int N, const float ALPHA,
+                  const float *A, const int lda, const bool *active,
+                  const float *X, const int INCX, const float BETA, float *Y,
+                  const int INCY);
+
+void
+blas_sger(const int M, const int N, const float ALPHA, const float *X,
+          const int INCX, const float *Y, const int INCY, float *A,
+          const int lda);
+
+void
+blas_saxpy(const int N, const float ALPHA, const float *X, const int INCX,
+           float *Y, const int INCY);
+
+void
+blas_smul(const int N, const float *X, const int INCX, float *Y,
+          const int INCY);
+
+void
+blas_sscal(const int N, const float ALPHA, float *X, const int INCX);
+
+double
+blas_ssum(const float *X, const int N);
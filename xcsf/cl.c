@@ -17,7 +17,7 @@
  * @file cl.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2023.
+ * @date 2015--2026.
  * @brief Functions operating on classifiers.
  */
 
@@ -51,6 +51,10 @@ cl_init(const struct XCSF *xcsf, struct Cl *c, const double size,
     c->m = false;
     c->age = 0;
     c->mtotal = 0;
+    c->cond_slot = -1;
+    c->batch_slot = -1;
+    c->del_slot = -1;
+    c->pred_stamp = 0;
 }
 
 /**
@@ -94,6 +98,10 @@ cl_init_copy(const struct XCSF *xcsf, struct Cl *dest, const struct Cl *src)
     dest->m = src->m;
     dest->age = src->age;
     dest->mtotal = src->mtotal;
+    dest->cond_slot = -1;
+    dest->batch_slot = -1;
+    dest->del_slot = -1;
+    dest->pred_stamp = 0;
     dest->cond_vptr = src->cond_vptr;
     dest->pred_vptr = src->pred_vptr;
     dest->act_vptr = src->act_vptr;
@@ -184,7 +192,10 @@ cl_update(const struct XCSF *xcsf, struct Cl *c, const double *x,
           const double *y, const int set_num, const bool cur)
 {
     ++(c->exp);
-    if (!cur) { // propagate inputs for the previous state update
+    if (!cur && (c->pred_stamp == 0 || c->pred_stamp != xcsf->prev_stamp ||
+                 !pred_reusable(xcsf, c))) {
+        // propagate inputs for the previous state update unless the
+        // prediction made on the previous step is still held
         cl_predict(xcsf, c, x);
     }
     const double error = (xcsf->loss_ptr)(xcsf, c->prediction, y);
@@ -198,6 +209,7 @@ cl_update(const struct XCSF *xcsf, struct Cl *c, const double *x,
     cond_update(xcsf, c, x, y);
     pred_update(xcsf, c, x, y);
     act_update(xcsf, c, x, y);
+    c->pred_stamp = 0; // the prediction is stale after the update
 }
 
 /**
@@ -256,7 +268,22 @@ cl_print(const struct XCSF *xcsf, const struct Cl *c, const bool print_cond,
 bool
 cl_match(const struct XCSF *xcsf, struct Cl *c, const double *x)
 {
-    c->m = cond_match(xcsf, c, x);
+    return cl_match_result(xcsf, c, cond_match(xcsf, c, x));
+}
+
+/**
+ * @brief Records the outcome of matching a classifier against an input.
+ * @details Used directly when conditions are matched in batch.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] c The classifier that was tested for matching.
+ * @param [in] m Whether the classifier condition matched the input.
+ * @return Whether the classifier matches the input.
+ */
+bool
+cl_match_result(const struct XCSF *xcsf, struct Cl *c, const bool m)
+{
+    (void) xcsf;
+    c->m = m;
     if (c->m) {
         ++(c->mtotal);
     }
@@ -461,6 +488,10 @@ cl_load(const struct XCSF *xcsf, struct Cl *c, FILE *fp)
     s += fread(&c->m, sizeof(bool), 1, fp);
     s += fread(&c->age, sizeof(int), 1, fp);
     s += fread(&c->mtotal, sizeof(int), 1, fp);
+    c->cond_slot = -1;
+    c->batch_slot = -1;
+    c->del_slot = -1;
+    c->pred_stamp = 0;
     c->prediction = malloc(sizeof(double) * xcsf->y_dim);
     s += fread(c->prediction, sizeof(double), xcsf->y_dim, fp);
     s += fread(&c->action, sizeof(int), 1, fp);
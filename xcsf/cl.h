@@ -37,6 +37,9 @@ cl_m(const struct XCSF *xcsf, const struct Cl *c);
 bool
 cl_match(const struct XCSF *xcsf, struct Cl *c, const double *x);
 
+bool
+cl_match_result(const struct XCSF *xcsf, struct Cl *c, const bool m);
+
 bool
 cl_mutate(const struct XCSF *xcsf, const struct Cl *c);
 
@@ -17,38 +17,21 @@
  * @file clset.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2023.
+ * @date 2015--2026.
  * @brief Functions operating on sets of classifiers.
  */
 
 #include "clset.h"
 #include "cl.h"
+#include "cond_index.h"
+#include "cond_neural_batch.h"
+#include "cond_ternary.h"
+#include "del_index.h"
 #include "utils.h"
 
 #define MAX_COVER (1000000) //!< Maximum number of covering attempts
-
-/**
- * @brief Finds a rule in the population that never matches an input.
- * @param [in] xcsf The XCSF data structure.
- * @param [out] del A pointer to the classifier to be deleted, if one is found.
- * @param [out] delprev A pointer to the rule previous to the one being deleted.
- */
-static void
-clset_pset_never_match(const struct XCSF *xcsf, struct Clist **del,
-                       struct Clist **delprev)
-{
-    struct Clist *prev = NULL;
-    struct Clist *iter = xcsf->pset.list;
-    while (iter != NULL) {
-        if (iter->cl->mtotal == 0 && iter->cl->age > xcsf->M_PROBATION) {
-            *del = iter;
-            *delprev = prev;
-            break;
-        }
-        prev = iter;
-        iter = iter->next;
-    }
-}
+#define SET_INIT_CAPACITY (16) //!< Initial number of handles allocated
+#define UPDATE_CHUNK (4) //!< Rules per work unit when updating in parallel
 
 /**
  * @brief Selects a classifier from the population for deletion via roulette.
@@ -56,44 +39,32 @@ clset_pset_never_match(const struct XCSF *xcsf, struct Clist **del,
  * two classifiers are selected using roulette wheel selection with the
  * deletion vote and the rule with the largest condition + prediction size is
  * chosen. For fixed-length representations, the effect is the same as one
- * roulette spin.
+ * roulette spin. Spins descend the deletion index rather than walking the
+ * population.
  * @param [in] xcsf The XCSF data structure.
- * @param [out] del A pointer to the rule to be deleted.
- * @param [out] delprev A pointer to the rule previous to the one being deleted.
+ * @return The population index of the rule to be deleted.
  */
-static void
-clset_pset_roulette(const struct XCSF *xcsf, struct Clist **del,
-                    struct Clist **delprev)
+static int
+clset_pset_roulette(const struct XCSF *xcsf)
 {
-    const double avg_fit = clset_total_fit(&xcsf->pset) / xcsf->pset.num;
-    double total_vote = 0;
-    struct Clist *iter = xcsf->pset.list;
-    while (iter != NULL) {
-        total_vote += cl_del_vote(xcsf, iter->cl, avg_fit);
-        iter = iter->next;
-    }
+    const struct Set *pset = &xcsf->pset;
+    const double total_vote = del_index_votes(xcsf);
+    int del = -1;
     double delsize = 0;
     const int n_spins = (xcsf->COMPACTION && xcsf->error < xcsf->E0) ? 2 : 1;
     for (int i = 0; i < n_spins; ++i) {
         // perform a single roulette spin with the deletion vote
-        iter = xcsf->pset.list;
-        struct Clist *prev = NULL;
         const double p = rand_uniform(0, total_vote);
-        double sum = cl_del_vote(xcsf, iter->cl, avg_fit);
-        while (p > sum) {
-            prev = iter;
-            iter = iter->next;
-            sum += cl_del_vote(xcsf, iter->cl, avg_fit);
-        }
+        const int j = del_index_spin(xcsf, p);
         // select the rule for deletion if it is the largest sized winner
-        const double s =
-            cl_cond_size(xcsf, iter->cl) + cl_pred_size(xcsf, iter->cl);
-        if (*del == NULL || s > delsize) {
-            *del = iter;
-            *delprev = prev;
+        const struct Cl *c = pset->cl[j];
+        const double s = cl_cond_size(xcsf, c) + cl_pred_size(xcsf, c);
+        if (del < 0 || s > delsize) {
+            del = j;
             delsize = s;
         }
     }
+    return del;
 }
 
 /**
@@ -103,27 +74,27 @@ clset_pset_roulette(const struct XCSF *xcsf, struct Clist **del,
 static void
 clset_pset_del(struct XCSF *xcsf)
 {
-    struct Clist *del = NULL;
-    struct Clist *delprev = NULL;
+    struct Set *pset = &xcsf->pset;
+    del_index_sync(xcsf);
     // select any rules that never match
-    clset_pset_never_match(xcsf, &del, &delprev);
+    int del = del_index_never_match(xcsf);
     // if none found, select a rule using roulette wheel
-    if (del == NULL) {
-        clset_pset_roulette(xcsf, &del, &delprev);
+    if (del < 0) {
+        del = clset_pset_roulette(xcsf);
     }
     // decrement numerosity
-    --(del->cl->num);
-    --(xcsf->pset.num);
-    // remove macro-classifiers as necessary
-    if (del->cl->num == 0) {
-        clset_add(&xcsf->kset, del->cl);
-        --(xcsf->pset.size);
-        if (delprev == NULL) {
-            xcsf->pset.list = del->next;
-        } else {
-            delprev->next = del->next;
-        }
-        free(del);
+    struct Cl *c = pset->cl[del];
+    --(c->num);
+    --(pset->num);
+    // remove macro-classifiers as necessary; the last handle fills the slot,
+    // which reorders the population
+    if (c->num == 0) {
+        del_index_remove(xcsf, c);
+        clset_add(&xcsf->kset, c);
+        --(pset->size);
+        pset->cl[del] = pset->cl[pset->size];
+    } else {
+        del_index_update(xcsf, c);
     }
 }
 
@@ -137,10 +108,8 @@ static bool
 clset_action_coverage(const struct XCSF *xcsf, bool *act_covered)
 {
     memset(act_covered, 0, sizeof(bool) * xcsf->n_actions);
-    const struct Clist *iter = xcsf->mset.list;
-    while (iter != NULL) {
-        act_covered[iter->cl->action] = true;
-        iter = iter->next;
+    for (int i = 0; i < xcsf->mset.size; ++i) {
+        act_covered[xcsf->mset.cl[i]->action] = true;
     }
     for (int i = 0; i < xcsf->n_actions; ++i) {
         if (!act_covered[i]) {
@@ -198,31 +167,31 @@ clset_cover(struct XCSF *xcsf, const double *x)
 
 /**
  * @brief Updates the fitness of classifiers in the set.
+ * @details The accuracy sum is accumulated in set order so that fitness does
+ * not depend on the number of threads.
  * @param [in] xcsf The XCSF data structure.
  * @param [in] set The set to update.
+ * @param [in] accs The accuracy of each classifier in the set.
  */
 static void
-clset_update_fit(const struct XCSF *xcsf, const struct Set *set)
+clset_update_fit(const struct XCSF *xcsf, const struct Set *set,
+                 const double *accs)
 {
     double acc_sum = 0;
-    double accs[set->size];
-    // calculate accuracies
-    const struct Clist *iter = set->list;
-    for (int i = 0; iter != NULL && i < set->size; ++i) {
-        accs[i] = cl_acc(xcsf, iter->cl);
-        acc_sum += accs[i] * iter->cl->num;
-        iter = iter->next;
+    for (int i = 0; i < set->size; ++i) {
+        acc_sum += accs[i] * set->cl[i]->num;
     }
-    // update fitnesses
-    iter = set->list;
-    for (int i = 0; iter != NULL && i < set->size; ++i) {
-        cl_update_fit(xcsf, iter->cl, acc_sum, accs[i]);
-        iter = iter->next;
+    for (int i = 0; i < set->size; ++i) {
+        cl_update_fit(xcsf, set->cl[i], acc_sum, accs[i]);
+        del_index_update(xcsf, set->cl[i]);
     }
 }
 
 /**
  * @brief Performs set subsumption.
+ * @details The most general subsumer is found in set order because generality
+ * is only a partial order; testing the rest of the set against it is shared
+ * among threads and the results applied in set order.
  * @param [in] xcsf The XCSF data structure.
  * @param [in] set The set to perform subsumption.
  */
@@ -231,31 +200,37 @@ clset_subsumption(struct XCSF *xcsf, struct Set *set)
 {
     // find the most general subsumer in the set
     struct Cl *s = NULL;
-    const struct Clist *iter = set->list;
-    while (iter != NULL) {
-        struct Cl *c = iter->cl;
+    for (int i = 0; i < set->size; ++i) {
+        struct Cl *c = set->cl[i];
         if (cl_subsumer(xcsf, c) && (s == NULL || cl_general(xcsf, c, s))) {
             s = c;
         }
-        iter = iter->next;
     }
     // subsume the more specific classifiers in the set
     if (s != NULL) {
+        bool *general = malloc(sizeof(bool) * set->size);
+#ifdef PARALLEL_UPDATE
+        #pragma omp parallel for schedule(static, UPDATE_CHUNK)
+#endif
+        for (int i = 0; i < set->size; ++i) {
+            const struct Cl *c = set->cl[i];
+            general[i] = c != NULL && s != c && cl_general(xcsf, s, c);
+        }
         bool subsumed = false;
-        iter = set->list;
-        while (iter != NULL) {
-            struct Cl *c = iter->cl;
-            if (c != NULL && s != c && cl_general(xcsf, s, c)) {
+        for (int i = 0; i < set->size; ++i) {
+            if (general[i]) {
+                struct Cl *c = set->cl[i];
                 s->num += c->num;
                 c->num = 0;
                 clset_add(&xcsf->kset, c);
                 subsumed = true;
             }
-            iter = iter->next;
         }
+        free(general);
         if (subsumed) {
             clset_validate(set);
             clset_validate(&xcsf->pset);
+            del_index_clear(xcsf);
         }
     }
 }
@@ -269,10 +244,8 @@ static double
 clset_total_time(const struct Set *set)
 {
     double sum = 0;
-    const struct Clist *iter = set->list;
-    while (iter != NULL) {
-        sum += iter->cl->time * iter->cl->num;
-        iter = iter->next;
+    for (int i = 0; i < set->size; ++i) {
+        sum += set->cl[i]->time * set->cl[i]->num;
     }
     return sum;
 }
@@ -327,7 +300,19 @@ clset_pset_init(struct XCSF *xcsf)
 void
 clset_init(struct Set *set)
 {
-    set->list = NULL;
+    set->cl = NULL;
+    set->size = 0;
+    set->num = 0;
+    set->capacity = 0;
+}
+
+/**
+ * @brief Removes all classifiers from the set, retaining its storage.
+ * @param [in] set The set to be cleared.
+ */
+void
+clset_clear(struct Set *set)
+{
     set->size = 0;
     set->num = 0;
 }
@@ -344,10 +329,33 @@ clset_pset_enforce_limit(struct XCSF *xcsf)
     }
 }
 
+/**
+ * @brief Matches a population classifier, using the batched result if any.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] c The classifier to match.
+ * @param [in] x The input state.
+ * @param [in] bitmap Batched match results for the population, or NULL.
+ * @param [in] i The population index of the classifier.
+ * @return Whether the classifier matches the input.
+ */
+static inline bool
+clset_cl_match(const struct XCSF *xcsf, struct Cl *c, const double *x,
+               const uint64_t *bitmap, const int i)
+{
+    if (bitmap != NULL) {
+        return cl_match_result(xcsf, c, (bitmap[i >> 6] >> (i & 63)) & 1);
+    }
+    return cl_match(xcsf, c, x);
+}
+
 /**
  * @brief Constructs the match set - forward propagates conditions and actions.
  * @details Processes the matching conditions and actions for each classifier
  * in the population. If a classifier matches, it is added to the match set.
+ * Interval conditions are matched for the whole population at once through the
+ * condition index, neural conditions are propagated in groups of identical
+ * topology, and the input is binarised once for ternary conditions. Each call
+ * presents a new input stamp with which predictions are tagged.
  * @param [in] xcsf The XCSF data structure.
  * @param [in] x The input state.
  * @param [in] cover Whether to check action set coverage.
@@ -355,46 +363,112 @@ clset_pset_enforce_limit(struct XCSF *xcsf)
 void
 clset_match(struct XCSF *xcsf, const double *x, const bool cover)
 {
-#ifdef PARALLEL_MATCH
-    // prepare for parallel processing of matching conditions
-    struct Clist *blist[xcsf->pset.size];
-    struct Clist *iter = xcsf->pset.list;
-    for (int i = 0; iter != NULL && i < xcsf->pset.size; ++i) {
-        blist[i] = iter;
-        iter = iter->next;
+    struct Cl **pset = xcsf->pset.cl;
+    const int psize = xcsf->pset.size;
+    const bool ternary = xcsf->cond->type == COND_TYPE_TERNARY;
+    const uint64_t *bitmap = NULL;
+    ++(xcsf->input_stamp);
+    if (cond_index_supported(xcsf)) {
+        bitmap = cond_index_match(xcsf, &xcsf->pset, x);
+    } else if (xcsf->cond->type == COND_TYPE_NEURAL) {
+        bitmap = cond_neural_batch_match(xcsf, &xcsf->pset, x);
+    } else if (ternary) {
+        // binarise the input once for all rules
+        cond_ternary_set_input(xcsf, x);
     }
+#ifdef PARALLEL_MATCH
     // process conditions and actions setting m flags in parallel
     #pragma omp parallel for
-    for (int i = 0; i < xcsf->pset.size; ++i) {
-        cl_match(xcsf, blist[i]->cl, x);
-        cl_action(xcsf, blist[i]->cl, x);
-    }
-    // build match set list in series
-    for (int i = 0; i < xcsf->pset.size; ++i) {
-        if (cl_m(xcsf, blist[i]->cl)) {
-            clset_add(&xcsf->mset, blist[i]->cl);
+    for (int i = 0; i < psize; ++i) {
+        clset_cl_match(xcsf, pset[i], x, bitmap, i);
+        cl_action(xcsf, pset[i], x);
+    }
+    // build match set in series
+    for (int i = 0; i < psize; ++i) {
+        if (cl_m(xcsf, pset[i])) {
+            clset_add(&xcsf->mset, pset[i]);
         }
     }
 #else
-    // process conditions and actions and build match set list in series
-    struct Clist *iter = xcsf->pset.list;
-    while (iter != NULL) {
-        if (cl_match(xcsf, iter->cl, x)) {
-            clset_add(&xcsf->mset, iter->cl);
-            cl_action(xcsf, iter->cl, x);
+    // process conditions and actions and build match set in series
+    for (int i = 0; i < psize; ++i) {
+        if (clset_cl_match(xcsf, pset[i], x, bitmap, i)) {
+            clset_add(&xcsf->mset, pset[i]);
+            cl_action(xcsf, pset[i], x);
         }
-        iter = iter->next;
     }
 #endif
     // perform covering if all actions are not represented
     if (cover && (xcsf->n_actions > 1 || xcsf->mset.size < 1)) {
         clset_cover(xcsf, x);
     }
+    if (ternary) {
+        cond_ternary_set_input(xcsf, NULL);
+    }
     // update statistics
     xcsf->mset_size += (xcsf->mset.size - xcsf->mset_size) * xcsf->BETA;
     xcsf->mfrac += (clset_mfrac(xcsf) - xcsf->mfrac) * xcsf->BETA;
 }
 
+/**
+ * @brief Returns whether the population can be matched concurrently.
+ * @details Neural and tree conditions keep evaluation state in the classifier
+ * and so must be matched one input at a time.
+ * @param [in] xcsf The XCSF data structure.
+ * @return Whether clset_match_bitmap() can be called concurrently.
+ */
+bool
+clset_match_concurrent(const struct XCSF *xcsf)
+{
+    switch (xcsf->cond->type) {
+        case COND_TYPE_DUMMY:
+        case COND_TYPE_HYPERRECTANGLE_CSR:
+        case COND_TYPE_HYPERRECTANGLE_UBR:
+        case COND_TYPE_HYPERELLIPSOID:
+        case COND_TYPE_TERNARY:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Calculates which population classifiers match an input.
+ * @details Unlike clset_match() no match set is built and neither the
+ * classifiers nor the statistics are updated, so different inputs can be
+ * matched concurrently when clset_match_concurrent() holds.
+ * @pre cond_index_update() has been called when conditions are indexed.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] x The input state.
+ * @param [out] bitmap Bit i is set if the i-th population classifier matches.
+ */
+void
+clset_match_bitmap(const struct XCSF *xcsf, const double *x, uint64_t *bitmap)
+{
+    const struct Set *pset = &xcsf->pset;
+    if (cond_index_supported(xcsf)) {
+        cond_index_bitmap(xcsf, x, bitmap);
+        return;
+    }
+    memset(bitmap, 0, sizeof(uint64_t) * ((pset->size + 63) / 64));
+    if (xcsf->cond->type == COND_TYPE_TERNARY) {
+        const int n_words = cond_ternary_input_words(xcsf);
+        uint64_t input[n_words];
+        cond_ternary_binarise(xcsf, x, input, n_words);
+        for (int i = 0; i < pset->size; ++i) {
+            if (cond_ternary_match_input(pset->cl[i], input)) {
+                bitmap[i >> 6] |= UINT64_C(1) << (i & 63);
+            }
+        }
+        return;
+    }
+    for (int i = 0; i < pset->size; ++i) {
+        if (cond_match(xcsf, pset->cl[i], x)) {
+            bitmap[i >> 6] |= UINT64_C(1) << (i & 63);
+        }
+    }
+}
+
 /**
  * @brief Constructs the action set from the match set.
  * @param [in] xcsf The XCSF data structure.
@@ -403,12 +477,10 @@ clset_match(struct XCSF *xcsf, const double *x, const bool cover)
 void
 clset_action(struct XCSF *xcsf, const int action)
 {
-    const struct Clist *iter = xcsf->mset.list;
-    while (iter != NULL) {
-        if (iter->cl->action == action) {
-            clset_add(&xcsf->aset, iter->cl);
+    for (int i = 0; i < xcsf->mset.size; ++i) {
+        if (xcsf->mset.cl[i]->action == action) {
+            clset_add(&xcsf->aset, xcsf->mset.cl[i]);
         }
-        iter = iter->next;
     }
     // update statistics
     xcsf->aset_size += (xcsf->aset.size - xcsf->aset_size) * xcsf->BETA;
@@ -416,28 +488,29 @@ clset_action(struct XCSF *xcsf, const int action)
 
 /**
  * @brief Adds a classifier to the set.
+ * @details The classifier is appended to the end of the set.
  * @param [in] set The set to add the classifier.
  * @param [in] c The classifier to add.
  */
 void
 clset_add(struct Set *set, struct Cl *c)
 {
-    if (set->list == NULL) {
-        set->list = malloc(sizeof(struct Clist));
-        set->list->cl = c;
-        set->list->next = NULL;
-    } else {
-        struct Clist *new = malloc(sizeof(struct Clist));
-        new->cl = c;
-        new->next = set->list;
-        set->list = new;
+    if (set->size == set->capacity) {
+        set->capacity =
+            (set->capacity > 0) ? set->capacity * 2 : SET_INIT_CAPACITY;
+        set->cl = realloc(set->cl, sizeof(struct Cl *) * set->capacity);
     }
+    set->cl[set->size] = c;
     ++(set->size);
     set->num += c->num;
 }
 
 /**
  * @brief Provides reinforcement to the set and performs set subsumption.
+ * @details Rules are updated and their accuracies computed in parallel.
+ * Updates may draw random numbers, e.g., to propagate dropout layers, so rules
+ * are assigned to threads statically in chunks for the per-thread random
+ * number streams to make runs reproducible.
  * @param [in] xcsf The XCSF data structure.
  * @param [in] set The set to provide reinforcement.
  * @param [in] x The input state.
@@ -448,25 +521,16 @@ void
 clset_update(struct XCSF *xcsf, struct Set *set, const double *x,
              const double *y, const bool cur)
 {
+    double *accs = malloc(sizeof(double) * set->size);
 #ifdef PARALLEL_UPDATE
-    struct Clist *blist[set->size];
-    struct Clist *iter = set->list;
-    for (int i = 0; iter != NULL && i < set->size; ++i) {
-        blist[i] = iter;
-        iter = iter->next;
-    }
-    #pragma omp parallel for
+    #pragma omp parallel for schedule(static, UPDATE_CHUNK)
+#endif
     for (int i = 0; i < set->size; ++i) {
-        cl_update(xcsf, blist[i]->cl, x, y, set->num, cur);
-    }
-#else
-    struct Clist *iter = set->list;
-    while (iter != NULL) {
-        cl_update(xcsf, iter->cl, x, y, set->num, cur);
-        iter = iter->next;
+        cl_update(xcsf, set->cl[i], x, y, set->num, cur);
+        accs[i] = cl_acc(xcsf, set->cl[i]);
     }
-#endif
-    clset_update_fit(xcsf, set);
+    clset_update_fit(xcsf, set, accs);
+    free(accs);
     if (xcsf->SET_SUBSUMPTION) {
         clset_subsumption(xcsf, set);
     }
@@ -474,33 +538,23 @@ clset_update(struct XCSF *xcsf, struct Set *set, const double *x,
 
 /**
  * @brief Removes classifiers with 0 numerosity from the set.
+ * @details The remaining classifiers are compacted in their existing order.
  * @param [in] set The set to validate.
  */
 void
 clset_validate(struct Set *set)
 {
-    set->size = 0;
+    int size = 0;
     set->num = 0;
-    struct Clist *prev = NULL;
-    struct Clist *iter = set->list;
-    while (iter != NULL) {
-        if (iter->cl == NULL || iter->cl->num == 0) {
-            if (prev == NULL) {
-                set->list = iter->next;
-                free(iter);
-                iter = set->list;
-            } else {
-                prev->next = iter->next;
-                free(iter);
-                iter = prev->next;
-            }
-        } else {
-            ++(set->size);
-            set->num += iter->cl->num;
-            prev = iter;
-            iter = iter->next;
+    for (int i = 0; i < set->size; ++i) {
+        struct Cl *c = set->cl[i];
+        if (c != NULL && c->num != 0) {
+            set->cl[size] = c;
+            ++size;
+            set->num += c->num;
         }
     }
+    set->size = size;
 }
 
 /**
@@ -529,10 +583,8 @@ clset_print(const struct XCSF *xcsf, const struct Set *set,
 void
 clset_set_times(const struct XCSF *xcsf, const struct Set *set)
 {
-    const struct Clist *iter = set->list;
-    while (iter != NULL) {
-        iter->cl->time = xcsf->time;
-        iter = iter->next;
+    for (int i = 0; i < set->size; ++i) {
+        set->cl[i]->time = xcsf->time;
     }
 }
 
@@ -545,10 +597,8 @@ double
 clset_total_fit(const struct Set *set)
 {
     double sum = 0;
-    const struct Clist *iter = set->list;
-    while (iter != NULL) {
-        sum += iter->cl->fit;
-        iter = iter->next;
+    for (int i = 0; i < set->size; ++i) {
+        sum += set->cl[i]->fit;
     }
     return sum;
 }
@@ -571,14 +621,8 @@ clset_mean_time(const struct Set *set)
 void
 clset_free(struct Set *set)
 {
-    struct Clist *iter = set->list;
-    while (iter != NULL) {
-        set->list = iter->next;
-        free(iter);
-        iter = set->list;
-    }
-    set->size = 0;
-    set->num = 0;
+    free(set->cl);
+    clset_init(set);
 }
 
 /**
@@ -589,15 +633,13 @@ clset_free(struct Set *set)
 void
 clset_kill(const struct XCSF *xcsf, struct Set *set)
 {
-    struct Clist *iter = set->list;
-    while (iter != NULL) {
-        cl_free(xcsf, iter->cl);
-        set->list = iter->next;
-        free(iter);
-        iter = set->list;
+    if (set == &xcsf->pset) {
+        del_index_clear(xcsf);
     }
-    set->size = 0;
-    set->num = 0;
+    for (int i = 0; i < set->size; ++i) {
+        cl_free(xcsf, set->cl[i]);
+    }
+    clset_free(set);
 }
 
 /**
@@ -612,33 +654,12 @@ clset_pset_save(const struct XCSF *xcsf, FILE *fp)
     size_t s = 0;
     s += fwrite(&xcsf->pset.size, sizeof(int), 1, fp);
     s += fwrite(&xcsf->pset.num, sizeof(int), 1, fp);
-    const struct Clist *iter = xcsf->pset.list;
-    while (iter != NULL) {
-        s += cl_save(xcsf, iter->cl, fp);
-        iter = iter->next;
+    for (int i = 0; i < xcsf->pset.size; ++i) {
+        s += cl_save(xcsf, xcsf->pset.cl[i], fp);
     }
     return s;
 }
 
-/**
- * @brief Reverses the order of the population classifier list.
- * @param [in] xcsf The XCSF data structure.
- */
-static void
-clset_pset_reverse(struct XCSF *xcsf)
-{
-    struct Clist *current = xcsf->pset.list;
-    struct Clist *prev = NULL;
-    struct Clist *next = NULL;
-    while (current != NULL) {
-        next = current->next;
-        current->next = prev;
-        prev = current;
-        current = next;
-    }
-    xcsf->pset.list = prev;
-}
-
 /**
  * @brief Reads the population set from a file.
  * @param [in] xcsf The XCSF data structure.
@@ -659,7 +680,6 @@ clset_pset_load(struct XCSF *xcsf, FILE *fp)
         s += cl_load(xcsf, c, fp);
         clset_add(&xcsf->pset, c);
     }
-    clset_pset_reverse(xcsf); // reverse population list for consistency
     return s;
 }
 
@@ -674,11 +694,9 @@ clset_mean_cond_size(const struct XCSF *xcsf, const struct Set *set)
 {
     double sum = 0;
     int cnt = 0;
-    const struct Clist *iter = set->list;
-    while (iter != NULL) {
-        sum += cl_cond_size(xcsf, iter->cl);
+    for (int i = 0; i < set->size; ++i) {
+        sum += cl_cond_size(xcsf, set->cl[i]);
         ++cnt;
-        iter = iter->next;
     }
     return sum / cnt;
 }
@@ -694,11 +712,9 @@ clset_mean_pred_size(const struct XCSF *xcsf, const struct Set *set)
 {
     double sum = 0;
     int cnt = 0;
-    const struct Clist *iter = set->list;
-    while (iter != NULL) {
-        sum += cl_pred_size(xcsf, iter->cl);
+    for (int i = 0; i < set->size; ++i) {
+        sum += cl_pred_size(xcsf, set->cl[i]);
         ++cnt;
-        iter = iter->next;
     }
     return sum / cnt;
 }
@@ -713,29 +729,26 @@ double
 clset_mfrac(const struct XCSF *xcsf)
 {
     double mfrac = 0;
+    const struct Set *pset = &xcsf->pset;
     // most general rule below E0
-    const struct Clist *iter = xcsf->pset.list;
-    while (iter != NULL) {
-        const double e = iter->cl->err;
-        if (e < xcsf->E0 && iter->cl->exp * xcsf->BETA > 1) {
-            const double m = cl_mfrac(xcsf, iter->cl);
+    for (int i = 0; i < pset->size; ++i) {
+        const struct Cl *c = pset->cl[i];
+        if (c->err < xcsf->E0 && c->exp * xcsf->BETA > 1) {
+            const double m = cl_mfrac(xcsf, c);
             if (m > mfrac) {
                 mfrac = m;
             }
         }
-        iter = iter->next;
     }
     // lowest error rule
     if (mfrac == 0) {
         double error = DBL_MAX;
-        iter = xcsf->pset.list;
-        while (iter != NULL) {
-            const double e = iter->cl->err;
-            if (e < error && iter->cl->exp * xcsf->BETA > 1) {
-                mfrac = cl_mfrac(xcsf, iter->cl);
-                error = e;
+        for (int i = 0; i < pset->size; ++i) {
+            const struct Cl *c = pset->cl[i];
+            if (c->err < error && c->exp * xcsf->BETA > 1) {
+                mfrac = cl_mfrac(xcsf, c);
+                error = c->err;
             }
-            iter = iter->next;
         }
     }
     return mfrac;
@@ -757,14 +770,12 @@ clset_json_export(const struct XCSF *xcsf, const struct Set *set,
 {
     cJSON *json = cJSON_CreateObject();
     cJSON *classifiers = cJSON_AddArrayToObject(json, "classifiers");
-    const struct Clist *iter = set->list;
-    while (iter != NULL) {
-        char *str = cl_json_export(xcsf, iter->cl, return_cond, return_act,
+    for (int i = 0; i < set->size; ++i) {
+        char *str = cl_json_export(xcsf, set->cl[i], return_cond, return_act,
                                    return_pred);
         cJSON *classifier = cJSON_Parse(str);
         cJSON_AddItemToArray(classifiers, classifier);
         free(str);
-        iter = iter->next;
     }
     char *string = cJSON_Print(json);
     cJSON_Delete(json);
@@ -798,16 +809,10 @@ clset_json_insert(struct XCSF *xcsf, const char *json_str)
     cJSON *json = cJSON_Parse(json_str);
     utils_json_parse_check(json);
     if (json->child != NULL && cJSON_IsArray(json->child)) {
-        cJSON *tail = json->child->child; // insert inverted for consistency
-        if (tail != NULL) {
-            tail->prev = NULL; // this should have been set by cJSON!
-            while (tail->next != NULL) {
-                tail = tail->next;
-            }
-            while (tail != NULL) {
-                clset_json_insert_cl(xcsf, tail);
-                tail = tail->prev;
-            }
+        // insert in order for consistency with the exported set
+        for (const cJSON *iter = json->child->child; iter != NULL;
+             iter = iter->next) {
+            clset_json_insert_cl(xcsf, iter);
         }
     }
     cJSON_Delete(json);
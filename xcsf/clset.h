@@ -17,7 +17,7 @@
  * @file clset.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2023.
+ * @date 2015--2026.
  * @brief Functions operating on sets of classifiers.
  */
 
@@ -52,6 +52,9 @@ clset_action(struct XCSF *xcsf, const int action);
 void
 clset_add(struct Set *set, struct Cl *c);
 
+void
+clset_clear(struct Set *set);
+
 void
 clset_free(struct Set *set);
 
@@ -64,6 +67,12 @@ clset_kill(const struct XCSF *xcsf, struct Set *set);
 void
 clset_match(struct XCSF *xcsf, const double *x, const bool cover);
 
+bool
+clset_match_concurrent(const struct XCSF *xcsf);
+
+void
+clset_match_bitmap(const struct XCSF *xcsf, const double *x, uint64_t *bitmap);
+
 void
 clset_pset_enforce_limit(struct XCSF *xcsf);
 
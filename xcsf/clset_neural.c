@@ -42,11 +42,9 @@ clset_mean_cond_layers(const struct XCSF *xcsf, const struct Set *set)
     int cnt = 0;
     if (xcsf->cond->type == COND_TYPE_NEURAL ||
         xcsf->cond->type == RULE_TYPE_NEURAL) {
-        const struct Clist *iter = set->list;
-        while (iter != NULL) {
-            sum += cond_neural_layers(xcsf, iter->cl);
+        for (int i = 0; i < set->size; ++i) {
+            sum += cond_neural_layers(xcsf, set->cl[i]);
             ++cnt;
-            iter = iter->next;
         }
     }
     if (cnt != 0) {
@@ -69,11 +67,9 @@ clset_mean_cond_neurons(const struct XCSF *xcsf, const struct Set *set,
     int cnt = 0;
     if (xcsf->cond->type == COND_TYPE_NEURAL ||
         xcsf->cond->type == RULE_TYPE_NEURAL) {
-        const struct Clist *iter = set->list;
-        while (iter != NULL) {
-            sum += cond_neural_neurons(xcsf, iter->cl, layer);
+        for (int i = 0; i < set->size; ++i) {
+            sum += cond_neural_neurons(xcsf, set->cl[i], layer);
             ++cnt;
-            iter = iter->next;
         }
     }
     if (cnt != 0) {
@@ -97,11 +93,9 @@ clset_mean_cond_connections(const struct XCSF *xcsf, const struct Set *set,
     int cnt = 0;
     if (xcsf->cond->type == COND_TYPE_NEURAL ||
         xcsf->cond->type == RULE_TYPE_NEURAL) {
-        const struct Clist *iter = set->list;
-        while (iter != NULL) {
-            sum += cond_neural_connections(xcsf, iter->cl, layer);
+        for (int i = 0; i < set->size; ++i) {
+            sum += cond_neural_connections(xcsf, set->cl[i], layer);
             ++cnt;
-            iter = iter->next;
         }
     }
     if (cnt != 0) {
@@ -124,11 +118,9 @@ clset_mean_pred_neurons(const struct XCSF *xcsf, const struct Set *set,
     int sum = 0;
     int cnt = 0;
     if (xcsf->pred->type == PRED_TYPE_NEURAL) {
-        const struct Clist *iter = set->list;
-        while (iter != NULL) {
-            sum += pred_neural_neurons(xcsf, iter->cl, layer);
+        for (int i = 0; i < set->size; ++i) {
+            sum += pred_neural_neurons(xcsf, set->cl[i], layer);
             ++cnt;
-            iter = iter->next;
         }
     }
     if (cnt != 0) {
@@ -149,11 +141,9 @@ clset_mean_pred_layers(const struct XCSF *xcsf, const struct Set *set)
     int sum = 0;
     int cnt = 0;
     if (xcsf->pred->type == PRED_TYPE_NEURAL) {
-        const struct Clist *iter = set->list;
-        while (iter != NULL) {
-            sum += pred_neural_layers(xcsf, iter->cl);
+        for (int i = 0; i < set->size; ++i) {
+            sum += pred_neural_layers(xcsf, set->cl[i]);
             ++cnt;
-            iter = iter->next;
         }
     }
     if (cnt != 0) {
@@ -176,11 +166,9 @@ clset_mean_pred_eta(const struct XCSF *xcsf, const struct Set *set,
     double sum = 0;
     int cnt = 0;
     if (xcsf->pred->type == PRED_TYPE_NEURAL) {
-        const struct Clist *iter = set->list;
-        while (iter != NULL) {
-            sum += pred_neural_eta(xcsf, iter->cl, layer);
+        for (int i = 0; i < set->size; ++i) {
+            sum += pred_neural_eta(xcsf, set->cl[i], layer);
             ++cnt;
-            iter = iter->next;
         }
     }
     if (cnt != 0) {
@@ -203,11 +191,9 @@ clset_mean_pred_connections(const struct XCSF *xcsf, const struct Set *set,
     int sum = 0;
     int cnt = 0;
     if (xcsf->pred->type == PRED_TYPE_NEURAL) {
-        const struct Clist *iter = set->list;
-        while (iter != NULL) {
-            sum += pred_neural_connections(xcsf, iter->cl, layer);
+        for (int i = 0; i < set->size; ++i) {
+            sum += pred_neural_connections(xcsf, set->cl[i], layer);
             ++cnt;
-            iter = iter->next;
         }
     }
     if (cnt != 0) {
@@ -17,11 +17,12 @@
  * @file cond_ellipsoid.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2019--2021.
+ * @date 2019--2026.
  * @brief Hyperellipsoid condition functions.
  */
 
 #include "cond_ellipsoid.h"
+#include "cond_index.h"
 #include "ea.h"
 #include "sam.h"
 #include "utils.h"
@@ -85,8 +86,8 @@ cond_ellipsoid_init(const struct XCSF *xcsf, struct Cl *c)
 void
 cond_ellipsoid_free(const struct XCSF *xcsf, const struct Cl *c)
 {
-    (void) xcsf;
     const struct CondEllipsoid *cond = c->cond;
+    cond_index_invalidate(xcsf, c);
     free(cond->center);
     free(cond->spread);
     free(cond->mu);
@@ -130,6 +131,7 @@ cond_ellipsoid_cover(const struct XCSF *xcsf, const struct Cl *c,
         cond->center[i] = x[i];
         cond->spread[i] = rand_uniform(xcsf->cond->spread_min, spread_max);
     }
+    cond_index_invalidate(xcsf, c);
 }
 
 /**
@@ -149,6 +151,7 @@ cond_ellipsoid_update(const struct XCSF *xcsf, const struct Cl *c,
         for (int i = 0; i < xcsf->x_dim; ++i) {
             cond->center[i] += xcsf->cond->eta * (x[i] - cond->center[i]);
         }
+        cond_index_invalidate(xcsf, c);
     }
 }
 
@@ -166,6 +169,28 @@ cond_ellipsoid_match(const struct XCSF *xcsf, const struct Cl *c,
     return (cond_ellipsoid_dist(xcsf, c, x) < 1);
 }
 
+/**
+ * @brief Returns an axis-aligned box enclosing a hyperellipsoid condition.
+ * @details The box is widened slightly so that it always contains every input
+ * matched by the hyperellipsoid despite rounding.
+ * @param [in] xcsf XCSF data structure.
+ * @param [in] c Classifier whose condition bounds are returned.
+ * @param [out] lb Lower bound in each dimension.
+ * @param [out] ub Upper bound in each dimension.
+ */
+void
+cond_ellipsoid_bounds(const struct XCSF *xcsf, const struct Cl *c, double *lb,
+                      double *ub)
+{
+    const struct CondEllipsoid *cond = c->cond;
+    for (int i = 0; i < xcsf->x_dim; ++i) {
+        const double spread = fabs(cond->spread[i]);
+        const double r = spread + 1e-9 * (spread + fabs(cond->center[i]));
+        lb[i] = cond->center[i] - r;
+        ub[i] = cond->center[i] + r;
+    }
+}
+
 /**
  * @brief Performs uniform crossover with two hyperellipsoid conditions.
  * @param [in] xcsf XCSF data structure.
@@ -196,6 +221,10 @@ cond_ellipsoid_crossover(const struct XCSF *xcsf, const struct Cl *c1,
             }
         }
     }
+    if (changed) {
+        cond_index_invalidate(xcsf, c1);
+        cond_index_invalidate(xcsf, c2);
+    }
     return changed;
 }
 
@@ -227,6 +256,9 @@ cond_ellipsoid_mutate(const struct XCSF *xcsf, const struct Cl *c)
             changed = true;
         }
     }
+    if (changed) {
+        cond_index_invalidate(xcsf, c);
+    }
     return changed;
 }
 
@@ -390,4 +422,5 @@ cond_ellipsoid_json_import(const struct XCSF *xcsf, struct Cl *c,
         }
     }
     sam_json_import(cond->mu, N_MU, json);
+    cond_index_invalidate(xcsf, c);
 }
@@ -17,7 +17,7 @@
  * @file cond_ellipsoid.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2019--2021.
+ * @date 2019--2026.
  * @brief Hyperellipsoid condition functions.
  */
 
@@ -35,6 +35,10 @@ struct CondEllipsoid {
     double *mu; //!< Mutation rates
 };
 
+void
+cond_ellipsoid_bounds(const struct XCSF *xcsf, const struct Cl *c, double *lb,
+                      double *ub);
+
 bool
 cond_ellipsoid_crossover(const struct XCSF *xcsf, const struct Cl *c1,
                          const struct Cl *c2);
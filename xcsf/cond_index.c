@@ -0,0 +1,364 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cond_index.c
+ * @author Richard Preen <rpreen@gmail.com>
+ * @copyright The Authors.
+ * @date 2026.
+ * @brief Population index for matching interval conditions.
+ * @details Hyperrectangles are matched exactly from their boxes;
+ * hyperellipsoids are filtered by their enclosing boxes and the remaining
+ * candidates matched exactly.
+ */
+
+#include "cond_index.h"
+#include "cond_ellipsoid.h"
+
+#define INDEX_TILE (BATCH_TILE) //!< Number of columns per bitmap word
+#define INDEX_MAX_MFRAC (0.2) //!< Largest match set fraction to use the bins
+
+/**
+ * @brief Returns whether the condition type can be matched with the index.
+ * @param [in] xcsf The XCSF data structure.
+ * @return Whether conditions are hyperrectangles or hyperellipsoids.
+ */
+bool
+cond_index_supported(const struct XCSF *xcsf)
+{
+    switch (xcsf->cond->type) {
+        case COND_TYPE_HYPERRECTANGLE_CSR:
+        case COND_TYPE_HYPERRECTANGLE_UBR:
+        case COND_TYPE_HYPERELLIPSOID:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Returns the bin containing a value.
+ * @details Values outside of [min, max] fall in the first or last bin.
+ * @param [in] index The condition index.
+ * @param [in] v The value.
+ * @return The bin number.
+ */
+static inline int
+cond_index_bin(const struct CondIndex *index, const double v)
+{
+    const double f = (v - index->bin_min) * index->bin_scale;
+    if (!(f > 0)) {
+        return 0;
+    }
+    if (f >= INDEX_BINS) {
+        return INDEX_BINS - 1;
+    }
+    return (int) f;
+}
+
+/**
+ * @brief Discards all columns if the dimensionality or input range changed.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] index The condition index.
+ */
+static void
+cond_index_reset(const struct XCSF *xcsf, struct CondIndex *index)
+{
+    const double range = xcsf->cond->max - xcsf->cond->min;
+    const double scale = (range > 0) ? INDEX_BINS / range : 0;
+    if (index->x_dim == xcsf->x_dim && index->bin_min == xcsf->cond->min &&
+        index->bin_scale == scale) {
+        return;
+    }
+    for (int j = 0; j < index->capacity; ++j) {
+        index->cl[j] = NULL;
+    }
+    cond_rectangle_batch_free(&index->boxes);
+    free(index->bins);
+    index->bins = NULL;
+    index->tmp_lb = realloc(index->tmp_lb, sizeof(double) * xcsf->x_dim);
+    index->tmp_ub = realloc(index->tmp_ub, sizeof(double) * xcsf->x_dim);
+    index->x_dim = xcsf->x_dim;
+    index->bin_min = xcsf->cond->min;
+    index->bin_scale = scale;
+    index->size = 0;
+    index->capacity = 0;
+}
+
+/**
+ * @brief Resizes the condition index to hold at least n columns.
+ * @details Capacity is kept a multiple of the tile width so that every tile
+ * can be evaluated at full width; columns beyond the set size are ignored.
+ * @param [in] index The condition index.
+ * @param [in] n The number of columns required.
+ */
+static void
+cond_index_resize(struct CondIndex *index, const int n)
+{
+    if (n <= index->capacity && index->bins != NULL) {
+        return;
+    }
+    int capacity = index->capacity > 0 ? index->capacity : INDEX_TILE;
+    while (capacity < n) {
+        capacity *= 2;
+    }
+    const int x_dim = index->x_dim;
+    const int words = capacity / INDEX_TILE;
+    const int prev_words = index->capacity / INDEX_TILE;
+    const int n_rows = x_dim * INDEX_BINS;
+    cond_rectangle_batch_resize(&index->boxes, x_dim, capacity);
+    uint64_t *bins = calloc((size_t) n_rows * words, sizeof(uint64_t));
+    if (index->bins != NULL) {
+        for (int r = 0; r < n_rows; ++r) {
+            memcpy(&bins[r * words], &index->bins[r * prev_words],
+                   sizeof(uint64_t) * prev_words);
+        }
+    }
+    free(index->bins);
+    index->bins = bins;
+    index->cl = realloc(index->cl, sizeof(struct Cl *) * capacity);
+    for (int j = index->capacity; j < capacity; ++j) {
+        index->cl[j] = NULL;
+    }
+    index->bitmap = realloc(index->bitmap, sizeof(uint64_t) * words);
+    index->capacity = capacity;
+}
+
+/**
+ * @brief Writes the bounds of a classifier condition to a column.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] index The condition index.
+ * @param [in] c The classifier.
+ * @param [in] j The column to write.
+ */
+static void
+cond_index_set(const struct XCSF *xcsf, struct CondIndex *index,
+               const struct Cl *c, const int j)
+{
+    if (xcsf->cond->type == COND_TYPE_HYPERELLIPSOID) {
+        cond_ellipsoid_bounds(xcsf, c, index->tmp_lb, index->tmp_ub);
+    } else {
+        cond_rectangle_bounds(xcsf, c, index->tmp_lb, index->tmp_ub);
+    }
+    cond_rectangle_batch_set(&index->boxes, j, index->tmp_lb, index->tmp_ub);
+    const int words = index->capacity / INDEX_TILE;
+    const uint64_t bit = UINT64_C(1) << (j % INDEX_TILE);
+    for (int i = 0; i < index->x_dim; ++i) {
+        const double lb = index->tmp_lb[i];
+        const double ub = index->tmp_ub[i];
+        // a NaN bound never excludes an input
+        const int lo = isnan(lb) ? 0 : cond_index_bin(index, lb);
+        const int hi = isnan(ub) ? INDEX_BINS - 1 : cond_index_bin(index, ub);
+        uint64_t *bins = &index->bins[i * INDEX_BINS * words + j / INDEX_TILE];
+        for (int b = 0; b < INDEX_BINS; ++b) {
+            if (b >= lo && b <= hi) {
+                bins[b * words] |= bit;
+            } else {
+                bins[b * words] &= ~bit;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Makes the columns of the condition index mirror a set.
+ * @details Only columns whose classifier differs from the set are rewritten;
+ * columns beyond the set size are released so that a freed classifier can
+ * never be mistaken for a new one allocated at the same address.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] index The condition index.
+ * @param [in] set The set of classifiers.
+ */
+static void
+cond_index_sync(const struct XCSF *xcsf, struct CondIndex *index,
+                const struct Set *set)
+{
+    cond_index_reset(xcsf, index);
+    cond_index_resize(index, set->size);
+    for (int j = 0; j < set->size; ++j) {
+        struct Cl *c = set->cl[j];
+        if (index->cl[j] != c) {
+            cond_index_set(xcsf, index, c, j);
+            index->cl[j] = c;
+            c->cond_slot = j;
+        }
+    }
+    for (int j = set->size; j < index->size; ++j) {
+        index->cl[j] = NULL;
+    }
+    index->size = set->size;
+}
+
+/**
+ * @brief Matches the boxes of the candidate columns in one bitmap word.
+ * @details Candidates are the columns whose boxes overlap the bin containing
+ * the input in every dimension; each is then checked against its box.
+ * @param [in] index The condition index.
+ * @param [in] x Input state.
+ * @param [in] xbin The bin containing the input in each dimension, or -1.
+ * @param [in] w The bitmap word.
+ * @return Bitmap of the columns within the word whose box contains x.
+ */
+static uint64_t
+cond_index_candidates(const struct CondIndex *index, const double *x,
+                      const int *xbin, const int w)
+{
+    const struct CondRectangleBatch *boxes = &index->boxes;
+    const int stride = boxes->capacity;
+    const int words = stride / INDEX_TILE;
+    uint64_t cand = ~UINT64_C(0);
+    for (int i = 0; i < index->x_dim && cand; ++i) {
+        if (xbin[i] >= 0) {
+            cand &= index->bins[(i * INDEX_BINS + xbin[i]) * words + w];
+        }
+    }
+    uint64_t word = cand;
+    while (cand) {
+        const int k = __builtin_ctzll(cand);
+        const int j = w * INDEX_TILE + k;
+        cand &= cand - 1;
+        for (int i = 0; i < index->x_dim; ++i) {
+            if (x[i] < boxes->lb[i * stride + j] ||
+                x[i] > boxes->ub[i * stride + j]) {
+                word &= ~(UINT64_C(1) << k);
+                break;
+            }
+        }
+    }
+    return word;
+}
+
+/**
+ * @brief Brings the condition index up to date with a set.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] set The set of classifiers to be matched.
+ */
+void
+cond_index_update(const struct XCSF *xcsf, const struct Set *set)
+{
+    if (xcsf->cond->index == NULL) {
+        xcsf->cond->index = calloc(1, sizeof(struct CondIndex));
+    }
+    cond_index_sync(xcsf, xcsf->cond->index, set);
+}
+
+/**
+ * @brief Calculates which indexed classifiers match an input.
+ * @details Boxes are tested a tile of columns at a time so that the compiler
+ * can vectorise across rules. When only a small fraction of rules match, the
+ * bins are used instead so that only candidate columns are tested. Finding the
+ * candidates still ANDs one bin bitmap per dimension over every word, so the
+ * cost remains O(N·x_dim/64) rather than proportional to the number of
+ * matches. Neither the index nor the classifiers are modified, so different
+ * inputs may be matched concurrently.
+ * @pre The index has been updated with the set to be matched.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] x Input state.
+ * @param [out] bitmap Bit j is set if the j-th classifier in the set matches.
+ */
+void
+cond_index_bitmap(const struct XCSF *xcsf, const double *x, uint64_t *bitmap)
+{
+    const struct CondIndex *index = xcsf->cond->index;
+    const int n_words = (index->size + INDEX_TILE - 1) / INDEX_TILE;
+    const bool sparse = xcsf->mset_size < INDEX_MAX_MFRAC * index->size;
+    int xbin[index->x_dim];
+    for (int i = 0; i < index->x_dim; ++i) {
+        xbin[i] = isnan(x[i]) ? -1 : cond_index_bin(index, x[i]);
+    }
+#ifdef PARALLEL_MATCH
+    #pragma omp parallel for
+#endif
+    for (int w = 0; w < n_words; ++w) {
+        if (sparse) {
+            bitmap[w] = cond_index_candidates(index, x, xbin, w);
+        } else {
+            bitmap[w] =
+                cond_rectangle_batch_tile(&index->boxes, x, w * INDEX_TILE);
+        }
+    }
+    const int tail = index->size % INDEX_TILE;
+    if (tail > 0) {
+        bitmap[n_words - 1] &= (UINT64_C(1) << tail) - 1;
+    }
+    if (xcsf->cond->type == COND_TYPE_HYPERELLIPSOID) {
+        // boxes enclose the hyperellipsoids: match the candidates exactly
+#ifdef PARALLEL_MATCH
+    #pragma omp parallel for
+#endif
+        for (int w = 0; w < n_words; ++w) {
+            uint64_t cand = bitmap[w];
+            while (cand) {
+                const int k = __builtin_ctzll(cand);
+                cand &= cand - 1;
+                if (!cond_match(xcsf, index->cl[w * INDEX_TILE + k], x)) {
+                    bitmap[w] &= ~(UINT64_C(1) << k);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Calculates which classifiers in a set match an input.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] set The set of classifiers to match.
+ * @param [in] x Input state.
+ * @return Bitmap where bit j is set if the j-th classifier in the set matches.
+ */
+const uint64_t *
+cond_index_match(const struct XCSF *xcsf, const struct Set *set,
+                 const double *x)
+{
+    cond_index_update(xcsf, set);
+    cond_index_bitmap(xcsf, x, xcsf->cond->index->bitmap);
+    return xcsf->cond->index->bitmap;
+}
+
+/**
+ * @brief Releases the column of a classifier whose condition has changed.
+ * @details The column is rewritten the next time the index is matched.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] c The classifier.
+ */
+void
+cond_index_invalidate(const struct XCSF *xcsf, const struct Cl *c)
+{
+    struct CondIndex *index = xcsf->cond->index;
+    const int j = c->cond_slot;
+    if (index != NULL && j >= 0 && j < index->capacity && index->cl[j] == c) {
+        index->cl[j] = NULL;
+    }
+}
+
+/**
+ * @brief Frees the condition index.
+ * @param [in] xcsf The XCSF data structure.
+ */
+void
+cond_index_free(const struct XCSF *xcsf)
+{
+    struct CondIndex *index = xcsf->cond->index;
+    if (index != NULL) {
+        cond_rectangle_batch_free(&index->boxes);
+        free(index->cl);
+        free(index->bins);
+        free(index->bitmap);
+        free(index->tmp_lb);
+        free(index->tmp_ub);
+        free(index);
+        xcsf->cond->index = NULL;
+    }
+}
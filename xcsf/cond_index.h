@@ -0,0 +1,71 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cond_index.h
+ * @author Richard Preen <rpreen@gmail.com>
+ * @copyright The Authors.
+ * @date 2026.
+ * @brief Population index for matching interval conditions.
+ */
+
+#pragma once
+
+#include "cond_rectangle.h"
+#include "condition.h"
+#include "xcsf.h"
+
+#define INDEX_BINS (16) //!< Number of bins each input dimension is split into
+
+/**
+ * @brief Index of the bounds of a set of interval conditions.
+ * @details Each classifier occupies a column of a hyperrectangle batched
+ * matching block holding its (enclosing) box. Each dimension is also split
+ * into INDEX_BINS equal bins over [min, max] with a bitmap of the columns whose
+ * box overlaps each bin, so that candidates for an input can be found by
+ * ANDing one bitmap per dimension.
+ */
+struct CondIndex {
+    struct CondRectangleBatch boxes; //!< Box of each column
+    const struct Cl **cl; //!< Classifier held in each column
+    uint64_t *bins; //!< Bin bitmaps [x_dim][INDEX_BINS][capacity / 64]
+    uint64_t *bitmap; //!< Match results, one bit per column
+    double *tmp_lb; //!< Temporary storage for the bounds of one column
+    double *tmp_ub; //!< Temporary storage for the bounds of one column
+    double bin_min; //!< Lower edge of the first bin
+    double bin_scale; //!< Number of bins per unit of input
+    int size; //!< Number of columns in use
+    int capacity; //!< Number of columns allocated
+    int x_dim; //!< Number of dimensions allocated
+};
+
+bool
+cond_index_supported(const struct XCSF *xcsf);
+
+void
+cond_index_update(const struct XCSF *xcsf, const struct Set *set);
+
+void
+cond_index_bitmap(const struct XCSF *xcsf, const double *x, uint64_t *bitmap);
+
+const uint64_t *
+cond_index_match(const struct XCSF *xcsf, const struct Set *set,
+                 const double *x);
+
+void
+cond_index_invalidate(const struct XCSF *xcsf, const struct Cl *c);
+
+void
+cond_index_free(const struct XCSF *xcsf);
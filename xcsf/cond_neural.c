@@ -17,11 +17,12 @@
  * @file cond_neural.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2016--2022.
+ * @date 2016--2026.
  * @brief Multi-layer perceptron neural network condition functions.
  */
 
 #include "cond_neural.h"
+#include "cond_neural_batch.h"
 #include "neural_activations.h"
 #include "neural_layer_connected.h"
 #include "neural_layer_convolutional.h"
@@ -54,7 +55,7 @@ cond_neural_init(const struct XCSF *xcsf, struct Cl *c)
 void
 cond_neural_free(const struct XCSF *xcsf, const struct Cl *c)
 {
-    (void) xcsf;
+    cond_neural_batch_invalidate(xcsf, c);
     struct CondNeural *cond = c->cond;
     neural_free(&cond->net);
     free(c->cond);
@@ -85,6 +86,7 @@ cond_neural_copy(const struct XCSF *xcsf, struct Cl *dest, const struct Cl *src)
 void
 cond_neural_cover(const struct XCSF *xcsf, const struct Cl *c, const double *x)
 {
+    cond_neural_batch_invalidate(xcsf, c);
     const struct CondNeural *cond = c->cond;
     do {
         neural_rand(&cond->net);
@@ -118,7 +120,7 @@ bool
 cond_neural_match(const struct XCSF *xcsf, const struct Cl *c, const double *x)
 {
     struct CondNeural *cond = c->cond;
-    neural_propagate(&cond->net, x, xcsf->explore);
+    neural_propagate(&cond->net, x, xcsf->explore, xcsf->FAST_ACTIVATIONS);
     if (neural_output(&cond->net, 0) > 0.5) {
         return true;
     }
@@ -134,9 +136,12 @@ cond_neural_match(const struct XCSF *xcsf, const struct Cl *c, const double *x)
 bool
 cond_neural_mutate(const struct XCSF *xcsf, const struct Cl *c)
 {
-    (void) xcsf;
-    const struct CondNeural *cond = c->cond;
-    return neural_mutate(&cond->net);
+    struct CondNeural *cond = c->cond;
+    if (neural_mutate(&cond->net)) {
+        cond_neural_batch_invalidate(xcsf, c);
+        return true;
+    }
+    return false;
 }
 
 /**
@@ -341,6 +346,7 @@ cond_neural_json_import(const struct XCSF *xcsf, struct Cl *c,
     }
     struct CondNeural *cond = c->cond;
     neural_json_import(&cond->net, xcsf->cond->largs, item);
+    cond_neural_batch_invalidate(xcsf, c);
 }
 
 /**
@@ -0,0 +1,510 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cond_neural_batch.c
+ * @author Richard Preen <rpreen@gmail.com>
+ * @copyright The Authors.
+ * @date 2026.
+ * @brief Batched inference of neural network conditions.
+ * @details Every neural condition in the population sees the same input, so
+ * the first layers of all networks with the same topology are evaluated by a
+ * single matrix-vector product over their stacked weights. Later layers take
+ * a different input for each network and are evaluated member by member from
+ * the same contiguous block.
+ */
+
+#include "cond_neural_batch.h"
+#include "blas.h"
+#include "cond_neural.h"
+#include "neural_activations.h"
+#include "neural_layer.h"
+
+/**
+ * @brief Returns whether a network can be evaluated in a group.
+ * @details Only connected layers are batched since they keep no state between
+ * inputs and behave the same whether or not the network is training.
+ * @param [in] net The neural network.
+ * @param [in] x_dim The number of network inputs.
+ * @return Whether the network is made only of connected layers.
+ */
+static bool
+cond_neural_batch_eligible(const struct Net *net, const int x_dim)
+{
+    if (net->tail == NULL || net->tail->layer->n_inputs != x_dim) {
+        return false;
+    }
+    for (const struct Llist *iter = net->tail; iter != NULL;
+         iter = iter->prev) {
+        if (iter->layer->type != CONNECTED) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Returns whether a network has the topology of a group.
+ * @param [in] group The group.
+ * @param [in] net The neural network.
+ * @return Whether each layer has the same number of outputs.
+ */
+static bool
+cond_neural_group_fits(const struct CondNeuralGroup *group,
+                       const struct Net *net)
+{
+    if (group->n_layers != net->n_layers) {
+        return false;
+    }
+    int l = 0;
+    for (const struct Llist *iter = net->tail; iter != NULL;
+         iter = iter->prev) {
+        if (iter->layer->n_outputs != group->n_outputs[l]) {
+            return false;
+        }
+        ++l;
+    }
+    return true;
+}
+
+/**
+ * @brief Frees the memory used by a group.
+ * @param [in] group The group to be freed.
+ */
+static void
+cond_neural_group_free(struct CondNeuralGroup *group)
+{
+    for (int l = 0; l < group->n_layers; ++l) {
+        free(group->w[l]);
+        free(group->b[l]);
+        free(group->out[l]);
+    }
+    free(group->w);
+    free(group->b);
+    free(group->out);
+    free(group->n_outputs);
+    free(group->col);
+    free(group->function);
+    memset(group, 0, sizeof(struct CondNeuralGroup));
+}
+
+/**
+ * @brief Sets the topology of an empty group to that of a network.
+ * @param [in] group The group.
+ * @param [in] net The neural network.
+ */
+static void
+cond_neural_group_init(struct CondNeuralGroup *group, const struct Net *net)
+{
+    cond_neural_group_free(group);
+    group->n_layers = net->n_layers;
+    group->n_outputs = malloc(sizeof(int) * net->n_layers);
+    group->w = calloc(net->n_layers, sizeof(neural_real *));
+    group->b = calloc(net->n_layers, sizeof(neural_real *));
+    group->out = calloc(net->n_layers, sizeof(neural_real *));
+    int l = 0;
+    for (const struct Llist *iter = net->tail; iter != NULL;
+         iter = iter->prev) {
+        group->n_outputs[l] = iter->layer->n_outputs;
+        ++l;
+    }
+}
+
+/**
+ * @brief Resizes a group to hold at least n members.
+ * @param [in] group The group.
+ * @param [in] x_dim The number of network inputs.
+ * @param [in] n The number of members required.
+ */
+static void
+cond_neural_group_resize(struct CondNeuralGroup *group, const int x_dim,
+                         const int n)
+{
+    if (n <= group->capacity) {
+        return;
+    }
+    int capacity = group->capacity > 0 ? group->capacity : 8;
+    while (capacity < n) {
+        capacity *= 2;
+    }
+    int n_inputs = x_dim;
+    for (int l = 0; l < group->n_layers; ++l) {
+        const size_t n_outputs = group->n_outputs[l];
+        const size_t n_weights = n_outputs * n_inputs;
+        group->w[l] =
+            realloc(group->w[l], sizeof(neural_real) * n_weights * capacity);
+        group->b[l] =
+            realloc(group->b[l], sizeof(neural_real) * n_outputs * capacity);
+        group->out[l] =
+            realloc(group->out[l], sizeof(neural_real) * n_outputs * capacity);
+        n_inputs = n_outputs;
+    }
+    group->col = realloc(group->col, sizeof(int) * capacity);
+    group->function =
+        realloc(group->function, sizeof(int) * group->n_layers * capacity);
+    group->capacity = capacity;
+}
+
+/**
+ * @brief Copies one member of a group to another position.
+ * @param [in] group The group.
+ * @param [in] x_dim The number of network inputs.
+ * @param [in] dest The position to write.
+ * @param [in] src The member to copy.
+ */
+static void
+cond_neural_group_move(struct CondNeuralGroup *group, const int x_dim,
+                       const int dest, const int src)
+{
+    int n_inputs = x_dim;
+    for (int l = 0; l < group->n_layers; ++l) {
+        const int n_outputs = group->n_outputs[l];
+        const int n_weights = n_outputs * n_inputs;
+        memcpy(&group->w[l][dest * n_weights], &group->w[l][src * n_weights],
+               sizeof(neural_real) * n_weights);
+        memcpy(&group->b[l][dest * n_outputs], &group->b[l][src * n_outputs],
+               sizeof(neural_real) * n_outputs);
+        group->function[dest * group->n_layers + l] =
+            group->function[src * group->n_layers + l];
+        n_inputs = n_outputs;
+    }
+    group->col[dest] = group->col[src];
+}
+
+/**
+ * @brief Adds a network to the end of a group.
+ * @param [in] group The group.
+ * @param [in] x_dim The number of network inputs.
+ * @param [in] net The neural network to copy.
+ * @param [in] col The population column of the network.
+ * @return The position of the new member.
+ */
+static int
+cond_neural_group_add(struct CondNeuralGroup *group, const int x_dim,
+                      const struct Net *net, const int col)
+{
+    cond_neural_group_resize(group, x_dim, group->size + 1);
+    const int m = group->size;
+    int l = 0;
+    for (const struct Llist *iter = net->tail; iter != NULL;
+         iter = iter->prev) {
+        const struct Layer *layer = iter->layer;
+        memcpy(&group->w[l][m * layer->n_weights], layer->weights,
+               sizeof(neural_real) * layer->n_weights);
+        memcpy(&group->b[l][m * layer->n_outputs], layer->biases,
+               sizeof(neural_real) * layer->n_outputs);
+        group->function[m * group->n_layers + l] = layer->function;
+        ++l;
+    }
+    group->col[m] = col;
+    ++(group->size);
+    return m;
+}
+
+/**
+ * @brief Returns the group with the topology of a network.
+ * @details An empty group is reused for a new topology if there is one.
+ * @param [in] batch The neural condition batch.
+ * @param [in] net The neural network.
+ * @return The index of the group.
+ */
+static int
+cond_neural_batch_group(struct CondNeuralBatch *batch, const struct Net *net)
+{
+    int empty = -1;
+    for (int g = 0; g < batch->n_groups; ++g) {
+        const struct CondNeuralGroup *group = &batch->groups[g];
+        if (cond_neural_group_fits(group, net)) {
+            return g;
+        }
+        if (group->size == 0 && empty < 0) {
+            empty = g;
+        }
+    }
+    if (empty < 0) {
+        empty = batch->n_groups;
+        ++(batch->n_groups);
+        batch->groups = realloc(batch->groups, sizeof(struct CondNeuralGroup) *
+                                                   batch->n_groups);
+        memset(&batch->groups[empty], 0, sizeof(struct CondNeuralGroup));
+    }
+    cond_neural_group_init(&batch->groups[empty], net);
+    return empty;
+}
+
+/**
+ * @brief Removes the network held in a column from its group.
+ * @details The last member of the group takes its place.
+ * @param [in] batch The neural condition batch.
+ * @param [in] j The column to release.
+ */
+static void
+cond_neural_batch_release(struct CondNeuralBatch *batch, const int j)
+{
+    const int g = batch->group[j];
+    if (g >= 0) {
+        struct CondNeuralGroup *group = &batch->groups[g];
+        const int m = batch->member[j];
+        const int last = group->size - 1;
+        if (m != last) {
+            cond_neural_group_move(group, batch->x_dim, m, last);
+            batch->member[group->col[m]] = m;
+        }
+        --(group->size);
+        batch->group[j] = -1;
+    }
+    batch->cl[j] = NULL;
+}
+
+/**
+ * @brief Discards all columns if the number of inputs changed.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] batch The neural condition batch.
+ */
+static void
+cond_neural_batch_reset(const struct XCSF *xcsf, struct CondNeuralBatch *batch)
+{
+    if (batch->x_dim == xcsf->x_dim) {
+        return;
+    }
+    for (int j = 0; j < batch->capacity; ++j) {
+        batch->cl[j] = NULL;
+        batch->group[j] = -1;
+    }
+    for (int g = 0; g < batch->n_groups; ++g) {
+        cond_neural_group_free(&batch->groups[g]);
+    }
+    free(batch->groups);
+    batch->groups = NULL;
+    batch->n_groups = 0;
+    batch->size = 0;
+    batch->x_dim = xcsf->x_dim;
+    free(batch->x);
+    batch->x = NULL;
+}
+
+/**
+ * @brief Returns an input in the precision of the network layers.
+ * @param [in] batch The neural condition batch.
+ * @param [in] x Input state.
+ * @return The input converted to neural_real.
+ */
+static const neural_real *
+cond_neural_batch_input(struct CondNeuralBatch *batch, const double *x)
+{
+#ifdef NEURAL_FLOAT
+    if (batch->x == NULL) {
+        batch->x = malloc(sizeof(neural_real) * batch->x_dim);
+    }
+    for (int i = 0; i < batch->x_dim; ++i) {
+        batch->x[i] = (neural_real) x[i];
+    }
+    return batch->x;
+#else
+    (void) batch;
+    return x;
+#endif
+}
+
+/**
+ * @brief Resizes the batch to hold at least n columns.
+ * @param [in] batch The neural condition batch.
+ * @param [in] n The number of columns required.
+ */
+static void
+cond_neural_batch_resize(struct CondNeuralBatch *batch, const int n)
+{
+    if (n <= batch->capacity && batch->bitmap != NULL) {
+        return;
+    }
+    int capacity = batch->capacity > 0 ? batch->capacity : 64;
+    while (capacity < n) {
+        capacity *= 2;
+    }
+    batch->cl = realloc(batch->cl, sizeof(struct Cl *) * capacity);
+    batch->group = realloc(batch->group, sizeof(int) * capacity);
+    batch->member = realloc(batch->member, sizeof(int) * capacity);
+    for (int j = batch->capacity; j < capacity; ++j) {
+        batch->cl[j] = NULL;
+        batch->group[j] = -1;
+    }
+    batch->bitmap = realloc(batch->bitmap, sizeof(uint64_t) * (capacity / 64));
+    batch->capacity = capacity;
+}
+
+/**
+ * @brief Makes the columns of the batch mirror a set.
+ * @details Only columns whose classifier differs from the set are rewritten;
+ * columns beyond the set size are released so that a freed classifier can
+ * never be mistaken for a new one allocated at the same address.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] batch The neural condition batch.
+ * @param [in] set The set of classifiers.
+ */
+static void
+cond_neural_batch_sync(const struct XCSF *xcsf, struct CondNeuralBatch *batch,
+                       const struct Set *set)
+{
+    cond_neural_batch_reset(xcsf, batch);
+    cond_neural_batch_resize(batch, set->size);
+    for (int j = set->size; j < batch->size; ++j) {
+        cond_neural_batch_release(batch, j);
+    }
+    for (int j = 0; j < set->size; ++j) {
+        struct Cl *c = set->cl[j];
+        if (batch->cl[j] == c) {
+            continue;
+        }
+        cond_neural_batch_release(batch, j);
+        const struct CondNeural *cond = c->cond;
+        if (cond_neural_batch_eligible(&cond->net, batch->x_dim)) {
+            const int g = cond_neural_batch_group(batch, &cond->net);
+            batch->group[j] = g;
+            batch->member[j] = cond_neural_group_add(
+                &batch->groups[g], batch->x_dim, &cond->net, j);
+        }
+        batch->cl[j] = c;
+        c->batch_slot = j;
+    }
+    batch->size = set->size;
+}
+
+/**
+ * @brief Forward propagates every network in a group.
+ * @param [in] group The group.
+ * @param [in] x_dim The number of network inputs.
+ * @param [in] x Input state.
+ * @param [in] fast Whether to use approximate activations.
+ */
+static void
+cond_neural_group_propagate(const struct CondNeuralGroup *group,
+                            const int x_dim, const neural_real *x,
+                            const bool fast)
+{
+    const int size = group->size;
+    const neural_real *input = x;
+    int n_inputs = x_dim;
+    for (int l = 0; l < group->n_layers; ++l) {
+        const int n_outputs = group->n_outputs[l];
+        const int n_weights = n_outputs * n_inputs;
+        neural_real *out = group->out[l];
+        memcpy(out, group->b[l], sizeof(neural_real) * n_outputs * size);
+        if (l == 0) {
+            // same input: one product over the stacked weights of all members
+            neural_gemv(0, n_outputs * size, n_inputs, 1, group->w[l],
+                        n_inputs, x, 1, 1, out, 1);
+        } else {
+            for (int m = 0; m < size; ++m) {
+                neural_gemv(0, n_outputs, n_inputs, 1,
+                            &group->w[l][m * n_weights], n_inputs,
+                            &input[m * n_inputs], 1, 1, &out[m * n_outputs],
+                            1);
+            }
+        }
+        for (int m = 0; m < size; ++m) {
+            neural_real *state = &out[m * n_outputs];
+            neural_activate_array(state, state, n_outputs,
+                                  group->function[m * group->n_layers + l],
+                                  fast);
+        }
+        input = out;
+        n_inputs = n_outputs;
+    }
+}
+
+/**
+ * @brief Calculates which neural conditions in a set match an input.
+ * @details The networks of the set are neither propagated nor modified when
+ * they can be evaluated in a group; the others are matched individually.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] set The set of classifiers to match.
+ * @param [in] x Input state.
+ * @return Bitmap where bit j is set if the j-th classifier in the set matches.
+ */
+const uint64_t *
+cond_neural_batch_match(const struct XCSF *xcsf, const struct Set *set,
+                        const double *x)
+{
+    if (xcsf->cond->batch == NULL) {
+        xcsf->cond->batch = calloc(1, sizeof(struct CondNeuralBatch));
+        xcsf->cond->batch->x_dim = xcsf->x_dim;
+    }
+    struct CondNeuralBatch *batch = xcsf->cond->batch;
+    cond_neural_batch_sync(xcsf, batch, set);
+    uint64_t *bitmap = batch->bitmap;
+    memset(bitmap, 0, sizeof(uint64_t) * ((set->size + 63) / 64));
+    const neural_real *input = cond_neural_batch_input(batch, x);
+    for (int g = 0; g < batch->n_groups; ++g) {
+        const struct CondNeuralGroup *group = &batch->groups[g];
+        if (group->size < 1) {
+            continue;
+        }
+        cond_neural_group_propagate(group, batch->x_dim, input,
+                                    xcsf->FAST_ACTIVATIONS);
+        const neural_real *out = group->out[group->n_layers - 1];
+        const int n_outputs = group->n_outputs[group->n_layers - 1];
+        for (int m = 0; m < group->size; ++m) {
+            if (out[m * n_outputs] > 0.5) {
+                const int j = group->col[m];
+                bitmap[j >> 6] |= UINT64_C(1) << (j & 63);
+            }
+        }
+    }
+    for (int j = 0; j < set->size; ++j) {
+        if (batch->group[j] < 0 && cond_match(xcsf, set->cl[j], x)) {
+            bitmap[j >> 6] |= UINT64_C(1) << (j & 63);
+        }
+    }
+    return bitmap;
+}
+
+/**
+ * @brief Releases the column of a classifier whose condition has changed.
+ * @details The column is rewritten the next time the batch is matched.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] c The classifier.
+ */
+void
+cond_neural_batch_invalidate(const struct XCSF *xcsf, const struct Cl *c)
+{
+    struct CondNeuralBatch *batch = xcsf->cond->batch;
+    const int j = c->batch_slot;
+    if (batch != NULL && j >= 0 && j < batch->capacity && batch->cl[j] == c) {
+        cond_neural_batch_release(batch, j);
+    }
+}
+
+/**
+ * @brief Frees the neural condition batch.
+ * @param [in] xcsf The XCSF data structure.
+ */
+void
+cond_neural_batch_free(const struct XCSF *xcsf)
+{
+    struct CondNeuralBatch *batch = xcsf->cond->batch;
+    if (batch != NULL) {
+        for (int g = 0; g < batch->n_groups; ++g) {
+            cond_neural_group_free(&batch->groups[g]);
+        }
+        free(batch->groups);
+        free(batch->cl);
+        free(batch->group);
+        free(batch->member);
+        free(batch->bitmap);
+        free(batch->x);
+        free(batch);
+        xcsf->cond->batch = NULL;
+    }
+}
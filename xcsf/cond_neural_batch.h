@@ -0,0 +1,75 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file cond_neural_batch.h
+ * @author Richard Preen <rpreen@gmail.com>
+ * @copyright The Authors.
+ * @date 2026.
+ * @brief Batched inference of neural network conditions.
+ */
+
+#pragma once
+
+#include "condition.h"
+#include "neural.h"
+#include "xcsf.h"
+
+/**
+ * @brief Neural conditions sharing the same layer topology.
+ * @details The weights and biases of each layer are stacked member-major so
+ * that layer l of member m starts at w[l][m * n_weights(l)], and the outputs
+ * of each layer are stacked likewise.
+ */
+struct CondNeuralGroup {
+    int n_layers; //!< Number of layers
+    int *n_outputs; //!< Number of outputs of each layer
+    int *col; //!< Population column of each member
+    int *function; //!< Activation function of each layer of each member
+    neural_real **w; //!< Stacked weights of each layer
+    neural_real **b; //!< Stacked biases of each layer
+    neural_real **out; //!< Stacked outputs of each layer
+    int size; //!< Number of members
+    int capacity; //!< Number of members allocated
+};
+
+/**
+ * @brief Stacked copies of the networks of a set of neural conditions.
+ * @details Each classifier occupies a column. Networks made only of connected
+ * layers are copied into the group with the same topology; other networks are
+ * propagated individually.
+ */
+struct CondNeuralBatch {
+    const struct Cl **cl; //!< Classifier held in each column
+    int *group; //!< Group of each column, or -1 if not batched
+    int *member; //!< Position of each column within its group
+    uint64_t *bitmap; //!< Match results, one bit per column
+    neural_real *x; //!< Input converted to neural_real
+    struct CondNeuralGroup *groups; //!< Groups of identical topology
+    int n_groups; //!< Number of groups
+    int size; //!< Number of columns in use
+    int capacity; //!< Number of columns allocated
+    int x_dim; //!< Number of network inputs
+};
+
+const uint64_t *
+cond_neural_batch_match(const struct XCSF *xcsf, const struct Set *set,
+                        const double *x);
+
+void
+cond_neural_batch_invalidate(const struct XCSF *xcsf, const struct Cl *c);
+
+void
+cond_neural_batch_free(const struct XCSF *xcsf);
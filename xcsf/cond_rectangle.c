@@ -17,11 +17,12 @@
  * @file cond_rectangle.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2019--2023.
+ * @date 2019--2026.
  * @brief Hyperrectangle condition functions.
  */
 
 #include "cond_rectangle.h"
+#include "cond_index.h"
 #include "ea.h"
 #include "sam.h"
 #include "utils.h"
@@ -68,8 +69,8 @@ cond_rectangle_init(const struct XCSF *xcsf, struct Cl *c)
 void
 cond_rectangle_free(const struct XCSF *xcsf, const struct Cl *c)
 {
-    (void) xcsf;
     const struct CondRectangle *cond = c->cond;
+    cond_index_invalidate(xcsf, c);
     free(cond->b1);
     free(cond->b2);
     free(cond->mu);
@@ -122,6 +123,7 @@ cond_rectangle_cover(const struct XCSF *xcsf, const struct Cl *c,
             cond->b2[i] = x[i] + (r2 * 0.5);
         }
     }
+    cond_index_invalidate(xcsf, c);
 }
 
 /**
@@ -142,6 +144,7 @@ cond_rectangle_update(const struct XCSF *xcsf, const struct Cl *c,
         for (int i = 0; i < xcsf->x_dim; ++i) {
             cond->b1[i] += xcsf->cond->eta * (x[i] - cond->b1[i]);
         }
+        cond_index_invalidate(xcsf, c);
     }
 }
 
@@ -177,6 +180,31 @@ cond_rectangle_match(const struct XCSF *xcsf, const struct Cl *c,
     return true;
 }
 
+/**
+ * @brief Returns the lower and upper bounds of a hyperrectangle condition.
+ * @param [in] xcsf XCSF data structure.
+ * @param [in] c Classifier whose condition bounds are returned.
+ * @param [out] lb Lower bound in each dimension.
+ * @param [out] ub Upper bound in each dimension.
+ */
+void
+cond_rectangle_bounds(const struct XCSF *xcsf, const struct Cl *c, double *lb,
+                      double *ub)
+{
+    const struct CondRectangle *cond = c->cond;
+    if (xcsf->cond->type == COND_TYPE_HYPERRECTANGLE_CSR) {
+        for (int i = 0; i < xcsf->x_dim; ++i) {
+            lb[i] = cond->b1[i] - cond->b2[i];
+            ub[i] = cond->b1[i] + cond->b2[i];
+        }
+    } else {
+        for (int i = 0; i < xcsf->x_dim; ++i) {
+            lb[i] = fmin(cond->b1[i], cond->b2[i]);
+            ub[i] = fmax(cond->b1[i], cond->b2[i]);
+        }
+    }
+}
+
 /**
  * @brief Performs uniform crossover with two hyperrectangle conditions.
  * @param [in] xcsf XCSF data structure.
@@ -207,6 +235,10 @@ cond_rectangle_crossover(const struct XCSF *xcsf, const struct Cl *c1,
             }
         }
     }
+    if (changed) {
+        cond_index_invalidate(xcsf, c1);
+        cond_index_invalidate(xcsf, c2);
+    }
     return changed;
 }
 
@@ -242,6 +274,9 @@ cond_rectangle_mutate(const struct XCSF *xcsf, const struct Cl *c)
             changed = true;
         }
     }
+    if (changed) {
+        cond_index_invalidate(xcsf, c);
+    }
     return changed;
 }
 
@@ -419,4 +454,108 @@ cond_rectangle_json_import(const struct XCSF *xcsf, struct Cl *c,
         }
     }
     sam_json_import(cond->mu, N_MU, json);
+    cond_index_invalidate(xcsf, c);
+}
+
+/**
+ * @brief Resizes a batched matching block.
+ * @details Existing columns are kept; a change of dimensionality discards
+ * them.
+ * @param [in] batch The batched matching block.
+ * @param [in] x_dim The number of dimensions.
+ * @param [in] capacity The number of columns, a multiple of BATCH_TILE.
+ */
+void
+cond_rectangle_batch_resize(struct CondRectangleBatch *batch, const int x_dim,
+                            const int capacity)
+{
+    if (batch->x_dim != x_dim) {
+        cond_rectangle_batch_free(batch);
+        batch->x_dim = x_dim;
+    }
+    if (capacity <= batch->capacity && batch->lb != NULL) {
+        return;
+    }
+    double *lb = calloc((size_t) x_dim * capacity, sizeof(double));
+    double *ub = calloc((size_t) x_dim * capacity, sizeof(double));
+    if (batch->lb != NULL) {
+        for (int i = 0; i < x_dim; ++i) {
+            memcpy(&lb[i * capacity], &batch->lb[i * batch->capacity],
+                   sizeof(double) * batch->capacity);
+            memcpy(&ub[i * capacity], &batch->ub[i * batch->capacity],
+                   sizeof(double) * batch->capacity);
+        }
+    }
+    free(batch->lb);
+    free(batch->ub);
+    batch->lb = lb;
+    batch->ub = ub;
+    batch->capacity = capacity;
+}
+
+/**
+ * @brief Writes the bounds of a rule to a column of a batched matching block.
+ * @param [in] batch The batched matching block.
+ * @param [in] j The column to write.
+ * @param [in] lb Lower bound in each dimension.
+ * @param [in] ub Upper bound in each dimension.
+ */
+void
+cond_rectangle_batch_set(struct CondRectangleBatch *batch, const int j,
+                         const double *lb, const double *ub)
+{
+    const int stride = batch->capacity;
+    for (int i = 0; i < batch->x_dim; ++i) {
+        batch->lb[i * stride + j] = lb[i];
+        batch->ub[i * stride + j] = ub[i];
+    }
+}
+
+/**
+ * @brief Matches one tile of a batched matching block against an input.
+ * @details The bounds of the tile are compared a dimension at a time so that
+ * the compiler can vectorise across rules, stopping early once every rule in
+ * the tile has failed.
+ * @param [in] batch The batched matching block.
+ * @param [in] x Input state.
+ * @param [in] start The first column of the tile.
+ * @return Bitmap of the matching columns within the tile.
+ */
+uint64_t
+cond_rectangle_batch_tile(const struct CondRectangleBatch *batch,
+                          const double *x, const int start)
+{
+    uint64_t miss[BATCH_TILE] = { 0 };
+    for (int i = 0; i < batch->x_dim; ++i) {
+        const double *lb = &batch->lb[i * batch->capacity + start];
+        const double *ub = &batch->ub[i * batch->capacity + start];
+        const double xi = x[i];
+        uint64_t all = 1;
+        for (int j = 0; j < BATCH_TILE; ++j) {
+            miss[j] |= (uint64_t) ((xi < lb[j]) | (xi > ub[j]));
+            all &= miss[j];
+        }
+        if (all) {
+            return 0;
+        }
+    }
+    uint64_t word = 0;
+    for (int j = 0; j < BATCH_TILE; ++j) {
+        word |= (miss[j] ^ 1) << j;
+    }
+    return word;
+}
+
+/**
+ * @brief Frees the columns of a batched matching block.
+ * @param [in] batch The batched matching block.
+ */
+void
+cond_rectangle_batch_free(struct CondRectangleBatch *batch)
+{
+    free(batch->lb);
+    free(batch->ub);
+    batch->lb = NULL;
+    batch->ub = NULL;
+    batch->capacity = 0;
 }
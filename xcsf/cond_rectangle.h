@@ -17,7 +17,7 @@
  * @file cond_rectangle.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2019--2022.
+ * @date 2019--2026.
  * @brief Hyperrectangle condition functions.
  */
 
@@ -35,6 +35,40 @@ struct CondRectangle {
     double *mu; //!< Mutation rates
 };
 
+#define BATCH_TILE (64) //!< Number of rules matched per bitmap word
+
+/**
+ * @brief Hyperrectangle bounds of a set of rules for batched matching.
+ * @details Bounds are normalised to lower/upper for both CSR and UBR and stored
+ * dimension-major: lb[i * capacity + j] is the lower bound of the j-th rule in
+ * dimension i. The capacity is a multiple of the tile width.
+ */
+struct CondRectangleBatch {
+    double *lb; //!< Lower bounds
+    double *ub; //!< Upper bounds
+    int capacity; //!< Number of columns allocated
+    int x_dim; //!< Number of dimensions allocated
+};
+
+void
+cond_rectangle_batch_resize(struct CondRectangleBatch *batch, const int x_dim,
+                            const int capacity);
+
+void
+cond_rectangle_batch_set(struct CondRectangleBatch *batch, const int j,
+                         const double *lb, const double *ub);
+
+uint64_t
+cond_rectangle_batch_tile(const struct CondRectangleBatch *batch,
+                          const double *x, const int start);
+
+void
+cond_rectangle_batch_free(struct CondRectangleBatch *batch);
+
+void
+cond_rectangle_bounds(const struct XCSF *xcsf, const struct Cl *c, double *lb,
+                      double *ub);
+
 bool
 cond_rectangle_crossover(const struct XCSF *xcsf, const struct Cl *c1,
                          const struct Cl *c2);
@@ -17,9 +17,10 @@
  * @file cond_ternary.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2019--2022.
+ * @date 2019--2026.
  * @brief Ternary condition functions.
- * @details Binarises inputs.
+ * @details Binarises inputs. Conditions are packed into care and value
+ * bitplanes so that matching and subsumption operate on whole words.
  */
 
 #include "cond_ternary.h"
@@ -29,12 +30,132 @@
 
 #define DONT_CARE ('#') //!< Don't care symbol
 #define N_MU (1) //!< Number of ternary mutation rates
+#define WORD_BITS (64) //!< Number of symbols packed per bitplane word
 
 /**
  * @brief Self-adaptation method for mutating ternary conditions.
  */
 static const int MU_TYPE[N_MU] = { SAM_LOG_NORMAL };
 
+/**
+ * @brief Returns the symbol at a position of a ternary condition.
+ * @param [in] cond The ternary condition.
+ * @param [in] i The position of the symbol.
+ * @return The symbol: '0', '1', or don't care.
+ */
+static inline char
+cond_ternary_get(const struct CondTernary *cond, const int i)
+{
+    const uint64_t bit = UINT64_C(1) << (i % WORD_BITS);
+    if (!(cond->care[i / WORD_BITS] & bit)) {
+        return DONT_CARE;
+    }
+    return (cond->value[i / WORD_BITS] & bit) ? '1' : '0';
+}
+
+/**
+ * @brief Sets the symbol at a position of a ternary condition.
+ * @param [in] cond The ternary condition.
+ * @param [in] i The position of the symbol.
+ * @param [in] symbol The symbol to set: '0', '1', or don't care.
+ */
+static inline void
+cond_ternary_set(const struct CondTernary *cond, const int i,
+                 const char symbol)
+{
+    const uint64_t bit = UINT64_C(1) << (i % WORD_BITS);
+    const int w = i / WORD_BITS;
+    if (symbol == DONT_CARE) {
+        cond->care[w] &= ~bit;
+        cond->value[w] &= ~bit;
+    } else {
+        cond->care[w] |= bit;
+        if (symbol == '1') {
+            cond->value[w] |= bit;
+        } else {
+            cond->value[w] &= ~bit;
+        }
+    }
+}
+
+/**
+ * @brief Returns the number of words in a packed binarised input.
+ * @param [in] xcsf The XCSF data structure.
+ * @return The number of 64-bit words.
+ */
+int
+cond_ternary_input_words(const struct XCSF *xcsf)
+{
+    const int length = xcsf->x_dim * xcsf->cond->bits;
+    return (length + WORD_BITS - 1) / WORD_BITS;
+}
+
+/**
+ * @brief Binarises an input into a packed bitstring.
+ * @details Each input variable is encoded with the most significant bit first,
+ * as with float_to_binary().
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] x The input state.
+ * @param [out] input The packed bitstring (n_words long).
+ * @param [in] n_words The number of words in the packed bitstring.
+ */
+void
+cond_ternary_binarise(const struct XCSF *xcsf, const double *x,
+                      uint64_t *input, const int n_words)
+{
+    const int bits = xcsf->cond->bits;
+    memset(input, 0, sizeof(uint64_t) * n_words);
+    for (int i = 0; i < xcsf->x_dim; ++i) {
+        const bool ones = x[i] >= 1;
+        const int a = (ones || x[i] <= 0) ? 0 : (int) ldexp(x[i], bits);
+        for (int j = 0; j < bits; ++j) {
+            if (ones || ((a >> (bits - 1 - j)) & 1)) {
+                const int pos = i * bits + j;
+                input[pos / WORD_BITS] |= UINT64_C(1) << (pos % WORD_BITS);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Returns the packed binarisation of an input.
+ * @details Uses the shared binarised input if it holds x; otherwise binarises
+ * x into the buffer provided.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] x The input state.
+ * @param [out] buffer Storage used if x is not already binarised.
+ * @param [in] n_words The number of words in the packed bitstring.
+ * @return The packed binarised input.
+ */
+static const uint64_t *
+cond_ternary_input(const struct XCSF *xcsf, const double *x, uint64_t *buffer,
+                   const int n_words)
+{
+    const struct CondTernaryInput *input = xcsf->cond->input;
+    if (input != NULL && input->x == x && input->n_words == n_words) {
+        return input->bits;
+    }
+    cond_ternary_binarise(xcsf, x, buffer, n_words);
+    return buffer;
+}
+
+/**
+ * @brief Allocates the bitplanes of a ternary condition.
+ * @param [in] length The length of the bitstring.
+ * @return A ternary condition with all symbols set to '0'.
+ */
+static struct CondTernary *
+cond_ternary_alloc(const int length)
+{
+    struct CondTernary *new = malloc(sizeof(struct CondTernary));
+    new->length = length;
+    new->n_words = (length + WORD_BITS - 1) / WORD_BITS;
+    new->care = calloc(new->n_words, sizeof(uint64_t));
+    new->value = calloc(new->n_words, sizeof(uint64_t));
+    new->mu = malloc(sizeof(double) * N_MU);
+    return new;
+}
+
 /**
  * @brief Randomises a ternary condition.
  * @param [in] xcsf The XCSF data structure.
@@ -46,11 +167,11 @@ cond_ternary_rand(const struct XCSF *xcsf, const struct Cl *c)
     const struct CondTernary *cond = c->cond;
     for (int i = 0; i < cond->length; ++i) {
         if (rand_uniform(0, 1) < xcsf->cond->p_dontcare) {
-            cond->string[i] = DONT_CARE;
+            cond_ternary_set(cond, i, DONT_CARE);
         } else if (rand_uniform(0, 1) < 0.5) {
-            cond->string[i] = '0';
+            cond_ternary_set(cond, i, '0');
         } else {
-            cond->string[i] = '1';
+            cond_ternary_set(cond, i, '1');
         }
     }
 }
@@ -63,11 +184,8 @@ cond_ternary_rand(const struct XCSF *xcsf, const struct Cl *c)
 void
 cond_ternary_init(const struct XCSF *xcsf, struct Cl *c)
 {
-    struct CondTernary *new = malloc(sizeof(struct CondTernary));
-    new->length = xcsf->x_dim * xcsf->cond->bits;
-    new->string = malloc(sizeof(char) * new->length);
-    new->tmp_input = malloc(sizeof(char) * xcsf->cond->bits);
-    new->mu = malloc(sizeof(double) * N_MU);
+    const int length = xcsf->x_dim * xcsf->cond->bits;
+    struct CondTernary *new = cond_ternary_alloc(length);
     sam_init(new->mu, N_MU, MU_TYPE);
     c->cond = new;
     cond_ternary_rand(xcsf, c);
@@ -83,8 +201,8 @@ cond_ternary_free(const struct XCSF *xcsf, const struct Cl *c)
 {
     (void) xcsf;
     const struct CondTernary *cond = c->cond;
-    free(cond->string);
-    free(cond->tmp_input);
+    free(cond->care);
+    free(cond->value);
     free(cond->mu);
     free(c->cond);
 }
@@ -99,13 +217,11 @@ void
 cond_ternary_copy(const struct XCSF *xcsf, struct Cl *dest,
                   const struct Cl *src)
 {
-    struct CondTernary *new = malloc(sizeof(struct CondTernary));
+    (void) xcsf;
     const struct CondTernary *src_cond = src->cond;
-    new->length = src_cond->length;
-    new->string = malloc(sizeof(char) * src_cond->length);
-    new->tmp_input = malloc(sizeof(char) * xcsf->cond->bits);
-    new->mu = malloc(sizeof(double) * N_MU);
-    memcpy(new->string, src_cond->string, sizeof(char) * src_cond->length);
+    struct CondTernary *new = cond_ternary_alloc(src_cond->length);
+    memcpy(new->care, src_cond->care, sizeof(uint64_t) * src_cond->n_words);
+    memcpy(new->value, src_cond->value, sizeof(uint64_t) * src_cond->n_words);
     memcpy(new->mu, src_cond->mu, sizeof(double) * N_MU);
     dest->cond = new;
 }
@@ -120,15 +236,18 @@ void
 cond_ternary_cover(const struct XCSF *xcsf, const struct Cl *c, const double *x)
 {
     const struct CondTernary *cond = c->cond;
-    const int bits = xcsf->cond->bits;
-    for (int i = 0; i < xcsf->x_dim; ++i) {
-        float_to_binary(x[i], cond->tmp_input, bits);
-        for (int j = 0; j < bits; ++j) {
-            if (rand_uniform(0, 1) < xcsf->cond->p_dontcare) {
-                cond->string[i * bits + j] = DONT_CARE;
-            } else {
-                cond->string[i * bits + j] = cond->tmp_input[j];
-            }
+    uint64_t buffer[cond->n_words];
+    const uint64_t *in = cond_ternary_input(xcsf, x, buffer, cond->n_words);
+    for (int i = 0; i < cond->length; ++i) {
+        const int w = i / WORD_BITS;
+        const uint64_t bit = UINT64_C(1) << (i % WORD_BITS);
+        if (rand_uniform(0, 1) < xcsf->cond->p_dontcare) {
+            cond->care[w] &= ~bit;
+            cond->value[w] &= ~bit;
+        } else {
+            cond->care[w] |= bit;
+            cond->value[w] &= ~bit;
+            cond->value[w] |= in[w] & bit;
         }
     }
 }
@@ -161,14 +280,24 @@ bool
 cond_ternary_match(const struct XCSF *xcsf, const struct Cl *c, const double *x)
 {
     const struct CondTernary *cond = c->cond;
-    const int bits = xcsf->cond->bits;
-    for (int i = 0; i < xcsf->x_dim; ++i) {
-        float_to_binary(x[i], cond->tmp_input, bits);
-        for (int j = 0; j < bits; ++j) {
-            const char s = cond->string[i * bits + j];
-            if (s != DONT_CARE && s != cond->tmp_input[j]) {
-                return false;
-            }
+    uint64_t buffer[cond->n_words];
+    const uint64_t *in = cond_ternary_input(xcsf, x, buffer, cond->n_words);
+    return cond_ternary_match_input(c, in);
+}
+
+/**
+ * @brief Calculates whether a ternary condition matches a binarised input.
+ * @param [in] c Classifier whose condition to match.
+ * @param [in] input The packed binarised input.
+ * @return Whether the condition matches the input.
+ */
+bool
+cond_ternary_match_input(const struct Cl *c, const uint64_t *input)
+{
+    const struct CondTernary *cond = c->cond;
+    for (int w = 0; w < cond->n_words; ++w) {
+        if ((input[w] ^ cond->value[w]) & cond->care[w]) {
+            return false;
         }
     }
     return true;
@@ -189,11 +318,22 @@ cond_ternary_crossover(const struct XCSF *xcsf, const struct Cl *c1,
     const struct CondTernary *cond2 = c2->cond;
     bool changed = false;
     if (rand_uniform(0, 1) < xcsf->ea->p_crossover) {
-        for (int i = 0; i < cond1->length; ++i) {
-            if (rand_uniform(0, 1) < 0.5) {
-                const char tmp = cond1->string[i];
-                cond1->string[i] = cond2->string[i];
-                cond2->string[i] = tmp;
+        for (int w = 0; w < cond1->n_words; ++w) {
+            // build the mask of positions to swap then swap them word-wide
+            uint64_t mask = 0;
+            const int n = cond1->length - (w * WORD_BITS);
+            for (int i = 0; i < n && i < WORD_BITS; ++i) {
+                if (rand_uniform(0, 1) < 0.5) {
+                    mask |= UINT64_C(1) << i;
+                }
+            }
+            const uint64_t care = (cond1->care[w] ^ cond2->care[w]) & mask;
+            const uint64_t value = (cond1->value[w] ^ cond2->value[w]) & mask;
+            cond1->care[w] ^= care;
+            cond2->care[w] ^= care;
+            cond1->value[w] ^= value;
+            cond2->value[w] ^= value;
+            if (mask) {
                 changed = true;
             }
         }
@@ -216,10 +356,11 @@ cond_ternary_mutate(const struct XCSF *xcsf, const struct Cl *c)
     bool changed = false;
     for (int i = 0; i < cond->length; ++i) {
         if (rand_uniform(0, 1) < cond->mu[0]) {
-            if (cond->string[i] == DONT_CARE) {
-                cond->string[i] = (rand_uniform(0, 1) < 0.5) ? '0' : '1';
+            if (cond_ternary_get(cond, i) == DONT_CARE) {
+                cond_ternary_set(cond, i,
+                                 (rand_uniform(0, 1) < 0.5) ? '0' : '1');
             } else {
-                cond->string[i] = DONT_CARE;
+                cond_ternary_set(cond, i, DONT_CARE);
             }
             changed = true;
         }
@@ -241,17 +382,18 @@ cond_ternary_general(const struct XCSF *xcsf, const struct Cl *c1,
     (void) xcsf;
     const struct CondTernary *cond1 = c1->cond;
     const struct CondTernary *cond2 = c2->cond;
-    bool general = false;
-    for (int i = 0; i < cond1->length; ++i) {
-        if (cond1->string[i] != DONT_CARE &&
-            cond1->string[i] != cond2->string[i]) {
+    uint64_t diff = 0;
+    for (int w = 0; w < cond1->n_words; ++w) {
+        const uint64_t care1 = cond1->care[w];
+        const uint64_t care2 = cond2->care[w];
+        const uint64_t value = cond1->value[w] ^ cond2->value[w];
+        // c1 specifies a symbol that c2 does not share
+        if ((care1 & ~care2) | (care1 & value)) {
             return false;
         }
-        if (cond1->string[i] != cond2->string[i]) {
-            general = true;
-        }
+        diff |= (care1 ^ care2) | value;
     }
-    return general;
+    return diff != 0;
 }
 
 /**
@@ -283,6 +425,7 @@ cond_ternary_size(const struct XCSF *xcsf, const struct Cl *c)
 
 /**
  * @brief Writes a ternary condition to a file.
+ * @details The bitstring is written one symbol per byte.
  * @param [in] xcsf The XCSF data structure.
  * @param [in] c The classifier whose condition is to be written.
  * @param [in] fp Pointer to the file to be written.
@@ -294,9 +437,14 @@ cond_ternary_save(const struct XCSF *xcsf, const struct Cl *c, FILE *fp)
     (void) xcsf;
     size_t s = 0;
     const struct CondTernary *cond = c->cond;
+    char *string = malloc(sizeof(char) * cond->length);
+    for (int i = 0; i < cond->length; ++i) {
+        string[i] = cond_ternary_get(cond, i);
+    }
     s += fwrite(&cond->length, sizeof(int), 1, fp);
-    s += fwrite(cond->string, sizeof(char), cond->length, fp);
+    s += fwrite(string, sizeof(char), cond->length, fp);
     s += fwrite(cond->mu, sizeof(double), N_MU, fp);
+    free(string);
     return s;
 }
 
@@ -310,19 +458,21 @@ cond_ternary_save(const struct XCSF *xcsf, const struct Cl *c, FILE *fp)
 size_t
 cond_ternary_load(const struct XCSF *xcsf, struct Cl *c, FILE *fp)
 {
+    (void) xcsf;
     size_t s = 0;
-    struct CondTernary *new = malloc(sizeof(struct CondTernary));
-    new->length = 0;
-    s += fread(&new->length, sizeof(int), 1, fp);
-    if (new->length < 1) {
+    int length = 0;
+    s += fread(&length, sizeof(int), 1, fp);
+    if (length < 1) {
         printf("cond_ternary_load(): read error\n");
-        new->length = 1;
         exit(EXIT_FAILURE);
     }
-    new->string = malloc(sizeof(char) * new->length);
-    s += fread(new->string, sizeof(char), new->length, fp);
-    new->tmp_input = malloc(sizeof(char) * xcsf->cond->bits);
-    new->mu = malloc(sizeof(double) * N_MU);
+    struct CondTernary *new = cond_ternary_alloc(length);
+    char *string = malloc(sizeof(char) * length);
+    s += fread(string, sizeof(char), length, fp);
+    for (int i = 0; i < length; ++i) {
+        cond_ternary_set(new, i, string[i]);
+    }
+    free(string);
     s += fread(new->mu, sizeof(double), N_MU, fp);
     c->cond = new;
     return s;
@@ -342,7 +492,9 @@ cond_ternary_json_export(const struct XCSF *xcsf, const struct Cl *c)
     cJSON *json = cJSON_CreateObject();
     cJSON_AddStringToObject(json, "type", "ternary");
     char buff[cond->length + 1];
-    memcpy(buff, cond->string, sizeof(char) * cond->length);
+    for (int i = 0; i < cond->length; ++i) {
+        buff[i] = cond_ternary_get(cond, i);
+    }
     buff[cond->length] = '\0';
     cJSON_AddStringToObject(json, "string", buff);
     cJSON *mutation = cJSON_CreateDoubleArray(cond->mu, N_MU);
@@ -372,12 +524,61 @@ cond_ternary_json_import(const struct XCSF *xcsf, struct Cl *c,
                 printf("Import error: string terminated early\n");
                 exit(EXIT_FAILURE);
             }
-            cond->string[i] = bit;
+            if (bit != '0' && bit != '1' && bit != DONT_CARE) {
+                printf("Import error: invalid symbol '%c'\n", bit);
+                exit(EXIT_FAILURE);
+            }
+            cond_ternary_set(cond, i, bit);
         }
     }
     sam_json_import(cond->mu, N_MU, json);
 }
 
+/**
+ * @brief Binarises an input once for matching by all ternary conditions.
+ * @details While set, ternary conditions matched or covered with the same
+ * input pointer reuse the shared binarisation instead of recomputing it.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] x The input state, or NULL to release the shared input.
+ */
+void
+cond_ternary_set_input(const struct XCSF *xcsf, const double *x)
+{
+    struct CondTernaryInput *input = xcsf->cond->input;
+    if (x == NULL) {
+        if (input != NULL) {
+            input->x = NULL;
+        }
+        return;
+    }
+    if (input == NULL) {
+        input = calloc(1, sizeof(struct CondTernaryInput));
+        xcsf->cond->input = input;
+    }
+    const int n_words = cond_ternary_input_words(xcsf);
+    if (input->n_words != n_words) {
+        input->bits = realloc(input->bits, sizeof(uint64_t) * n_words);
+        input->n_words = n_words;
+    }
+    cond_ternary_binarise(xcsf, x, input->bits, n_words);
+    input->x = x;
+}
+
+/**
+ * @brief Frees the shared binarised input.
+ * @param [in] xcsf The XCSF data structure.
+ */
+void
+cond_ternary_input_free(const struct XCSF *xcsf)
+{
+    struct CondTernaryInput *input = xcsf->cond->input;
+    if (input != NULL) {
+        free(input->bits);
+        free(input);
+        xcsf->cond->input = NULL;
+    }
+}
+
 /**
  * @brief Returns a json formatted string of the ternary parameters.
  * @param [in] xcsf The XCSF data structure.
@@ -17,7 +17,7 @@
  * @file cond_ternary.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2019--2022.
+ * @date 2019--2026.
  * @brief Ternary condition functions.
  */
 
@@ -28,14 +28,42 @@
 
 /**
  * @brief Ternary condition data structure.
+ * @details Symbol i is stored in bit i % 64 of word i / 64 of each bitplane;
+ * value bits are always clear where the care bit is clear.
  */
 struct CondTernary {
-    char *string; //!< Ternary bitstring
+    uint64_t *care; //!< Bitplane set where the symbol is not don't care
+    uint64_t *value; //!< Bitplane set where the symbol is '1'
     int length; //!< Length of the bitstring
+    int n_words; //!< Number of 64-bit words in each bitplane
     double *mu; //!< Mutation rates
-    char *tmp_input; //!< Temporary storage for float conversion
 };
 
+/**
+ * @brief Binarised input shared by all ternary conditions while matching.
+ */
+struct CondTernaryInput {
+    const double *x; //!< Input that is currently binarised, or NULL
+    uint64_t *bits; //!< Packed binarised input
+    int n_words; //!< Number of words allocated
+};
+
+int
+cond_ternary_input_words(const struct XCSF *xcsf);
+
+void
+cond_ternary_binarise(const struct XCSF *xcsf, const double *x,
+                      uint64_t *input, const int n_words);
+
+bool
+cond_ternary_match_input(const struct Cl *c, const uint64_t *input);
+
+void
+cond_ternary_set_input(const struct XCSF *xcsf, const double *x);
+
+void
+cond_ternary_input_free(const struct XCSF *xcsf);
+
 void
 cond_ternary_param_defaults(struct XCSF *xcsf);
 
@@ -17,7 +17,7 @@
  * @file condition.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2022.
+ * @date 2015--2026.
  * @brief Interface for classifier conditions.
  */
 
@@ -25,7 +25,9 @@
 #include "cond_dummy.h"
 #include "cond_ellipsoid.h"
 #include "cond_gp.h"
+#include "cond_index.h"
 #include "cond_neural.h"
+#include "cond_neural_batch.h"
 #include "cond_rectangle.h"
 #include "cond_ternary.h"
 #include "rule_dgp.h"
@@ -170,6 +172,9 @@ cond_param_defaults(struct XCSF *xcsf)
     cond_param_set_min(xcsf, 0);
     cond_param_set_max(xcsf, 1);
     cond_param_set_spread_min(xcsf, 0.1);
+    xcsf->cond->index = NULL;
+    xcsf->cond->batch = NULL;
+    xcsf->cond->input = NULL;
     cond_ternary_param_defaults(xcsf);
     cond_neural_param_defaults(xcsf);
     cond_dgp_param_defaults(xcsf);
@@ -370,6 +375,9 @@ cond_param_free(struct XCSF *xcsf)
     xcsf->cond->targs = NULL;
     xcsf->cond->dargs = NULL;
     layer_args_free(&xcsf->cond->largs);
+    cond_index_free(xcsf);
+    cond_neural_batch_free(xcsf);
+    cond_ternary_input_free(xcsf);
 }
 
 /* parameter setters */
@@ -17,7 +17,7 @@
  * @file condition.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2022.
+ * @date 2015--2026.
  * @brief Interface for classifier conditions.
  */
 
@@ -68,6 +68,9 @@ struct ArgsCond {
     struct ArgsLayer *largs; //!< Linked-list of layer parameters
     struct ArgsDGP *dargs; //!< DGP parameters
     struct ArgsGPTree *targs; //!< Tree GP parameters
+    struct CondIndex *index; //!< Index of interval condition bounds
+    struct CondNeuralBatch *batch; //!< Stacked neural condition networks
+    struct CondTernaryInput *input; //!< Binarised input for ternary matching
 };
 
 void
@@ -0,0 +1,400 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file del_index.c
+ * @author Richard Preen <rpreen@gmail.com>
+ * @copyright The Authors.
+ * @date 2026.
+ * @brief Population index for selecting classifiers for deletion.
+ * @details Slots mirror the population set. Appended rules are picked up when
+ * the index is synchronised; rules whose fitness, numerosity, experience, or
+ * set size change are updated in place; and removals move the last slot into
+ * the hole, as the population set does. Reordering the population clears the
+ * index, which is then rebuilt on the next synchronisation.
+ */
+
+#include "del_index.h"
+
+#define DEL_INDEX_MIN_CAPACITY (64) //!< Smallest number of slots allocated
+#define DEL_INDEX_TOL (1e-9) //!< Relative tolerance of refresh pruning
+
+/**
+ * @brief Node of a slot that holds no classifier.
+ */
+static const struct DelNode DEL_NODE_EMPTY = { .vote = 0,
+                                               .scaled = 0,
+                                               .fit = 0,
+                                               .min_k = INFINITY,
+                                               .max_k = -INFINITY,
+                                               .oldest = -1 };
+
+/**
+ * @brief Returns the older of two rules that are yet to match.
+ * @details All rules in the population are tested for matching the same
+ * number of times, so the order of their ages never changes and a node can
+ * keep its oldest rule while the ages grow. The oldest rule only tells whether
+ * a subtree holds any rule past probation; it does not choose the rule.
+ * @param [in] index The deletion index.
+ * @param [in] a The slot of the first rule, or -1 if none.
+ * @param [in] b The slot of the second rule, or -1 if none.
+ * @return The slot of the older rule, or the first if equally old.
+ */
+static inline int
+del_index_older(const struct DelIndex *index, const int a, const int b)
+{
+    if (a < 0) {
+        return b;
+    }
+    if (b < 0) {
+        return a;
+    }
+    return (index->cl[b]->age > index->cl[a]->age) ? b : a;
+}
+
+/**
+ * @brief Recalculates an internal node from its children.
+ * @param [in] index The deletion index.
+ * @param [in] i The node to recalculate.
+ */
+static inline void
+del_index_pull(const struct DelIndex *index, const int i)
+{
+    struct DelNode *n = &index->node[i];
+    const struct DelNode *l = &index->node[2 * i];
+    const struct DelNode *r = &index->node[2 * i + 1];
+    n->vote = l->vote + r->vote;
+    n->scaled = l->scaled + r->scaled;
+    n->fit = l->fit + r->fit;
+    n->min_k = fmin(l->min_k, r->min_k);
+    n->max_k = fmax(l->max_k, r->max_k);
+    n->oldest = del_index_older(index, l->oldest, r->oldest);
+}
+
+/**
+ * @brief Recalculates the leaf of a slot from its classifier.
+ * @details Mirrors cl_del_vote(): an experienced rule whose fitness is below
+ * DELTA times the mean fitness times its numerosity has a vote scaled by the
+ * mean. The comparison is the same expression as in cl_del_vote() so that both
+ * agree on rules lying on the threshold.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] index The deletion index.
+ * @param [in] j The slot to recalculate.
+ */
+static void
+del_index_leaf(const struct XCSF *xcsf, const struct DelIndex *index,
+               const int j)
+{
+    struct DelNode *n = &index->node[index->capacity + j];
+    const struct Cl *c = index->cl[j];
+    if (c == NULL) {
+        *n = DEL_NODE_EMPTY;
+        return;
+    }
+    const double k = c->fit / c->num;
+    const bool experienced = c->exp > xcsf->THETA_DEL;
+    n->fit = c->fit;
+    n->oldest = (c->mtotal == 0) ? j : -1;
+    if (experienced && c->fit < xcsf->DELTA * index->avg_fit * c->num) {
+        n->vote = 0;
+        n->scaled = c->size * c->num / k;
+        n->min_k = INFINITY;
+        n->max_k = k;
+    } else {
+        n->vote = c->size * c->num;
+        n->scaled = 0;
+        n->min_k = experienced ? k : INFINITY;
+        n->max_k = -INFINITY;
+    }
+}
+
+/**
+ * @brief Recalculates the leaf of a slot and the nodes above it.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] index The deletion index.
+ * @param [in] j The slot to recalculate.
+ */
+static void
+del_index_set(const struct XCSF *xcsf, const struct DelIndex *index,
+              const int j)
+{
+    del_index_leaf(xcsf, index, j);
+    for (int i = (index->capacity + j) / 2; i > 0; i /= 2) {
+        del_index_pull(index, i);
+    }
+}
+
+/**
+ * @brief Grows the index to hold at least a number of slots.
+ * @details The tree is rebuilt, so all slots are marked for synchronisation.
+ * @param [in] index The deletion index.
+ * @param [in] size The number of slots required.
+ */
+static void
+del_index_resize(struct DelIndex *index, const int size)
+{
+    int capacity = DEL_INDEX_MIN_CAPACITY;
+    while (capacity < size) {
+        capacity *= 2;
+    }
+    free(index->cl);
+    free(index->node);
+    index->cl = calloc(capacity, sizeof(struct Cl *));
+    index->node = malloc(sizeof(struct DelNode) * 2 * capacity);
+    for (int i = 0; i < 2 * capacity; ++i) {
+        index->node[i] = DEL_NODE_EMPTY;
+    }
+    index->capacity = capacity;
+    index->size = 0;
+}
+
+/**
+ * @brief Makes the slots of the deletion index mirror the population set.
+ * @details Slots beyond the last synchronisation are filled from the
+ * population. The index is rebuilt if the population has shrunk without it.
+ * @param [in] xcsf The XCSF data structure.
+ */
+void
+del_index_sync(struct XCSF *xcsf)
+{
+    const struct Set *pset = &xcsf->pset;
+    struct DelIndex *index = xcsf->del_index;
+    if (index == NULL) {
+        index = calloc(1, sizeof(struct DelIndex));
+        xcsf->del_index = index;
+    }
+    if (pset->size > index->capacity) {
+        del_index_resize(index, pset->size);
+    }
+    const int from = (pset->size < index->size) ? 0 : index->size;
+    const int to = (pset->size > index->size) ? pset->size : index->size;
+    for (int j = from; j < to; ++j) {
+        index->cl[j] = (j < pset->size) ? pset->cl[j] : NULL;
+        if (index->cl[j] != NULL) {
+            index->cl[j]->del_slot = j;
+        }
+        del_index_leaf(xcsf, index, j);
+    }
+    if (from < to) {
+        int lo = (index->capacity + from) / 2;
+        int hi = (index->capacity + to - 1) / 2;
+        while (lo > 0) {
+            for (int i = hi; i >= lo; --i) {
+                del_index_pull(index, i);
+            }
+            lo /= 2;
+            hi /= 2;
+        }
+    }
+    index->size = pset->size;
+}
+
+/**
+ * @brief Updates the deletion vote of a classifier in the index.
+ * @details Classifiers not yet held by the index are ignored; they are picked
+ * up on the next synchronisation.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] c The classifier whose parameters have changed.
+ */
+void
+del_index_update(const struct XCSF *xcsf, const struct Cl *c)
+{
+    const struct DelIndex *index = xcsf->del_index;
+    const int j = c->del_slot;
+    if (index != NULL && j >= 0 && j < index->size && index->cl[j] == c) {
+        del_index_set(xcsf, index, j);
+    }
+}
+
+/**
+ * @brief Removes a classifier from the index.
+ * @details The last slot fills the hole, as in the population set.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] c The classifier removed from the population.
+ */
+void
+del_index_remove(const struct XCSF *xcsf, const struct Cl *c)
+{
+    struct DelIndex *index = xcsf->del_index;
+    const int j = c->del_slot;
+    if (index == NULL || j < 0 || j >= index->size || index->cl[j] != c) {
+        return;
+    }
+    const int last = index->size - 1;
+    index->cl[j] = index->cl[last];
+    index->cl[j]->del_slot = j;
+    index->cl[last] = NULL;
+    del_index_set(xcsf, index, last);
+    if (j != last) {
+        del_index_set(xcsf, index, j);
+    }
+    index->size = last;
+}
+
+/**
+ * @brief Empties the index after the population has been reordered.
+ * @param [in] xcsf The XCSF data structure.
+ */
+void
+del_index_clear(const struct XCSF *xcsf)
+{
+    struct DelIndex *index = xcsf->del_index;
+    if (index != NULL) {
+        for (int j = 0; j < index->size; ++j) {
+            index->cl[j] = NULL;
+        }
+        for (int i = 0; i < 2 * index->capacity; ++i) {
+            index->node[i] = DEL_NODE_EMPTY;
+        }
+        index->size = 0;
+    }
+}
+
+/**
+ * @brief Frees the deletion index.
+ * @param [in] xcsf The XCSF data structure.
+ */
+void
+del_index_free(struct XCSF *xcsf)
+{
+    struct DelIndex *index = xcsf->del_index;
+    if (index != NULL) {
+        free(index->cl);
+        free(index->node);
+        free(index);
+        xcsf->del_index = NULL;
+    }
+}
+
+/**
+ * @brief Recalculates the leaves whose votes switch between scaled and
+ * unscaled after the mean fitness has changed.
+ * @details Subtrees are pruned on fitness per micro-classifier with a small
+ * tolerance, so that every leaf whose exact comparison may have changed is
+ * recalculated.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] index The deletion index.
+ * @param [in] i The root of the subtree to refresh.
+ */
+static void
+del_index_refresh(const struct XCSF *xcsf, const struct DelIndex *index,
+                  const int i)
+{
+    const struct DelNode *n = &index->node[i];
+    const double thresh = xcsf->DELTA * index->avg_fit;
+    if (!(n->min_k < thresh * (1 + DEL_INDEX_TOL)) &&
+        !(n->max_k >= thresh * (1 - DEL_INDEX_TOL))) {
+        return;
+    }
+    if (i >= index->capacity) {
+        del_index_leaf(xcsf, index, i - index->capacity);
+        return;
+    }
+    del_index_refresh(xcsf, index, 2 * i);
+    del_index_refresh(xcsf, index, 2 * i + 1);
+    del_index_pull(index, i);
+}
+
+/**
+ * @brief Returns the sum of the deletion votes of the population.
+ * @details Sets the current mean fitness; must follow
+ * del_index_sync() and precede del_index_spin().
+ * @param [in] xcsf The XCSF data structure.
+ * @return The total deletion vote.
+ */
+double
+del_index_votes(const struct XCSF *xcsf)
+{
+    struct DelIndex *index = xcsf->del_index;
+    const struct DelNode *root = &index->node[1];
+    const double avg_fit = root->fit / xcsf->pset.num;
+    index->avg_fit = avg_fit;
+    del_index_refresh(xcsf, index, 1);
+    return root->vote + avg_fit * root->scaled;
+}
+
+/**
+ * @brief Performs a single roulette spin with the deletion vote.
+ * @details Returns the first slot whose cumulative vote reaches p.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] p The position of the spin, [0, del_index_votes()].
+ * @return The selected population slot.
+ */
+int
+del_index_spin(const struct XCSF *xcsf, const double p)
+{
+    const struct DelIndex *index = xcsf->del_index;
+    const double avg_fit = index->node[1].fit / xcsf->pset.num;
+    double rem = p;
+    int i = 1;
+    while (i < index->capacity) {
+        const struct DelNode *l = &index->node[2 * i];
+        const double w = l->vote + avg_fit * l->scaled;
+        if (rem > w) {
+            rem -= w;
+            i = 2 * i + 1;
+        } else {
+            i = 2 * i;
+        }
+    }
+    const int j = i - index->capacity;
+    return (j < index->size) ? j : index->size - 1;
+}
+
+/**
+ * @brief Finds the first slot within a subtree holding a rule that has never
+ * matched after M_PROBATION match tests.
+ * @details Rules that have matched since their node was calculated are
+ * recalculated as they are encountered.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] index The deletion index.
+ * @param [in] i The root of the subtree to search.
+ * @return The slot found, or -1 if none found.
+ */
+static int
+del_index_probation(const struct XCSF *xcsf, const struct DelIndex *index,
+                    const int i)
+{
+    int o = index->node[i].oldest;
+    while (o >= 0 && index->cl[o]->mtotal > 0) {
+        del_index_set(xcsf, index, o);
+        o = index->node[i].oldest;
+    }
+    if (o < 0 || index->cl[o]->age <= xcsf->M_PROBATION) {
+        return -1;
+    }
+    if (i >= index->capacity) {
+        return i - index->capacity;
+    }
+    const int j = del_index_probation(xcsf, index, 2 * i);
+    if (j >= 0) {
+        return j;
+    }
+    return del_index_probation(xcsf, index, 2 * i + 1);
+}
+
+/**
+ * @brief Finds a rule in the population that never matches an input.
+ * @details Subtrees are searched left to right and slots mirror the
+ * population set, so the rule returned is the first in set order, as when
+ * walking the population.
+ * @param [in] xcsf The XCSF data structure.
+ * @return The population slot of the first such rule, or -1 if none found.
+ */
+int
+del_index_never_match(const struct XCSF *xcsf)
+{
+    return del_index_probation(xcsf, xcsf->del_index, 1);
+}
@@ -0,0 +1,79 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file del_index.h
+ * @author Richard Preen <rpreen@gmail.com>
+ * @copyright The Authors.
+ * @date 2026.
+ * @brief Population index for selecting classifiers for deletion.
+ */
+
+#pragma once
+
+#include "xcsf.h"
+
+/**
+ * @brief Node of the deletion index.
+ * @details A rule whose fitness is below DELTA times the population mean has
+ * a deletion vote proportional to the mean, so votes are split into a part
+ * that is independent of the mean and a part that is scaled by it.
+ */
+struct DelNode {
+    double vote; //!< Sum of votes that do not depend on the mean fitness
+    double scaled; //!< Sum of votes per unit of mean fitness
+    double fit; //!< Sum of fitnesses
+    double min_k; //!< Least fitness per micro-classifier of unscaled votes
+    double max_k; //!< Greatest fitness per micro-classifier of scaled votes
+    int oldest; //!< Slot of the oldest rule yet to match, or -1 if none
+};
+
+/**
+ * @brief Index of the deletion votes of the population.
+ * @details A segment tree over population slots: leaf j is node
+ * capacity + j and node i sums nodes 2i and 2i + 1, so that roulette
+ * selection and the search for rules that never match descend from the root.
+ */
+struct DelIndex {
+    struct Cl **cl; //!< Classifier held in each slot
+    struct DelNode *node; //!< Tree nodes [2 * capacity]
+    double avg_fit; //!< Mean fitness at the last total of the votes
+    int size; //!< Number of slots in use
+    int capacity; //!< Number of slots allocated
+};
+
+void
+del_index_sync(struct XCSF *xcsf);
+
+void
+del_index_update(const struct XCSF *xcsf, const struct Cl *c);
+
+void
+del_index_remove(const struct XCSF *xcsf, const struct Cl *c);
+
+void
+del_index_clear(const struct XCSF *xcsf);
+
+void
+del_index_free(struct XCSF *xcsf);
+
+double
+del_index_votes(const struct XCSF *xcsf);
+
+int
+del_index_spin(const struct XCSF *xcsf, const double p);
+
+int
+del_index_never_match(const struct XCSF *xcsf);
@@ -17,13 +17,14 @@
  * @file ea.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2023.
+ * @date 2015--2026.
  * @brief Evolutionary algorithm functions.
  */
 
 #include "ea.h"
 #include "cl.h"
 #include "clset.h"
+#include "del_index.h"
 #include "utils.h"
 
 /**
@@ -71,25 +72,30 @@ ea_subsume(struct XCSF *xcsf, struct Cl *c, struct Cl *c1p, struct Cl *c2p,
     if (cl_subsumer(xcsf, c1p) && cl_general(xcsf, c1p, c)) {
         ++(c1p->num);
         ++(xcsf->pset.num);
+        del_index_update(xcsf, c1p);
         cl_free(xcsf, c);
     } else if (cl_subsumer(xcsf, c2p) && cl_general(xcsf, c2p, c)) {
         ++(c2p->num);
         ++(xcsf->pset.num);
+        del_index_update(xcsf, c2p);
         cl_free(xcsf, c);
     }
     // attempt to find a random subsumer from the set
     else {
-        struct Clist *candidates[set->size];
+        struct Cl *candidates[set->size];
         int choices = 0;
-        for (struct Clist *iter = set->list; iter != NULL; iter = iter->next) {
-            if (cl_subsumer(xcsf, iter->cl) && cl_general(xcsf, iter->cl, c)) {
-                candidates[choices] = iter;
+        for (int i = 0; i < set->size; ++i) {
+            if (cl_subsumer(xcsf, set->cl[i]) &&
+                cl_general(xcsf, set->cl[i], c)) {
+                candidates[choices] = set->cl[i];
                 ++choices;
             }
         }
         if (choices > 0) { // found
-            ++(candidates[rand_uniform_int(0, choices)]->cl->num);
+            struct Cl *s = candidates[rand_uniform_int(0, choices)];
+            ++(s->num);
             ++(xcsf->pset.num);
+            del_index_update(xcsf, s);
             cl_free(xcsf, c);
         }
         // if no subsumers are found the offspring is added to the population
@@ -116,6 +122,7 @@ ea_add(struct XCSF *xcsf, const struct Set *set, struct Cl *c1p, struct Cl *c2p,
     if (!cmod && !mmod) {
         ++(c1p->num);
         ++(xcsf->pset.num);
+        del_index_update(xcsf, c1p);
         cl_free(xcsf, c1);
     } else if (xcsf->ea->subsumption) {
         ea_subsume(xcsf, c1, c1p, c2p, set);
@@ -137,13 +144,13 @@ ea_select_rw(const struct XCSF *xcsf, const struct Set *set,
 {
     (void) xcsf;
     const double p = rand_uniform(0, fit_sum);
-    const struct Clist *iter = set->list;
-    double sum = iter->cl->fit;
-    while (p > sum) {
-        iter = iter->next;
-        sum += iter->cl->fit;
+    int i = 0;
+    double sum = set->cl[i]->fit;
+    while (p > sum && i < set->size - 1) {
+        ++i;
+        sum += set->cl[i]->fit;
     }
-    return iter->cl;
+    return set->cl[i];
 }
 
 /**
@@ -157,13 +164,12 @@ ea_select_tournament(const struct XCSF *xcsf, const struct Set *set)
 {
     struct Cl *winner = NULL;
     while (winner == NULL) {
-        const struct Clist *iter = set->list;
-        while (iter != NULL) {
+        for (int i = 0; i < set->size; ++i) {
+            struct Cl *c = set->cl[i];
             if ((rand_uniform(0, 1) < xcsf->ea->select_size) &&
-                (winner == NULL || iter->cl->fit > winner->fit)) {
-                winner = iter->cl;
+                (winner == NULL || c->fit > winner->fit)) {
+                winner = c;
             }
-            iter = iter->next;
         }
     }
     return winner;
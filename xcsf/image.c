@@ -17,15 +17,29 @@
  * @file image.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2020--2023.
+ * @date 2020--2026.
  * @brief Image handling functions.
  */
 
 #include "image.h"
+#include <string.h>
+
+#define CONV_BLOCK (4) //!< Filters convolved together by direct convolution
+
+#if defined(__GNUC__)
+    #define CONV_VECTOR
+/**
+ * @brief CONV_VEC adjacent values held in vector registers.
+ */
+typedef neural_real conv_vec
+    __attribute__((vector_size(CONV_VEC * sizeof(neural_real)),
+                   aligned(sizeof(neural_real))));
+#endif
 
 static void
-col2im_add_pixel(double *im, const int height, const int width, int row,
-                 int col, const int channel, const int pad, const double val)
+col2im_add_pixel(neural_real *im, const int height, const int width, int row,
+                 int col, const int channel, const int pad,
+                 const neural_real val)
 {
     row -= pad;
     col -= pad;
@@ -35,9 +49,9 @@ col2im_add_pixel(double *im, const int height, const int width, int row,
     im[col + width * (row + height * channel)] += val;
 }
 
-static double
-im2col_get_pixel(const double *im, const int height, const int width, int row,
-                 int col, const int channel, const int pad)
+static neural_real
+im2col_get_pixel(const neural_real *im, const int height, const int width,
+                 int row, int col, const int channel, const int pad)
 {
     row -= pad;
     col -= pad;
@@ -60,9 +74,9 @@ im2col_get_pixel(const double *im, const int height, const int width, int row,
  * @param [out] data_im The resulting image vector.
  */
 void
-col2im(const double *data_col, const int channels, const int height,
+col2im(const neural_real *data_col, const int channels, const int height,
        const int width, const int ksize, const int stride, const int pad,
-       double *data_im)
+       neural_real *data_im)
 {
     const int height_col = (height + 2 * pad - ksize) / stride + 1;
     const int width_col = (width + 2 * pad - ksize) / stride + 1;
@@ -76,7 +90,7 @@ col2im(const double *data_col, const int channels, const int height,
                 const int im_row = h_offset + h * stride;
                 const int im_col = w_offset + w * stride;
                 const int col_index = (c * height_col + h) * width_col + w;
-                const double val = data_col[col_index];
+                const neural_real val = data_col[col_index];
                 col2im_add_pixel(data_im, height, width, im_row, im_col, c_im,
                                  pad, val);
             }
@@ -97,9 +111,9 @@ col2im(const double *data_col, const int channels, const int height,
  * @param [out] data_col The resulting column vector.
  */
 void
-im2col(const double *data_im, const int channels, const int height,
+im2col(const neural_real *data_im, const int channels, const int height,
        const int width, const int ksize, const int stride, const int pad,
-       double *data_col)
+       neural_real *data_col)
 {
     const int height_col = (height + 2 * pad - ksize) / stride + 1;
     const int width_col = (width + 2 * pad - ksize) / stride + 1;
@@ -119,3 +133,624 @@ im2col(const double *data_im, const int channels, const int height,
         }
     }
 }
+
+/**
+ * @brief Returns the number of elements of a padded image, including the
+ * slack read past its end by the direct convolution kernel.
+ * @param [in] channels Number of image channels.
+ * @param [in] height Padded image height.
+ * @param [in] width Padded image width.
+ * @param [in] ksize Kernel size.
+ * @param [in] stride Kernel stride.
+ * @return The padded image size in elements.
+ */
+static size_t
+conv_padded_size(const int channels, const int height, const int width,
+                 const int ksize, const int stride)
+{
+    return (size_t) channels * height * width + CONV_VEC * stride + ksize;
+}
+
+/**
+ * @brief Copies an image into the centre of a zeroed, larger image.
+ * @param [in] data_im Image of dimension: channels × height × width.
+ * @param [in] channels Number of image channels.
+ * @param [in] height Image height.
+ * @param [in] width Image width.
+ * @param [in] pad Border added to each side.
+ * @param [in] size Number of elements of the padded image, with slack.
+ * @param [out] padded The padded image.
+ */
+static void
+conv_pad(const neural_real *data_im, const int channels, const int height,
+         const int width, const int pad, const size_t size, neural_real *padded)
+{
+    const int ph = height + 2 * pad;
+    const int pw = width + 2 * pad;
+    memset(padded, 0, sizeof(neural_real) * size);
+    for (int c = 0; c < channels; ++c) {
+        for (int y = 0; y < height; ++y) {
+            memcpy(padded + (c * ph + y + pad) * pw + pad,
+                   data_im + (c * height + y) * width,
+                   sizeof(neural_real) * width);
+        }
+    }
+}
+
+/**
+ * @brief Convolves CONV_VEC adjacent outputs with a block of filters.
+ * @param [in] im Padded image at the first input of the first output.
+ * @param [in] channels Number of image channels.
+ * @param [in] ph Padded image height.
+ * @param [in] pw Padded image width.
+ * @param [in] ksize Kernel size.
+ * @param [in] stride Kernel stride.
+ * @param [in] w Block of CONV_BLOCK filters packed by conv_pack().
+ * @param [out] acc The CONV_BLOCK × CONV_VEC outputs.
+ */
+static inline void
+conv_tile(const neural_real *im, const int channels, const int ph,
+          const int pw, const int ksize, const int stride,
+          const neural_real *w, neural_real acc[CONV_BLOCK][CONV_VEC])
+{
+#ifdef CONV_VECTOR
+    if (stride == 1) {
+        conv_vec sum[CONV_BLOCK] = { 0 };
+        for (int c = 0; c < channels; ++c) {
+            for (int ky = 0; ky < ksize; ++ky) {
+                const neural_real *row = im + (c * ph + ky) * pw;
+                for (int kx = 0; kx < ksize; ++kx) {
+                    const conv_vec r = *(const conv_vec *) &row[kx];
+                    for (int f = 0; f < CONV_BLOCK; ++f) {
+                        sum[f] += w[f] * r;
+                    }
+                    w += CONV_BLOCK;
+                }
+            }
+        }
+        for (int f = 0; f < CONV_BLOCK; ++f) {
+            *(conv_vec *) acc[f] = sum[f];
+        }
+        return;
+    }
+#endif
+    memset(acc, 0, sizeof(neural_real) * CONV_BLOCK * CONV_VEC);
+    for (int c = 0; c < channels; ++c) {
+        for (int ky = 0; ky < ksize; ++ky) {
+            const neural_real *row = im + (c * ph + ky) * pw;
+            for (int kx = 0; kx < ksize; ++kx) {
+                for (int f = 0; f < CONV_BLOCK; ++f) {
+                    for (int x = 0; x < CONV_VEC; ++x) {
+                        acc[f][x] += w[f] * row[kx + x * stride];
+                    }
+                }
+                w += CONV_BLOCK;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Convolves a padded image with filters packed in blocks.
+ * @details Each block of CONV_BLOCK filters is applied to CONV_VEC adjacent
+ * outputs at once, keeping the sums in registers while the taps of every
+ * channel are accumulated, so that each input element loaded is used for
+ * CONV_BLOCK multiply-adds.
+ * @param [in] im Padded image of dimension: channels × ph × pw.
+ * @param [in] channels Number of image channels.
+ * @param [in] ph Padded image height.
+ * @param [in] pw Padded image width.
+ * @param [in] ksize Kernel size.
+ * @param [in] stride Kernel stride.
+ * @param [in] packed Filters packed by conv_pack().
+ * @param [in] n_filters Number of filters.
+ * @param [in] out_h Output height.
+ * @param [in] out_w Output width.
+ * @param [in,out] data_out Output to which the convolution is added.
+ */
+static void
+conv_kernel(const neural_real *im, const int channels, const int ph,
+            const int pw, const int ksize, const int stride,
+            const neural_real *packed, const int n_filters, const int out_h,
+            const int out_w, neural_real *data_out)
+{
+    const int k = channels * ksize * ksize;
+    for (int f0 = 0; f0 < n_filters; f0 += CONV_BLOCK) {
+        const neural_real *wb = packed + (size_t) f0 * k;
+        const int nf = (n_filters - f0 < CONV_BLOCK) ? n_filters - f0
+                                                     : CONV_BLOCK;
+        for (int oy = 0; oy < out_h; ++oy) {
+            for (int ox = 0; ox < out_w; ox += CONV_VEC) {
+                neural_real acc[CONV_BLOCK][CONV_VEC];
+                conv_tile(im + oy * stride * pw + ox * stride, channels, ph,
+                          pw, ksize, stride, wb, acc);
+                const int nx = (out_w - ox < CONV_VEC) ? out_w - ox : CONV_VEC;
+                for (int f = 0; f < nf; ++f) {
+                    neural_real *out =
+                        data_out + ((f0 + f) * out_h + oy) * out_w + ox;
+                    for (int x = 0; x < nx; ++x) {
+                        out[x] += acc[f][x];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Packs filters into blocks of CONV_BLOCK interleaved filters.
+ * @details Filters are read as w[f * f_stride + c * c_stride + tap], where the
+ * ksize² taps are optionally reversed, so that the same routine packs the
+ * transposed and rotated filters applied when propagating errors backwards.
+ * Filters beyond the last are zero.
+ * @param [in] weights The filters.
+ * @param [in] n_filters Number of filters.
+ * @param [in] channels Number of channels of each filter.
+ * @param [in] taps Number of taps of each channel, ksize².
+ * @param [in] f_stride Distance between filters.
+ * @param [in] c_stride Distance between channels.
+ * @param [in] flip Whether to reverse the taps.
+ * @param [out] packed The packed filters.
+ */
+static void
+conv_pack(const neural_real *weights, const int n_filters, const int channels,
+          const int taps, const int f_stride, const int c_stride,
+          const bool flip, neural_real *packed)
+{
+    const int k = channels * taps;
+    for (int f0 = 0; f0 < n_filters; f0 += CONV_BLOCK) {
+        for (int i = 0; i < k; ++i) {
+            const int c = i / taps;
+            const int t = flip ? taps - 1 - i % taps : i % taps;
+            for (int f = 0; f < CONV_BLOCK; ++f) {
+                packed[(size_t) f0 * k + i * CONV_BLOCK + f] =
+                    (f0 + f < n_filters)
+                    ? weights[(f0 + f) * f_stride + c * c_stride + t]
+                    : 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Returns the number of filters rounded up to whole blocks.
+ * @param [in] n_filters Number of filters.
+ * @return The number of packed filters.
+ */
+static int
+conv_blocks(const int n_filters)
+{
+    return (n_filters + CONV_BLOCK - 1) / CONV_BLOCK * CONV_BLOCK;
+}
+
+/**
+ * @brief Returns a row length rounded up to whole vectors.
+ * @param [in] width The row length.
+ * @return The rounded length.
+ */
+static int
+conv_row(const int width)
+{
+    return (width + CONV_VEC - 1) / CONV_VEC * CONV_VEC;
+}
+
+/**
+ * @brief Correlates a block of filter errors with a block of filter taps.
+ * @param [in] im Padded image of the channel.
+ * @param [in] pw Padded image width.
+ * @param [in] tap Offset of each tap within the padded image.
+ * @param [in] stride Kernel stride.
+ * @param [in] d Padded errors of CONV_BLOCK filters.
+ * @param [in] out_h Output height.
+ * @param [in] dw Padded output width.
+ * @param [out] acc The CONV_BLOCK filters × CONV_BLOCK taps gradients.
+ */
+static inline void
+conv_grad_tile(const neural_real *im, const int pw, const int *tap,
+               const int stride, const neural_real *d, const int out_h,
+               const int dw, double acc[CONV_BLOCK][CONV_BLOCK])
+{
+    const int fs = out_h * dw;
+#ifdef CONV_VECTOR
+    if (stride == 1) {
+        conv_vec sum[CONV_BLOCK][CONV_BLOCK];
+        memset(sum, 0, sizeof(sum));
+        for (int oy = 0; oy < out_h; ++oy) {
+            for (int ox = 0; ox < dw; ox += CONV_VEC) {
+                conv_vec dv[CONV_BLOCK];
+                for (int f = 0; f < CONV_BLOCK; ++f) {
+                    dv[f] = *(const conv_vec *) &d[f * fs + oy * dw + ox];
+                }
+                for (int t = 0; t < CONV_BLOCK; ++t) {
+                    const conv_vec r =
+                        *(const conv_vec *) &im[tap[t] + oy * pw + ox];
+                    for (int f = 0; f < CONV_BLOCK; ++f) {
+                        sum[f][t] += dv[f] * r;
+                    }
+                }
+            }
+        }
+        for (int f = 0; f < CONV_BLOCK; ++f) {
+            for (int t = 0; t < CONV_BLOCK; ++t) {
+                acc[f][t] = 0;
+                for (int x = 0; x < CONV_VEC; ++x) {
+                    acc[f][t] += sum[f][t][x];
+                }
+            }
+        }
+        return;
+    }
+#endif
+    memset(acc, 0, sizeof(double) * CONV_BLOCK * CONV_BLOCK);
+    for (int oy = 0; oy < out_h; ++oy) {
+        for (int t = 0; t < CONV_BLOCK; ++t) {
+            const neural_real *row = im + tap[t] + oy * stride * pw;
+            for (int f = 0; f < CONV_BLOCK; ++f) {
+                const neural_real *dr = d + f * fs + oy * dw;
+                for (int ox = 0; ox < dw; ++ox) {
+                    acc[f][t] += dr[ox] * row[ox * stride];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Returns the number of elements of workspace used by the direct
+ * convolution functions.
+ * @param [in] channels Number of image channels.
+ * @param [in] height Image height.
+ * @param [in] width Image width.
+ * @param [in] ksize Kernel size.
+ * @param [in] stride Kernel stride.
+ * @param [in] pad Kernel padding.
+ * @param [in] n_filters Number of filters.
+ * @return The workspace size in elements.
+ */
+size_t
+conv_direct_workspace(const int channels, const int height, const int width,
+                      const int ksize, const int stride, const int pad,
+                      const int n_filters)
+{
+    const int out_h = (height + 2 * pad - ksize) / stride + 1;
+    const int out_w = (width + 2 * pad - ksize) / stride + 1;
+    const int taps = ksize * ksize;
+    const size_t forward =
+        conv_padded_size(channels, height + 2 * pad, width + 2 * pad, ksize,
+                         stride) +
+        (size_t) conv_blocks(n_filters) * channels * taps;
+    const size_t weights =
+        conv_padded_size(channels, height + 2 * pad, width + 2 * pad, ksize,
+                         stride) +
+        (size_t) conv_blocks(n_filters) * out_h * conv_row(out_w);
+    const int bpad = ksize - 1 - pad;
+    size_t backward = 0;
+    if (stride == 1 && bpad >= 0) {
+        backward = conv_padded_size(n_filters, out_h + 2 * bpad,
+                                    out_w + 2 * bpad, ksize, 1) +
+            (size_t) conv_blocks(channels) * n_filters * taps;
+    }
+    size_t size = forward > backward ? forward : backward;
+    return size > weights ? size : weights;
+}
+
+/**
+ * @brief Convolves an image directly with a set of filters.
+ * @details The image is copied into a zero border so that the kernel needs no
+ * bounds checks, and blocks of filters are applied to runs of adjacent
+ * outputs held in registers, avoiding the ksize² expansion of im2col().
+ * @param [in] data_im Image of dimension: channels × height × width.
+ * @param [in] channels Number of image channels.
+ * @param [in] height Image height.
+ * @param [in] width Image width.
+ * @param [in] ksize Kernel size.
+ * @param [in] stride Kernel stride.
+ * @param [in] pad Kernel padding.
+ * @param [in] weights Filters of dimension: n_filters × channels × ksize².
+ * @param [in] n_filters Number of filters.
+ * @param [in] workspace Scratch space of conv_direct_workspace() elements.
+ * @param [in,out] data_out Output to which the convolution is added.
+ */
+void
+conv_direct_forward(const neural_real *data_im, const int channels,
+                    const int height, const int width, const int ksize,
+                    const int stride, const int pad, const neural_real *weights,
+                    const int n_filters, neural_real *workspace,
+                    neural_real *data_out)
+{
+    const int ph = height + 2 * pad;
+    const int pw = width + 2 * pad;
+    const int out_h = (ph - ksize) / stride + 1;
+    const int out_w = (pw - ksize) / stride + 1;
+    const int taps = ksize * ksize;
+    const size_t size = conv_padded_size(channels, ph, pw, ksize, stride);
+    neural_real *packed = workspace + size;
+    conv_pad(data_im, channels, height, width, pad, size, workspace);
+    conv_pack(weights, n_filters, channels, taps, channels * taps, taps, false,
+              packed);
+    if (stride == 1) {
+        conv_kernel(workspace, channels, ph, pw, ksize, 1, packed, n_filters,
+                    out_h, out_w, data_out);
+    } else {
+        conv_kernel(workspace, channels, ph, pw, ksize, stride, packed,
+                    n_filters, out_h, out_w, data_out);
+    }
+}
+
+/**
+ * @brief Accumulates the weight gradients of a direct convolution.
+ * @param [in] data_im Image of dimension: channels × height × width.
+ * @param [in] channels Number of image channels.
+ * @param [in] height Image height.
+ * @param [in] width Image width.
+ * @param [in] ksize Kernel size.
+ * @param [in] stride Kernel stride.
+ * @param [in] pad Kernel padding.
+ * @param [in] delta Output error of dimension: n_filters × out_h × out_w.
+ * @param [in] n_filters Number of filters.
+ * @param [in] workspace Scratch space of conv_direct_workspace() elements.
+ * @param [in,out] updates Weight gradients to which the result is added.
+ */
+void
+conv_direct_weights(const neural_real *data_im, const int channels,
+                    const int height, const int width, const int ksize,
+                    const int stride, const int pad, const neural_real *delta,
+                    const int n_filters, neural_real *workspace,
+                    neural_real *updates)
+{
+    const int ph = height + 2 * pad;
+    const int pw = width + 2 * pad;
+    const int out_h = (ph - ksize) / stride + 1;
+    const int out_w = (pw - ksize) / stride + 1;
+    const int taps = ksize * ksize;
+    const int dw = conv_row(out_w);
+    const int fs = out_h * dw;
+    const size_t size = conv_padded_size(channels, ph, pw, ksize, stride);
+    neural_real *d = workspace + size;
+    conv_pad(data_im, channels, height, width, pad, size, workspace);
+    memset(d, 0, sizeof(neural_real) * conv_blocks(n_filters) * fs);
+    for (int f = 0; f < n_filters; ++f) {
+        for (int oy = 0; oy < out_h; ++oy) {
+            memcpy(d + f * fs + oy * dw, delta + (f * out_h + oy) * out_w,
+                   sizeof(neural_real) * out_w);
+        }
+    }
+    for (int f0 = 0; f0 < n_filters; f0 += CONV_BLOCK) {
+        const int nf = (n_filters - f0 < CONV_BLOCK) ? n_filters - f0
+                                                     : CONV_BLOCK;
+        for (int c = 0; c < channels; ++c) {
+            for (int t0 = 0; t0 < taps; t0 += CONV_BLOCK) {
+                const int nt = (taps - t0 < CONV_BLOCK) ? taps - t0
+                                                        : CONV_BLOCK;
+                int tap[CONV_BLOCK];
+                for (int t = 0; t < CONV_BLOCK; ++t) {
+                    const int i = (t < nt) ? t0 + t : t0;
+                    tap[t] = (c * ph + i / ksize) * pw + i % ksize;
+                }
+                double acc[CONV_BLOCK][CONV_BLOCK];
+                conv_grad_tile(workspace, pw, tap, stride, d + f0 * fs, out_h,
+                               dw, acc);
+                for (int f = 0; f < nf; ++f) {
+                    for (int t = 0; t < nt; ++t) {
+                        updates[(f0 + f) * channels * taps + c * taps + t0 +
+                                t] += acc[f][t];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Accumulates the input error of a direct convolution.
+ * @details At stride 1 the input error is the convolution of the zero-bordered
+ * output error with the transposed and rotated filters, which is computed by
+ * the forward kernel. Other strides scatter the error tap by tap.
+ * @param [in] delta Output error of dimension: n_filters × out_h × out_w.
+ * @param [in] channels Number of image channels.
+ * @param [in] height Image height.
+ * @param [in] width Image width.
+ * @param [in] ksize Kernel size.
+ * @param [in] stride Kernel stride.
+ * @param [in] pad Kernel padding.
+ * @param [in] weights Filters of dimension: n_filters × channels × ksize².
+ * @param [in] n_filters Number of filters.
+ * @param [in] workspace Scratch space of conv_direct_workspace() elements.
+ * @param [in,out] data_im Image error to which the result is added.
+ */
+void
+conv_direct_delta(const neural_real *delta, const int channels,
+                  const int height, const int width, const int ksize,
+                  const int stride, const int pad, const neural_real *weights,
+                  const int n_filters, neural_real *workspace,
+                  neural_real *data_im)
+{
+    const int out_h = (height + 2 * pad - ksize) / stride + 1;
+    const int out_w = (width + 2 * pad - ksize) / stride + 1;
+    const int taps = ksize * ksize;
+    const int bpad = ksize - 1 - pad;
+    if (stride == 1 && bpad >= 0) {
+        const int ph = out_h + 2 * bpad;
+        const int pw = out_w + 2 * bpad;
+        const size_t size = conv_padded_size(n_filters, ph, pw, ksize, 1);
+        neural_real *packed = workspace + size;
+        conv_pad(delta, n_filters, out_h, out_w, bpad, size, workspace);
+        conv_pack(weights, channels, n_filters, taps, taps, channels * taps,
+                  true, packed);
+        conv_kernel(workspace, n_filters, ph, pw, ksize, 1, packed, channels,
+                    height, width, data_im);
+        return;
+    }
+    for (int f = 0; f < n_filters; ++f) {
+        for (int c = 0; c < channels; ++c) {
+            for (int ky = 0; ky < ksize; ++ky) {
+                for (int kx = 0; kx < ksize; ++kx) {
+                    const neural_real w =
+                        weights[(f * channels + c) * taps + ky * ksize + kx];
+                    for (int oy = 0; oy < out_h; ++oy) {
+                        const int y = oy * stride + ky - pad;
+                        if (y < 0 || y >= height) {
+                            continue;
+                        }
+                        const neural_real *d = delta + (f * out_h + oy) * out_w;
+                        neural_real *row = data_im + (c * height + y) * width;
+                        for (int ox = 0; ox < out_w; ++ox) {
+                            const int x = ox * stride + kx - pad;
+                            if (x >= 0 && x < width) {
+                                row[x] += w * d[ox];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Returns the number of elements of workspace used by a Winograd
+ * convolution.
+ * @param [in] channels Number of image channels.
+ * @param [in] height Image height.
+ * @param [in] width Image width.
+ * @param [in] pad Kernel padding.
+ * @param [in] n_filters Number of filters.
+ * @return The workspace size in elements.
+ */
+size_t
+conv_winograd_workspace(const int channels, const int height, const int width,
+                        const int pad, const int n_filters)
+{
+    const size_t out_h = (size_t) (height + 2 * pad - 2);
+    const size_t out_w = (size_t) (width + 2 * pad - 2);
+    const size_t tiles = ((out_h + 1) / 2) * ((out_w + 1) / 2);
+    const size_t c = (size_t) channels;
+    const size_t m = (size_t) n_filters;
+    return 16 * (m * c + c * tiles + m * tiles);
+}
+
+/**
+ * @brief Convolves an image with 3×3 filters at stride 1 using the Winograd
+ * F(2×2, 3×3) algorithm.
+ * @details Each 2×2 output tile is computed from a 4×4 input tile with 16
+ * multiplications per channel instead of 36. The transformed filters and
+ * input tiles are multiplied for all tiles and channels as 16 matrix products
+ * so that the bulk of the work is done by neural_gemm().
+ * @param [in] data_im Image of dimension: channels × height × width.
+ * @param [in] channels Number of image channels.
+ * @param [in] height Image height.
+ * @param [in] width Image width.
+ * @param [in] pad Kernel padding.
+ * @param [in] weights Filters of dimension: n_filters × channels × 9.
+ * @param [in] n_filters Number of filters.
+ * @param [in] workspace Scratch space of conv_winograd_workspace() elements.
+ * @param [in,out] data_out Output to which the convolution is added.
+ */
+void
+conv_winograd_forward(const neural_real *data_im, const int channels,
+                      const int height, const int width, const int pad,
+                      const neural_real *weights, const int n_filters,
+                      neural_real *workspace, neural_real *data_out)
+{
+    const int out_h = height + 2 * pad - 2;
+    const int out_w = width + 2 * pad - 2;
+    const int tiles_h = (out_h + 1) / 2;
+    const int tiles_w = (out_w + 1) / 2;
+    const int n_tiles = tiles_h * tiles_w;
+    const int m = n_filters;
+    const int n_c = channels;
+    neural_real *u = workspace; // 16 × m × channels
+    neural_real *v = u + 16 * m * n_c; // 16 × channels × tiles
+    neural_real *p = v + 16 * n_c * n_tiles; // 16 × m × tiles
+    // transform the filters: G g Gᵀ
+    for (int f = 0; f < m; ++f) {
+        for (int c = 0; c < n_c; ++c) {
+            const neural_real *g = weights + (f * n_c + c) * 9;
+            double t[4][3];
+            for (int j = 0; j < 3; ++j) {
+                t[0][j] = g[j];
+                t[1][j] = 0.5 * (g[j] + g[3 + j] + g[6 + j]);
+                t[2][j] = 0.5 * (g[j] - g[3 + j] + g[6 + j]);
+                t[3][j] = g[6 + j];
+            }
+            for (int i = 0; i < 4; ++i) {
+                neural_real *dst = u + (i * 4) * m * n_c + f * n_c + c;
+                const int s = m * n_c;
+                dst[0] = t[i][0];
+                dst[s] = 0.5 * (t[i][0] + t[i][1] + t[i][2]);
+                dst[2 * s] = 0.5 * (t[i][0] - t[i][1] + t[i][2]);
+                dst[3 * s] = t[i][2];
+            }
+        }
+    }
+    // transform the input tiles: Bᵀ d B
+    for (int c = 0; c < n_c; ++c) {
+        const neural_real *im = data_im + c * height * width;
+        for (int ty = 0; ty < tiles_h; ++ty) {
+            for (int tx = 0; tx < tiles_w; ++tx) {
+                double d[4][4];
+                for (int i = 0; i < 4; ++i) {
+                    const int y = 2 * ty + i - pad;
+                    for (int j = 0; j < 4; ++j) {
+                        const int x = 2 * tx + j - pad;
+                        d[i][j] = (y >= 0 && y < height && x >= 0 && x < width)
+                            ? im[y * width + x]
+                            : 0;
+                    }
+                }
+                double t[4][4];
+                for (int j = 0; j < 4; ++j) {
+                    t[0][j] = d[0][j] - d[2][j];
+                    t[1][j] = d[1][j] + d[2][j];
+                    t[2][j] = d[2][j] - d[1][j];
+                    t[3][j] = d[1][j] - d[3][j];
+                }
+                const int s = n_c * n_tiles;
+                neural_real *dst = v + c * n_tiles + ty * tiles_w + tx;
+                for (int i = 0; i < 4; ++i) {
+                    dst[(i * 4) * s] = t[i][0] - t[i][2];
+                    dst[(i * 4 + 1) * s] = t[i][1] + t[i][2];
+                    dst[(i * 4 + 2) * s] = t[i][2] - t[i][1];
+                    dst[(i * 4 + 3) * s] = t[i][1] - t[i][3];
+                }
+            }
+        }
+    }
+    // multiply the transforms for each of the 16 tile positions
+    for (int xi = 0; xi < 16; ++xi) {
+        neural_gemm(0, 0, m, n_tiles, n_c, 1, u + xi * m * n_c, n_c,
+                    v + xi * n_c * n_tiles, n_tiles, 0, p + xi * m * n_tiles,
+                    n_tiles);
+    }
+    // transform the products back to output tiles: Aᵀ M A
+    const int s = m * n_tiles;
+    for (int f = 0; f < m; ++f) {
+        neural_real *out = data_out + f * out_h * out_w;
+        for (int ty = 0; ty < tiles_h; ++ty) {
+            for (int tx = 0; tx < tiles_w; ++tx) {
+                const neural_real *src = p + f * n_tiles + ty * tiles_w + tx;
+                double t[2][4];
+                for (int j = 0; j < 4; ++j) {
+                    const double m0 = src[j * s];
+                    const double m1 = src[(4 + j) * s];
+                    const double m2 = src[(8 + j) * s];
+                    const double m3 = src[(12 + j) * s];
+                    t[0][j] = m0 + m1 + m2;
+                    t[1][j] = m1 - m2 - m3;
+                }
+                for (int i = 0; i < 2; ++i) {
+                    const int y = 2 * ty + i;
+                    if (y >= out_h) {
+                        break;
+                    }
+                    const double y0 = t[i][0] + t[i][1] + t[i][2];
+                    const double y1 = t[i][1] - t[i][2] - t[i][3];
+                    out[y * out_w + 2 * tx] += y0;
+                    if (2 * tx + 1 < out_w) {
+                        out[y * out_w + 2 * tx + 1] += y1;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -17,16 +17,58 @@
  * @file image.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2020.
+ * @date 2020--2026.
  * @brief Image handling functions.
  */
 
+#pragma once
+
+#include "neural.h"
+
+#define CONV_VEC (8) //!< Adjacent outputs convolved together directly
+
 void
-col2im(const double *data_col, const int channels, const int height,
+col2im(const neural_real *data_col, const int channels, const int height,
        const int width, const int ksize, const int stride, const int pad,
-       double *data_im);
+       neural_real *data_im);
 
 void
-im2col(const double *data_im, const int channels, const int height,
+im2col(const neural_real *data_im, const int channels, const int height,
        const int width, const int ksize, const int stride, const int pad,
-       double *data_col);
+       neural_real *data_col);
+
+void
+conv_direct_forward(const neural_real *data_im, const int channels,
+                    const int height, const int width, const int ksize,
+                    const int stride, const int pad, const neural_real *weights,
+                    const int n_filters, neural_real *workspace,
+                    neural_real *data_out);
+
+void
+conv_direct_weights(const neural_real *data_im, const int channels,
+                    const int height, const int width, const int ksize,
+                    const int stride, const int pad, const neural_real *delta,
+                    const int n_filters, neural_real *workspace,
+                    neural_real *updates);
+
+void
+conv_direct_delta(const neural_real *delta, const int channels,
+                  const int height, const int width, const int ksize,
+                  const int stride, const int pad, const neural_real *weights,
+                  const int n_filters, neural_real *workspace,
+                  neural_real *data_im);
+
+size_t
+conv_direct_workspace(const int channels, const int height, const int width,
+                      const int ksize, const int stride, const int pad,
+                      const int n_filters);
+
+size_t
+conv_winograd_workspace(const int channels, const int height, const int width,
+                        const int pad, const int n_filters);
+
+void
+conv_winograd_forward(const neural_real *data_im, const int channels,
+                      const int height, const int width, const int pad,
+                      const neural_real *weights, const int n_filters,
+                      neural_real *workspace, neural_real *data_out);
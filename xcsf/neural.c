@@ -17,7 +17,7 @@
  * @file neural.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2012--2024.
+ * @date 2012--2026.
  * @brief An implementation of a multi-layer perceptron neural network.
  */
 
@@ -42,7 +42,162 @@ neural_init(struct Net *net)
     net->n_inputs = 0;
     net->n_outputs = 0;
     net->output = NULL;
+    net->input = NULL;
     net->train = false;
+    net->fast = false;
+    net->arena = NULL;
+    net->arena_size = 0;
+}
+
+/**
+ * @brief Sets the number of network inputs from the first layer.
+ * @details Single-precision networks also allocate the buffer into which
+ * inputs are converted.
+ * @param [in] net The neural network.
+ * @param [in] l The first layer of the network.
+ */
+static void
+neural_set_inputs(struct Net *net, const struct Layer *l)
+{
+    net->n_inputs = l->n_inputs;
+#ifdef NEURAL_FLOAT
+    net->input = realloc(net->input, sizeof(neural_real) * net->n_inputs);
+#endif
+}
+
+/**
+ * @brief Returns a network input in the precision of the layers.
+ * @param [in] net The neural network.
+ * @param [in] input The network input.
+ * @return The input converted to neural_real.
+ */
+static const neural_real *
+neural_input(const struct Net *net, const double *input)
+{
+#ifdef NEURAL_FLOAT
+    for (int i = 0; i < net->n_inputs; ++i) {
+        net->input[i] = (neural_real) input[i];
+    }
+    return net->input;
+#else
+    (void) net;
+    return input;
+#endif
+}
+
+/**
+ * @brief Returns whether an address lies within the arena of a network.
+ * @param [in] net The neural network.
+ * @param [in] p The address.
+ * @return Whether the arena holds the address.
+ */
+static bool
+neural_in_arena(const struct Net *net, const void *p)
+{
+    const uintptr_t a = (uintptr_t) p;
+    const uintptr_t start = (uintptr_t) net->arena;
+    return net->arena != NULL && a >= start && a < start + net->arena_size;
+}
+
+/**
+ * @brief Returns whether every list node and layer of a network, including
+ * the layer buffers, lies within the network arena.
+ * @param [in] net The neural network.
+ * @return Whether the network is packed.
+ */
+static bool
+neural_packed(const struct Net *net)
+{
+    if (net->arena == NULL) {
+        return false;
+    }
+    const struct Llist *iter = net->tail;
+    while (iter != NULL) {
+        if (!neural_in_arena(net, iter) ||
+            !layer_arena_holds(iter->layer, net->arena, net->arena_size)) {
+            return false;
+        }
+        iter = iter->prev;
+    }
+    return true;
+}
+
+/**
+ * @brief Copies the layers of a network into a new arena.
+ * @details Each list node is followed by its layer, the layer slab and any
+ * sub-layers, from the first layer to the output layer.
+ * @param [in] net The neural network to hold the copy.
+ * @param [in] src The neural network to copy.
+ * @param [in] keep_state Whether to also copy neuron states and gradients.
+ */
+static void
+neural_arena_build(struct Net *net, const struct Net *src,
+                   const bool keep_state)
+{
+    size_t size = 0;
+    const struct Llist *iter = src->tail;
+    while (iter != NULL) {
+        size += layer_align(sizeof(struct Llist));
+        size += layer_arena_size(iter->layer);
+        iter = iter->prev;
+    }
+    char *arena = malloc(size);
+    net->arena = arena;
+    net->arena_size = size;
+    net->head = NULL;
+    net->tail = NULL;
+    struct Llist *prev = NULL;
+    iter = src->tail;
+    while (iter != NULL) {
+        struct Llist *node = (struct Llist *) arena;
+        arena += layer_align(sizeof(struct Llist));
+        node->layer = layer_arena_copy(iter->layer, &arena, keep_state);
+        node->next = prev;
+        node->prev = NULL;
+        if (prev == NULL) {
+            net->tail = node;
+        } else {
+            prev->prev = node;
+        }
+        prev = node;
+        iter = iter->prev;
+    }
+    net->head = prev;
+    net->n_layers = src->n_layers;
+    net->n_inputs = src->n_inputs;
+    net->n_outputs = src->n_outputs;
+    net->output = net->head->layer->output;
+}
+
+/**
+ * @brief Moves all of the layers of a network into a single arena.
+ * @param [in] net The neural network to pack.
+ */
+static void
+neural_pack(struct Net *net)
+{
+    if (net->tail == NULL) {
+        return;
+    }
+    struct Net old = *net;
+    neural_arena_build(net, &old, true);
+    old.input = NULL;
+    neural_free(&old);
+}
+
+/**
+ * @brief Repacks a network whose layers have been reallocated outside its
+ * arena, as when layers are resized.
+ * @param [in] net The neural network.
+ */
+static void
+neural_repack(struct Net *net)
+{
+    if (net->arena != NULL && !neural_packed(net)) {
+        neural_pack(net);
+    } else if (net->head != NULL) {
+        net->output = net->head->layer->output;
+    }
 }
 
 /**
@@ -83,6 +238,7 @@ neural_create(struct Net *net, struct ArgsLayer *arg)
         printf("neural_create() error: initialising network\n");
         exit(EXIT_FAILURE);
     }
+    neural_pack(net);
 }
 
 /**
@@ -100,7 +256,7 @@ neural_insert(struct Net *net, struct Layer *l, const int pos)
         net->head->prev = NULL;
         net->head->next = NULL;
         net->tail = net->head;
-        net->n_inputs = l->n_inputs;
+        neural_set_inputs(net, l);
         net->n_outputs = l->n_outputs;
         net->output = l->output;
     } else { // insert
@@ -122,7 +278,7 @@ neural_insert(struct Net *net, struct Layer *l, const int pos)
             iter->next = new;
             if (iter->next == NULL) { // new tail
                 net->tail = new;
-                net->n_inputs = l->n_inputs;
+                neural_set_inputs(net, l);
             } else { // middle
                 new->next->prev = new;
             }
@@ -173,9 +329,10 @@ neural_remove(struct Net *net, const int pos)
         iter->prev->next = iter->next;
     }
     --(net->n_layers);
-    layer_free(iter->layer);
-    free(iter->layer);
-    free(iter);
+    layer_delete(iter->layer);
+    if (!neural_in_arena(net, iter)) {
+        free(iter);
+    }
 }
 
 /**
@@ -199,8 +356,27 @@ neural_pop(struct Net *net)
     neural_remove(net, net->n_layers - 1);
 }
 
+/**
+ * @brief Maps an address within the arena of a network to a copy of it.
+ * @param [in] net The neural network owning the original arena.
+ * @param [in] p The address within the original arena, or NULL.
+ * @param [in] arena The copied arena.
+ * @return The corresponding address within the copy, or NULL.
+ */
+static void *
+neural_rebase(const struct Net *net, const void *p, void *arena)
+{
+    if (p == NULL) {
+        return NULL;
+    }
+    return (char *) arena + ((uintptr_t) p - (uintptr_t) net->arena);
+}
+
 /**
  * @brief Copies a neural network.
+ * @details A packed network is copied with a single memcpy() of its arena
+ * followed by relocating the pointers; otherwise the layers are packed into a
+ * new arena as they are copied.
  * @param [in] dest The destination neural network.
  * @param [in] src The source neural network.
  */
@@ -208,12 +384,33 @@ void
 neural_copy(struct Net *dest, const struct Net *src)
 {
     neural_init(dest);
-    const struct Llist *iter = src->tail;
+    if (src->tail == NULL) {
+        return;
+    }
+    if (!neural_packed(src)) {
+        neural_arena_build(dest, src, false);
+        neural_set_inputs(dest, dest->tail->layer);
+        return;
+    }
+    dest->arena = malloc(src->arena_size);
+    dest->arena_size = src->arena_size;
+    memcpy(dest->arena, src->arena, src->arena_size);
+    dest->head = neural_rebase(src, src->head, dest->arena);
+    dest->tail = neural_rebase(src, src->tail, dest->arena);
+    struct Llist *iter = dest->tail;
     while (iter != NULL) {
-        struct Layer *l = layer_copy(iter->layer);
-        neural_push(dest, l);
+        iter->layer = neural_rebase(src, iter->layer, dest->arena);
+        iter->next = neural_rebase(src, iter->next, dest->arena);
+        iter->prev = neural_rebase(src, iter->prev, dest->arena);
+        layer_arena_rebase(iter->layer, src->arena, src->arena_size,
+                           dest->arena);
         iter = iter->prev;
     }
+    dest->n_layers = src->n_layers;
+    dest->n_inputs = src->n_inputs;
+    dest->n_outputs = src->n_outputs;
+    dest->output = dest->head->layer->output;
+    neural_set_inputs(dest, dest->tail->layer);
 }
 
 /**
@@ -225,13 +422,19 @@ neural_free(struct Net *net)
 {
     struct Llist *iter = net->tail;
     while (iter != NULL) {
-        layer_free(iter->layer);
-        free(iter->layer);
+        layer_delete(iter->layer);
         net->tail = iter->prev;
-        free(iter);
+        if (!neural_in_arena(net, iter)) {
+            free(iter);
+        }
         iter = net->tail;
         --(net->n_layers);
     }
+    free(net->input);
+    net->input = NULL;
+    free(net->arena);
+    net->arena = NULL;
+    net->arena_size = 0;
 }
 
 /**
@@ -254,7 +457,7 @@ neural_rand(const struct Net *net)
  * @return Whether any alterations were made.
  */
 bool
-neural_mutate(const struct Net *net)
+neural_mutate(struct Net *net)
 {
     bool mod = false;
     bool do_resize = false;
@@ -279,6 +482,7 @@ neural_mutate(const struct Net *net)
         prev = iter->layer;
         iter = iter->prev;
     }
+    neural_repack(net);
     return mod;
 }
 
@@ -287,7 +491,7 @@ neural_mutate(const struct Net *net)
  * @param [in] net The neural network to resize.
  */
 void
-neural_resize(const struct Net *net)
+neural_resize(struct Net *net)
 {
     const struct Layer *prev = NULL;
     const struct Llist *iter = net->tail;
@@ -298,6 +502,7 @@ neural_resize(const struct Net *net)
         prev = iter->layer;
         iter = iter->prev;
     }
+    neural_repack(net);
 }
 
 /**
@@ -305,15 +510,19 @@ neural_resize(const struct Net *net)
  * @param [in] net Neural network to propagate.
  * @param [in] input Input state.
  * @param [in] train Whether the network is in training mode.
+ * @param [in] fast Whether to use approximate activations.
  */
 void
-neural_propagate(struct Net *net, const double *input, const bool train)
+neural_propagate(struct Net *net, const double *input, const bool train,
+                 const bool fast)
 {
     net->train = train;
+    net->fast = fast;
+    const neural_real *x = neural_input(net, input);
     const struct Llist *iter = net->tail;
     while (iter != NULL) {
-        layer_forward(iter->layer, net, input);
-        input = layer_output(iter->layer);
+        layer_forward(iter->layer, net, x);
+        x = layer_output(iter->layer);
         iter = iter->prev;
     }
 }
@@ -330,7 +539,8 @@ neural_learn(const struct Net *net, const double *truth, const double *input)
     // reset deltas
     const struct Llist *iter = net->tail;
     while (iter != NULL) {
-        memset(iter->layer->delta, 0, sizeof(double) * iter->layer->n_outputs);
+        memset(iter->layer->delta, 0,
+               sizeof(neural_real) * iter->layer->n_outputs);
         iter = iter->prev;
     }
     // calculate output layer delta
@@ -343,7 +553,7 @@ neural_learn(const struct Net *net, const double *truth, const double *input)
     while (iter != NULL) {
         const struct Layer *l = iter->layer;
         if (iter->next == NULL) {
-            layer_backward(l, net, input, 0);
+            layer_backward(l, net, neural_input(net, input), 0);
         } else {
             const struct Layer *prev = iter->next->layer;
             layer_backward(l, net, prev->output, prev->delta);
@@ -380,7 +590,7 @@ neural_output(const struct Net *net, const int IDX)
  * @param [in] net The neural network to output.
  * @return The neural network outputs.
  */
-double *
+const neural_real *
 neural_outputs(const struct Net *net)
 {
     return layer_output(net->head->layer);
@@ -468,6 +678,34 @@ neural_size(const struct Net *net)
     return size;
 }
 
+/**
+ * @brief Returns whether the output of a neural network can be reused for an
+ * input already propagated.
+ * @details Recurrent and LSTM layers carry state between inputs, and dropout
+ * and noise layers draw random numbers when training, so another forward pass
+ * of a network with any of them gives different activations.
+ * @param [in] net A neural network.
+ * @return Whether the network has no recurrent, LSTM, dropout or noise layers.
+ */
+bool
+neural_reusable(const struct Net *net)
+{
+    const struct Llist *iter = net->tail;
+    while (iter != NULL) {
+        switch (iter->layer->type) {
+            case RECURRENT:
+            case LSTM:
+            case DROPOUT:
+            case NOISE:
+                return false;
+            default:
+                break;
+        }
+        iter = iter->prev;
+    }
+    return true;
+}
+
 /**
  * @brief Writes a neural network to a file.
  * @param [in] net The neural network to save.
@@ -511,5 +749,6 @@ neural_load(struct Net *net, FILE *fp)
         s += layer_load(l, fp);
         neural_push(net, l);
     }
+    neural_pack(net);
     return s;
 }
@@ -17,12 +17,13 @@
  * @file neural.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2012--2022.
+ * @date 2012--2026.
  * @brief An implementation of a multi-layer perceptron neural network.
  */
 
 #pragma once
 
+#include "blas.h"
 #include "utils.h"
 #include <stdbool.h>
 #include <stdint.h>
@@ -30,6 +31,28 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef NEURAL_FLOAT
+typedef float neural_real; //!< Precision of neural network layer buffers
+    #define neural_gemm blas_sgemm //!< Matrix product of layer buffers
+    #define neural_gemv blas_sgemv //!< Matrix-vector product of layer buffers
+    #define neural_gemv_sparse blas_sgemv_sparse //!< Sparse neural_gemv
+    #define neural_ger blas_sger //!< Rank-1 update of layer buffers
+    #define neural_axpy blas_saxpy //!< Scaled addition of layer buffers
+    #define neural_mul blas_smul //!< Elementwise product of layer buffers
+    #define neural_scal blas_sscal //!< Scaling of a layer buffer
+    #define neural_sum blas_ssum //!< Sum of a layer buffer
+#else
+typedef double neural_real; //!< Precision of neural network layer buffers
+    #define neural_gemm blas_gemm //!< Matrix product of layer buffers
+    #define neural_gemv blas_gemv //!< Matrix-vector product of layer buffers
+    #define neural_gemv_sparse blas_gemv_sparse //!< Sparse neural_gemv
+    #define neural_ger blas_ger //!< Rank-1 update of layer buffers
+    #define neural_axpy blas_axpy //!< Scaled addition of layer buffers
+    #define neural_mul blas_mul //!< Elementwise product of layer buffers
+    #define neural_scal blas_scal //!< Scaling of a layer buffer
+    #define neural_sum blas_sum //!< Sum of a layer buffer
+#endif
+
 struct ArgsLayer; //!< Forward declaration of layer parameter structure
 struct Layer; //!< Forward declaration of layer structure.
 
@@ -49,14 +72,18 @@ struct Net {
     int n_layers; //!< Number of layers (hidden + output)
     int n_inputs; //!< Number of network inputs
     int n_outputs; //!< Number of network outputs
-    double *output; //!< Pointer to the network output
+    neural_real *output; //!< Pointer to the network output
+    neural_real *input; //!< Network input converted to neural_real
     struct Llist *head; //!< Pointer to the head layer (output layer)
     struct Llist *tail; //!< Pointer to the tail layer (first layer)
     bool train; //!< Whether the network is in training mode
+    bool fast; //!< Whether to use approximate activations
+    void *arena; //!< Single allocation holding the layers, or NULL
+    size_t arena_size; //!< Size of the arena in bytes
 };
 
 bool
-neural_mutate(const struct Net *net);
+neural_mutate(struct Net *net);
 
 char *
 neural_json_export(const struct Net *net, const bool return_weights);
@@ -68,12 +95,15 @@ neural_json_import(struct Net *net, const struct ArgsLayer *arg,
 double
 neural_output(const struct Net *net, const int IDX);
 
-double *
+const neural_real *
 neural_outputs(const struct Net *net);
 
 double
 neural_size(const struct Net *net);
 
+bool
+neural_reusable(const struct Net *net);
+
 size_t
 neural_load(struct Net *net, FILE *fp);
 
@@ -111,10 +141,11 @@ void
 neural_print(const struct Net *net, const bool print_weights);
 
 void
-neural_propagate(struct Net *net, const double *input, const bool train);
+neural_propagate(struct Net *net, const double *input, const bool train,
+                 const bool fast);
 
 void
 neural_rand(const struct Net *net);
 
 void
-neural_resize(const struct Net *net);
+neural_resize(struct Net *net);
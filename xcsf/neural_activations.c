@@ -17,13 +17,135 @@
  * @file neural_activations.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2012--2020.
+ * @date 2012--2026.
  * @brief Neural network activation functions.
  */
 
 #include "neural_activations.h"
 #include "neural_layer.h"
 #include "utils.h"
+#include <stdint.h>
+#include <string.h>
+
+#define EXP_MIN (-708.) //!< Smallest exp() argument with a normal result
+#define EXP_MAX (709.) //!< Largest exp() argument with a finite result
+#define ROUND_SHIFT (0x1.8p52) //!< Adding rounds a double to an integer
+#define LN2_HI (0x1.62e42fefa3800p-1) //!< Upper bits of ln(2)
+#define LN2_LO (0x1.ef35793c76730p-45) //!< Remaining bits of ln(2)
+#define PIO2_1 (1.57079632673412561417e+00) //!< First 33 bits of pi/2
+#define PIO2_2 (6.07710050630396597660e-11) //!< Next 33 bits of pi/2
+#define PIO2_3 (2.02226624871116645580e-21) //!< Remaining bits of pi/2
+#define SELU_SCALE (1.0507) //!< SELU scale
+#define SELU_ALPHA (1.6732) //!< SELU alpha
+
+/**
+ * @brief Returns an approximation of exp(x) that the compiler can vectorise.
+ * @details The argument is reduced to x = k ln(2) + r with |r| <= ln(2)/2 and
+ * exp(r) is evaluated by its Taylor series to degree 13, which truncates with a
+ * relative error below 1e-17; the result is accurate to a few ulp. Arguments
+ * are clamped to [EXP_MIN, EXP_MAX] so that 2^k is formed directly from the
+ * exponent bits without overflow or subnormals.
+ * @param [in] x The argument.
+ * @return An approximation of exp(x).
+ */
+static inline double
+fast_exp(double x)
+{
+    x = (x < EXP_MIN) ? EXP_MIN : (x > EXP_MAX) ? EXP_MAX : x;
+    const double t = x * 1.44269504088896340736 + ROUND_SHIFT;
+    const double k = t - ROUND_SHIFT;
+    uint64_t bits;
+    memcpy(&bits, &t, sizeof(bits));
+    bits = (bits + 1023) << 52;
+    double scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    double r = x - k * LN2_HI;
+    r -= k * LN2_LO;
+    double p = 1. / 6227020800.;
+    p = p * r + 1. / 479001600.;
+    p = p * r + 1. / 39916800.;
+    p = p * r + 1. / 3628800.;
+    p = p * r + 1. / 362880.;
+    p = p * r + 1. / 40320.;
+    p = p * r + 1. / 5040.;
+    p = p * r + 1. / 720.;
+    p = p * r + 1. / 120.;
+    p = p * r + 1. / 24.;
+    p = p * r + 1. / 6.;
+    p = p * r + 0.5;
+    p = p * r + 1.;
+    p = p * r + 1.;
+    return p * scale;
+}
+
+/**
+ * @brief Returns an approximation of sin(x + q pi/2) that can be vectorised.
+ * @details The argument is reduced to x = k pi/2 + r with |r| <= pi/4 using a
+ * three-part pi/2, which is exact for the clamped neuron states, and sin(r) or
+ * cos(r) is selected by the quadrant k + q. The Taylor series to degree 15 and
+ * 16 truncate with absolute errors below 1e-16.
+ * @param [in] x The argument.
+ * @param [in] q The number of quarter turns to add; 0 for sin and 1 for cos.
+ * @return An approximation of sin(x + q pi/2).
+ */
+static inline double
+fast_sin_quadrant(const double x, const uint64_t q)
+{
+    const double t = x * 0.63661977236758134308 + ROUND_SHIFT;
+    const double k = t - ROUND_SHIFT;
+    uint64_t quadrant;
+    memcpy(&quadrant, &t, sizeof(quadrant));
+    quadrant += q;
+    double r = x - k * PIO2_1;
+    r -= k * PIO2_2;
+    r -= k * PIO2_3;
+    const double s = r * r;
+    double sp = -1. / 1307674368000.;
+    sp = sp * s + 1. / 6227020800.;
+    sp = sp * s - 1. / 39916800.;
+    sp = sp * s + 1. / 362880.;
+    sp = sp * s - 1. / 5040.;
+    sp = sp * s + 1. / 120.;
+    sp = sp * s - 1. / 6.;
+    const double sin_r = r + r * s * sp;
+    double cp = 1. / 20922789888000.;
+    cp = cp * s - 1. / 87178291200.;
+    cp = cp * s + 1. / 479001600.;
+    cp = cp * s - 1. / 3628800.;
+    cp = cp * s + 1. / 40320.;
+    cp = cp * s - 1. / 720.;
+    cp = cp * s + 1. / 24.;
+    cp = cp * s - 0.5;
+    const double cos_r = 1. + s * cp;
+    const double v = (quadrant & 1) ? cos_r : sin_r;
+    return (quadrant & 2) ? -v : v;
+}
+
+/**
+ * @brief Returns an approximation of tanh(x) that can be vectorised.
+ * @details Computed as (1 - e) / (1 + e) with e = exp(-2|x|), giving an
+ * absolute error of a few ulp of 1.
+ * @param [in] x The argument.
+ * @return An approximation of tanh(x).
+ */
+static inline double
+fast_tanh(const double x)
+{
+    const double e = fast_exp(-2. * fabs(x));
+    const double t = (1. - e) / (1. + e);
+    return (x < 0) ? -t : t;
+}
+
+/**
+ * @brief Returns an approximation of the logistic function.
+ * @param [in] x The argument.
+ * @return An approximation of 1 / (1 + exp(-x)).
+ */
+static inline double
+fast_logistic(const double x)
+{
+    return 1. / (1. + fast_exp(-x));
+}
 
 /**
  * @brief Returns the result from applying a specified activation function.
@@ -190,17 +312,92 @@ neural_activation_as_int(const char *a)
 
 /**
  * @brief Applies an activation function to a vector of neuron states.
+ * @details The states are clamped to [NEURON_MIN, NEURON_MAX]. Unless fast,
+ * every element is evaluated with neural_activate(). Otherwise the function
+ * is selected once and applied in a branch-free loop per function, using
+ * vectorised approximations of exp, tanh, sin and cos accurate to a few ulp;
+ * soft plus still calls log1p() and is not vectorised.
  * @param [in,out] state The neuron states.
  * @param [in,out] output The neuron outputs.
  * @param [in] n The length of the input array.
  * @param [in] a The activation function.
+ * @param [in] fast Whether to use the approximations.
  */
 void
-neural_activate_array(double *state, double *output, const int n, const int a)
+neural_activate_array(neural_real *state, neural_real *output, const int n,
+                      const int a, const bool fast)
 {
     for (int i = 0; i < n; ++i) {
         state[i] = clamp(state[i], NEURON_MIN, NEURON_MAX);
-        output[i] = neural_activate(a, state[i]);
+    }
+    if (!fast) {
+        for (int i = 0; i < n; ++i) {
+            output[i] = neural_activate(a, state[i]);
+        }
+        return;
+    }
+    switch (a) {
+        case LOGISTIC:
+            for (int i = 0; i < n; ++i) {
+                output[i] = fast_logistic(state[i]);
+            }
+            break;
+        case RELU:
+            for (int i = 0; i < n; ++i) {
+                output[i] = relu_activate(state[i]);
+            }
+            break;
+        case GAUSSIAN:
+            for (int i = 0; i < n; ++i) {
+                output[i] = fast_exp(-state[i] * state[i]);
+            }
+            break;
+        case TANH:
+            for (int i = 0; i < n; ++i) {
+                output[i] = fast_tanh(state[i]);
+            }
+            break;
+        case SIN:
+            for (int i = 0; i < n; ++i) {
+                output[i] = fast_sin_quadrant(state[i], 0);
+            }
+            break;
+        case COS:
+            for (int i = 0; i < n; ++i) {
+                output[i] = fast_sin_quadrant(state[i], 1);
+            }
+            break;
+        case SOFT_PLUS:
+            for (int i = 0; i < n; ++i) {
+                output[i] = soft_plus_activate(state[i]);
+            }
+            break;
+        case LINEAR:
+            for (int i = 0; i < n; ++i) {
+                output[i] = linear_activate(state[i]);
+            }
+            break;
+        case LEAKY:
+            for (int i = 0; i < n; ++i) {
+                output[i] = leaky_activate(state[i]);
+            }
+            break;
+        case SELU:
+            for (int i = 0; i < n; ++i) {
+                const double x = state[i];
+                output[i] = (x >= 0) ? SELU_SCALE * x
+                                     : SELU_SCALE * SELU_ALPHA *
+                                           (fast_exp(x) - 1.);
+            }
+            break;
+        case LOGGY:
+            for (int i = 0; i < n; ++i) {
+                output[i] = 2. * fast_logistic(state[i]) - 1.;
+            }
+            break;
+        default:
+            printf("neural_activate_array(): invalid activation: %d\n", a);
+            exit(EXIT_FAILURE);
     }
 }
 
@@ -210,12 +407,137 @@ neural_activate_array(double *state, double *output, const int n, const int a)
  * @param [in,out] delta The neuron gradients.
  * @param [in] n The length of the input array.
  * @param [in] a The activation function.
+ * @param [in] fast Whether to use the approximations.
  */
 void
-neural_gradient_array(const double *state, double *delta, const int n,
-                      const int a)
+neural_gradient_array(const neural_real *state, neural_real *delta,
+                      const int n, const int a, const bool fast)
 {
-    for (int i = 0; i < n; ++i) {
-        delta[i] *= neural_gradient(a, state[i]);
+    if (!fast) {
+        for (int i = 0; i < n; ++i) {
+            delta[i] *= neural_gradient(a, state[i]);
+        }
+        return;
+    }
+    switch (a) {
+        case LOGISTIC:
+            for (int i = 0; i < n; ++i) {
+                const double y = fast_logistic(state[i]);
+                delta[i] *= y * (1. - y);
+            }
+            break;
+        case RELU:
+            for (int i = 0; i < n; ++i) {
+                delta[i] *= relu_gradient(state[i]);
+            }
+            break;
+        case GAUSSIAN:
+            for (int i = 0; i < n; ++i) {
+                const double x = state[i];
+                delta[i] *= -2. * x * fast_exp(-x * x);
+            }
+            break;
+        case TANH:
+            for (int i = 0; i < n; ++i) {
+                const double y = fast_tanh(state[i]);
+                delta[i] *= 1. - y * y;
+            }
+            break;
+        case SIN:
+            for (int i = 0; i < n; ++i) {
+                delta[i] *= fast_sin_quadrant(state[i], 1);
+            }
+            break;
+        case COS:
+            for (int i = 0; i < n; ++i) {
+                delta[i] *= -fast_sin_quadrant(state[i], 0);
+            }
+            break;
+        case SOFT_PLUS:
+            for (int i = 0; i < n; ++i) {
+                delta[i] *= fast_logistic(state[i]);
+            }
+            break;
+        case LINEAR:
+            for (int i = 0; i < n; ++i) {
+                delta[i] *= linear_gradient(state[i]);
+            }
+            break;
+        case LEAKY:
+            for (int i = 0; i < n; ++i) {
+                delta[i] *= leaky_gradient(state[i]);
+            }
+            break;
+        case SELU:
+            for (int i = 0; i < n; ++i) {
+                const double x = state[i];
+                delta[i] *= (x >= 0) ? SELU_SCALE
+                                     : SELU_SCALE * SELU_ALPHA * fast_exp(x);
+            }
+            break;
+        case LOGGY:
+            for (int i = 0; i < n; ++i) {
+                const double y = fast_logistic(state[i]);
+                delta[i] *= 2. * y * (1. - y);
+            }
+            break;
+        default:
+            printf("neural_gradient_array(): invalid activation: %d\n", a);
+            exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Applies a gradient function reusing the outputs of the forward pass.
+ * @details Logistic, loggy and tanh gradients are computed from the cached
+ * outputs and the Gaussian and SELU gradients rescale them, so no exponential
+ * is evaluated again; the other functions are as neural_gradient_array().
+ * @param [in] state The neuron states.
+ * @param [in] output The neuron outputs computed from the states.
+ * @param [in,out] delta The neuron gradients.
+ * @param [in] n The length of the input array.
+ * @param [in] a The activation function.
+ * @param [in] fast Whether to use the approximations.
+ */
+void
+neural_gradient_array_cached(const neural_real *state,
+                             const neural_real *output, neural_real *delta,
+                             const int n, const int a, const bool fast)
+{
+    if (!fast) {
+        neural_gradient_array(state, delta, n, a, fast);
+        return;
+    }
+    switch (a) {
+        case LOGISTIC:
+            for (int i = 0; i < n; ++i) {
+                delta[i] *= output[i] * (1. - output[i]);
+            }
+            break;
+        case GAUSSIAN:
+            for (int i = 0; i < n; ++i) {
+                delta[i] *= -2. * state[i] * output[i];
+            }
+            break;
+        case TANH:
+            for (int i = 0; i < n; ++i) {
+                delta[i] *= 1. - output[i] * output[i];
+            }
+            break;
+        case SELU:
+            for (int i = 0; i < n; ++i) {
+                delta[i] *= (state[i] >= 0)
+                    ? SELU_SCALE
+                    : output[i] + SELU_SCALE * SELU_ALPHA;
+            }
+            break;
+        case LOGGY:
+            for (int i = 0; i < n; ++i) {
+                delta[i] *= 0.5 * (1. + output[i]) * (1. - output[i]);
+            }
+            break;
+        default:
+            neural_gradient_array(state, delta, n, a, fast);
+            break;
     }
 }
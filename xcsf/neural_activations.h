@@ -17,13 +17,15 @@
  * @file neural_activations.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2012--2020.
+ * @date 2012--2026.
  * @brief Neural network activation functions.
  */
 
 #pragma once
 
+#include "neural.h"
 #include <math.h>
+#include <stdbool.h>
 
 #define LOGISTIC (0) //!< Logistic [0,1]
 #define RELU (1) //!< Rectified linear unit [0,inf]
@@ -65,11 +67,17 @@ int
 neural_activation_as_int(const char *a);
 
 void
-neural_activate_array(double *state, double *output, const int n, const int a);
+neural_activate_array(neural_real *state, neural_real *output, const int n,
+                      const int a, const bool fast);
 
 void
-neural_gradient_array(const double *state, double *delta, const int n,
-                      const int a);
+neural_gradient_array(const neural_real *state, neural_real *delta,
+                      const int n, const int a, const bool fast);
+
+void
+neural_gradient_array_cached(const neural_real *state,
+                             const neural_real *output, neural_real *delta,
+                             const int n, const int a, const bool fast);
 
 static inline double
 logistic_activate(const double x)
@@ -17,7 +17,7 @@
  * @file neural_layer.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2016--2020.
+ * @date 2016--2026.
  * @brief Interface for neural network layers.
  */
 
@@ -33,6 +33,50 @@
 #include "neural_layer_softmax.h"
 #include "neural_layer_upsample.h"
 #include "utils.h"
+#include <stddef.h>
+
+#define LAYER_MOVES_MAX (32) //!< Maximum blocks moved when copying a layer
+
+/**
+ * @brief Offsets of the layer fields that may point into a slab.
+ */
+static const size_t LAYER_BUFFERS[] = {
+    offsetof(struct Layer, state),     offsetof(struct Layer, output),
+    offsetof(struct Layer, weights),   offsetof(struct Layer, weight_active),
+    offsetof(struct Layer, biases),    offsetof(struct Layer, bias_updates),
+    offsetof(struct Layer, weight_updates),
+    offsetof(struct Layer, delta),     offsetof(struct Layer, mu),
+    offsetof(struct Layer, prev_state), offsetof(struct Layer, cell),
+    offsetof(struct Layer, prev_cell), offsetof(struct Layer, f),
+    offsetof(struct Layer, i),         offsetof(struct Layer, g),
+    offsetof(struct Layer, o),         offsetof(struct Layer, c),
+    offsetof(struct Layer, h),         offsetof(struct Layer, dc),
+    offsetof(struct Layer, indexes)
+};
+
+/**
+ * @brief Offsets of the layer fields pointing to sub-layers.
+ */
+static const size_t LAYER_CHILDREN[] = {
+    offsetof(struct Layer, input_layer), offsetof(struct Layer, self_layer),
+    offsetof(struct Layer, output_layer), offsetof(struct Layer, uf),
+    offsetof(struct Layer, ui),          offsetof(struct Layer, ug),
+    offsetof(struct Layer, uo),          offsetof(struct Layer, wf),
+    offsetof(struct Layer, wi),          offsetof(struct Layer, wg),
+    offsetof(struct Layer, wo)
+};
+
+#define N_LAYER_BUFFERS (sizeof(LAYER_BUFFERS) / sizeof(LAYER_BUFFERS[0]))
+#define N_LAYER_CHILDREN (sizeof(LAYER_CHILDREN) / sizeof(LAYER_CHILDREN[0]))
+
+/**
+ * @brief A block of memory moved from one address to another.
+ */
+struct LayerMove {
+    uintptr_t from; //!< Original address of the block
+    size_t size; //!< Size of the block in bytes
+    char *to; //!< New address of the block
+};
 
 /**
  * @brief Sets a neural network layer's functions to the implementations.
@@ -136,15 +180,17 @@ layer_add_neurons(struct Layer *l, const int N)
     l->n_weights = l->n_outputs * l->n_inputs;
     layer_guard_outputs(l);
     layer_guard_weights(l);
-    l->weights = realloc(l->weights, sizeof(double) * l->n_weights);
-    l->weight_active = realloc(l->weight_active, sizeof(bool) * l->n_weights);
-    l->weight_updates =
-        realloc(l->weight_updates, sizeof(double) * l->n_weights);
-    l->state = realloc(l->state, sizeof(double) * l->n_outputs);
-    l->output = realloc(l->output, sizeof(double) * l->n_outputs);
-    l->biases = realloc(l->biases, sizeof(double) * l->n_biases);
-    l->bias_updates = realloc(l->bias_updates, sizeof(double) * l->n_biases);
-    l->delta = realloc(l->delta, sizeof(double) * l->n_outputs);
+    const struct LayerBuffer buffers[] = {
+        { &l->weights, sizeof(neural_real) * l->n_weights },
+        { &l->weight_active, sizeof(bool) * l->n_weights },
+        { &l->weight_updates, sizeof(neural_real) * l->n_weights },
+        { &l->state, sizeof(neural_real) * l->n_outputs },
+        { &l->output, sizeof(neural_real) * l->n_outputs },
+        { &l->biases, sizeof(neural_real) * l->n_biases },
+        { &l->bias_updates, sizeof(neural_real) * l->n_biases },
+        { &l->delta, sizeof(neural_real) * l->n_outputs }
+    };
+    layer_slab_resize(l, buffers, 8);
     for (int i = old_n_weights; i < l->n_weights; ++i) {
         if (l->options & LAYER_EVOLVE_CONNECT && rand_uniform(0, 1) < 0.5) {
             l->weights[i] = 0;
@@ -326,12 +372,12 @@ layer_weight_json(const struct Layer *l, const bool return_weights)
     cJSON *json = cJSON_CreateObject();
     cJSON_AddNumberToObject(json, "n_weights", l->n_weights);
     if (return_weights) {
-        cJSON *weights = cJSON_CreateDoubleArray(l->weights, l->n_weights);
+        cJSON *weights = layer_json_array(l->weights, l->n_weights);
         cJSON_AddItemToObject(json, "weights", weights);
     }
     cJSON_AddNumberToObject(json, "n_biases", l->n_biases);
     if (return_weights) {
-        cJSON *biases = cJSON_CreateDoubleArray(l->biases, l->n_biases);
+        cJSON *biases = layer_json_array(l->biases, l->n_biases);
         cJSON_AddItemToObject(json, "biases", biases);
     }
     cJSON_AddNumberToObject(json, "n_active", l->n_active);
@@ -460,9 +506,6 @@ layer_defaults(struct Layer *l)
     l->o = NULL;
     l->c = NULL;
     l->h = NULL;
-    l->temp = NULL;
-    l->temp2 = NULL;
-    l->temp3 = NULL;
     l->dc = NULL;
     l->height = 0;
     l->width = 0;
@@ -475,6 +518,11 @@ layer_defaults(struct Layer *l)
     l->stride = 0;
     l->indexes = NULL;
     l->n_filters = 0;
+    l->slab = NULL;
+    l->slab_size = 0;
+    l->slab_keep = 0;
+    l->slab_shared = false;
+    l->shared = false;
 }
 
 /**
@@ -614,3 +662,458 @@ layer_guard_weights(const struct Layer *l)
         exit(EXIT_FAILURE);
     }
 }
+
+/**
+ * @brief Writes an array of layer values to a file in double precision.
+ * @details Layers are always saved in double precision so that a network
+ * saved by a single-precision build loads in a double-precision build and
+ * vice versa.
+ * @param [in] x The values to write.
+ * @param [in] n The number of values.
+ * @param [in] fp Pointer to the file to be written.
+ * @return The number of elements written.
+ */
+size_t
+layer_save_array(const neural_real *x, const int n, FILE *fp)
+{
+#ifdef NEURAL_FLOAT
+    size_t s = 0;
+    for (int i = 0; i < n; ++i) {
+        const double value = x[i];
+        s += fwrite(&value, sizeof(double), 1, fp);
+    }
+    return s;
+#else
+    return fwrite(x, sizeof(double), n, fp);
+#endif
+}
+
+/**
+ * @brief Reads an array of layer values saved by layer_save_array().
+ * @param [out] x The values read.
+ * @param [in] n The number of values.
+ * @param [in] fp Pointer to the file to be read.
+ * @return The number of elements read.
+ */
+size_t
+layer_load_array(neural_real *x, const int n, FILE *fp)
+{
+#ifdef NEURAL_FLOAT
+    size_t s = 0;
+    for (int i = 0; i < n; ++i) {
+        double value = 0;
+        s += fread(&value, sizeof(double), 1, fp);
+        x[i] = (neural_real) value;
+    }
+    return s;
+#else
+    return fread(x, sizeof(double), n, fp);
+#endif
+}
+
+/**
+ * @brief Returns a cJSON array of layer values.
+ * @param [in] x The values.
+ * @param [in] n The number of values.
+ * @return The cJSON array.
+ */
+cJSON *
+layer_json_array(const neural_real *x, const int n)
+{
+#ifdef NEURAL_FLOAT
+    double *tmp = malloc(sizeof(double) * n);
+    for (int i = 0; i < n; ++i) {
+        tmp[i] = x[i];
+    }
+    cJSON *json = cJSON_CreateDoubleArray(tmp, n);
+    free(tmp);
+    return json;
+#else
+    return cJSON_CreateDoubleArray(x, n);
+#endif
+}
+
+/**
+ * @brief Returns the scratch pool of the calling thread.
+ * @details Layers borrow the pool for buffers that are only live during one
+ * call to layer_forward() or layer_backward(), so that a population of layers
+ * holds only its parameters and the state kept between calls. The pool only
+ * grows and its contents are undefined. It is shared by every layer run on the
+ * thread, so a layer must not rely on it across running another layer that
+ * uses it. See thread_pool().
+ * @param [in] n The number of elements required.
+ * @return The scratch pool.
+ */
+neural_real *
+layer_scratch(const size_t n)
+{
+    return thread_pool(THREAD_POOL_LAYER, sizeof(neural_real) * n);
+}
+
+/**
+ * @brief Reads a pointer field of a layer.
+ * @param [in] l The layer.
+ * @param [in] offset Offset of the field within the layer structure.
+ * @return The value of the field.
+ */
+static void *
+layer_field(const struct Layer *l, const size_t offset)
+{
+    void *p = NULL;
+    memcpy(&p, (const char *) l + offset, sizeof(void *));
+    return p;
+}
+
+/**
+ * @brief Writes a pointer field of a layer.
+ * @param [in] l The layer.
+ * @param [in] offset Offset of the field within the layer structure.
+ * @param [in] p The new value of the field.
+ */
+static void
+layer_set_field(struct Layer *l, const size_t offset, void *p)
+{
+    memcpy((char *) l + offset, &p, sizeof(void *));
+}
+
+/**
+ * @brief Returns whether an address lies within a block of memory.
+ * @param [in] p The address.
+ * @param [in] block The start of the block.
+ * @param [in] size The size of the block in bytes.
+ * @return Whether the address is within the block.
+ */
+static bool
+in_block(const void *p, const void *block, const size_t size)
+{
+    const uintptr_t a = (uintptr_t) p;
+    const uintptr_t start = (uintptr_t) block;
+    return block != NULL && a >= start && a < start + size;
+}
+
+/**
+ * @brief Allocates the buffers of a layer as one zeroed slab.
+ * @details Buffers are laid out in the order given, each starting a whole
+ * number of cache lines from the start of the slab. The first n_keep buffers
+ * hold the parameters that copies of the layer inherit; the remainder are
+ * cleared when the layer is copied.
+ * @param [in] l The layer to be allocated memory.
+ * @param [in] buffers The buffers to allocate.
+ * @param [in] n The number of buffers.
+ * @param [in] n_keep The number of leading buffers preserved by copies.
+ */
+void
+layer_slab_alloc(struct Layer *l, const struct LayerBuffer *buffers,
+                 const int n, const int n_keep)
+{
+    size_t size = 0;
+    for (int i = 0; i < n; ++i) {
+        size += layer_align(buffers[i].size);
+    }
+    char *slab = calloc(size, 1);
+    size_t offset = 0;
+    l->slab_keep = 0;
+    for (int i = 0; i < n; ++i) {
+        void *p = slab + offset;
+        memcpy(buffers[i].field, &p, sizeof(void *));
+        offset += layer_align(buffers[i].size);
+        if (i < n_keep) {
+            l->slab_keep = offset;
+        }
+    }
+    l->slab = slab;
+    l->slab_size = size;
+    l->slab_shared = false;
+}
+
+/**
+ * @brief Resizes some of the buffers of a layer slab.
+ * @details The slab is reallocated with the listed buffers at their new sizes
+ * and the others unchanged. Contents are preserved up to the smaller of the
+ * old and new sizes, as with realloc(), and any growth is zeroed.
+ * @param [in] l The layer whose buffers are to be resized.
+ * @param [in] buffers The buffers to resize.
+ * @param [in] n The number of buffers.
+ */
+void
+layer_slab_resize(struct Layer *l, const struct LayerBuffer *buffers,
+                  const int n)
+{
+    size_t field[N_LAYER_BUFFERS];
+    size_t old_offset[N_LAYER_BUFFERS];
+    size_t old_size[N_LAYER_BUFFERS];
+    size_t new_size[N_LAYER_BUFFERS];
+    const char *old = l->slab;
+    int n_own = 0;
+    // find the buffers held in the slab, in order of position
+    for (size_t i = 0; i < N_LAYER_BUFFERS; ++i) {
+        const char *p = layer_field(l, LAYER_BUFFERS[i]);
+        if (in_block(p, old, l->slab_size)) {
+            const size_t offset = (size_t) (p - old);
+            int j = n_own;
+            while (j > 0 && old_offset[j - 1] > offset) {
+                field[j] = field[j - 1];
+                old_offset[j] = old_offset[j - 1];
+                --j;
+            }
+            field[j] = LAYER_BUFFERS[i];
+            old_offset[j] = offset;
+            ++n_own;
+        }
+    }
+    for (int i = 0; i < n_own; ++i) {
+        const size_t end = (i + 1 < n_own) ? old_offset[i + 1] : l->slab_size;
+        old_size[i] = end - old_offset[i];
+        new_size[i] = old_size[i];
+    }
+    // apply the new sizes, appending buffers not yet in the slab
+    for (int i = 0; i < n; ++i) {
+        const size_t offset =
+            (size_t) ((const char *) buffers[i].field - (const char *) l);
+        int j = 0;
+        while (j < n_own && field[j] != offset) {
+            ++j;
+        }
+        if (j == n_own) {
+            if (n_own == (int) N_LAYER_BUFFERS) {
+                printf("layer_slab_resize(): invalid buffer\n");
+                exit(EXIT_FAILURE);
+            }
+            field[j] = offset;
+            old_offset[j] = 0;
+            old_size[j] = 0;
+            ++n_own;
+        }
+        new_size[j] = layer_align(buffers[i].size);
+    }
+    // move the buffers to a new slab
+    size_t size = 0;
+    for (int i = 0; i < n_own; ++i) {
+        size += new_size[i];
+    }
+    char *slab = calloc(size, 1);
+    size_t offset = 0;
+    size_t keep = 0;
+    for (int i = 0; i < n_own; ++i) {
+        const size_t bytes = new_size[i] < old_size[i] ? new_size[i]
+                                                       : old_size[i];
+        if (bytes > 0) {
+            memcpy(slab + offset, old + old_offset[i], bytes);
+        }
+        layer_set_field(l, field[i], slab + offset);
+        offset += new_size[i];
+        if (old_size[i] > 0 && old_offset[i] < l->slab_keep) {
+            keep = offset;
+        }
+    }
+    layer_slab_free(l);
+    l->slab = slab;
+    l->slab_size = size;
+    l->slab_keep = keep;
+    l->slab_shared = false;
+}
+
+/**
+ * @brief Zeroes the buffers of a layer slab that copies do not inherit.
+ * @param [in] l The layer whose slab is to be cleared.
+ */
+void
+layer_slab_clear(const struct Layer *l)
+{
+    if (l->slab != NULL) {
+        memset((char *) l->slab + l->slab_keep, 0,
+               l->slab_size - l->slab_keep);
+    }
+}
+
+/**
+ * @brief Frees the slab of a layer unless it is held in a network arena.
+ * @param [in] l The layer whose slab is to be freed.
+ */
+void
+layer_slab_free(const struct Layer *l)
+{
+    if (!l->slab_shared) {
+        free(l->slab);
+    }
+}
+
+/**
+ * @brief Frees a layer and, unless it is held in a network arena, the layer
+ * structure itself.
+ * @param [in] l The layer to be deleted.
+ */
+void
+layer_delete(struct Layer *l)
+{
+    layer_free(l);
+    if (!l->shared) {
+        free(l);
+    }
+}
+
+/**
+ * @brief Returns the number of bytes a layer occupies in a network arena.
+ * @param [in] l The layer.
+ * @return The size of the layer structure, its slab and its sub-layers.
+ */
+size_t
+layer_arena_size(const struct Layer *l)
+{
+    size_t size = layer_align(sizeof(struct Layer)) + l->slab_size;
+    for (size_t i = 0; i < N_LAYER_CHILDREN; ++i) {
+        const struct Layer *child = layer_field(l, LAYER_CHILDREN[i]);
+        if (child != NULL) {
+            size += layer_arena_size(child);
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Copies a layer, its slab and its sub-layers into an arena.
+ * @param [in] src The layer to copy.
+ * @param [in,out] arena The next free address in the arena.
+ * @param [in] keep_state Whether to copy the buffers that copies clear.
+ * @param [out] moves The blocks copied.
+ * @param [in,out] n_moves The number of blocks copied.
+ * @return The copied layer, still pointing to the blocks of the source.
+ */
+static struct Layer *
+layer_arena_place(const struct Layer *src, char **arena, const bool keep_state,
+                  struct LayerMove *moves, int *n_moves)
+{
+    if (*n_moves + 2 > LAYER_MOVES_MAX) {
+        printf("layer_arena_copy(): too many sub-layers\n");
+        exit(EXIT_FAILURE);
+    }
+    struct Layer *l = (struct Layer *) *arena;
+    memcpy(l, src, sizeof(struct Layer));
+    moves[*n_moves].from = (uintptr_t) src;
+    moves[*n_moves].size = sizeof(struct Layer);
+    moves[*n_moves].to = *arena;
+    ++(*n_moves);
+    *arena += layer_align(sizeof(struct Layer));
+    if (src->slab != NULL) {
+        const size_t bytes = keep_state ? src->slab_size : src->slab_keep;
+        memcpy(*arena, src->slab, bytes);
+        memset(*arena + bytes, 0, src->slab_size - bytes);
+        moves[*n_moves].from = (uintptr_t) src->slab;
+        moves[*n_moves].size = src->slab_size;
+        moves[*n_moves].to = *arena;
+        ++(*n_moves);
+        *arena += src->slab_size;
+    }
+    l->shared = true;
+    l->slab_shared = true;
+    for (size_t i = 0; i < N_LAYER_CHILDREN; ++i) {
+        const struct Layer *child = layer_field(src, LAYER_CHILDREN[i]);
+        if (child != NULL) {
+            layer_arena_place(child, arena, keep_state, moves, n_moves);
+        }
+    }
+    return l;
+}
+
+/**
+ * @brief Redirects the pointers of a layer and its sub-layers to moved blocks.
+ * @param [in] l The layer whose pointers are to be updated.
+ * @param [in] moves The blocks moved.
+ * @param [in] n_moves The number of blocks moved.
+ */
+static void
+layer_arena_relocate(struct Layer *l, const struct LayerMove *moves,
+                     const int n_moves)
+{
+    for (size_t i = 0; i < N_LAYER_BUFFERS + N_LAYER_CHILDREN + 1; ++i) {
+        size_t offset = offsetof(struct Layer, slab);
+        if (i < N_LAYER_BUFFERS) {
+            offset = LAYER_BUFFERS[i];
+        } else if (i < N_LAYER_BUFFERS + N_LAYER_CHILDREN) {
+            offset = LAYER_CHILDREN[i - N_LAYER_BUFFERS];
+        }
+        const uintptr_t p = (uintptr_t) layer_field(l, offset);
+        for (int j = 0; j < n_moves; ++j) {
+            if (p >= moves[j].from && p < moves[j].from + moves[j].size) {
+                layer_set_field(l, offset, moves[j].to + (p - moves[j].from));
+                break;
+            }
+        }
+    }
+    for (size_t i = 0; i < N_LAYER_CHILDREN; ++i) {
+        struct Layer *child = layer_field(l, LAYER_CHILDREN[i]);
+        if (child != NULL) {
+            layer_arena_relocate(child, moves, n_moves);
+        }
+    }
+}
+
+/**
+ * @brief Copies a layer into a network arena.
+ * @details The layer structure is followed by its slab and then its
+ * sub-layers, so that the whole layer occupies layer_arena_size() contiguous
+ * bytes. Copies clear the buffers that layer_copy() would not inherit unless
+ * the state is kept, as when a network is repacked.
+ * @param [in] src The layer to copy.
+ * @param [in,out] arena The next free address in the arena.
+ * @param [in] keep_state Whether to also copy neuron states and gradients.
+ * @return The copied layer.
+ */
+struct Layer *
+layer_arena_copy(const struct Layer *src, char **arena, const bool keep_state)
+{
+    struct LayerMove moves[LAYER_MOVES_MAX];
+    int n_moves = 0;
+    struct Layer *l =
+        layer_arena_place(src, arena, keep_state, moves, &n_moves);
+    layer_arena_relocate(l, moves, n_moves);
+    return l;
+}
+
+/**
+ * @brief Prepares a layer within a byte-for-byte copy of a network arena.
+ * @details Pointers into the original arena are redirected to the copy and
+ * the buffers that layer_copy() would not inherit are cleared.
+ * @param [in] l The layer within the copied arena.
+ * @param [in] from The original arena.
+ * @param [in] size The size of the arena in bytes.
+ * @param [in] to The copied arena.
+ */
+void
+layer_arena_rebase(struct Layer *l, const void *from, const size_t size,
+                   void *to)
+{
+    const struct LayerMove move = { (uintptr_t) from, size, to };
+    layer_arena_relocate(l, &move, 1);
+    layer_slab_clear(l);
+    for (size_t i = 0; i < N_LAYER_CHILDREN; ++i) {
+        const struct Layer *child = layer_field(l, LAYER_CHILDREN[i]);
+        if (child != NULL) {
+            layer_slab_clear(child);
+        }
+    }
+}
+
+/**
+ * @brief Returns whether a layer, its slab and its sub-layers all lie within
+ * a network arena.
+ * @param [in] l The layer.
+ * @param [in] arena The network arena.
+ * @param [in] size The size of the arena in bytes.
+ * @return Whether the arena holds the whole layer.
+ */
+bool
+layer_arena_holds(const struct Layer *l, const void *arena, const size_t size)
+{
+    if (!in_block(l, arena, size) ||
+        (l->slab != NULL && !in_block(l->slab, arena, size))) {
+        return false;
+    }
+    for (size_t i = 0; i < N_LAYER_CHILDREN; ++i) {
+        const struct Layer *child = layer_field(l, LAYER_CHILDREN[i]);
+        if (child != NULL && !layer_arena_holds(child, arena, size)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -17,7 +17,7 @@
  * @file neural_layer.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2016--2024.
+ * @date 2016--2026.
  * @brief Interface for neural network layers.
  */
 
@@ -63,6 +63,8 @@
 #define N_INPUTS_MAX (2000000) //!< Maximum number of inputs per layer
 #define N_OUTPUTS_MAX (2000000) //!< Maximum number of outputs per layer
 
+#define LAYER_ALIGN (64) //!< Slab and arena blocks span whole cache lines
+
 #define WEIGHT_SD_INIT (0.1) //!< Std dev of Gaussian for weight initialisation
 #define WEIGHT_SD (0.1) //!< Std dev of Gaussian for weight resizing
 #define WEIGHT_SD_RAND (1.0) //!< Std dev of Gaussian for weight randomising
@@ -72,15 +74,15 @@
  */
 struct Layer {
     int type; //!< Layer type: CONNECTED, DROPOUT, etc.
-    double *state; //!< Current neuron states (before activation function)
-    double *output; //!< Current neuron outputs (after activation function)
+    neural_real *state; //!< Current neuron states (before activation function)
+    neural_real *output; //!< Current neuron outputs (after activation function)
     uint32_t options; //!< Bitwise layer options permitting evolution, SGD, etc.
-    double *weights; //!< Weights for calculating neuron states
+    neural_real *weights; //!< Weights for calculating neuron states
     bool *weight_active; //!< Whether each connection is present in the layer
-    double *biases; //!< Biases for calculating neuron states
-    double *bias_updates; //!< Updates to biases
-    double *weight_updates; //!< Updates to weights
-    double *delta; //!< Delta for updating weights
+    neural_real *biases; //!< Biases for calculating neuron states
+    neural_real *bias_updates; //!< Updates to biases
+    neural_real *weight_updates; //!< Updates to weights
+    neural_real *delta; //!< Delta for updating weights
     double *mu; //!< Mutation rates
     double eta; //!< Gradient descent rate
     double eta_max; //!< Maximum gradient descent rate
@@ -98,7 +100,7 @@ struct Layer {
     double scale; //!< Usage depends on layer implementation
     double probability; //!< Usage depends on layer implementation
     struct LayerVtbl const *layer_vptr; //!< Functions acting on layers
-    double *prev_state; //!< Previous state for recursive layers
+    neural_real *prev_state; //!< Previous state for recursive layers
     struct Layer *input_layer; //!< Recursive layer input
     struct Layer *self_layer; //!< Recursive layer self
     struct Layer *output_layer; //!< Recursive layer output
@@ -111,18 +113,15 @@ struct Layer {
     struct Layer *wi; //!< LSTM
     struct Layer *wg; //!< LSTM
     struct Layer *wo; //!< LSTM
-    double *cell; //!< LSTM
-    double *prev_cell; //!< LSTM
-    double *f; //!< LSTM
-    double *i; //!< LSTM
-    double *g; //!< LSTM
-    double *o; //!< LSTM
-    double *c; //!< LSTM
-    double *h; //!< LSTM
-    double *temp; //!< LSTM
-    double *temp2; //!< LSTM
-    double *temp3; //!< LSTM
-    double *dc; //!< LSTM
+    neural_real *cell; //!< LSTM
+    neural_real *prev_cell; //!< LSTM
+    neural_real *f; //!< LSTM
+    neural_real *i; //!< LSTM
+    neural_real *g; //!< LSTM
+    neural_real *o; //!< LSTM
+    neural_real *c; //!< LSTM
+    neural_real *h; //!< LSTM
+    neural_real *dc; //!< LSTM
     int height; //!< Pool, Conv, and Upsample
     int width; //!< Pool, Conv, and Upsample
     int channels; //!< Pool, Conv, and Upsample
@@ -134,8 +133,35 @@ struct Layer {
     int stride; //!< Pool, Conv, and Upsample
     int *indexes; //!< Pool
     int n_filters; //!< Conv
+    void *slab; //!< Single allocation holding the layer buffers
+    size_t slab_size; //!< Size of the slab in bytes
+    size_t slab_keep; //!< Leading slab bytes preserved when copying the layer
+    bool slab_shared; //!< Whether the slab is held in a network arena
+    bool shared; //!< Whether the layer structure is held in a network arena
+};
+
+/**
+ * @brief A buffer to be laid out in a layer slab.
+ */
+struct LayerBuffer {
+    void *field; //!< Address of the layer pointer to the buffer
+    size_t size; //!< Size of the buffer in bytes
 };
 
+/**
+ * @brief Returns the number of bytes a block occupies in a slab or arena.
+ * @param [in] size The size of the block in bytes.
+ * @return The size rounded up to a non-zero multiple of LAYER_ALIGN.
+ */
+static inline size_t
+layer_align(const size_t size)
+{
+    if (size < 1) {
+        return LAYER_ALIGN;
+    }
+    return (size + LAYER_ALIGN - 1) / LAYER_ALIGN * LAYER_ALIGN;
+}
+
 /**
  * @brief Neural network layer interface data structure.
  * @details Neural network layer implementations must implement these functions.
@@ -150,10 +176,10 @@ struct LayerVtbl {
     void (*layer_impl_print)(const struct Layer *l, const bool print_weights);
     void (*layer_impl_update)(const struct Layer *l);
     void (*layer_impl_backward)(const struct Layer *l, const struct Net *net,
-                                const double *input, double *delta);
+                                const neural_real *input, neural_real *delta);
     void (*layer_impl_forward)(const struct Layer *l, const struct Net *net,
-                               const double *input);
-    double *(*layer_impl_output)(const struct Layer *l);
+                               const neural_real *input);
+    neural_real *(*layer_impl_output)(const struct Layer *l);
     size_t (*layer_impl_save)(const struct Layer *l, FILE *fp);
     size_t (*layer_impl_load)(struct Layer *l, FILE *fp);
     char *(*layer_impl_json_export)(const struct Layer *l,
@@ -165,7 +191,7 @@ struct LayerVtbl {
  * @param [in] l The layer whose outputs are to be returned.
  * @return The layer outputs.
  */
-static inline double *
+static inline neural_real *
 layer_output(const struct Layer *l)
 {
     return (*l->layer_vptr->layer_impl_output)(l);
@@ -178,7 +204,8 @@ layer_output(const struct Layer *l)
  * @param [in] input Input to the layer.
  */
 static inline void
-layer_forward(const struct Layer *l, const struct Net *net, const double *input)
+layer_forward(const struct Layer *l, const struct Net *net,
+              const neural_real *input)
 {
     (*l->layer_vptr->layer_impl_forward)(l, net, input);
 }
@@ -192,7 +219,7 @@ layer_forward(const struct Layer *l, const struct Net *net, const double *input)
  */
 static inline void
 layer_backward(const struct Layer *l, const struct Net *net,
-               const double *input, double *delta)
+               const neural_real *input, neural_real *delta)
 {
     (*l->layer_vptr->layer_impl_backward)(l, net, input, delta);
 }
@@ -347,6 +374,48 @@ layer_guard_outputs(const struct Layer *l);
 void
 layer_guard_weights(const struct Layer *l);
 
+size_t
+layer_save_array(const neural_real *x, const int n, FILE *fp);
+
+size_t
+layer_load_array(neural_real *x, const int n, FILE *fp);
+
+cJSON *
+layer_json_array(const neural_real *x, const int n);
+
+neural_real *
+layer_scratch(const size_t n);
+
+void
+layer_slab_alloc(struct Layer *l, const struct LayerBuffer *buffers,
+                 const int n, const int n_keep);
+
+void
+layer_slab_resize(struct Layer *l, const struct LayerBuffer *buffers,
+                  const int n);
+
+void
+layer_slab_clear(const struct Layer *l);
+
+void
+layer_slab_free(const struct Layer *l);
+
+void
+layer_delete(struct Layer *l);
+
+size_t
+layer_arena_size(const struct Layer *l);
+
+struct Layer *
+layer_arena_copy(const struct Layer *src, char **arena, const bool keep_state);
+
+void
+layer_arena_rebase(struct Layer *l, const void *from, const size_t size,
+                   void *to);
+
+bool
+layer_arena_holds(const struct Layer *l, const void *arena, const size_t size);
+
 /**
  * @brief Creates and initialises a new layer.
  * @param [in] args Layer parameters used to initialise the layer.
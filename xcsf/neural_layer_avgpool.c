@@ -17,7 +17,7 @@
  * @file neural_layer_avgpool.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2016--2021.
+ * @date 2016--2026.
  * @brief An implementation of an average pooling layer.
  */
 
@@ -33,8 +33,11 @@ static void
 malloc_layer_arrays(struct Layer *l)
 {
     layer_guard_outputs(l);
-    l->output = calloc(l->n_outputs, sizeof(double));
-    l->delta = calloc(l->n_outputs, sizeof(double));
+    const struct LayerBuffer buffers[] = {
+        { &l->output, sizeof(neural_real) * l->n_outputs },
+        { &l->delta, sizeof(neural_real) * l->n_outputs }
+    };
+    layer_slab_alloc(l, buffers, 2, 0);
 }
 
 /**
@@ -45,8 +48,11 @@ static void
 realloc_layer_arrays(struct Layer *l)
 {
     layer_guard_outputs(l);
-    l->output = realloc(l->output, sizeof(double) * l->n_outputs);
-    l->delta = realloc(l->delta, sizeof(double) * l->n_outputs);
+    const struct LayerBuffer buffers[] = {
+        { &l->output, sizeof(neural_real) * l->n_outputs },
+        { &l->delta, sizeof(neural_real) * l->n_outputs }
+    };
+    layer_slab_resize(l, buffers, 2);
 }
 
 /**
@@ -56,8 +62,7 @@ realloc_layer_arrays(struct Layer *l)
 void
 neural_layer_avgpool_free(const struct Layer *l)
 {
-    free(l->output);
-    free(l->delta);
+    layer_slab_free(l);
 }
 
 /**
@@ -127,7 +132,7 @@ neural_layer_avgpool_rand(struct Layer *l)
  */
 void
 neural_layer_avgpool_forward(const struct Layer *l, const struct Net *net,
-                             const double *input)
+                             const neural_real *input)
 {
     (void) net;
     const int n = l->height * l->width;
@@ -149,7 +154,7 @@ neural_layer_avgpool_forward(const struct Layer *l, const struct Net *net,
  */
 void
 neural_layer_avgpool_backward(const struct Layer *l, const struct Net *net,
-                              const double *input, double *delta)
+                              const neural_real *input, neural_real *delta)
 {
     (void) net;
     (void) input;
@@ -211,7 +216,7 @@ neural_layer_avgpool_resize(struct Layer *l, const struct Layer *prev)
  * @param [in] l The layer whose output to return.
  * @return The layer output.
  */
-double *
+neural_real *
 neural_layer_avgpool_output(const struct Layer *l)
 {
     return l->output;
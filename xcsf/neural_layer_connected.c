@@ -17,7 +17,7 @@
  * @file neural_layer_connected.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2016--2022.
+ * @date 2016--2026.
  * @brief An implementation of a fully-connected layer of perceptrons.
  */
 
@@ -28,6 +28,7 @@
 #include "utils.h"
 
 #define N_MU (6) //!< Number of mutation rates applied to a connected layer
+#define SPARSE_RATIO (64) //!< Weights per active weight to skip inactive ones
 
 /**
  * @brief Self-adaptation method for mutating a connected layer.
@@ -50,15 +51,18 @@ malloc_layer_arrays(struct Layer *l)
 {
     layer_guard_outputs(l);
     layer_guard_weights(l);
-    l->state = calloc(l->n_outputs, sizeof(double));
-    l->output = calloc(l->n_outputs, sizeof(double));
-    l->biases = malloc(sizeof(double) * l->n_outputs);
-    l->bias_updates = calloc(l->n_outputs, sizeof(double));
-    l->delta = calloc(l->n_outputs, sizeof(double));
-    l->weight_updates = calloc(l->n_weights, sizeof(double));
-    l->weight_active = malloc(sizeof(bool) * l->n_weights);
-    l->weights = malloc(sizeof(double) * l->n_weights);
-    l->mu = malloc(sizeof(double) * N_MU);
+    const struct LayerBuffer buffers[] = {
+        { &l->weights, sizeof(neural_real) * l->n_weights },
+        { &l->weight_active, sizeof(bool) * l->n_weights },
+        { &l->biases, sizeof(neural_real) * l->n_outputs },
+        { &l->mu, sizeof(double) * N_MU },
+        { &l->state, sizeof(neural_real) * l->n_outputs },
+        { &l->output, sizeof(neural_real) * l->n_outputs },
+        { &l->bias_updates, sizeof(neural_real) * l->n_outputs },
+        { &l->delta, sizeof(neural_real) * l->n_outputs },
+        { &l->weight_updates, sizeof(neural_real) * l->n_weights }
+    };
+    layer_slab_alloc(l, buffers, 9, 4);
 }
 
 /**
@@ -91,7 +95,7 @@ neural_layer_connected_init(struct Layer *l, const struct ArgsLayer *args)
         l->weights[i] = rand_normal(0, WEIGHT_SD_INIT);
         l->weight_active[i] = true;
     }
-    memset(l->biases, 0, sizeof(double) * l->n_biases);
+    memset(l->biases, 0, sizeof(neural_real) * l->n_biases);
     sam_init(l->mu, N_MU, MU_TYPE);
 }
 
@@ -102,15 +106,7 @@ neural_layer_connected_init(struct Layer *l, const struct ArgsLayer *args)
 void
 neural_layer_connected_free(const struct Layer *l)
 {
-    free(l->state);
-    free(l->output);
-    free(l->biases);
-    free(l->bias_updates);
-    free(l->delta);
-    free(l->weight_updates);
-    free(l->weight_active);
-    free(l->weights);
-    free(l->mu);
+    layer_slab_free(l);
 }
 
 /**
@@ -147,8 +143,8 @@ neural_layer_connected_copy(const struct Layer *src)
     l->max_neuron_grow = src->max_neuron_grow;
     l->n_active = src->n_active;
     malloc_layer_arrays(l);
-    memcpy(l->biases, src->biases, sizeof(double) * src->n_biases);
-    memcpy(l->weights, src->weights, sizeof(double) * src->n_weights);
+    memcpy(l->biases, src->biases, sizeof(neural_real) * src->n_biases);
+    memcpy(l->weights, src->weights, sizeof(neural_real) * src->n_weights);
     memcpy(l->weight_active, src->weight_active, sizeof(bool) * src->n_weights);
     memcpy(l->mu, src->mu, sizeof(double) * N_MU);
     return l;
@@ -164,6 +160,21 @@ neural_layer_connected_rand(struct Layer *l)
     layer_weight_rand(l);
 }
 
+/**
+ * @brief Returns whether so few connections are active that the inactive ones
+ * are worth skipping when propagating a connected layer.
+ * @details Inactive weights are zero, so both paths give the same result.
+ * Masks are mutated one connection at a time, so runs of inactive connections
+ * only become common once the layer is very sparse.
+ * @param [in] l The connected layer.
+ * @return Whether to use sparse matrix-vector products.
+ */
+static bool
+connected_sparse(const struct Layer *l)
+{
+    return l->n_active * SPARSE_RATIO < l->n_weights;
+}
+
 /**
  * @brief Forward propagates a connected layer.
  * @param [in] l Layer to forward propagate.
@@ -172,17 +183,19 @@ neural_layer_connected_rand(struct Layer *l)
  */
 void
 neural_layer_connected_forward(const struct Layer *l, const struct Net *net,
-                               const double *input)
+                               const neural_real *input)
 {
-    (void) net;
-    const int k = l->n_inputs;
-    const int n = l->n_outputs;
-    const double *a = input;
-    const double *b = l->weights;
-    double *c = l->state;
-    memcpy(l->state, l->biases, sizeof(double) * l->n_outputs);
-    blas_gemm(0, 1, 1, n, k, 1, a, k, b, k, 1, c, n);
-    neural_activate_array(l->state, l->output, l->n_outputs, l->function);
+    const int m = l->n_outputs;
+    const int n = l->n_inputs;
+    memcpy(l->state, l->biases, sizeof(neural_real) * l->n_outputs);
+    if (connected_sparse(l)) {
+        neural_gemv_sparse(0, m, n, 1, l->weights, n, l->weight_active, input,
+                           1, 1, l->state, 1);
+    } else {
+        neural_gemv(0, m, n, 1, l->weights, n, input, 1, 1, l->state, 1);
+    }
+    neural_activate_array(l->state, l->output, l->n_outputs, l->function,
+                          net->fast);
 }
 
 /**
@@ -194,26 +207,21 @@ neural_layer_connected_forward(const struct Layer *l, const struct Net *net,
  */
 void
 neural_layer_connected_backward(const struct Layer *l, const struct Net *net,
-                                const double *input, double *delta)
+                                const neural_real *input, neural_real *delta)
 {
-    (void) net;
-    neural_gradient_array(l->state, l->delta, l->n_outputs, l->function);
+    neural_gradient_array_cached(l->state, l->output, l->delta, l->n_outputs,
+                                 l->function, net->fast);
+    const int m = l->n_outputs;
+    const int n = l->n_inputs;
     if (l->options & LAYER_SGD_WEIGHTS) {
-        const int m = l->n_outputs;
-        const int n = l->n_inputs;
-        const double *a = l->delta;
-        const double *b = input;
-        double *c = l->weight_updates;
-        blas_axpy(l->n_outputs, 1, l->delta, 1, l->bias_updates, 1);
-        blas_gemm(1, 0, m, n, 1, 1, a, m, b, n, 1, c, n);
+        neural_axpy(l->n_outputs, 1, l->delta, 1, l->bias_updates, 1);
+        neural_ger(m, n, 1, l->delta, 1, input, 1, l->weight_updates, n);
     }
-    if (delta) {
-        const int k = l->n_outputs;
-        const int n = l->n_inputs;
-        const double *a = l->delta;
-        const double *b = l->weights;
-        double *c = delta;
-        blas_gemm(0, 0, 1, n, k, 1, a, k, b, n, 1, c, n);
+    if (delta && connected_sparse(l)) {
+        neural_gemv_sparse(1, m, n, 1, l->weights, n, l->weight_active,
+                           l->delta, 1, 1, delta, 1);
+    } else if (delta) {
+        neural_gemv(1, m, n, 1, l->weights, n, l->delta, 1, 1, delta, 1);
     }
 }
 
@@ -225,14 +233,14 @@ void
 neural_layer_connected_update(const struct Layer *l)
 {
     if (l->options & LAYER_SGD_WEIGHTS && l->eta > 0) {
-        blas_axpy(l->n_biases, l->eta, l->bias_updates, 1, l->biases, 1);
-        blas_scal(l->n_biases, l->momentum, l->bias_updates, 1);
+        neural_axpy(l->n_biases, l->eta, l->bias_updates, 1, l->biases, 1);
+        neural_scal(l->n_biases, l->momentum, l->bias_updates, 1);
         if (l->decay > 0) {
-            blas_axpy(l->n_weights, -(l->decay), l->weights, 1,
-                      l->weight_updates, 1);
+            neural_axpy(l->n_weights, -(l->decay), l->weights, 1,
+                        l->weight_updates, 1);
         }
-        blas_axpy(l->n_weights, l->eta, l->weight_updates, 1, l->weights, 1);
-        blas_scal(l->n_weights, l->momentum, l->weight_updates, 1);
+        neural_axpy(l->n_weights, l->eta, l->weight_updates, 1, l->weights, 1);
+        neural_scal(l->n_weights, l->momentum, l->weight_updates, 1);
         layer_weight_clamp(l);
     }
 }
@@ -251,8 +259,8 @@ neural_layer_connected_resize(struct Layer *l, const struct Layer *prev)
         layer_print(l, false);
         exit(EXIT_FAILURE);
     }
-    double *weights = malloc(sizeof(double) * n_weights);
-    double *weight_updates = malloc(sizeof(double) * n_weights);
+    neural_real *weights = malloc(sizeof(neural_real) * n_weights);
+    neural_real *weight_updates = malloc(sizeof(neural_real) * n_weights);
     bool *weight_active = malloc(sizeof(bool) * n_weights);
     for (int i = 0; i < l->n_outputs; ++i) {
         const int orig_offset = i * l->n_inputs;
@@ -269,12 +277,18 @@ neural_layer_connected_resize(struct Layer *l, const struct Layer *prev)
             }
         }
     }
-    free(l->weights);
-    free(l->weight_updates);
-    free(l->weight_active);
-    l->weights = weights;
-    l->weight_updates = weight_updates;
-    l->weight_active = weight_active;
+    const struct LayerBuffer buffers[] = {
+        { &l->weights, sizeof(neural_real) * n_weights },
+        { &l->weight_updates, sizeof(neural_real) * n_weights },
+        { &l->weight_active, sizeof(bool) * n_weights }
+    };
+    layer_slab_resize(l, buffers, 3);
+    memcpy(l->weights, weights, sizeof(neural_real) * n_weights);
+    memcpy(l->weight_updates, weight_updates, sizeof(neural_real) * n_weights);
+    memcpy(l->weight_active, weight_active, sizeof(bool) * n_weights);
+    free(weights);
+    free(weight_updates);
+    free(weight_active);
     l->n_weights = n_weights;
     l->n_inputs = prev->n_outputs;
     layer_calc_n_active(l);
@@ -324,7 +338,7 @@ neural_layer_connected_mutate(struct Layer *l)
  * @param [in] l The layer whose output to return.
  * @return The layer output.
  */
-double *
+neural_real *
 neural_layer_connected_output(const struct Layer *l)
 {
     return l->output;
@@ -396,11 +410,11 @@ neural_layer_connected_save(const struct Layer *l, FILE *fp)
     s += fwrite(&l->momentum, sizeof(double), 1, fp);
     s += fwrite(&l->decay, sizeof(double), 1, fp);
     s += fwrite(&l->n_active, sizeof(int), 1, fp);
-    s += fwrite(l->weights, sizeof(double), l->n_weights, fp);
+    s += layer_save_array(l->weights, l->n_weights, fp);
     s += fwrite(l->weight_active, sizeof(bool), l->n_weights, fp);
-    s += fwrite(l->biases, sizeof(double), l->n_biases, fp);
-    s += fwrite(l->bias_updates, sizeof(double), l->n_biases, fp);
-    s += fwrite(l->weight_updates, sizeof(double), l->n_weights, fp);
+    s += layer_save_array(l->biases, l->n_biases, fp);
+    s += layer_save_array(l->bias_updates, l->n_biases, fp);
+    s += layer_save_array(l->weight_updates, l->n_weights, fp);
     s += fwrite(l->mu, sizeof(double), N_MU, fp);
     return s;
 }
@@ -433,11 +447,11 @@ neural_layer_connected_load(struct Layer *l, FILE *fp)
     l->out_c = 1;
     l->out_h = 1;
     malloc_layer_arrays(l);
-    s += fread(l->weights, sizeof(double), l->n_weights, fp);
+    s += layer_load_array(l->weights, l->n_weights, fp);
     s += fread(l->weight_active, sizeof(bool), l->n_weights, fp);
-    s += fread(l->biases, sizeof(double), l->n_biases, fp);
-    s += fread(l->bias_updates, sizeof(double), l->n_biases, fp);
-    s += fread(l->weight_updates, sizeof(double), l->n_weights, fp);
+    s += layer_load_array(l->biases, l->n_biases, fp);
+    s += layer_load_array(l->bias_updates, l->n_biases, fp);
+    s += layer_load_array(l->weight_updates, l->n_weights, fp);
     s += fread(l->mu, sizeof(double), N_MU, fp);
     return s;
 }
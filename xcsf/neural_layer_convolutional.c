@@ -17,7 +17,7 @@
  * @file neural_layer_convolutional.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2016--2022.
+ * @date 2016--2026.
  * @brief An implementation of a 2D convolutional layer.
  */
 
@@ -29,6 +29,7 @@
 #include "utils.h"
 
 #define N_MU (6) //!< Number of mutation rates applied to a convolutional layer
+#define WINOGRAD_MIN_PAIRS (2304) //!< Least channel-filter pairs for Winograd
 
 /**
  * @brief Self-adaptation method for mutating a convolutional layer.
@@ -64,22 +65,77 @@ get_out_width(const struct Layer *l)
     return (l->width + 2 * l->pad - l->size) / l->stride + 1;
 }
 
+static int algorithm = CONV_ALGO_AUTO; //!< Algorithm used by all layers
+
 /**
- * @brief Returns the memory workspace size for a convolutional layer.
+ * @brief Returns the algorithm used to convolve a layer.
+ * @details Unless overridden with neural_layer_convolutional_set_algorithm(),
+ * filters at stride 1 are convolved directly, except that 3×3 filters use
+ * Winograd F(2×2, 3×3) when there are enough channels and filters to amortise
+ * the tile transforms and the output rows leave vector lanes of the direct
+ * kernel idle. Strided filters use im2col() and neural_gemm(). The thresholds
+ * were chosen with bench/conv_bench.
  * @param [in] l A convolutional layer.
- * @return The workspace size.
+ * @return The convolution algorithm.
  */
-static size_t
-get_workspace_size(const struct Layer *l)
+int
+neural_layer_convolutional_algorithm(const struct Layer *l)
 {
-    const size_t workspace_size = (size_t) l->out_h * l->out_w * l->size *
-        l->size * l->channels * sizeof(double);
-    if (workspace_size < 1) {
+    const bool winograd = l->size == 3 && l->stride == 1;
+    if (algorithm == CONV_ALGO_WINOGRAD && !winograd) {
+        return CONV_ALGO_DIRECT;
+    }
+    if (algorithm != CONV_ALGO_AUTO) {
+        return algorithm;
+    }
+    if (l->stride != 1 || l->size == 1) {
+        return CONV_ALGO_IM2COL;
+    }
+    if (winograd && l->out_w % CONV_VEC != 0 &&
+        l->channels * l->n_filters >= WINOGRAD_MIN_PAIRS) {
+        return CONV_ALGO_WINOGRAD;
+    }
+    return CONV_ALGO_DIRECT;
+}
+
+/**
+ * @brief Sets the algorithm used to convolve all layers.
+ * @details Layers whose shape does not suit Winograd convolution use direct
+ * convolution instead.
+ * @param [in] algo The convolution algorithm, or CONV_ALGO_AUTO to choose
+ * for each layer from its shape.
+ */
+void
+neural_layer_convolutional_set_algorithm(const int algo)
+{
+    algorithm = algo;
+}
+
+/**
+ * @brief Returns the workspace used to run a convolutional layer.
+ * @details The workspace is borrowed from the scratch pool of the thread.
+ * @param [in] l The convolutional layer to be run.
+ * @param [in] algo The algorithm to be run.
+ * @return The workspace.
+ */
+static neural_real *
+get_workspace(const struct Layer *l, const int algo)
+{
+    size_t size = (size_t) l->out_h * l->out_w * l->size * l->size *
+        l->channels;
+    if (algo == CONV_ALGO_WINOGRAD) {
+        size = conv_winograd_workspace(l->channels, l->height, l->width, l->pad,
+                                       l->n_filters);
+    } else if (algo == CONV_ALGO_DIRECT) {
+        size = conv_direct_workspace(l->channels, l->height, l->width, l->size,
+                                     l->stride, l->pad, l->n_filters);
+    }
+    if (size < 1) {
         printf("neural_layer_convolutional: invalid workspace size\n");
         layer_print(l, false);
         exit(EXIT_FAILURE);
     }
-    return workspace_size;
+    return layer_scratch(size);
 }
 
 /**
@@ -102,16 +158,18 @@ static void
 malloc_layer_arrays(struct Layer *l)
 {
     guard_malloc(l);
-    l->delta = calloc(l->n_outputs, sizeof(double));
-    l->state = calloc(l->n_outputs, sizeof(double));
-    l->output = calloc(l->n_outputs, sizeof(double));
-    l->weights = malloc(sizeof(double) * l->n_weights);
-    l->weight_updates = calloc(l->n_weights, sizeof(double));
-    l->weight_active = malloc(sizeof(bool) * l->n_weights);
-    l->biases = malloc(sizeof(double) * l->n_biases);
-    l->bias_updates = calloc(l->n_biases, sizeof(double));
-    l->temp = malloc(get_workspace_size(l));
-    l->mu = malloc(sizeof(double) * N_MU);
+    const struct LayerBuffer buffers[] = {
+        { &l->weights, sizeof(neural_real) * l->n_weights },
+        { &l->weight_active, sizeof(bool) * l->n_weights },
+        { &l->biases, sizeof(neural_real) * l->n_biases },
+        { &l->mu, sizeof(double) * N_MU },
+        { &l->delta, sizeof(neural_real) * l->n_outputs },
+        { &l->state, sizeof(neural_real) * l->n_outputs },
+        { &l->output, sizeof(neural_real) * l->n_outputs },
+        { &l->weight_updates, sizeof(neural_real) * l->n_weights },
+        { &l->bias_updates, sizeof(neural_real) * l->n_biases }
+    };
+    layer_slab_alloc(l, buffers, 9, 4);
 }
 
 /**
@@ -122,16 +180,17 @@ static void
 realloc_layer_arrays(struct Layer *l)
 {
     guard_malloc(l);
-    l->delta = realloc(l->delta, sizeof(double) * l->n_outputs);
-    l->state = realloc(l->state, sizeof(double) * l->n_outputs);
-    l->output = realloc(l->output, sizeof(double) * l->n_outputs);
-    l->weights = realloc(l->weights, sizeof(double) * l->n_weights);
-    l->weight_updates =
-        realloc(l->weight_updates, sizeof(double) * l->n_weights);
-    l->weight_active = realloc(l->weight_active, sizeof(bool) * l->n_weights);
-    l->biases = realloc(l->biases, sizeof(double) * l->n_biases);
-    l->bias_updates = realloc(l->bias_updates, sizeof(double) * l->n_biases);
-    l->temp = realloc(l->temp, get_workspace_size(l));
+    const struct LayerBuffer buffers[] = {
+        { &l->weights, sizeof(neural_real) * l->n_weights },
+        { &l->weight_active, sizeof(bool) * l->n_weights },
+        { &l->biases, sizeof(neural_real) * l->n_biases },
+        { &l->delta, sizeof(neural_real) * l->n_outputs },
+        { &l->state, sizeof(neural_real) * l->n_outputs },
+        { &l->output, sizeof(neural_real) * l->n_outputs },
+        { &l->weight_updates, sizeof(neural_real) * l->n_weights },
+        { &l->bias_updates, sizeof(neural_real) * l->n_biases }
+    };
+    layer_slab_resize(l, buffers, 8);
 }
 
 /**
@@ -141,16 +200,7 @@ realloc_layer_arrays(struct Layer *l)
 void
 neural_layer_convolutional_free(const struct Layer *l)
 {
-    free(l->delta);
-    free(l->state);
-    free(l->output);
-    free(l->weights);
-    free(l->weight_updates);
-    free(l->weight_active);
-    free(l->biases);
-    free(l->bias_updates);
-    free(l->temp);
-    free(l->mu);
+    layer_slab_free(l);
 }
 
 /**
@@ -190,7 +240,7 @@ neural_layer_convolutional_init(struct Layer *l, const struct ArgsLayer *args)
         l->weights[i] = rand_normal(0, WEIGHT_SD_INIT);
         l->weight_active[i] = true;
     }
-    memset(l->biases, 0, sizeof(double) * l->n_biases);
+    memset(l->biases, 0, sizeof(neural_real) * l->n_biases);
     sam_init(l->mu, N_MU, MU_TYPE);
 }
 
@@ -235,9 +285,9 @@ neural_layer_convolutional_copy(const struct Layer *src)
     l->eta_max = src->eta_max;
     l->eta_min = src->eta_min;
     malloc_layer_arrays(l);
-    memcpy(l->weights, src->weights, sizeof(double) * src->n_weights);
+    memcpy(l->weights, src->weights, sizeof(neural_real) * src->n_weights);
     memcpy(l->weight_active, src->weight_active, sizeof(bool) * src->n_weights);
-    memcpy(l->biases, src->biases, sizeof(double) * src->n_biases);
+    memcpy(l->biases, src->biases, sizeof(neural_real) * src->n_biases);
     memcpy(l->mu, src->mu, sizeof(double) * N_MU);
     return l;
 }
@@ -260,29 +310,36 @@ neural_layer_convolutional_rand(struct Layer *l)
  */
 void
 neural_layer_convolutional_forward(const struct Layer *l, const struct Net *net,
-                                   const double *input)
+                                   const neural_real *input)
 {
-    (void) net;
     const int m = l->n_filters;
     const int k = l->size * l->size * l->channels;
     const int n = l->out_w * l->out_h;
-    const double *a = l->weights;
-    double *b = l->temp;
-    double *c = l->state;
-    memset(l->state, 0, sizeof(double) * l->n_outputs);
+    const neural_real *a = l->weights;
+    neural_real *c = l->state;
+    memset(l->state, 0, sizeof(neural_real) * l->n_outputs);
+    const int algo = neural_layer_convolutional_algorithm(l);
     if (l->size == 1) {
-        blas_gemm(0, 0, m, n, k, 1, a, k, input, n, 1, c, n);
+        neural_gemm(0, 0, m, n, k, 1, a, k, input, n, 1, c, n);
+    } else if (algo == CONV_ALGO_WINOGRAD) {
+        conv_winograd_forward(input, l->channels, l->height, l->width, l->pad,
+                              a, m, get_workspace(l, algo), c);
+    } else if (algo == CONV_ALGO_DIRECT) {
+        conv_direct_forward(input, l->channels, l->height, l->width, l->size,
+                            l->stride, l->pad, a, m, get_workspace(l, algo), c);
     } else {
+        neural_real *b = get_workspace(l, algo);
         im2col(input, l->channels, l->height, l->width, l->size, l->stride,
                l->pad, b);
-        blas_gemm(0, 0, m, n, k, 1, a, k, b, n, 1, c, n);
+        neural_gemm(0, 0, m, n, k, 1, a, k, b, n, 1, c, n);
     }
     for (int i = 0; i < l->n_biases; ++i) {
         for (int j = 0; j < n; ++j) {
             l->state[i * n + j] += l->biases[i];
         }
     }
-    neural_activate_array(l->state, l->output, l->n_outputs, l->function);
+    neural_activate_array(l->state, l->output, l->n_outputs, l->function,
+                          net->fast);
 }
 
 /**
@@ -294,40 +351,50 @@ neural_layer_convolutional_forward(const struct Layer *l, const struct Net *net,
  */
 void
 neural_layer_convolutional_backward(const struct Layer *l,
-                                    const struct Net *net, const double *input,
-                                    double *delta)
+                                    const struct Net *net,
+                                    const neural_real *input,
+                                    neural_real *delta)
 {
-    (void) net;
     const int m = l->n_filters;
     const int n = l->size * l->size * l->channels;
     const int k = l->out_w * l->out_h;
+    const bool direct =
+        neural_layer_convolutional_algorithm(l) != CONV_ALGO_IM2COL;
     if (l->options & LAYER_SGD_WEIGHTS) {
-        neural_gradient_array(l->state, l->delta, l->n_outputs, l->function);
+        neural_gradient_array_cached(l->state, l->output, l->delta,
+                                     l->n_outputs, l->function, net->fast);
         for (int i = 0; i < l->n_biases; ++i) {
-            l->bias_updates[i] += blas_sum(l->delta + k * i, k);
+            l->bias_updates[i] += neural_sum(l->delta + k * i, k);
         }
-        const double *a = l->delta;
-        double *b = l->temp;
-        double *c = l->weight_updates;
+        const neural_real *a = l->delta;
+        neural_real *c = l->weight_updates;
         if (l->size == 1) {
-            blas_gemm(0, 1, m, n, k, 1, a, k, input, k, 1, c, n);
+            neural_gemm(0, 1, m, n, k, 1, a, k, input, k, 1, c, n);
+        } else if (direct) {
+            conv_direct_weights(input, l->channels, l->height, l->width,
+                                l->size, l->stride, l->pad, a, m,
+                                get_workspace(l, CONV_ALGO_DIRECT), c);
         } else {
+            neural_real *b = get_workspace(l, CONV_ALGO_IM2COL);
             im2col(input, l->channels, l->height, l->width, l->size, l->stride,
                    l->pad, b);
-            blas_gemm(0, 1, m, n, k, 1, a, k, b, k, 1, c, n);
+            neural_gemm(0, 1, m, n, k, 1, a, k, b, k, 1, c, n);
         }
     }
     if (delta) {
-        const double *a = l->weights;
-        const double *b = l->delta;
-        double *c = l->temp;
+        const neural_real *a = l->weights;
+        const neural_real *b = l->delta;
         if (l->size == 1) {
-            c = delta;
-        }
-        blas_gemm(1, 0, n, k, m, 1, a, n, b, k, 0, c, k);
-        if (l->size != 1) {
-            col2im(l->temp, l->channels, l->height, l->width, l->size,
-                   l->stride, l->pad, delta);
+            neural_gemm(1, 0, n, k, m, 1, a, n, b, k, 0, delta, k);
+        } else if (direct) {
+            conv_direct_delta(b, l->channels, l->height, l->width, l->size,
+                              l->stride, l->pad, a, m,
+                              get_workspace(l, CONV_ALGO_DIRECT), delta);
+        } else {
+            neural_real *c = get_workspace(l, CONV_ALGO_IM2COL);
+            neural_gemm(1, 0, n, k, m, 1, a, n, b, k, 0, c, k);
+            col2im(c, l->channels, l->height, l->width, l->size, l->stride,
+                   l->pad, delta);
         }
     }
 }
@@ -340,14 +407,14 @@ void
 neural_layer_convolutional_update(const struct Layer *l)
 {
     if (l->options & LAYER_SGD_WEIGHTS && l->eta > 0) {
-        blas_axpy(l->n_biases, l->eta, l->bias_updates, 1, l->biases, 1);
-        blas_scal(l->n_biases, l->momentum, l->bias_updates, 1);
+        neural_axpy(l->n_biases, l->eta, l->bias_updates, 1, l->biases, 1);
+        neural_scal(l->n_biases, l->momentum, l->bias_updates, 1);
         if (l->decay > 0) {
-            blas_axpy(l->n_weights, -(l->decay), l->weights, 1,
-                      l->weight_updates, 1);
+            neural_axpy(l->n_weights, -(l->decay), l->weights, 1,
+                        l->weight_updates, 1);
         }
-        blas_axpy(l->n_weights, l->eta, l->weight_updates, 1, l->weights, 1);
-        blas_scal(l->n_weights, l->momentum, l->weight_updates, 1);
+        neural_axpy(l->n_weights, l->eta, l->weight_updates, 1, l->weights, 1);
+        neural_scal(l->n_weights, l->momentum, l->weight_updates, 1);
         layer_weight_clamp(l);
     }
 }
@@ -483,7 +550,7 @@ neural_layer_convolutional_mutate(struct Layer *l)
  * @param [in] l The layer whose output to return.
  * @return The layer output.
  */
-double *
+neural_real *
 neural_layer_convolutional_output(const struct Layer *l)
 {
     return l->output;
@@ -570,11 +637,11 @@ neural_layer_convolutional_save(const struct Layer *l, FILE *fp)
     s += fwrite(&l->momentum, sizeof(double), 1, fp);
     s += fwrite(&l->decay, sizeof(double), 1, fp);
     s += fwrite(&l->max_neuron_grow, sizeof(int), 1, fp);
-    s += fwrite(l->weights, sizeof(double), l->n_weights, fp);
-    s += fwrite(l->weight_updates, sizeof(double), l->n_weights, fp);
+    s += layer_save_array(l->weights, l->n_weights, fp);
+    s += layer_save_array(l->weight_updates, l->n_weights, fp);
     s += fwrite(l->weight_active, sizeof(bool), l->n_weights, fp);
-    s += fwrite(l->biases, sizeof(double), l->n_biases, fp);
-    s += fwrite(l->bias_updates, sizeof(double), l->n_filters, fp);
+    s += layer_save_array(l->biases, l->n_biases, fp);
+    s += layer_save_array(l->bias_updates, l->n_filters, fp);
     s += fwrite(l->mu, sizeof(double), N_MU, fp);
     return s;
 }
@@ -614,11 +681,11 @@ neural_layer_convolutional_load(struct Layer *l, FILE *fp)
     s += fread(&l->decay, sizeof(double), 1, fp);
     s += fread(&l->max_neuron_grow, sizeof(int), 1, fp);
     malloc_layer_arrays(l);
-    s += fread(l->weights, sizeof(double), l->n_weights, fp);
-    s += fread(l->weight_updates, sizeof(double), l->n_weights, fp);
+    s += layer_load_array(l->weights, l->n_weights, fp);
+    s += layer_load_array(l->weight_updates, l->n_weights, fp);
     s += fread(l->weight_active, sizeof(bool), l->n_weights, fp);
-    s += fread(l->biases, sizeof(double), l->n_biases, fp);
-    s += fread(l->bias_updates, sizeof(double), l->n_biases, fp);
+    s += layer_load_array(l->biases, l->n_biases, fp);
+    s += layer_load_array(l->bias_updates, l->n_biases, fp);
     s += fread(l->mu, sizeof(double), N_MU, fp);
     return s;
 }
@@ -17,7 +17,7 @@
  * @file neural_layer_convolutional.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2016--2021.
+ * @date 2016--2026.
  * @brief An implementation of a 2D convolutional layer.
  */
 
@@ -25,6 +25,17 @@
 
 #include "neural_layer.h"
 
+#define CONV_ALGO_AUTO (0) //!< Choose the convolution algorithm by layer shape
+#define CONV_ALGO_IM2COL (1) //!< Convolve with im2col() and a matrix product
+#define CONV_ALGO_DIRECT (2) //!< Convolve directly over the image
+#define CONV_ALGO_WINOGRAD (3) //!< Convolve 3×3 filters with Winograd F(2, 3)
+
+int
+neural_layer_convolutional_algorithm(const struct Layer *l);
+
+void
+neural_layer_convolutional_set_algorithm(const int algo);
+
 void
 neural_layer_convolutional_init(struct Layer *l, const struct ArgsLayer *args);
 
@@ -36,12 +47,13 @@ neural_layer_convolutional_rand(struct Layer *l);
 
 void
 neural_layer_convolutional_forward(const struct Layer *l, const struct Net *net,
-                                   const double *input);
+                                   const neural_real *input);
 
 void
 neural_layer_convolutional_backward(const struct Layer *l,
-                                    const struct Net *net, const double *input,
-                                    double *delta);
+                                    const struct Net *net,
+                                    const neural_real *input,
+                                    neural_real *delta);
 
 void
 neural_layer_convolutional_update(const struct Layer *l);
@@ -56,7 +68,7 @@ neural_layer_convolutional_mutate(struct Layer *l);
 void
 neural_layer_convolutional_free(const struct Layer *l);
 
-double *
+neural_real *
 neural_layer_convolutional_output(const struct Layer *l);
 
 size_t
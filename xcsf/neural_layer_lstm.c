@@ -17,7 +17,7 @@
  * @file neural_layer_lstm.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2016--2024.
+ * @date 2016--2026.
  * @brief An implementation of a long short-term memory layer.
  * @details Stateful, and with a step of 1.
  * Typically the output activation is TANH and recurrent activation LOGISTIC.
@@ -31,6 +31,7 @@
 #include "utils.h"
 
 #define N_MU (6) //!< Number of mutation rates applied to an LSTM layer
+#define N_BUFFERS (14) //!< Number of buffers held in an LSTM layer slab
 
 /**
  * @brief Self-adaptation method for mutating an LSTM layer.
@@ -80,6 +81,34 @@ set_layer_n_active(struct Layer *l)
         l->wo->n_active;
 }
 
+/**
+ * @brief Lists the buffers of an LSTM layer, parameters first.
+ * @param [in] l The layer whose buffers are to be listed.
+ * @param [out] buffers The buffers of the layer.
+ */
+static void
+layer_buffers(struct Layer *l, struct LayerBuffer *buffers)
+{
+    const size_t n = sizeof(neural_real) * l->n_outputs;
+    const struct LayerBuffer list[N_BUFFERS] = {
+        { &l->mu, sizeof(double) * N_MU },
+        { &l->delta, n },
+        { &l->output, n },
+        { &l->state, n },
+        { &l->prev_state, n },
+        { &l->prev_cell, n },
+        { &l->cell, n },
+        { &l->f, n },
+        { &l->i, n },
+        { &l->g, n },
+        { &l->o, n },
+        { &l->c, n },
+        { &l->h, n },
+        { &l->dc, n }
+    };
+    memcpy(buffers, list, sizeof(list));
+}
+
 /**
  * @brief Allocate memory used by an LSTM layer.
  * @param [in] l The layer to be allocated memory.
@@ -88,22 +117,23 @@ static void
 malloc_layer_arrays(struct Layer *l)
 {
     layer_guard_outputs(l);
-    l->delta = calloc(l->n_outputs, sizeof(double));
-    l->output = calloc(l->n_outputs, sizeof(double));
-    l->state = calloc(l->n_outputs, sizeof(double));
-    l->prev_state = calloc(l->n_outputs, sizeof(double));
-    l->prev_cell = calloc(l->n_outputs, sizeof(double));
-    l->cell = calloc(l->n_outputs, sizeof(double));
-    l->f = calloc(l->n_outputs, sizeof(double));
-    l->i = calloc(l->n_outputs, sizeof(double));
-    l->g = calloc(l->n_outputs, sizeof(double));
-    l->o = calloc(l->n_outputs, sizeof(double));
-    l->c = calloc(l->n_outputs, sizeof(double));
-    l->h = calloc(l->n_outputs, sizeof(double));
-    l->temp = calloc(l->n_outputs, sizeof(double));
-    l->temp2 = calloc(l->n_outputs, sizeof(double));
-    l->temp3 = calloc(l->n_outputs, sizeof(double));
-    l->dc = calloc(l->n_outputs, sizeof(double));
+    struct LayerBuffer buffers[N_BUFFERS];
+    layer_buffers(l, buffers);
+    layer_slab_alloc(l, buffers, N_BUFFERS, 1);
+}
+
+/**
+ * @brief Resize and zero the neuron arrays of an LSTM layer.
+ * @param [in] l The layer to be reallocated memory.
+ */
+static void
+realloc_layer_arrays(struct Layer *l)
+{
+    layer_guard_outputs(l);
+    struct LayerBuffer buffers[N_BUFFERS];
+    layer_buffers(l, buffers);
+    layer_slab_resize(l, &buffers[1], N_BUFFERS - 1);
+    layer_slab_clear(l);
 }
 
 /**
@@ -123,31 +153,6 @@ malloc_layers(struct Layer *l)
     l->wo = malloc(sizeof(struct Layer));
 }
 
-/**
- * @brief Free memory used by an LSTM layer.
- * @param [in] l The layer to be freed.
- */
-static void
-free_layer_arrays(const struct Layer *l)
-{
-    free(l->delta);
-    free(l->output);
-    free(l->state);
-    free(l->prev_state);
-    free(l->prev_cell);
-    free(l->cell);
-    free(l->f);
-    free(l->i);
-    free(l->g);
-    free(l->o);
-    free(l->c);
-    free(l->h);
-    free(l->temp);
-    free(l->temp2);
-    free(l->temp3);
-    free(l->dc);
-}
-
 /**
  * @brief Sets the gradient descent rate used to update an LSTM layer.
  * @param [in] l The layer whose gradient descent rate is to be set.
@@ -172,7 +177,7 @@ set_eta(struct Layer *l)
 static void
 reset_layer_deltas(const struct Layer *l)
 {
-    size_t size = l->n_outputs * sizeof(double);
+    size_t size = l->n_outputs * sizeof(neural_real);
     memset(l->wf->delta, 0, size);
     memset(l->wi->delta, 0, size);
     memset(l->wg->delta, 0, size);
@@ -227,8 +232,7 @@ mutate_neurons(struct Layer *l)
         set_layer_n_weights(l);
         set_layer_n_biases(l);
         set_layer_n_active(l);
-        free_layer_arrays(l);
-        malloc_layer_arrays(l);
+        realloc_layer_arrays(l);
         return true;
     }
     return false;
@@ -314,7 +318,6 @@ neural_layer_lstm_init(struct Layer *l, const struct ArgsLayer *args)
     set_layer_n_active(l);
     set_eta(l);
     malloc_layer_arrays(l);
-    l->mu = malloc(sizeof(double) * N_MU);
     sam_init(l->mu, N_MU, MU_TYPE);
 }
 
@@ -360,7 +363,6 @@ neural_layer_lstm_copy(const struct Layer *src)
     l->wg = layer_copy(src->wg);
     l->wo = layer_copy(src->wo);
     malloc_layer_arrays(l);
-    l->mu = malloc(sizeof(double) * N_MU);
     memcpy(l->mu, src->mu, sizeof(double) * N_MU);
     return l;
 }
@@ -372,24 +374,15 @@ neural_layer_lstm_copy(const struct Layer *src)
 void
 neural_layer_lstm_free(const struct Layer *l)
 {
-    layer_free(l->uf);
-    layer_free(l->ui);
-    layer_free(l->ug);
-    layer_free(l->uo);
-    layer_free(l->wf);
-    layer_free(l->wi);
-    layer_free(l->wg);
-    layer_free(l->wo);
-    free(l->uf);
-    free(l->ui);
-    free(l->ug);
-    free(l->uo);
-    free(l->wf);
-    free(l->wi);
-    free(l->wg);
-    free(l->wo);
-    free_layer_arrays(l);
-    free(l->mu);
+    layer_delete(l->uf);
+    layer_delete(l->ui);
+    layer_delete(l->ug);
+    layer_delete(l->uo);
+    layer_delete(l->wf);
+    layer_delete(l->wi);
+    layer_delete(l->wg);
+    layer_delete(l->wo);
+    layer_slab_free(l);
 }
 
 /**
@@ -417,7 +410,7 @@ neural_layer_lstm_rand(struct Layer *l)
  */
 void
 neural_layer_lstm_forward(const struct Layer *l, const struct Net *net,
-                          const double *input)
+                          const neural_real *input)
 {
     layer_forward(l->uf, net, input);
     layer_forward(l->ui, net, input);
@@ -427,27 +420,31 @@ neural_layer_lstm_forward(const struct Layer *l, const struct Net *net,
     layer_forward(l->wi, net, l->h);
     layer_forward(l->wg, net, l->h);
     layer_forward(l->wo, net, l->h);
-    memcpy(l->f, l->wf->output, sizeof(double) * l->n_outputs);
-    blas_axpy(l->n_outputs, 1, l->uf->output, 1, l->f, 1);
-    memcpy(l->i, l->wi->output, sizeof(double) * l->n_outputs);
-    blas_axpy(l->n_outputs, 1, l->ui->output, 1, l->i, 1);
-    memcpy(l->g, l->wg->output, sizeof(double) * l->n_outputs);
-    blas_axpy(l->n_outputs, 1, l->ug->output, 1, l->g, 1);
-    memcpy(l->o, l->wo->output, sizeof(double) * l->n_outputs);
-    blas_axpy(l->n_outputs, 1, l->uo->output, 1, l->o, 1);
-    neural_activate_array(l->f, l->f, l->n_outputs, l->recurrent_function);
-    neural_activate_array(l->i, l->i, l->n_outputs, l->recurrent_function);
-    neural_activate_array(l->g, l->g, l->n_outputs, l->function);
-    neural_activate_array(l->o, l->o, l->n_outputs, l->recurrent_function);
-    memcpy(l->temp, l->i, sizeof(double) * l->n_outputs);
-    blas_mul(l->n_outputs, l->g, 1, l->temp, 1);
-    blas_mul(l->n_outputs, l->f, 1, l->c, 1);
-    blas_axpy(l->n_outputs, 1, l->temp, 1, l->c, 1);
-    memcpy(l->h, l->c, sizeof(double) * l->n_outputs);
-    neural_activate_array(l->h, l->h, l->n_outputs, l->function);
-    blas_mul(l->n_outputs, l->o, 1, l->h, 1);
-    memcpy(l->cell, l->c, sizeof(double) * l->n_outputs);
-    memcpy(l->output, l->h, sizeof(double) * l->n_outputs);
+    memcpy(l->f, l->wf->output, sizeof(neural_real) * l->n_outputs);
+    neural_axpy(l->n_outputs, 1, l->uf->output, 1, l->f, 1);
+    memcpy(l->i, l->wi->output, sizeof(neural_real) * l->n_outputs);
+    neural_axpy(l->n_outputs, 1, l->ui->output, 1, l->i, 1);
+    memcpy(l->g, l->wg->output, sizeof(neural_real) * l->n_outputs);
+    neural_axpy(l->n_outputs, 1, l->ug->output, 1, l->g, 1);
+    memcpy(l->o, l->wo->output, sizeof(neural_real) * l->n_outputs);
+    neural_axpy(l->n_outputs, 1, l->uo->output, 1, l->o, 1);
+    neural_activate_array(l->f, l->f, l->n_outputs, l->recurrent_function,
+                          net->fast);
+    neural_activate_array(l->i, l->i, l->n_outputs, l->recurrent_function,
+                          net->fast);
+    neural_activate_array(l->g, l->g, l->n_outputs, l->function, net->fast);
+    neural_activate_array(l->o, l->o, l->n_outputs, l->recurrent_function,
+                          net->fast);
+    neural_real *temp = layer_scratch(l->n_outputs);
+    memcpy(temp, l->i, sizeof(neural_real) * l->n_outputs);
+    neural_mul(l->n_outputs, l->g, 1, temp, 1);
+    neural_mul(l->n_outputs, l->f, 1, l->c, 1);
+    neural_axpy(l->n_outputs, 1, temp, 1, l->c, 1);
+    memcpy(l->h, l->c, sizeof(neural_real) * l->n_outputs);
+    neural_activate_array(l->h, l->h, l->n_outputs, l->function, net->fast);
+    neural_mul(l->n_outputs, l->o, 1, l->h, 1);
+    memcpy(l->cell, l->c, sizeof(neural_real) * l->n_outputs);
+    memcpy(l->output, l->h, sizeof(neural_real) * l->n_outputs);
 }
 
 /**
@@ -459,48 +456,54 @@ neural_layer_lstm_forward(const struct Layer *l, const struct Net *net,
  */
 void
 neural_layer_lstm_backward(const struct Layer *l, const struct Net *net,
-                           const double *input, double *delta)
+                           const neural_real *input, neural_real *delta)
 {
     reset_layer_deltas(l);
-    memcpy(l->temp3, l->delta, sizeof(double) * l->n_outputs);
-    memcpy(l->temp, l->c, sizeof(double) * l->n_outputs);
-    neural_activate_array(l->temp, l->temp, l->n_outputs, l->function);
-    memcpy(l->temp2, l->temp3, sizeof(double) * l->n_outputs);
-    blas_mul(l->n_outputs, l->o, 1, l->temp2, 1);
-    neural_gradient_array(l->temp, l->temp2, l->n_outputs, l->function);
-    blas_axpy(l->n_outputs, 1, l->dc, 1, l->temp2, 1);
-    memcpy(l->temp, l->c, sizeof(double) * l->n_outputs);
-    neural_activate_array(l->temp, l->temp, l->n_outputs, l->function);
-    blas_mul(l->n_outputs, l->temp3, 1, l->temp, 1);
-    neural_gradient_array(l->o, l->temp, l->n_outputs, l->recurrent_function);
-    memcpy(l->wo->delta, l->temp, sizeof(double) * l->n_outputs);
+    neural_real *temp = layer_scratch((size_t) 3 * l->n_outputs);
+    neural_real *temp2 = temp + l->n_outputs;
+    neural_real *temp3 = temp2 + l->n_outputs;
+    memcpy(temp3, l->delta, sizeof(neural_real) * l->n_outputs);
+    memcpy(temp, l->c, sizeof(neural_real) * l->n_outputs);
+    neural_activate_array(temp, temp, l->n_outputs, l->function, net->fast);
+    memcpy(temp2, temp3, sizeof(neural_real) * l->n_outputs);
+    neural_mul(l->n_outputs, l->o, 1, temp2, 1);
+    neural_gradient_array(temp, temp2, l->n_outputs, l->function, net->fast);
+    neural_axpy(l->n_outputs, 1, l->dc, 1, temp2, 1);
+    memcpy(temp, l->c, sizeof(neural_real) * l->n_outputs);
+    neural_activate_array(temp, temp, l->n_outputs, l->function, net->fast);
+    neural_mul(l->n_outputs, temp3, 1, temp, 1);
+    neural_gradient_array(l->o, temp, l->n_outputs, l->recurrent_function,
+                          net->fast);
+    memcpy(l->wo->delta, temp, sizeof(neural_real) * l->n_outputs);
     layer_backward(l->wo, net, l->prev_state, 0);
-    memcpy(l->uo->delta, l->temp, sizeof(double) * l->n_outputs);
+    memcpy(l->uo->delta, temp, sizeof(neural_real) * l->n_outputs);
     layer_backward(l->uo, net, input, delta);
-    memcpy(l->temp, l->temp2, sizeof(double) * l->n_outputs);
-    blas_mul(l->n_outputs, l->i, 1, l->temp, 1);
-    neural_gradient_array(l->g, l->temp, l->n_outputs, l->function);
-    memcpy(l->wg->delta, l->temp, sizeof(double) * l->n_outputs);
+    memcpy(temp, temp2, sizeof(neural_real) * l->n_outputs);
+    neural_mul(l->n_outputs, l->i, 1, temp, 1);
+    neural_gradient_array(l->g, temp, l->n_outputs, l->function, net->fast);
+    memcpy(l->wg->delta, temp, sizeof(neural_real) * l->n_outputs);
     layer_backward(l->wg, net, l->prev_state, 0);
-    memcpy(l->ug->delta, l->temp, sizeof(double) * l->n_outputs);
+    memcpy(l->ug->delta, temp, sizeof(neural_real) * l->n_outputs);
     layer_backward(l->ug, net, input, delta);
-    memcpy(l->temp, l->temp2, sizeof(double) * l->n_outputs);
-    blas_mul(l->n_outputs, l->g, 1, l->temp, 1);
-    neural_gradient_array(l->i, l->temp, l->n_outputs, l->recurrent_function);
-    memcpy(l->wi->delta, l->temp, sizeof(double) * l->n_outputs);
+    memcpy(temp, temp2, sizeof(neural_real) * l->n_outputs);
+    neural_mul(l->n_outputs, l->g, 1, temp, 1);
+    neural_gradient_array(l->i, temp, l->n_outputs, l->recurrent_function,
+                          net->fast);
+    memcpy(l->wi->delta, temp, sizeof(neural_real) * l->n_outputs);
     layer_backward(l->wi, net, l->prev_state, 0);
-    memcpy(l->ui->delta, l->temp, sizeof(double) * l->n_outputs);
+    memcpy(l->ui->delta, temp, sizeof(neural_real) * l->n_outputs);
     layer_backward(l->ui, net, input, delta);
-    memcpy(l->temp, l->temp2, sizeof(double) * l->n_outputs);
-    blas_mul(l->n_outputs, l->prev_cell, 1, l->temp, 1);
-    neural_gradient_array(l->f, l->temp, l->n_outputs, l->recurrent_function);
-    memcpy(l->wf->delta, l->temp, sizeof(double) * l->n_outputs);
+    memcpy(temp, temp2, sizeof(neural_real) * l->n_outputs);
+    neural_mul(l->n_outputs, l->prev_cell, 1, temp, 1);
+    neural_gradient_array(l->f, temp, l->n_outputs, l->recurrent_function,
+                          net->fast);
+    memcpy(l->wf->delta, temp, sizeof(neural_real) * l->n_outputs);
     layer_backward(l->wf, net, l->prev_state, 0);
-    memcpy(l->uf->delta, l->temp, sizeof(double) * l->n_outputs);
+    memcpy(l->uf->delta, temp, sizeof(neural_real) * l->n_outputs);
     layer_backward(l->uf, net, input, delta);
-    memcpy(l->temp, l->temp2, sizeof(double) * l->n_outputs);
-    blas_mul(l->n_outputs, l->f, 1, l->temp, 1);
-    memcpy(l->dc, l->temp, sizeof(double) * l->n_outputs);
+    memcpy(temp, temp2, sizeof(neural_real) * l->n_outputs);
+    neural_mul(l->n_outputs, l->f, 1, temp, 1);
+    memcpy(l->dc, temp, sizeof(neural_real) * l->n_outputs);
 }
 
 /**
@@ -546,7 +549,7 @@ neural_layer_lstm_resize(struct Layer *l, const struct Layer *prev)
  * @param [in] l The layer whose output to return.
  * @return The layer output.
  */
-double *
+neural_real *
 neural_layer_lstm_output(const struct Layer *l)
 {
     return l->output;
@@ -675,19 +678,22 @@ neural_layer_lstm_save(const struct Layer *l, FILE *fp)
     s += fwrite(&l->max_neuron_grow, sizeof(int), 1, fp);
     s += fwrite(&l->options, sizeof(uint32_t), 1, fp);
     s += fwrite(l->mu, sizeof(double), N_MU, fp);
-    s += fwrite(l->state, sizeof(double), l->n_outputs, fp);
-    s += fwrite(l->prev_state, sizeof(double), l->n_outputs, fp);
-    s += fwrite(l->cell, sizeof(double), l->n_outputs, fp);
-    s += fwrite(l->f, sizeof(double), l->n_outputs, fp);
-    s += fwrite(l->i, sizeof(double), l->n_outputs, fp);
-    s += fwrite(l->g, sizeof(double), l->n_outputs, fp);
-    s += fwrite(l->o, sizeof(double), l->n_outputs, fp);
-    s += fwrite(l->c, sizeof(double), l->n_outputs, fp);
-    s += fwrite(l->h, sizeof(double), l->n_outputs, fp);
-    s += fwrite(l->temp, sizeof(double), l->n_outputs, fp);
-    s += fwrite(l->temp2, sizeof(double), l->n_outputs, fp);
-    s += fwrite(l->temp3, sizeof(double), l->n_outputs, fp);
-    s += fwrite(l->dc, sizeof(double), l->n_outputs, fp);
+    s += layer_save_array(l->state, l->n_outputs, fp);
+    s += layer_save_array(l->prev_state, l->n_outputs, fp);
+    s += layer_save_array(l->cell, l->n_outputs, fp);
+    s += layer_save_array(l->f, l->n_outputs, fp);
+    s += layer_save_array(l->i, l->n_outputs, fp);
+    s += layer_save_array(l->g, l->n_outputs, fp);
+    s += layer_save_array(l->o, l->n_outputs, fp);
+    s += layer_save_array(l->c, l->n_outputs, fp);
+    s += layer_save_array(l->h, l->n_outputs, fp);
+    /* scratch buffers are no longer held but remain in the file format */
+    neural_real *temp = layer_scratch(l->n_outputs);
+    memset(temp, 0, sizeof(neural_real) * l->n_outputs);
+    for (int i = 0; i < 3; ++i) {
+        s += layer_save_array(temp, l->n_outputs, fp);
+    }
+    s += layer_save_array(l->dc, l->n_outputs, fp);
     s += layer_save(l->uf, fp);
     s += layer_save(l->ui, fp);
     s += layer_save(l->ug, fp);
@@ -725,21 +731,21 @@ neural_layer_lstm_load(struct Layer *l, FILE *fp)
     l->out_c = 1;
     l->out_h = 1;
     malloc_layer_arrays(l);
-    l->mu = malloc(sizeof(double) * N_MU);
     s += fread(l->mu, sizeof(double), N_MU, fp);
-    s += fread(l->state, sizeof(double), l->n_outputs, fp);
-    s += fread(l->prev_state, sizeof(double), l->n_outputs, fp);
-    s += fread(l->cell, sizeof(double), l->n_outputs, fp);
-    s += fread(l->f, sizeof(double), l->n_outputs, fp);
-    s += fread(l->i, sizeof(double), l->n_outputs, fp);
-    s += fread(l->g, sizeof(double), l->n_outputs, fp);
-    s += fread(l->o, sizeof(double), l->n_outputs, fp);
-    s += fread(l->c, sizeof(double), l->n_outputs, fp);
-    s += fread(l->h, sizeof(double), l->n_outputs, fp);
-    s += fread(l->temp, sizeof(double), l->n_outputs, fp);
-    s += fread(l->temp2, sizeof(double), l->n_outputs, fp);
-    s += fread(l->temp3, sizeof(double), l->n_outputs, fp);
-    s += fread(l->dc, sizeof(double), l->n_outputs, fp);
+    s += layer_load_array(l->state, l->n_outputs, fp);
+    s += layer_load_array(l->prev_state, l->n_outputs, fp);
+    s += layer_load_array(l->cell, l->n_outputs, fp);
+    s += layer_load_array(l->f, l->n_outputs, fp);
+    s += layer_load_array(l->i, l->n_outputs, fp);
+    s += layer_load_array(l->g, l->n_outputs, fp);
+    s += layer_load_array(l->o, l->n_outputs, fp);
+    s += layer_load_array(l->c, l->n_outputs, fp);
+    s += layer_load_array(l->h, l->n_outputs, fp);
+    neural_real *temp = layer_scratch(l->n_outputs);
+    for (int i = 0; i < 3; ++i) {
+        s += layer_load_array(temp, l->n_outputs, fp);
+    }
+    s += layer_load_array(l->dc, l->n_outputs, fp);
     malloc_layers(l);
     s += layer_load(l->uf, fp);
     s += layer_load(l->ui, fp);
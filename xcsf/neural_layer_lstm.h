@@ -36,11 +36,11 @@ neural_layer_lstm_rand(struct Layer *l);
 
 void
 neural_layer_lstm_forward(const struct Layer *l, const struct Net *net,
-                          const double *input);
+                          const neural_real *input);
 
 void
 neural_layer_lstm_backward(const struct Layer *l, const struct Net *net,
-                           const double *input, double *delta);
+                           const neural_real *input, neural_real *delta);
 
 void
 neural_layer_lstm_update(const struct Layer *l);
@@ -54,7 +54,7 @@ neural_layer_lstm_mutate(struct Layer *l);
 void
 neural_layer_lstm_free(const struct Layer *l);
 
-double *
+neural_real *
 neural_layer_lstm_output(const struct Layer *l);
 
 size_t
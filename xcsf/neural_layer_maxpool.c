@@ -17,7 +17,7 @@
  * @file neural_layer_maxpool.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2016--2021.
+ * @date 2016--2026.
  * @brief An implementation of a 2D maxpooling layer.
  */
 
@@ -34,9 +34,12 @@ static void
 malloc_layer_arrays(struct Layer *l)
 {
     layer_guard_outputs(l);
-    l->indexes = calloc(l->n_outputs, sizeof(int));
-    l->output = calloc(l->n_outputs, sizeof(double));
-    l->delta = calloc(l->n_outputs, sizeof(double));
+    const struct LayerBuffer buffers[] = {
+        { &l->indexes, sizeof(int) * l->n_outputs },
+        { &l->output, sizeof(neural_real) * l->n_outputs },
+        { &l->delta, sizeof(neural_real) * l->n_outputs }
+    };
+    layer_slab_alloc(l, buffers, 3, 0);
 }
 
 /**
@@ -47,9 +50,12 @@ static void
 realloc_layer_arrays(struct Layer *l)
 {
     layer_guard_outputs(l);
-    l->indexes = realloc(l->indexes, sizeof(int) * l->n_outputs);
-    l->output = realloc(l->output, sizeof(double) * l->n_outputs);
-    l->delta = realloc(l->delta, sizeof(double) * l->n_outputs);
+    const struct LayerBuffer buffers[] = {
+        { &l->indexes, sizeof(int) * l->n_outputs },
+        { &l->output, sizeof(neural_real) * l->n_outputs },
+        { &l->delta, sizeof(neural_real) * l->n_outputs }
+    };
+    layer_slab_resize(l, buffers, 3);
 }
 
 /**
@@ -114,9 +120,7 @@ neural_layer_maxpool_copy(const struct Layer *src)
 void
 neural_layer_maxpool_free(const struct Layer *l)
 {
-    free(l->indexes);
-    free(l->output);
-    free(l->delta);
+    layer_slab_free(l);
 }
 
 /**
@@ -140,8 +144,8 @@ neural_layer_maxpool_rand(struct Layer *l)
  * @return The index of the maximum value.
  */
 static int
-max_pool(const struct Layer *l, const double *input, const int i, const int j,
-         const int k)
+max_pool(const struct Layer *l, const neural_real *input, const int i,
+         const int j, const int k)
 {
     const int w_offset = -l->pad / 2;
     const int h_offset = w_offset;
@@ -175,7 +179,7 @@ max_pool(const struct Layer *l, const double *input, const int i, const int j,
  */
 void
 neural_layer_maxpool_forward(const struct Layer *l, const struct Net *net,
-                             const double *input)
+                             const neural_real *input)
 {
     (void) net;
     for (int k = 0; k < l->channels; ++k) {
@@ -201,7 +205,7 @@ neural_layer_maxpool_forward(const struct Layer *l, const struct Net *net,
  */
 void
 neural_layer_maxpool_backward(const struct Layer *l, const struct Net *net,
-                              const double *input, double *delta)
+                              const neural_real *input, neural_real *delta)
 {
     (void) net;
     (void) input;
@@ -262,7 +266,7 @@ neural_layer_maxpool_resize(struct Layer *l, const struct Layer *prev)
  * @param [in] l The layer whose output to return.
  * @return The layer output.
  */
-double *
+neural_real *
 neural_layer_maxpool_output(const struct Layer *l)
 {
     return l->output;
@@ -36,11 +36,11 @@ neural_layer_maxpool_rand(struct Layer *l);
 
 void
 neural_layer_maxpool_forward(const struct Layer *l, const struct Net *net,
-                             const double *input);
+                             const neural_real *input);
 
 void
 neural_layer_maxpool_backward(const struct Layer *l, const struct Net *net,
-                              const double *input, double *delta);
+                              const neural_real *input, neural_real *delta);
 
 void
 neural_layer_maxpool_update(const struct Layer *l);
@@ -54,7 +54,7 @@ neural_layer_maxpool_mutate(struct Layer *l);
 void
 neural_layer_maxpool_free(const struct Layer *l);
 
-double *
+neural_real *
 neural_layer_maxpool_output(const struct Layer *l);
 
 size_t
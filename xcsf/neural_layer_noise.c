@@ -17,7 +17,7 @@
  * @file neural_layer_noise.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2016--2021.
+ * @date 2016--2026.
  * @brief An implementation of a Gaussian noise adding layer.
  */
 
@@ -33,9 +33,12 @@ static void
 malloc_layer_arrays(struct Layer *l)
 {
     layer_guard_outputs(l);
-    l->output = calloc(l->n_outputs, sizeof(double));
-    l->delta = calloc(l->n_outputs, sizeof(double));
-    l->state = calloc(l->n_outputs, sizeof(double));
+    const struct LayerBuffer buffers[] = {
+        { &l->output, sizeof(neural_real) * l->n_outputs },
+        { &l->delta, sizeof(neural_real) * l->n_outputs },
+        { &l->state, sizeof(neural_real) * l->n_outputs }
+    };
+    layer_slab_alloc(l, buffers, 3, 0);
 }
 
 /**
@@ -45,9 +48,7 @@ malloc_layer_arrays(struct Layer *l)
 static void
 free_layer_arrays(const struct Layer *l)
 {
-    free(l->output);
-    free(l->delta);
-    free(l->state);
+    layer_slab_free(l);
 }
 
 /**
@@ -125,7 +126,7 @@ neural_layer_noise_rand(struct Layer *l)
  */
 void
 neural_layer_noise_forward(const struct Layer *l, const struct Net *net,
-                           const double *input)
+                           const neural_real *input)
 {
     if (!net->train) {
         for (int i = 0; i < l->n_inputs; ++i) {
@@ -152,7 +153,7 @@ neural_layer_noise_forward(const struct Layer *l, const struct Net *net,
  */
 void
 neural_layer_noise_backward(const struct Layer *l, const struct Net *net,
-                            const double *input, double *delta)
+                            const neural_real *input, neural_real *delta)
 {
     (void) net;
     (void) input;
@@ -208,7 +209,7 @@ neural_layer_noise_resize(struct Layer *l, const struct Layer *prev)
  * @param [in] l The layer whose output to return.
  * @return The layer output.
  */
-double *
+neural_real *
 neural_layer_noise_output(const struct Layer *l)
 {
     return l->output;
@@ -17,7 +17,7 @@
  * @file neural_layer_recurrent.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2016--2024.
+ * @date 2016--2026.
  * @brief An implementation of a recurrent layer of perceptrons.
  * @details Fully-connected, stateful, and with a step of 1.
  */
@@ -51,9 +51,12 @@ static void
 malloc_layer_arrays(struct Layer *l)
 {
     layer_guard_outputs(l);
-    l->state = calloc(l->n_outputs, sizeof(double));
-    l->prev_state = calloc(l->n_outputs, sizeof(double));
-    l->mu = malloc(sizeof(double) * N_MU);
+    const struct LayerBuffer buffers[] = {
+        { &l->mu, sizeof(double) * N_MU },
+        { &l->prev_state, sizeof(neural_real) * l->n_outputs },
+        { &l->state, sizeof(neural_real) * l->n_outputs }
+    };
+    layer_slab_alloc(l, buffers, 3, 2);
 }
 
 /**
@@ -64,8 +67,11 @@ static void
 realloc_layer_arrays(struct Layer *l)
 {
     layer_guard_outputs(l);
-    l->state = realloc(l->state, l->n_outputs * sizeof(double));
-    l->prev_state = realloc(l->prev_state, l->n_outputs * sizeof(double));
+    const struct LayerBuffer buffers[] = {
+        { &l->prev_state, sizeof(neural_real) * l->n_outputs },
+        { &l->state, sizeof(neural_real) * l->n_outputs }
+    };
+    layer_slab_resize(l, buffers, 2);
 }
 
 /**
@@ -75,9 +81,7 @@ realloc_layer_arrays(struct Layer *l)
 static void
 free_layer_arrays(const struct Layer *l)
 {
-    free(l->state);
-    free(l->prev_state);
-    free(l->mu);
+    layer_slab_free(l);
 }
 
 /**
@@ -307,7 +311,8 @@ neural_layer_recurrent_copy(const struct Layer *src)
     l->delta = l->output_layer->delta;
     malloc_layer_arrays(l);
     memcpy(l->mu, src->mu, sizeof(double) * N_MU);
-    memcpy(l->prev_state, src->prev_state, sizeof(double) * src->n_outputs);
+    memcpy(l->prev_state, src->prev_state,
+           sizeof(neural_real) * src->n_outputs);
     return l;
 }
 
@@ -318,12 +323,9 @@ neural_layer_recurrent_copy(const struct Layer *src)
 void
 neural_layer_recurrent_free(const struct Layer *l)
 {
-    layer_free(l->input_layer);
-    layer_free(l->self_layer);
-    layer_free(l->output_layer);
-    free(l->input_layer);
-    free(l->self_layer);
-    free(l->output_layer);
+    layer_delete(l->input_layer);
+    layer_delete(l->self_layer);
+    layer_delete(l->output_layer);
     free_layer_arrays(l);
 }
 
@@ -347,13 +349,14 @@ neural_layer_recurrent_rand(struct Layer *l)
  */
 void
 neural_layer_recurrent_forward(const struct Layer *l, const struct Net *net,
-                               const double *input)
+                               const neural_real *input)
 {
-    memcpy(l->prev_state, l->state, sizeof(double) * l->n_outputs);
+    memcpy(l->prev_state, l->state, sizeof(neural_real) * l->n_outputs);
     layer_forward(l->input_layer, net, input);
     layer_forward(l->self_layer, net, l->output_layer->output);
-    memcpy(l->state, l->input_layer->output, sizeof(double) * l->n_outputs);
-    blas_axpy(l->n_outputs, 1, l->self_layer->output, 1, l->state, 1);
+    memcpy(l->state, l->input_layer->output,
+           sizeof(neural_real) * l->n_outputs);
+    neural_axpy(l->n_outputs, 1, l->self_layer->output, 1, l->state, 1);
     layer_forward(l->output_layer, net, l->state);
 }
 
@@ -366,13 +369,13 @@ neural_layer_recurrent_forward(const struct Layer *l, const struct Net *net,
  */
 void
 neural_layer_recurrent_backward(const struct Layer *l, const struct Net *net,
-                                const double *input, double *delta)
+                                const neural_real *input, neural_real *delta)
 {
-    memset(l->input_layer->delta, 0, sizeof(double) * l->n_outputs);
-    memset(l->self_layer->delta, 0, sizeof(double) * l->n_outputs);
+    memset(l->input_layer->delta, 0, sizeof(neural_real) * l->n_outputs);
+    memset(l->self_layer->delta, 0, sizeof(neural_real) * l->n_outputs);
     layer_backward(l->output_layer, net, l->state, l->self_layer->delta);
     memcpy(l->input_layer->delta, l->self_layer->delta,
-           sizeof(double) * l->n_outputs);
+           sizeof(neural_real) * l->n_outputs);
     layer_backward(l->self_layer, net, l->prev_state, 0);
     layer_backward(l->input_layer, net, input, delta);
 }
@@ -410,7 +413,7 @@ neural_layer_recurrent_resize(struct Layer *l, const struct Layer *prev)
  * @param [in] l The layer whose output to return.
  * @return The layer output.
  */
-double *
+neural_real *
 neural_layer_recurrent_output(const struct Layer *l)
 {
     return l->output;
@@ -502,8 +505,8 @@ neural_layer_recurrent_save(const struct Layer *l, FILE *fp)
     s += fwrite(&l->eta, sizeof(double), 1, fp);
     s += fwrite(&l->n_active, sizeof(int), 1, fp);
     s += fwrite(l->mu, sizeof(double), N_MU, fp);
-    s += fwrite(l->state, sizeof(double), l->n_outputs, fp);
-    s += fwrite(l->prev_state, sizeof(double), l->n_outputs, fp);
+    s += layer_save_array(l->state, l->n_outputs, fp);
+    s += layer_save_array(l->prev_state, l->n_outputs, fp);
     s += layer_save(l->input_layer, fp);
     s += layer_save(l->self_layer, fp);
     s += layer_save(l->output_layer, fp);
@@ -532,8 +535,8 @@ neural_layer_recurrent_load(struct Layer *l, FILE *fp)
     l->out_h = 1;
     malloc_layer_arrays(l);
     s += fread(l->mu, sizeof(double), N_MU, fp);
-    s += fread(l->state, sizeof(double), l->n_outputs, fp);
-    s += fread(l->prev_state, sizeof(double), l->n_outputs, fp);
+    s += layer_load_array(l->state, l->n_outputs, fp);
+    s += layer_load_array(l->prev_state, l->n_outputs, fp);
     malloc_layers(l);
     s += layer_load(l->input_layer, fp);
     s += layer_load(l->self_layer, fp);
@@ -17,7 +17,7 @@
  * @file neural_layer_softmax.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2016--2021.
+ * @date 2016--2026.
  * @brief An implementation of a softmax layer.
  */
 
@@ -33,8 +33,11 @@ static void
 malloc_layer_arrays(struct Layer *l)
 {
     layer_guard_outputs(l);
-    l->output = calloc(l->n_outputs, sizeof(double));
-    l->delta = calloc(l->n_outputs, sizeof(double));
+    const struct LayerBuffer buffers[] = {
+        { &l->output, sizeof(neural_real) * l->n_outputs },
+        { &l->delta, sizeof(neural_real) * l->n_outputs }
+    };
+    layer_slab_alloc(l, buffers, 2, 0);
 }
 
 /**
@@ -44,8 +47,7 @@ malloc_layer_arrays(struct Layer *l)
 static void
 free_layer_arrays(const struct Layer *l)
 {
-    free(l->output);
-    free(l->delta);
+    layer_slab_free(l);
 }
 
 /**
@@ -111,7 +113,7 @@ neural_layer_softmax_rand(struct Layer *l)
  */
 void
 neural_layer_softmax_forward(const struct Layer *l, const struct Net *net,
-                             const double *input)
+                             const neural_real *input)
 {
     (void) net;
     double largest = input[0];
@@ -140,7 +142,7 @@ neural_layer_softmax_forward(const struct Layer *l, const struct Net *net,
  */
 void
 neural_layer_softmax_backward(const struct Layer *l, const struct Net *net,
-                              const double *input, double *delta)
+                              const neural_real *input, neural_real *delta)
 {
     (void) net;
     (void) input;
@@ -241,7 +243,7 @@ neural_layer_softmax_free(const struct Layer *l)
  * @param [in] l The layer whose output to return.
  * @return The layer output.
  */
-double *
+neural_real *
 neural_layer_softmax_output(const struct Layer *l)
 {
     return l->output;
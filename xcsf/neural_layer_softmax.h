@@ -36,10 +36,10 @@ neural_layer_softmax_rand(struct Layer *l);
 
 void
 neural_layer_softmax_forward(const struct Layer *l, const struct Net *net,
-                             const double *input);
+                             const neural_real *input);
 void
 neural_layer_softmax_backward(const struct Layer *l, const struct Net *net,
-                              const double *input, double *delta);
+                              const neural_real *input, neural_real *delta);
 
 void
 neural_layer_softmax_update(const struct Layer *l);
@@ -53,7 +53,7 @@ neural_layer_softmax_mutate(struct Layer *l);
 void
 neural_layer_softmax_free(const struct Layer *l);
 
-double *
+neural_real *
 neural_layer_softmax_output(const struct Layer *l);
 
 size_t
@@ -17,14 +17,20 @@
  * @file pa.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2023.
+ * @date 2015--2026.
  * @brief Prediction array functions.
  */
 
 #include "pa.h"
+#include "blas.h"
 #include "cl.h"
+#include "prediction.h"
 #include "utils.h"
 
+#define PA_BLOCK (64) //!< Outputs accumulated per work unit
+#define PA_PARALLEL_MIN (512) //!< Minimum outputs to accumulate in parallel
+#define PA_LINEAR_MAX (256) //!< Maximum rules to predict in one serial pass
+
 /**
  * @brief Resets the prediction array to zero.
  * @param [in] xcsf The XCSF data structure.
@@ -51,6 +57,100 @@ pa_init(struct XCSF *xcsf)
     xcsf->cover = calloc(xcsf->pa_size, sizeof(double));
 }
 
+/**
+ * @brief Copies the fitness sum of each action to all of its outputs.
+ * @param [in] xcsf The XCSF data structure.
+ */
+static void
+pa_broadcast_nr(const struct XCSF *xcsf)
+{
+    const int y_dim = xcsf->y_dim;
+    for (int i = 0; i < xcsf->n_actions; ++i) {
+        double *nr = &xcsf->nr[i * y_dim];
+        for (int j = 1; j < y_dim; ++j) {
+            nr[j] = nr[0];
+        }
+    }
+}
+
+/**
+ * @brief Accumulates the fitness weighted predictions of the match set.
+ * @details Each prediction array element is summed over the match set in
+ * match set order, so the result is identical to a serial pass for any number
+ * of threads. Blocks of outputs are independent and are accumulated in
+ * parallel when y_dim is large, with a vectorisable loop over each block.
+ * @param [in] xcsf The XCSF data structure.
+ */
+static void
+pa_accumulate(const struct XCSF *xcsf)
+{
+    const struct Set *set = &xcsf->mset;
+    const int y_dim = xcsf->y_dim;
+    const int n_blocks = (y_dim + PA_BLOCK - 1) / PA_BLOCK;
+#ifdef PARALLEL_PRED
+    #pragma omp parallel for if (y_dim >= PA_PARALLEL_MIN)
+#endif
+    for (int b = 0; b < n_blocks; ++b) {
+        const int start = b * PA_BLOCK;
+        const int end = start + PA_BLOCK < y_dim ? start + PA_BLOCK : y_dim;
+        for (int i = 0; i < set->size; ++i) {
+            const struct Cl *c = set->cl[i];
+            const double *pred = c->prediction;
+            const double fitness = c->fit;
+            double *pa = &xcsf->pa[c->action * y_dim];
+            for (int j = start; j < end; ++j) {
+                pa[j] += pred[j] * fitness;
+            }
+        }
+    }
+    // the fitness sum is the same for every output of an action
+    for (int i = 0; i < set->size; ++i) {
+        const struct Cl *c = set->cl[i];
+        xcsf->nr[c->action * y_dim] += c->fit;
+    }
+    pa_broadcast_nr(xcsf);
+}
+
+/**
+ * @brief Computes and accumulates the predictions of a match set of least
+ * squares rules in one pass.
+ * @details Each rule's prediction is calculated from its weights and the
+ * shared input basis and added to the prediction array while the weights are
+ * still in cache, in match set order as pa_accumulate(). Large sets and wide
+ * outputs are left to the parallel path when PARALLEL_PRED is defined.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] x The input state.
+ * @return Whether the predictions are least squares and were accumulated.
+ */
+static bool
+pa_build_linear(const struct XCSF *xcsf, const double *x)
+{
+    const struct Set *set = &xcsf->mset;
+    const int y_dim = xcsf->y_dim;
+    if (set->size < 1 || pred_weights(xcsf, set->cl[0]) == NULL) {
+        return false;
+    }
+#ifdef PARALLEL_PRED
+    if (set->size > PA_LINEAR_MAX || y_dim >= PA_PARALLEL_MIN) {
+        return false;
+    }
+#endif
+    const int n = pred_basis_length(xcsf);
+    const double *basis = pred_basis(xcsf, x, 1);
+    for (int i = 0; i < set->size; ++i) {
+        struct Cl *c = set->cl[i];
+        const double *weights = pred_weights(xcsf, c);
+        double *pa = &xcsf->pa[c->action * y_dim];
+        for (int j = 0; j < y_dim; ++j) {
+            c->prediction[j] = blas_dot(n, &weights[j * n], 1, basis, 1);
+            pa[j] += c->prediction[j] * c->fit;
+        }
+        xcsf->nr[c->action * y_dim] += c->fit;
+    }
+    pa_broadcast_nr(xcsf);
+    return true;
+}
+
 /**
  * @brief Builds the prediction array for the specified input.
  * @details Calculates the match set mean fitness weighted prediction for each
@@ -65,41 +165,19 @@ pa_build(const struct XCSF *xcsf, const double *x)
     double *pa = xcsf->pa;
     double *nr = xcsf->nr;
     pa_reset(xcsf);
+    if (!pa_build_linear(xcsf, x)) {
+        // propagate input and compute predictions
 #ifdef PARALLEL_PRED
-    // (parallel) propagate input and compute predictions
-    struct Cl *clist[set->size];
-    struct Clist *iter = set->list;
-    for (int i = 0; i < set->size; ++i) {
-        clist[i] = NULL;
-        if (iter != NULL) {
-            clist[i] = iter->cl;
-            iter = iter->next;
-        }
-    }
     #pragma omp parallel for
-    for (int i = 0; i < set->size; ++i) {
-        if (clist[i] != NULL) {
-            cl_predict(xcsf, clist[i], x);
-        }
-    }
-#else
-    // (series) propagate input and compute predictions
-    const struct Clist *iter = set->list;
-    while (iter != NULL) {
-        cl_predict(xcsf, iter->cl, x);
-        iter = iter->next;
-    }
 #endif
-    // compute the prediction array in series for determinism
-    iter = set->list;
-    while (iter != NULL) {
-        const double *pred = iter->cl->prediction;
-        const double fitness = iter->cl->fit;
-        for (int j = 0; j < xcsf->y_dim; ++j) {
-            pa[iter->cl->action * xcsf->y_dim + j] += pred[j] * fitness;
-            nr[iter->cl->action * xcsf->y_dim + j] += fitness;
+        for (int i = 0; i < set->size; ++i) {
+            cl_predict(xcsf, set->cl[i], x);
         }
-        iter = iter->next;
+        pa_accumulate(xcsf);
+    }
+    // tag the predictions with the input they were computed for
+    for (int i = 0; i < set->size; ++i) {
+        set->cl[i]->pred_stamp = xcsf->input_stamp;
     }
     for (int i = 0; i < xcsf->n_actions; ++i) {
         for (int j = 0; j < xcsf->y_dim; ++j) {
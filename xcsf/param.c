@@ -17,12 +17,13 @@
  * @file param.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2023.
+ * @date 2015--2026.
  * @brief Functions for setting and printing parameters.
  */
 
 #include "param.h"
 #include "action.h"
+#include "blas.h"
 #include "condition.h"
 #include "ea.h"
 #include "prediction.h"
@@ -46,6 +47,8 @@ param_init(struct XCSF *xcsf, const int x_dim, const int y_dim,
            const int n_actions)
 {
     xcsf->time = 0;
+    xcsf->input_stamp = 0;
+    xcsf->prev_stamp = 0;
     xcsf->error = xcsf->E0;
     xcsf->mset_size = 0;
     xcsf->aset_size = 0;
@@ -78,6 +81,7 @@ param_init(struct XCSF *xcsf, const int x_dim, const int y_dim,
     param_set_m_probation(xcsf, 10000);
     param_set_stateful(xcsf, true);
     param_set_compaction(xcsf, false);
+    param_set_fast_activations(xcsf, false);
     param_set_gamma(xcsf, 0.95);
     param_set_teletransportation(xcsf, 50);
     param_set_p_explore(xcsf, 0.9);
@@ -152,6 +156,7 @@ param_json_export(const struct XCSF *xcsf)
     cJSON_AddNumberToObject(json, "m_probation", xcsf->M_PROBATION);
     cJSON_AddBoolToObject(json, "stateful", xcsf->STATEFUL);
     cJSON_AddBoolToObject(json, "compaction", xcsf->COMPACTION);
+    cJSON_AddBoolToObject(json, "fast_activations", xcsf->FAST_ACTIVATIONS);
     char *ea_param_str = ea_param_json_export(xcsf);
     cJSON *ea_params = cJSON_Parse(ea_param_str);
     cJSON_AddItemToObject(json, "ea", ea_params);
@@ -332,6 +337,10 @@ param_json_import_cl_general(struct XCSF *xcsf, const cJSON *json)
                cJSON_IsBool(json)) {
         const bool compact = true ? json->type == cJSON_True : false;
         catch_error(param_set_compaction(xcsf, compact));
+    } else if (strncmp(json->string, "fast_activations\0", 17) == 0 &&
+               cJSON_IsBool(json)) {
+        const bool fast = true ? json->type == cJSON_True : false;
+        catch_error(param_set_fast_activations(xcsf, fast));
     } else {
         return false;
     }
@@ -531,6 +540,7 @@ param_save(const struct XCSF *xcsf, FILE *fp)
     s += fwrite(&xcsf->M_PROBATION, sizeof(int), 1, fp);
     s += fwrite(&xcsf->STATEFUL, sizeof(bool), 1, fp);
     s += fwrite(&xcsf->COMPACTION, sizeof(bool), 1, fp);
+    s += fwrite(&xcsf->FAST_ACTIVATIONS, sizeof(bool), 1, fp);
     s += ea_param_save(xcsf, fp);
     s += action_param_save(xcsf, fp);
     s += cond_param_save(xcsf, fp);
@@ -594,6 +604,7 @@ param_load(struct XCSF *xcsf, FILE *fp)
     s += fread(&xcsf->M_PROBATION, sizeof(int), 1, fp);
     s += fread(&xcsf->STATEFUL, sizeof(bool), 1, fp);
     s += fread(&xcsf->COMPACTION, sizeof(bool), 1, fp);
+    s += fread(&xcsf->FAST_ACTIVATIONS, sizeof(bool), 1, fp);
     s += ea_param_load(xcsf, fp);
     s += action_param_load(xcsf, fp);
     s += cond_param_load(xcsf, fp);
@@ -606,6 +617,7 @@ param_load(struct XCSF *xcsf, FILE *fp)
 
 /**
  * @brief Sets the number of OMP threads.
+ * @details An external CBLAS library is limited to the same number of threads.
  * @param [in] xcsf The XCSF data structure.
  * @param [in] a The number of threads.
  * @return NULL if successful; or an error message.
@@ -620,6 +632,7 @@ param_set_omp_num_threads(struct XCSF *xcsf, const int a)
 #ifdef PARALLEL
     omp_set_num_threads(xcsf->OMP_NUM_THREADS);
 #endif
+    blas_set_num_threads(xcsf->OMP_NUM_THREADS);
     return NULL;
 }
 
@@ -720,6 +733,13 @@ param_set_compaction(struct XCSF *xcsf, const bool a)
     return NULL;
 }
 
+const char *
+param_set_fast_activations(struct XCSF *xcsf, const bool a)
+{
+    xcsf->FAST_ACTIVATIONS = a;
+    return NULL;
+}
+
 const char *
 param_set_huber_delta(struct XCSF *xcsf, const double a)
 {
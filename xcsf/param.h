@@ -87,6 +87,9 @@ param_set_stateful(struct XCSF *xcsf, const bool a);
 const char *
 param_set_compaction(struct XCSF *xcsf, const bool a);
 
+const char *
+param_set_fast_activations(struct XCSF *xcsf, const bool a);
+
 const char *
 param_set_huber_delta(struct XCSF *xcsf, const double a);
 
@@ -17,7 +17,7 @@
  * @file pred_constant.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2021.
+ * @date 2015--2026.
  * @brief Piece-wise constant prediction functions.
  */
 
@@ -102,6 +102,25 @@ pred_constant_compute(const struct XCSF *xcsf, const struct Cl *c,
     (void) x;
 }
 
+/**
+ * @brief Copies the constant prediction for several inputs.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] c The classifier calculating the predictions.
+ * @param [in] x The input states (n_rows × x_dim).
+ * @param [in] n_rows The number of input states.
+ * @param [out] out The predictions (n_rows × y_dim).
+ */
+void
+pred_constant_compute_batch(const struct XCSF *xcsf, const struct Cl *c,
+                            const double *x, const int n_rows, double *out)
+{
+    (void) x;
+    for (int i = 0; i < n_rows; ++i) {
+        memcpy(&out[i * xcsf->y_dim], c->prediction,
+               sizeof(double) * xcsf->y_dim);
+    }
+}
+
 /**
  * @brief Prints a constant prediction.
  * @param [in] xcsf The XCSF data structure.
@@ -17,7 +17,7 @@
  * @file pred_constant.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2021.
+ * @date 2015--2026.
  * @brief Piece-wise constant prediction functions.
  */
 
@@ -46,6 +46,10 @@ void
 pred_constant_compute(const struct XCSF *xcsf, const struct Cl *c,
                       const double *x);
 
+void
+pred_constant_compute_batch(const struct XCSF *xcsf, const struct Cl *c,
+                            const double *x, const int n_rows, double *out);
+
 void
 pred_constant_copy(const struct XCSF *xcsf, struct Cl *dest,
                    const struct Cl *src);
@@ -74,11 +78,11 @@ pred_constant_json_import(const struct XCSF *xcsf, struct Cl *c,
  * @brief Constant prediction implemented functions.
  */
 static struct PredVtbl const pred_constant_vtbl = {
-    &pred_constant_crossover,  &pred_constant_mutate,
-    &pred_constant_compute,    &pred_constant_copy,
-    &pred_constant_free,       &pred_constant_init,
-    &pred_constant_print,      &pred_constant_update,
-    &pred_constant_size,       &pred_constant_save,
-    &pred_constant_load,       &pred_constant_json_export,
-    &pred_constant_json_import
+    &pred_constant_crossover,   &pred_constant_mutate,
+    &pred_constant_compute,     &pred_constant_compute_batch,
+    &pred_constant_copy,        &pred_constant_free,
+    &pred_constant_init,        &pred_constant_print,
+    &pred_constant_update,      &pred_constant_size,
+    &pred_constant_save,        &pred_constant_load,
+    &pred_constant_json_export, &pred_constant_json_import
 };
@@ -17,7 +17,7 @@
  * @file pred_neural.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2016--2022.
+ * @date 2016--2026.
  * @brief Multi-layer perceptron neural network prediction functions.
  */
 
@@ -107,12 +107,33 @@ pred_neural_compute(const struct XCSF *xcsf, const struct Cl *c,
                     const double *x)
 {
     struct PredNeural *pred = c->pred;
-    neural_propagate(&pred->net, x, xcsf->explore);
+    neural_propagate(&pred->net, x, xcsf->explore, xcsf->FAST_ACTIVATIONS);
     for (int i = 0; i < xcsf->y_dim; ++i) {
         c->prediction[i] = neural_output(&pred->net, i);
     }
 }
 
+/**
+ * @brief Computes the neural network predictions for several inputs.
+ * @details Inputs are propagated in order so that recurrent state is the same
+ * as when computed one at a time.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] c The classifier calculating the predictions.
+ * @param [in] x The input states (n_rows × x_dim).
+ * @param [in] n_rows The number of input states.
+ * @param [out] out The predictions (n_rows × y_dim).
+ */
+void
+pred_neural_compute_batch(const struct XCSF *xcsf, const struct Cl *c,
+                          const double *x, const int n_rows, double *out)
+{
+    for (int i = 0; i < n_rows; ++i) {
+        pred_neural_compute(xcsf, c, &x[i * xcsf->x_dim]);
+        memcpy(&out[i * xcsf->y_dim], c->prediction,
+               sizeof(double) * xcsf->y_dim);
+    }
+}
+
 /**
  * @brief Prints a neural network prediction.
  * @param [in] xcsf The XCSF data structure.
@@ -153,7 +174,7 @@ bool
 pred_neural_mutate(const struct XCSF *xcsf, const struct Cl *c)
 {
     (void) xcsf;
-    const struct PredNeural *pred = c->pred;
+    struct PredNeural *pred = c->pred;
     return neural_mutate(&pred->net);
 }
 
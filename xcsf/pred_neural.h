@@ -17,7 +17,7 @@
  * @file pred_neural.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2016--2022.
+ * @date 2016--2026.
  * @brief Multi-layer perceptron neural network prediction functions.
  */
 
@@ -76,6 +76,10 @@ void
 pred_neural_compute(const struct XCSF *xcsf, const struct Cl *c,
                     const double *x);
 
+void
+pred_neural_compute_batch(const struct XCSF *xcsf, const struct Cl *c,
+                          const double *x, const int n_rows, double *out);
+
 void
 pred_neural_copy(const struct XCSF *xcsf, struct Cl *dest,
                  const struct Cl *src);
@@ -112,9 +116,9 @@ pred_neural_json_import(const struct XCSF *xcsf, struct Cl *c,
  * functions.
  */
 static struct PredVtbl const pred_neural_vtbl = {
-    &pred_neural_crossover,  &pred_neural_mutate, &pred_neural_compute,
-    &pred_neural_copy,       &pred_neural_free,   &pred_neural_init,
-    &pred_neural_print,      &pred_neural_update, &pred_neural_size,
-    &pred_neural_save,       &pred_neural_load,   &pred_neural_json_export,
-    &pred_neural_json_import
+    &pred_neural_crossover,     &pred_neural_mutate,      &pred_neural_compute,
+    &pred_neural_compute_batch, &pred_neural_copy,        &pred_neural_free,
+    &pred_neural_init,          &pred_neural_print,       &pred_neural_update,
+    &pred_neural_size,          &pred_neural_save,        &pred_neural_load,
+    &pred_neural_json_export,   &pred_neural_json_import
 };
@@ -17,7 +17,7 @@
  * @file pred_nlms.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2023.
+ * @date 2015--2026.
  * @brief Normalised least mean squares prediction functions.
  */
 
@@ -46,12 +46,7 @@ pred_nlms_init(const struct XCSF *xcsf, struct Cl *c)
     struct PredNLMS *pred = malloc(sizeof(struct PredNLMS));
     c->pred = pred;
     // set the length of weights per predicted variable
-    if (xcsf->pred->type == PRED_TYPE_NLMS_QUADRATIC) {
-        // offset(1) + n linear + n quadratic + n*(n-1)/2 mixed terms
-        pred->n = 1 + 2 * xcsf->x_dim + xcsf->x_dim * (xcsf->x_dim - 1) / 2;
-    } else {
-        pred->n = xcsf->x_dim + 1;
-    }
+    pred->n = pred_basis_length(xcsf);
     // initialise weights
     pred->n_weights = pred->n * xcsf->y_dim;
     pred->weights = calloc(pred->n_weights, sizeof(double));
@@ -65,8 +60,6 @@ pred_nlms_init(const struct XCSF *xcsf, struct Cl *c)
         memset(pred->mu, 0, sizeof(double) * N_MU);
         pred->eta = xcsf->pred->eta;
     }
-    // initialise temporary storage for weight updating
-    pred->tmp_input = malloc(sizeof(double) * pred->n);
 }
 
 /**
@@ -98,7 +91,6 @@ pred_nlms_free(const struct XCSF *xcsf, const struct Cl *c)
     (void) xcsf;
     struct PredNLMS *pred = c->pred;
     free(pred->weights);
-    free(pred->tmp_input);
     free(pred->mu);
     free(pred);
 }
@@ -120,11 +112,12 @@ pred_nlms_update(const struct XCSF *xcsf, const struct Cl *c, const double *x,
     const int n = pred->n;
     const double X0 = xcsf->pred->x0;
     const double norm = X0 * X0 + blas_dot(xcsf->x_dim, x, 1, x, 1);
+    const double *input = pred_basis(xcsf, x, 1);
     // update weights using the error
     for (int i = 0; i < xcsf->y_dim; ++i) {
         const double error = y[i] - c->prediction[i];
         const double correction = (pred->eta * error) / norm;
-        blas_axpy(n, correction, pred->tmp_input, 1, &pred->weights[i * n], 1);
+        blas_axpy(n, correction, input, 1, &pred->weights[i * n], 1);
     }
 }
 
@@ -139,10 +132,9 @@ pred_nlms_compute(const struct XCSF *xcsf, const struct Cl *c, const double *x)
 {
     const struct PredNLMS *pred = c->pred;
     const int n = pred->n;
-    pred_transform_input(xcsf, x, xcsf->pred->x0, pred->tmp_input);
+    const double *input = pred_basis(xcsf, x, 1);
     for (int i = 0; i < xcsf->y_dim; ++i) {
-        c->prediction[i] =
-            blas_dot(n, &pred->weights[i * n], 1, pred->tmp_input, 1);
+        c->prediction[i] = blas_dot(n, &pred->weights[i * n], 1, input, 1);
     }
 }
 
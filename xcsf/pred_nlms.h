@@ -17,7 +17,7 @@
  * @file pred_nlms.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2022.
+ * @date 2015--2026.
  * @brief Normalised least mean squares prediction functions.
  */
 
@@ -35,7 +35,6 @@ struct PredNLMS {
     double *weights; //!< Weights used to compute prediction
     double *mu; //!< Mutation rates
     double eta; //!< Gradient descent rate
-    double *tmp_input; //!< Temporary storage for updating weights
 };
 
 char *
@@ -89,9 +88,9 @@ pred_nlms_json_import(const struct XCSF *xcsf, struct Cl *c, const cJSON *json);
  * @brief Normalised least mean squares prediction implemented functions.
  */
 static struct PredVtbl const pred_nlms_vtbl = {
-    &pred_nlms_crossover,  &pred_nlms_mutate, &pred_nlms_compute,
-    &pred_nlms_copy,       &pred_nlms_free,   &pred_nlms_init,
-    &pred_nlms_print,      &pred_nlms_update, &pred_nlms_size,
-    &pred_nlms_save,       &pred_nlms_load,   &pred_nlms_json_export,
-    &pred_nlms_json_import
+    &pred_nlms_crossover,   &pred_nlms_mutate,     &pred_nlms_compute,
+    &pred_ls_compute_batch, &pred_nlms_copy,       &pred_nlms_free,
+    &pred_nlms_init,        &pred_nlms_print,      &pred_nlms_update,
+    &pred_nlms_size,        &pred_nlms_save,       &pred_nlms_load,
+    &pred_nlms_json_export, &pred_nlms_json_import
 };
@@ -17,7 +17,7 @@
  * @file pred_rls.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2022.
+ * @date 2015--2026.
  * @brief Recursive least mean squares prediction functions.
  */
 
@@ -25,6 +25,89 @@
 #include "blas.h"
 #include "utils.h"
 
+/**
+ * @brief Returns the number of elements stored for an RLS gain matrix.
+ * @param [in] n The number of rows and columns of the matrix.
+ * @return The number of elements stored.
+ */
+int
+pred_rls_matrix_size(const int n)
+{
+#ifdef RLS_PACKED
+    return n * (n + 1) / 2;
+#else
+    return n * n;
+#endif
+}
+
+/**
+ * @brief Returns the position of an element of an RLS gain matrix.
+ * @param [in] n The number of rows and columns of the matrix.
+ * @param [in] i The row of the element.
+ * @param [in] j The column of the element.
+ * @return The position of the element in the stored matrix.
+ */
+int
+pred_rls_matrix_index(const int n, const int i, const int j)
+{
+#ifdef RLS_PACKED
+    if (i > j) {
+        return pred_rls_matrix_index(n, j, i);
+    }
+    return i * n - i * (i - 1) / 2 + j - i;
+#else
+    return i * n + j;
+#endif
+}
+
+/**
+ * @brief Multiplies an RLS gain matrix by a vector.
+ * @param [in] n The number of rows and columns of the matrix.
+ * @param [in] matrix The gain matrix.
+ * @param [in] x The vector to multiply.
+ * @param [out] y The product.
+ */
+static void
+pred_rls_matrix_gemv(const int n, const double *matrix, const double *x,
+                     double *y)
+{
+#ifdef RLS_PACKED
+    memset(y, 0, sizeof(double) * n);
+    const double *row = matrix;
+    for (int i = 0; i < n; ++i) {
+        double sum = row[0] * x[i];
+        for (int j = i + 1; j < n; ++j) {
+            sum += row[j - i] * x[j];
+            y[j] += row[j - i] * x[i];
+        }
+        y[i] += sum;
+        row += n - i;
+    }
+#else
+    blas_gemv(0, n, n, 1, matrix, n, x, 1, 0, y, 1);
+#endif
+}
+
+/**
+ * @brief Copies the upper triangle of a full RLS gain matrix to the lower.
+ * @param [in] n The number of rows and columns of the matrix.
+ * @param [in,out] matrix The gain matrix.
+ */
+static void
+pred_rls_matrix_mirror(const int n, double *matrix)
+{
+#ifdef RLS_PACKED
+    (void) n;
+    (void) matrix;
+#else
+    for (int i = 1; i < n; ++i) {
+        for (int j = 0; j < i; ++j) {
+            matrix[i * n + j] = matrix[j * n + i];
+        }
+    }
+#endif
+}
+
 /**
  * @brief Initialises an RLS prediction.
  * @param [in] xcsf The XCSF data structure.
@@ -36,27 +119,17 @@ pred_rls_init(const struct XCSF *xcsf, struct Cl *c)
     struct PredRLS *pred = malloc(sizeof(struct PredRLS));
     c->pred = pred;
     // set the length of weights per predicted variable
-    if (xcsf->pred->type == PRED_TYPE_RLS_QUADRATIC) {
-        // offset(1) + n linear + n quadratic + n*(n-1)/2 mixed terms
-        pred->n = 1 + 2 * xcsf->x_dim + xcsf->x_dim * (xcsf->x_dim - 1) / 2;
-    } else {
-        pred->n = xcsf->x_dim + 1;
-    }
+    pred->n = pred_basis_length(xcsf);
     // initialise weights
     pred->n_weights = pred->n * xcsf->y_dim;
     pred->weights = calloc(pred->n_weights, sizeof(double));
     blas_fill(xcsf->y_dim, xcsf->pred->x0, pred->weights, pred->n);
     // initialise gain matrix
-    const int n_sqrd = pred->n * pred->n;
-    pred->matrix = calloc(n_sqrd, sizeof(double));
+    pred->matrix = calloc(pred_rls_matrix_size(pred->n), sizeof(double));
     for (int i = 0; i < pred->n; ++i) {
-        pred->matrix[i * pred->n + i] = xcsf->pred->scale_factor;
+        pred->matrix[pred_rls_matrix_index(pred->n, i, i)] =
+            xcsf->pred->scale_factor;
     }
-    // initialise temporary storage for weight updating
-    pred->tmp_input = malloc(sizeof(double) * pred->n);
-    pred->tmp_vec = calloc(pred->n, sizeof(double));
-    pred->tmp_matrix1 = calloc(n_sqrd, sizeof(double));
-    pred->tmp_matrix2 = calloc(n_sqrd, sizeof(double));
 }
 
 /**
@@ -87,15 +160,13 @@ pred_rls_free(const struct XCSF *xcsf, const struct Cl *c)
     struct PredRLS *pred = c->pred;
     free(pred->weights);
     free(pred->matrix);
-    free(pred->tmp_input);
-    free(pred->tmp_vec);
-    free(pred->tmp_matrix1);
-    free(pred->tmp_matrix2);
     free(pred);
 }
 
 /**
  * @brief Updates an RLS prediction for a given input and truth sample.
+ * @details The gain matrix P is updated with the symmetric rank-1 recursion
+ * P = (P - g gᵀ / (λ + xᵀ g)) / λ, where g = P x, in O(n²) operations.
  * @pre The prediction has been computed for the current state.
  * @param [in] xcsf The XCSF data structure.
  * @param [in] c Classifier whose prediction is to be updated.
@@ -106,46 +177,30 @@ void
 pred_rls_update(const struct XCSF *xcsf, const struct Cl *c, const double *x,
                 const double *y)
 {
-    (void) x;
     const struct PredRLS *pred = c->pred;
     const int n = pred->n;
-    // gain vector = matrix * tmp_input (tmp_input set during compute)
-    const double *A = pred->matrix;
-    const double *B = pred->tmp_input;
-    double *C = pred->tmp_vec;
-    blas_gemm(0, 0, n, 1, n, 1, A, n, B, 1, 0, C, 1);
+    const double lambda = xcsf->pred->lambda;
+    const double *input = pred_basis(xcsf, x, 1);
+    double *g = pred_scratch(n);
+    // gain vector = matrix * input
+    pred_rls_matrix_gemv(n, pred->matrix, input, g);
     // divide gain vector by lambda + gain vector
-    double divisor = blas_dot(n, pred->tmp_input, 1, pred->tmp_vec, 1);
-    divisor = 1 / (divisor + xcsf->pred->lambda);
-    blas_scal(n, divisor, pred->tmp_vec, 1);
+    double divisor = blas_dot(n, input, 1, g, 1);
+    divisor = 1 / (divisor + lambda);
     // update weights using the error
     for (int i = 0; i < xcsf->y_dim; ++i) {
         const double error = y[i] - c->prediction[i];
-        blas_axpy(n, error, pred->tmp_vec, 1, &pred->weights[i * n], 1);
-    }
-    // update gain matrix
-    for (int i = 0; i < n; ++i) {
-        for (int j = 0; j < n; ++j) {
-            const double tmp = pred->tmp_vec[i] * pred->tmp_input[j];
-            if (i == j) {
-                pred->tmp_matrix1[i * n + j] = 1 - tmp;
-            } else {
-                pred->tmp_matrix1[i * n + j] = -tmp;
-            }
-        }
+        blas_axpy(n, error * divisor, g, 1, &pred->weights[i * n], 1);
     }
-    // tmp_matrix2 = tmp_matrix1 * pred_matrix
-    A = pred->tmp_matrix1;
-    B = pred->matrix;
-    C = pred->tmp_matrix2;
-    blas_gemm(0, 0, n, n, n, 1, A, n, B, n, 0, C, n);
-    // divide gain matrix entries by lambda
-    const double lambda = xcsf->pred->lambda;
+    // update the upper triangle of the gain matrix
     for (int i = 0; i < n; ++i) {
-        for (int j = 0; j < n; ++j) {
-            pred->matrix[i * n + j] = pred->tmp_matrix2[i * n + j] / lambda;
+        const double k = g[i] * divisor;
+        double *row = &pred->matrix[pred_rls_matrix_index(n, i, i)] - i;
+        for (int j = i; j < n; ++j) {
+            row[j] = (row[j] - k * g[j]) / lambda;
         }
     }
+    pred_rls_matrix_mirror(n, pred->matrix);
 }
 
 /**
@@ -159,10 +214,9 @@ pred_rls_compute(const struct XCSF *xcsf, const struct Cl *c, const double *x)
 {
     const struct PredRLS *pred = c->pred;
     const int n = pred->n;
-    pred_transform_input(xcsf, x, xcsf->pred->x0, pred->tmp_input);
+    const double *input = pred_basis(xcsf, x, 1);
     for (int i = 0; i < xcsf->y_dim; ++i) {
-        c->prediction[i] =
-            blas_dot(n, &pred->weights[i * n], 1, pred->tmp_input, 1);
+        c->prediction[i] = blas_dot(n, &pred->weights[i * n], 1, input, 1);
     }
 }
 
@@ -240,8 +294,15 @@ pred_rls_save(const struct XCSF *xcsf, const struct Cl *c, FILE *fp)
     s += fwrite(&pred->n, sizeof(int), 1, fp);
     s += fwrite(&pred->n_weights, sizeof(int), 1, fp);
     s += fwrite(pred->weights, sizeof(double), pred->n_weights, fp);
-    const int n_sqrd = pred->n * pred->n;
-    s += fwrite(pred->matrix, sizeof(double), n_sqrd, fp);
+    // the gain matrix is always saved in full
+    double *row = malloc(sizeof(double) * pred->n);
+    for (int i = 0; i < pred->n; ++i) {
+        for (int j = 0; j < pred->n; ++j) {
+            row[j] = pred->matrix[pred_rls_matrix_index(pred->n, i, j)];
+        }
+        s += fwrite(row, sizeof(double), pred->n, fp);
+    }
+    free(row);
     return s;
 }
 
@@ -261,8 +322,15 @@ pred_rls_load(const struct XCSF *xcsf, struct Cl *c, FILE *fp)
     s += fread(&pred->n, sizeof(int), 1, fp);
     s += fread(&pred->n_weights, sizeof(int), 1, fp);
     s += fread(pred->weights, sizeof(double), pred->n_weights, fp);
-    const int n_sqrd = pred->n * pred->n;
-    s += fread(pred->matrix, sizeof(double), n_sqrd, fp);
+    double *row = malloc(sizeof(double) * pred->n);
+    for (int i = 0; i < pred->n; ++i) {
+        s += fread(row, sizeof(double), pred->n, fp);
+        for (int j = i; j < pred->n; ++j) {
+            pred->matrix[pred_rls_matrix_index(pred->n, i, j)] = row[j];
+        }
+    }
+    free(row);
+    pred_rls_matrix_mirror(pred->n, pred->matrix);
     return s;
 }
 
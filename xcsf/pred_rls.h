@@ -17,7 +17,7 @@
  * @file pred_rls.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2022.
+ * @date 2015--2026.
  * @brief Recursive least mean squares prediction functions.
  */
 
@@ -28,18 +28,22 @@
 
 /**
  * @brief Recursive least mean squares prediction data structure.
+ * @details The gain matrix is symmetric. With RLS_PACKED defined only its
+ * upper triangle is stored, row by row; otherwise it is stored in full.
  */
 struct PredRLS {
     int n; //!< Number of weights for each predicted variable
     int n_weights; //!< Total number of weights
     double *weights; //!< Weights used to compute prediction
     double *matrix; //!< Gain matrix used to update weights
-    double *tmp_input; //!< Temporary storage for updating weights
-    double *tmp_vec; //!< Temporary storage for updating weights
-    double *tmp_matrix1; //!< Temporary storage for updating gain matrix
-    double *tmp_matrix2; //!< Temporary storage for updating gain matrix
 };
 
+int
+pred_rls_matrix_size(const int n);
+
+int
+pred_rls_matrix_index(const int n, const int i, const int j);
+
 char *
 pred_rls_param_json_export(const struct XCSF *xcsf);
 
@@ -91,9 +95,9 @@ pred_rls_json_import(const struct XCSF *xcsf, struct Cl *c, const cJSON *json);
  * @brief Recursive least mean squares prediction implemented functions.
  */
 static struct PredVtbl const pred_rls_vtbl = {
-    &pred_rls_crossover,  &pred_rls_mutate, &pred_rls_compute,
-    &pred_rls_copy,       &pred_rls_free,   &pred_rls_init,
-    &pred_rls_print,      &pred_rls_update, &pred_rls_size,
-    &pred_rls_save,       &pred_rls_load,   &pred_rls_json_export,
-    &pred_rls_json_import
+    &pred_rls_crossover,    &pred_rls_mutate,     &pred_rls_compute,
+    &pred_ls_compute_batch, &pred_rls_copy,       &pred_rls_free,
+    &pred_rls_init,         &pred_rls_print,      &pred_rls_update,
+    &pred_rls_size,         &pred_rls_save,       &pred_rls_load,
+    &pred_rls_json_export,  &pred_rls_json_import
 };
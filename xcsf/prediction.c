@@ -17,16 +17,27 @@
  * @file prediction.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2022.
+ * @date 2015--2026.
  * @brief Interface for classifier predictions.
  */
 
+#include "blas.h"
 #include "pred_constant.h"
 #include "pred_neural.h"
 #include "pred_nlms.h"
 #include "pred_rls.h"
 #include "utils.h"
 
+/**
+ * @brief Shape of the least squares basis of the inputs last seen by a thread.
+ */
+struct PredBasis {
+    int n_rows; //!< Number of input rows transformed, or 0 if none
+    int x_dim; //!< Number of input variables
+    int type; //!< Prediction type used to transform the inputs
+    double x0; //!< Bias term used to transform the inputs
+};
+
 /**
  * @brief Sets a classifier's prediction functions to the implementations.
  * @param [in] xcsf The XCSF data structure.
@@ -254,6 +265,152 @@ pred_param_free(struct XCSF *xcsf)
     layer_args_free(&xcsf->pred->largs);
 }
 
+/**
+ * @brief Returns the scratch pool of the calling thread.
+ * @details Predictions borrow the pool for buffers that are only live during
+ * one call to pred_compute() or pred_update(), so that classifiers hold only
+ * their weights and gain matrices. The pool only grows and its contents are
+ * undefined. See thread_pool().
+ * @param [in] n The number of elements required.
+ * @return The scratch pool.
+ */
+double *
+pred_scratch(const size_t n)
+{
+    return thread_pool(THREAD_POOL_PRED, sizeof(double) * n);
+}
+
+/**
+ * @brief Returns the length of the least squares basis of an input.
+ * @param [in] xcsf The XCSF data structure.
+ * @return The number of basis terms.
+ */
+int
+pred_basis_length(const struct XCSF *xcsf)
+{
+    const int x_dim = xcsf->x_dim;
+    if (xcsf->pred->type == PRED_TYPE_NLMS_QUADRATIC ||
+        xcsf->pred->type == PRED_TYPE_RLS_QUADRATIC) {
+        // offset(1) + n linear + n quadratic + n*(n-1)/2 mixed terms
+        return 1 + 2 * x_dim + x_dim * (x_dim - 1) / 2;
+    }
+    return x_dim + 1;
+}
+
+/**
+ * @brief Returns the least squares basis of one or more inputs.
+ * @details The basis depends only on the inputs, so it is computed once and
+ * shared read-only by every matching classifier. Each thread keeps the basis
+ * of the inputs it last transformed and recomputes it only when called with
+ * different inputs or parameters.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] x The input states (n_rows × x_dim).
+ * @param [in] n_rows The number of input states.
+ * @return The transformed inputs (n_rows × pred_basis_length()).
+ */
+const double *
+pred_basis(const struct XCSF *xcsf, const double *x, const int n_rows)
+{
+    struct PredBasis *b =
+        thread_pool(THREAD_POOL_BASIS_INFO, sizeof(struct PredBasis));
+    const int x_dim = xcsf->x_dim;
+    const int n = pred_basis_length(xcsf);
+    const size_t x_size = sizeof(double) * n_rows * x_dim;
+    double *last_x = thread_pool(THREAD_POOL_BASIS_X, x_size);
+    double *basis = thread_pool(THREAD_POOL_BASIS, sizeof(double) * n_rows * n);
+    if (b->n_rows == n_rows && b->x_dim == x_dim &&
+        b->type == xcsf->pred->type && b->x0 == xcsf->pred->x0 &&
+        memcmp(last_x, x, x_size) == 0) {
+        return basis;
+    }
+    memcpy(last_x, x, x_size);
+    for (int i = 0; i < n_rows; ++i) {
+        pred_transform_input(xcsf, &x[i * x_dim], xcsf->pred->x0,
+                             &basis[i * n]);
+    }
+    b->n_rows = n_rows;
+    b->x_dim = x_dim;
+    b->type = xcsf->pred->type;
+    b->x0 = xcsf->pred->x0;
+    return basis;
+}
+
+/**
+ * @brief Returns whether a prediction made earlier for an input can be reused.
+ * @details Predictions that carry state between inputs or draw random numbers
+ * must be recomputed for every input presented, so that the computation, and
+ * the random numbers drawn, are the same as when no prediction is reused.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] c The classifier whose prediction is to be checked.
+ * @return Whether the prediction can be reused.
+ */
+bool
+pred_reusable(const struct XCSF *xcsf, const struct Cl *c)
+{
+    if (xcsf->pred->type == PRED_TYPE_NEURAL) {
+        const struct PredNeural *pred = c->pred;
+        return neural_reusable(&pred->net);
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the weights of a prediction that is linear in its basis.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] c The classifier whose weights are to be returned.
+ * @return The weights (y_dim × pred_basis_length()), or NULL if the
+ * prediction is not a least squares prediction.
+ */
+const double *
+pred_weights(const struct XCSF *xcsf, const struct Cl *c)
+{
+    switch (xcsf->pred->type) {
+        case PRED_TYPE_NLMS_LINEAR:
+        case PRED_TYPE_NLMS_QUADRATIC:
+            return ((const struct PredNLMS *) c->pred)->weights;
+        case PRED_TYPE_RLS_LINEAR:
+        case PRED_TYPE_RLS_QUADRATIC:
+            return ((const struct PredRLS *) c->pred)->weights;
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * @brief Computes least squares predictions from inputs already transformed.
+ * @details The bases are stacked so that the predictions are calculated with a
+ * single matrix multiplication. The classifier is not modified.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] c The classifier calculating the predictions.
+ * @param [in] basis The transformed inputs (n_rows × pred_basis_length()).
+ * @param [in] n_rows The number of input states.
+ * @param [out] out The predictions (n_rows × y_dim).
+ */
+void
+pred_ls_compute_basis(const struct XCSF *xcsf, const struct Cl *c,
+                      const double *basis, const int n_rows, double *out)
+{
+    const int n = pred_basis_length(xcsf);
+    blas_gemm(0, 1, n_rows, xcsf->y_dim, n, 1, basis, n, pred_weights(xcsf, c),
+              n, 0, out, xcsf->y_dim);
+}
+
+/**
+ * @brief Computes least squares predictions for several inputs at once.
+ * @details The classifier is not modified.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] c The classifier calculating the predictions.
+ * @param [in] x The input states (n_rows × x_dim).
+ * @param [in] n_rows The number of input states.
+ * @param [out] out The predictions (n_rows × y_dim).
+ */
+void
+pred_ls_compute_batch(const struct XCSF *xcsf, const struct Cl *c,
+                      const double *x, const int n_rows, double *out)
+{
+    pred_ls_compute_basis(xcsf, c, pred_basis(xcsf, x, n_rows), n_rows, out);
+}
+
 /**
  * @brief Prepares the input state for least squares computation.
  * @param [in] xcsf The XCSF data structure.
@@ -17,7 +17,7 @@
  * @file prediction.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2022.
+ * @date 2015--2026.
  * @brief Interface for classifier predictions.
  */
 
@@ -86,6 +86,29 @@ void
 pred_transform_input(const struct XCSF *xcsf, const double *x, const double X0,
                      double *tmp_input);
 
+double *
+pred_scratch(const size_t n);
+
+int
+pred_basis_length(const struct XCSF *xcsf);
+
+const double *
+pred_basis(const struct XCSF *xcsf, const double *x, const int n_rows);
+
+const double *
+pred_weights(const struct XCSF *xcsf, const struct Cl *c);
+
+void
+pred_ls_compute_basis(const struct XCSF *xcsf, const struct Cl *c,
+                      const double *basis, const int n_rows, double *out);
+
+void
+pred_ls_compute_batch(const struct XCSF *xcsf, const struct Cl *c,
+                      const double *x, const int n_rows, double *out);
+
+bool
+pred_reusable(const struct XCSF *xcsf, const struct Cl *c);
+
 void
 prediction_set(const struct XCSF *xcsf, struct Cl *c);
 
@@ -99,6 +122,9 @@ struct PredVtbl {
     bool (*pred_impl_mutate)(const struct XCSF *xcsf, const struct Cl *c);
     void (*pred_impl_compute)(const struct XCSF *xcsf, const struct Cl *c,
                               const double *x);
+    void (*pred_impl_compute_batch)(const struct XCSF *xcsf,
+                                    const struct Cl *c, const double *x,
+                                    const int n_rows, double *out);
     void (*pred_impl_copy)(const struct XCSF *xcsf, struct Cl *dest,
                            const struct Cl *src);
     void (*pred_impl_free)(const struct XCSF *xcsf, const struct Cl *c);
@@ -191,6 +217,23 @@ pred_compute(const struct XCSF *xcsf, const struct Cl *c, const double *x)
     (*c->pred_vptr->pred_impl_compute)(xcsf, c, x);
 }
 
+/**
+ * @brief Computes the classifier prediction for several inputs at once.
+ * @details Constant and least squares predictions do not modify the
+ * classifier, so may be computed concurrently for different inputs.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] c The classifier calculating the predictions.
+ * @param [in] x The input states (n_rows × x_dim).
+ * @param [in] n_rows The number of input states.
+ * @param [out] out The predictions (n_rows × y_dim).
+ */
+static inline void
+pred_compute_batch(const struct XCSF *xcsf, const struct Cl *c,
+                   const double *x, const int n_rows, double *out)
+{
+    (*c->pred_vptr->pred_impl_compute_batch)(xcsf, c, x, n_rows, out);
+}
+
 /**
  * @brief Copies the prediction from one classifier to another.
  * @param [in] xcsf The XCSF data structure.
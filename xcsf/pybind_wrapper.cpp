@@ -820,7 +820,7 @@ class XCS
     const char *
     json_export(const bool condition, const bool action, const bool prediction)
     {
-        if (xcs.pset.list != NULL) {
+        if (xcs.pset.size > 0) {
             return clset_json_export(&xcs, &xcs.pset, condition, action,
                                      prediction);
         }
@@ -90,7 +90,7 @@ rule_neural_cond_match(const struct XCSF *xcsf, const struct Cl *c,
                        const double *x)
 {
     struct RuleNeural *cond = c->cond;
-    neural_propagate(&cond->net, x, xcsf->explore);
+    neural_propagate(&cond->net, x, xcsf->explore, xcsf->FAST_ACTIVATIONS);
     if (neural_output(&cond->net, 0) > 0.5) {
         return true;
     }
@@ -101,7 +101,7 @@ bool
 rule_neural_cond_mutate(const struct XCSF *xcsf, const struct Cl *c)
 {
     (void) xcsf;
-    const struct RuleNeural *cond = c->cond;
+    struct RuleNeural *cond = c->cond;
     return neural_mutate(&cond->net);
 }
 
@@ -18,7 +18,7 @@
  * @author Richard Preen <rpreen@gmail.com>
  * @author David Pätzel
  * @copyright The Authors.
- * @date 2015--2021.
+ * @date 2015--2026.
  * @brief Utility functions for random number handling, etc.
  */
 
@@ -27,6 +27,160 @@
 #include <stdbool.h>
 #include <time.h>
 
+#ifdef PARALLEL
+    #include <omp.h>
+#endif
+
+/**
+ * @brief Per-thread pools of a thread.
+ */
+struct ThreadPools {
+    void *data[THREAD_POOL_NUM]; //!< Storage of each pool
+    size_t size[THREAD_POOL_NUM]; //!< Number of bytes allocated to each pool
+    struct ThreadPools *next; //!< Pools of the next thread registered
+};
+
+static struct ThreadPools *pools_all = NULL; //!< Pools of every thread
+static unsigned pools_epoch = 0; //!< Incremented whenever pools are freed
+static bool pools_registered = false; //!< Whether freed at exit
+
+static struct ThreadPools *pools_local = NULL; //!< Pools of this thread
+static unsigned pools_local_epoch = 0; //!< Epoch of the pools of this thread
+#ifdef PARALLEL
+    #pragma omp threadprivate(pools_local, pools_local_epoch)
+#endif
+
+/**
+ * @brief Random number stream.
+ */
+struct RandStream {
+    dsfmt_t *dsfmt; //!< Generator state
+    dsfmt_t state; //!< Storage for the state of a per-thread stream
+    double z1; //!< Spare Gaussian from the last Box-Muller transform
+    bool generate; //!< Whether the next Gaussian requires a new transform
+    unsigned epoch; //!< Seeding from which a per-thread stream derives
+};
+
+/**
+ * @brief Stream used outside of parallel regions.
+ */
+static struct RandStream rand_main = { .dsfmt = &dsfmt_global_data };
+
+#ifdef PARALLEL
+static struct RandStream rand_local; //!< Stream of this thread
+    #pragma omp threadprivate(rand_local)
+#endif
+
+static uint32_t rand_seed; //!< Seed from which the thread streams derive
+static unsigned rand_epoch = 0; //!< Incremented whenever the seed is set
+
+/**
+ * @brief Returns a pool of storage private to the calling thread.
+ * @details Pools are kept per operating system thread rather than per OpenMP
+ * thread number, so threads of nested teams never share a pool. A pool only
+ * grows; newly allocated storage is zeroed and is otherwise kept between calls
+ * on the same thread. Following OpenMP threadprivate rules, a thread keeps its
+ * pools across parallel regions run with the same number of threads while
+ * dynamic adjustment of threads is disabled.
+ * @param [in] pool The pool to return, [0, THREAD_POOL_NUM).
+ * @param [in] size The number of bytes required.
+ * @return The storage of the pool.
+ */
+void *
+thread_pool(const int pool, const size_t size)
+{
+    if (pools_local == NULL || pools_local_epoch != pools_epoch) {
+        pools_local = calloc(1, sizeof(struct ThreadPools));
+        pools_local_epoch = pools_epoch;
+#ifdef PARALLEL
+    #pragma omp critical(thread_pools)
+#endif
+        {
+            pools_local->next = pools_all;
+            pools_all = pools_local;
+            if (!pools_registered) {
+                atexit(thread_pool_free);
+                pools_registered = true;
+            }
+        }
+    }
+    if (pools_local->size[pool] < size) {
+        free(pools_local->data[pool]);
+        pools_local->data[pool] = calloc(size, 1);
+        pools_local->size[pool] = size;
+    }
+    return pools_local->data[pool];
+}
+
+/**
+ * @brief Frees the pools of every thread.
+ * @details Called at exit. Pools only hold storage borrowed within a call, so
+ * they may also be freed between calls, outside of parallel regions, to
+ * release memory; threads allocate new pools the next time they request one.
+ */
+void
+thread_pool_free(void)
+{
+    while (pools_all != NULL) {
+        struct ThreadPools *next = pools_all->next;
+        for (int i = 0; i < THREAD_POOL_NUM; ++i) {
+            free(pools_all->data[i]);
+        }
+        free(pools_all);
+        pools_all = next;
+    }
+    pools_local = NULL;
+    ++pools_epoch;
+}
+
+/**
+ * @brief Returns the seed of a per-thread stream.
+ * @details Splits the seed with a SplitMix64 step so that streams of nearby
+ * threads and seeds are uncorrelated.
+ * @param [in] thread The thread number.
+ * @return The seed of the stream.
+ */
+static uint32_t
+rand_stream_seed(const int thread)
+{
+    uint64_t z = ((uint64_t) rand_seed << 32) + (uint64_t) thread + 1;
+    z += UINT64_C(0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return (uint32_t) (z ^ (z >> 31));
+}
+
+/**
+ * @brief Returns the random number stream of the calling thread.
+ * @details Outside of parallel regions the global dSFMT state is used, so
+ * serial runs draw the same numbers whatever the number of threads. Within a
+ * parallel region each thread draws from its own thread private stream,
+ * derived from the seed and thread number and continued across parallel
+ * regions. Runs are therefore reproducible for a given number of threads only
+ * if each thread draws for the same work in every run, as in statically
+ * scheduled loops; dynamically scheduled loops must not draw random numbers.
+ * Streams restart only when the seed is set.
+ * @return The random number stream.
+ */
+static struct RandStream *
+rand_stream(void)
+{
+#ifdef PARALLEL
+    if (omp_in_parallel()) {
+        struct RandStream *stream = &rand_local;
+        if (stream->dsfmt == NULL || stream->epoch != rand_epoch) {
+            stream->dsfmt = &stream->state;
+            stream->generate = false;
+            stream->epoch = rand_epoch;
+            dsfmt_init_gen_rand(stream->dsfmt,
+                                rand_stream_seed(omp_get_thread_num()));
+        }
+        return stream;
+    }
+#endif
+    return &rand_main;
+}
+
 /**
  * @brief Initialises the pseudo-random number generator.
  */
@@ -39,7 +193,7 @@ rand_init(void)
     for (size_t i = 0; i < sizeof(now); ++i) {
         seed = (seed * (UCHAR_MAX + 2U)) + p[i];
     }
-    dsfmt_gv_init_gen_rand(seed);
+    rand_init_seed(seed);
 }
 
 /**
@@ -50,6 +204,8 @@ void
 rand_init_seed(const uint32_t seed)
 {
     dsfmt_gv_init_gen_rand(seed);
+    rand_seed = seed;
+    ++rand_epoch;
 }
 
 /**
@@ -61,7 +217,7 @@ rand_init_seed(const uint32_t seed)
 double
 rand_uniform(const double min, const double max)
 {
-    return min + (dsfmt_gv_genrand_open_open() * (max - min));
+    return min + (dsfmt_genrand_open_open(rand_stream()->dsfmt) * (max - min));
 }
 
 /**
@@ -87,16 +243,15 @@ double
 rand_normal(const double mu, const double sigma)
 {
     static const double two_pi = 2 * M_PI;
-    static double z1;
-    static bool generate;
-    generate = !generate;
-    if (!generate) {
-        return z1 * sigma + mu;
+    struct RandStream *stream = rand_stream();
+    stream->generate = !stream->generate;
+    if (!stream->generate) {
+        return stream->z1 * sigma + mu;
     }
-    const double u1 = dsfmt_gv_genrand_open_open();
-    const double u2 = dsfmt_gv_genrand_open_open();
+    const double u1 = dsfmt_genrand_open_open(stream->dsfmt);
+    const double u2 = dsfmt_genrand_open_open(stream->dsfmt);
     const double z0 = sqrt(-2 * log(u1)) * cos(two_pi * u2);
-    z1 = sqrt(-2 * log(u1)) * sin(two_pi * u2);
+    stream->z1 = sqrt(-2 * log(u1)) * sin(two_pi * u2);
     return z0 * sigma + mu;
 }
 
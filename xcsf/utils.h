@@ -18,7 +18,7 @@
  * @author Richard Preen <rpreen@gmail.com>
  * @author David Pätzel
  * @copyright The Authors.
- * @date 2015--2023.
+ * @date 2015--2026.
  * @brief Utility functions for random number handling, etc.
  */
 
@@ -31,6 +31,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#define THREAD_POOL_LAYER (0) //!< Scratch of neural layers
+#define THREAD_POOL_PRED (1) //!< Scratch of predictions
+#define THREAD_POOL_BASIS (2) //!< Least squares basis of the last inputs
+#define THREAD_POOL_BASIS_X (3) //!< Last inputs transformed to a basis
+#define THREAD_POOL_BASIS_INFO (4) //!< Shape of the last basis
+#define THREAD_POOL_NUM (5) //!< Number of per-thread pools
+
 double
 rand_normal(const double mu, const double sigma);
 
@@ -49,6 +56,12 @@ rand_init_seed(const uint32_t seed);
 void
 utils_json_parse_check(const cJSON *json);
 
+void *
+thread_pool(const int pool, const size_t size);
+
+void
+thread_pool_free(void);
+
 /**
  * @brief Returns a float clamped within the specified range.
  * @param [in] a The value to be clamped.
@@ -17,7 +17,7 @@
  * @file xcs_rl.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2023.
+ * @date 2015--2026.
  * @brief Reinforcement learning functions.
  * @details A trial consists of one or more steps.
  */
@@ -127,13 +127,14 @@ xcs_rl_init_trial(struct XCSF *xcsf)
 {
     xcsf->prev_reward = 0;
     xcsf->prev_pred = 0;
+    xcsf->prev_stamp = 0;
     if (xcsf->x_dim < 1) { // memory allocation guard
         printf("xcs_rl_init_trial(): error x_dim less than 1\n");
         xcsf->x_dim = 1;
         exit(EXIT_FAILURE);
     }
     xcsf->prev_state = malloc(sizeof(double) * xcsf->x_dim);
-    clset_init(&xcsf->prev_aset);
+    clset_clear(&xcsf->prev_aset);
     clset_init(&xcsf->kset);
 }
 
@@ -144,7 +145,7 @@ xcs_rl_init_trial(struct XCSF *xcsf)
 void
 xcs_rl_end_trial(struct XCSF *xcsf)
 {
-    clset_free(&xcsf->prev_aset);
+    clset_clear(&xcsf->prev_aset);
     clset_kill(xcsf, &xcsf->kset);
     free(xcsf->prev_state);
 }
@@ -156,8 +157,8 @@ xcs_rl_end_trial(struct XCSF *xcsf)
 void
 xcs_rl_init_step(struct XCSF *xcsf)
 {
-    clset_init(&xcsf->mset);
-    clset_init(&xcsf->aset);
+    clset_clear(&xcsf->mset);
+    clset_clear(&xcsf->aset);
 }
 
 /**
@@ -171,12 +172,16 @@ void
 xcs_rl_end_step(struct XCSF *xcsf, const double *state, const int action,
                 const double reward)
 {
-    clset_free(&xcsf->mset);
-    clset_free(&xcsf->prev_aset);
+    clset_clear(&xcsf->mset);
+    // the current action set becomes the previous; storage is recycled
+    const struct Set prev_aset = xcsf->prev_aset;
     xcsf->prev_aset = xcsf->aset;
+    xcsf->aset = prev_aset;
+    clset_clear(&xcsf->aset);
     xcsf->prev_reward = reward;
     xcsf->prev_pred = pa_val(xcsf, action);
     memcpy(xcsf->prev_state, state, sizeof(double) * xcsf->x_dim);
+    xcsf->prev_stamp = xcsf->input_stamp;
 }
 
 /**
@@ -193,7 +198,7 @@ xcs_rl_update(struct XCSF *xcsf, const double *state, const int action,
               const double reward, const bool done)
 {
     clset_action(xcsf, action); // create action set
-    if (xcsf->prev_aset.list != NULL) { // update previous action set and run EA
+    if (xcsf->prev_aset.size > 0) { // update previous action set and run EA
         const double p = xcsf->prev_reward + (xcsf->GAMMA * pa_best_val(xcsf));
         clset_validate(&xcsf->prev_aset);
         clset_update(xcsf, &xcsf->prev_aset, xcsf->prev_state, &p, false);
@@ -225,7 +230,7 @@ xcs_rl_error(struct XCSF *xcsf, const int action, const double reward,
 {
     double error = 0;
     const double prediction = pa_val(xcsf, action);
-    if (xcsf->prev_aset.list != NULL) {
+    if (xcsf->prev_aset.size > 0) {
         const double p = xcsf->prev_reward + (xcsf->GAMMA * prediction);
         error += (xcsf->loss_ptr)(xcsf, &xcsf->prev_pred, &p) / max_p;
     }
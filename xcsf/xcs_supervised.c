@@ -17,19 +17,25 @@
  * @file xcs_supervised.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2024.
+ * @date 2015--2026.
  * @brief Supervised regression learning functions.
  */
 
 #include "xcs_supervised.h"
+#include "action.h"
+#include "cl.h"
 #include "clset.h"
+#include "cond_index.h"
 #include "ea.h"
 #include "loss.h"
 #include "pa.h"
 #include "param.h"
 #include "perf.h"
+#include "prediction.h"
 #include "utils.h"
 
+#define PREDICT_BLOCK (64) //!< Number of rows predicted together
+
 /**
  * @brief Selects a data sample for training or testing.
  * @param [in] data The input data.
@@ -59,7 +65,7 @@ static void
 xcs_supervised_trial(struct XCSF *xcsf, const double *x, const double *y,
                      const double *cover)
 {
-    clset_init(&xcsf->mset);
+    clset_clear(&xcsf->mset);
     clset_init(&xcsf->kset);
     if (cover != NULL) {
         // no coverage is to be performed
@@ -81,7 +87,7 @@ xcs_supervised_trial(struct XCSF *xcsf, const double *x, const double *y,
         ea(xcsf, &xcsf->mset);
     }
     clset_kill(xcsf, &xcsf->kset);
-    clset_free(&xcsf->mset);
+    clset_clear(&xcsf->mset);
 }
 
 /**
@@ -128,8 +134,364 @@ xcs_supervised_fit(struct XCSF *xcsf, const struct Input *train_data,
     return err / trials;
 }
 
+/**
+ * @brief Temporary storage for predicting a block of rows.
+ */
+struct PredictBlock {
+    uint64_t *rows; //!< Rows of the block matched by each classifier
+    uint64_t *bitmap; //!< Classifiers matching one row
+    int *matches; //!< Number of rows matched by each classifier
+    double *nr; //!< Sum of fitnesses for each row of the block
+    double *x; //!< Inputs matched by one classifier
+    double *basis; //!< Least squares basis of the inputs of one classifier
+    double *pred; //!< Predictions of one classifier
+};
+
+/**
+ * @brief Allocates temporary storage for predicting blocks of rows.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [out] block The temporary storage to allocate.
+ */
+static void
+xcs_supervised_block_init(const struct XCSF *xcsf, struct PredictBlock *block)
+{
+    const int psize = xcsf->pset.size;
+    block->rows = malloc(sizeof(uint64_t) * (psize + 1));
+    block->bitmap = malloc(sizeof(uint64_t) * (psize / 64 + 1));
+    block->matches = calloc(psize + 1, sizeof(int));
+    block->nr = malloc(sizeof(double) * PREDICT_BLOCK * xcsf->pa_size);
+    block->x = malloc(sizeof(double) * PREDICT_BLOCK * xcsf->x_dim);
+    block->basis =
+        malloc(sizeof(double) * PREDICT_BLOCK * pred_basis_length(xcsf));
+    block->pred = malloc(sizeof(double) * PREDICT_BLOCK * xcsf->y_dim);
+}
+
+/**
+ * @brief Frees temporary storage for predicting blocks of rows.
+ * @param [in] block The temporary storage to free.
+ */
+static void
+xcs_supervised_block_free(struct PredictBlock *block)
+{
+    free(block->rows);
+    free(block->bitmap);
+    free(block->matches);
+    free(block->nr);
+    free(block->x);
+    free(block->basis);
+    free(block->pred);
+}
+
+/**
+ * @brief Matches a block of rows by building a match set for each row.
+ * @details Classifier match counts and match set statistics are updated as
+ * for a trial.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] block Temporary storage.
+ * @param [in] x The input feature variables.
+ * @param [in] n_rows The number of rows in the block.
+ * @return Bitmask of the rows matched by at least one classifier.
+ */
+static uint64_t
+xcs_supervised_block_match(struct XCSF *xcsf, struct PredictBlock *block,
+                           const double *x, const int n_rows)
+{
+    struct Cl **pset = xcsf->pset.cl;
+    const int psize = xcsf->pset.size;
+    uint64_t matched = 0;
+    memset(block->rows, 0, sizeof(uint64_t) * psize);
+    for (int r = 0; r < n_rows; ++r) {
+        const uint64_t bit = UINT64_C(1) << r;
+        clset_clear(&xcsf->mset);
+        clset_match(xcsf, &x[r * xcsf->x_dim], false);
+        if (xcsf->mset.size > 0) {
+            matched |= bit;
+        }
+        for (int i = 0; i < psize; ++i) {
+            if (cl_m(xcsf, pset[i])) {
+                block->rows[i] |= bit;
+            }
+        }
+    }
+    clset_clear(&xcsf->mset);
+    return matched;
+}
+
+/**
+ * @brief Matches a block of rows without modifying the population.
+ * @details Match counts are accumulated in the temporary storage and the
+ * match set size of each row is recorded, so that statistics can be updated
+ * afterwards.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] block Temporary storage.
+ * @param [in] x The input feature variables.
+ * @param [in] n_rows The number of rows in the block.
+ * @param [out] mset_size The match set size of each row.
+ * @return Bitmask of the rows matched by at least one classifier.
+ */
+static uint64_t
+xcs_supervised_block_match_concurrent(const struct XCSF *xcsf,
+                                      struct PredictBlock *block,
+                                      const double *x, const int n_rows,
+                                      int *mset_size)
+{
+    const int psize = xcsf->pset.size;
+    const int n_words = (psize + 63) / 64;
+    uint64_t matched = 0;
+    memset(block->rows, 0, sizeof(uint64_t) * psize);
+    for (int r = 0; r < n_rows; ++r) {
+        const uint64_t bit = UINT64_C(1) << r;
+        clset_match_bitmap(xcsf, &x[r * xcsf->x_dim], block->bitmap);
+        int size = 0;
+        for (int w = 0; w < n_words; ++w) {
+            uint64_t bits = block->bitmap[w];
+            size += __builtin_popcountll(bits);
+            for (; bits != 0; bits &= bits - 1) {
+                block->rows[w * 64 + __builtin_ctzll(bits)] |= bit;
+            }
+        }
+        if (size > 0) {
+            matched |= bit;
+        }
+        mset_size[r] = size;
+    }
+    for (int i = 0; i < psize; ++i) {
+        block->matches[i] += __builtin_popcountll(block->rows[i]);
+    }
+    return matched;
+}
+
+/**
+ * @brief Calculates the XCSF predictions for a matched block of rows.
+ * @details Each matching classifier computes its predictions for all of the
+ * rows it matched at once. Least squares predictions transform the block once
+ * and each classifier gathers the rows of the basis it matched, rather than
+ * transforming its own rows. Predictions are accumulated in population order,
+ * which is the order of the match set, so the result is the same as building
+ * the prediction array for each row.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] block Temporary storage holding the rows of each classifier.
+ * @param [in] x The input feature variables.
+ * @param [out] pred The calculated XCSF predictions.
+ * @param [in] n_rows The number of rows in the block.
+ * @param [in] cover The prediction array to use when the match set is empty.
+ * @param [in] matched Bitmask of the rows with a non-empty match set.
+ */
+static void
+xcs_supervised_block_predict(const struct XCSF *xcsf,
+                             struct PredictBlock *block, const double *x,
+                             double *pred, const int n_rows,
+                             const double *cover, const uint64_t matched)
+{
+    struct Cl **pset = xcsf->pset.cl;
+    const int psize = xcsf->pset.size;
+    const int pa_size = xcsf->pa_size;
+    const int x_dim = xcsf->x_dim;
+    const int y_dim = xcsf->y_dim;
+    memset(pred, 0, sizeof(double) * n_rows * pa_size);
+    memset(block->nr, 0, sizeof(double) * n_rows * pa_size);
+    const double *basis = NULL;
+    const int n = pred_basis_length(xcsf);
+    if (psize > 0 && pred_weights(xcsf, pset[0]) != NULL) {
+        basis = pred_basis(xcsf, x, n_rows);
+    }
+    for (int i = 0; i < psize; ++i) {
+        if (block->rows[i] == 0) {
+            continue;
+        }
+        const struct Cl *c = pset[i];
+        int k = 0;
+        if (basis != NULL) {
+            for (uint64_t bits = block->rows[i]; bits != 0; bits &= bits - 1) {
+                const int r = __builtin_ctzll(bits);
+                memcpy(&block->basis[k * n], &basis[r * n], sizeof(double) * n);
+                ++k;
+            }
+            pred_ls_compute_basis(xcsf, c, block->basis, k, block->pred);
+        } else {
+            for (uint64_t bits = block->rows[i]; bits != 0; bits &= bits - 1) {
+                const int r = __builtin_ctzll(bits);
+                memcpy(&block->x[k * x_dim], &x[r * x_dim],
+                       sizeof(double) * x_dim);
+                ++k;
+            }
+            pred_compute_batch(xcsf, c, block->x, k, block->pred);
+        }
+        k = 0;
+        for (uint64_t bits = block->rows[i]; bits != 0; bits &= bits - 1) {
+            const int r = __builtin_ctzll(bits);
+            const int offset = r * pa_size + c->action * y_dim;
+            for (int j = 0; j < y_dim; ++j) {
+                pred[offset + j] += block->pred[k * y_dim + j] * c->fit;
+                block->nr[offset + j] += c->fit;
+            }
+            ++k;
+        }
+    }
+    for (int r = 0; r < n_rows; ++r) {
+        double *pa = &pred[r * pa_size];
+        const double *nr = &block->nr[r * pa_size];
+        if (((matched >> r) & 1) == 0) {
+            memcpy(pa, cover, sizeof(double) * pa_size);
+            continue;
+        }
+        for (int k = 0; k < pa_size; ++k) {
+            if (nr[k] != 0) {
+                pa[k] /= nr[k];
+            } else {
+                pa[k] = 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Returns whether rows can be predicted concurrently.
+ * @details Requires that conditions, actions and predictions can be computed
+ * without modifying the classifiers; networks and trees cannot.
+ * @param [in] xcsf The XCSF data structure.
+ * @return Whether rows can be predicted concurrently.
+ */
+static bool
+xcs_supervised_concurrent(const struct XCSF *xcsf)
+{
+    return clset_match_concurrent(xcsf) &&
+        xcsf->act->type == ACT_TYPE_INTEGER &&
+        xcsf->pred->type != PRED_TYPE_NEURAL;
+}
+
+/**
+ * @brief Updates the statistics after rows were predicted concurrently.
+ * @details Experience counters and the mean match set size are the same as if
+ * the rows had been matched one at a time. The matching fraction of the best
+ * rule is moved towards its final value as it would be over that many trials.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] matches The number of rows matched by each classifier.
+ * @param [in] mset_size The match set size of each row.
+ * @param [in] n_samples The number of rows.
+ */
+static void
+xcs_supervised_concurrent_stats(struct XCSF *xcsf, const int *matches,
+                                const int *mset_size, const int n_samples)
+{
+    for (int i = 0; i < xcsf->pset.size; ++i) {
+        xcsf->pset.cl[i]->mtotal += matches[i];
+        xcsf->pset.cl[i]->age += n_samples;
+    }
+    for (int row = 0; row < n_samples; ++row) {
+        xcsf->mset_size += (mset_size[row] - xcsf->mset_size) * xcsf->BETA;
+    }
+    const double rate = 1 - pow(1 - xcsf->BETA, n_samples);
+    xcsf->mfrac += (clset_mfrac(xcsf) - xcsf->mfrac) * rate;
+}
+
+/**
+ * @brief Predicts rows in blocks from a population that is not changed.
+ * @details When classifiers can be computed without being modified, blocks are
+ * spread across threads, each with its own temporary storage, and statistics
+ * are updated once all rows have been predicted.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] x The input feature variables.
+ * @param [out] pred The calculated XCSF predictions.
+ * @param [in] n_samples The number of instances.
+ * @param [in] cover The prediction array to use when the match set is empty.
+ */
+static void
+xcs_supervised_infer(struct XCSF *xcsf, const double *x, double *pred,
+                     const int n_samples, const double *cover)
+{
+    const int n_blocks = (n_samples + PREDICT_BLOCK - 1) / PREDICT_BLOCK;
+    // batched predictions are not stamped, so forget the previous step's
+    xcsf->prev_stamp = 0;
+    if (!xcs_supervised_concurrent(xcsf)) {
+        struct PredictBlock block;
+        xcs_supervised_block_init(xcsf, &block);
+        for (int b = 0; b < n_blocks; ++b) {
+            const int row = b * PREDICT_BLOCK;
+            const int n_rows = clamp_int(n_samples - row, 0, PREDICT_BLOCK);
+            const double *xb = &x[row * xcsf->x_dim];
+            const uint64_t matched =
+                xcs_supervised_block_match(xcsf, &block, xb, n_rows);
+            xcs_supervised_block_predict(xcsf, &block, xb,
+                                         &pred[row * xcsf->pa_size], n_rows,
+                                         cover, matched);
+        }
+        xcs_supervised_block_free(&block);
+    } else {
+        if (cond_index_supported(xcsf)) {
+            cond_index_update(xcsf, &xcsf->pset);
+        }
+        int *matches = calloc(xcsf->pset.size + 1, sizeof(int));
+        int *mset_size = malloc(sizeof(int) * (n_samples + 1));
+#ifdef PARALLEL_PRED
+    #pragma omp parallel
+#endif
+        {
+            struct PredictBlock block;
+            xcs_supervised_block_init(xcsf, &block);
+            // no random numbers are drawn, so blocks can be handed out
+            // dynamically without affecting reproducibility
+#ifdef PARALLEL_PRED
+    #pragma omp for schedule(dynamic)
+#endif
+            for (int b = 0; b < n_blocks; ++b) {
+                const int row = b * PREDICT_BLOCK;
+                const int n_rows =
+                    clamp_int(n_samples - row, 0, PREDICT_BLOCK);
+                const double *xb = &x[row * xcsf->x_dim];
+                const uint64_t matched = xcs_supervised_block_match_concurrent(
+                    xcsf, &block, xb, n_rows, &mset_size[row]);
+                xcs_supervised_block_predict(xcsf, &block, xb,
+                                             &pred[row * xcsf->pa_size],
+                                             n_rows, cover, matched);
+            }
+#ifdef PARALLEL_PRED
+    #pragma omp critical
+#endif
+            for (int i = 0; i < xcsf->pset.size; ++i) {
+                matches[i] += block.matches[i];
+            }
+            xcs_supervised_block_free(&block);
+        }
+        xcs_supervised_concurrent_stats(xcsf, matches, mset_size, n_samples);
+        free(matches);
+        free(mset_size);
+    }
+    if (n_samples > 0) {
+        // leave the prediction array as that of the last row
+        memcpy(xcsf->pa, &pred[(n_samples - 1) * xcsf->pa_size],
+               sizeof(double) * xcsf->pa_size);
+    }
+}
+
+/**
+ * @brief Returns the total XCSF error for rows predicted without covering.
+ * @param [in] xcsf The XCSF data structure.
+ * @param [in] x The input feature variables.
+ * @param [in] y The labelled variables.
+ * @param [in] n_samples The number of instances.
+ * @param [in] cover The prediction array to use when the match set is empty.
+ * @return The total XCSF error using the loss function.
+ */
+static double
+xcs_supervised_infer_error(struct XCSF *xcsf, const double *x, const double *y,
+                           const int n_samples, const double *cover)
+{
+    double *pred = malloc(sizeof(double) * (n_samples + 1) * xcsf->pa_size);
+    xcs_supervised_infer(xcsf, x, pred, n_samples, cover);
+    double err = 0;
+    for (int row = 0; row < n_samples; ++row) {
+        err += (xcsf->loss_ptr)(xcsf, &pred[row * xcsf->pa_size],
+                                &y[row * xcsf->y_dim]);
+    }
+    free(pred);
+    return err;
+}
+
 /**
  * @brief Calculates the XCSF predictions for the provided input.
+ * @details When covering is disabled the population cannot change, so rows
+ * are predicted in blocks without building a prediction array for each row.
  * @param [in] xcsf The XCSF data structure.
  * @param [in] x The input feature variables.
  * @param [out] pred The calculated XCSF predictions.
@@ -142,6 +504,11 @@ xcs_supervised_predict(struct XCSF *xcsf, const double *x, double *pred,
                        const int n_samples, const double *cover)
 {
     param_set_explore(xcsf, false);
+    if (cover != NULL) {
+        xcs_supervised_infer(xcsf, x, pred, n_samples, cover);
+        return;
+    }
+    // covering may change the population between rows
     for (int row = 0; row < n_samples; ++row) {
         xcs_supervised_trial(xcsf, &x[row * xcsf->x_dim], NULL, cover);
         memcpy(&pred[row * xcsf->pa_size], xcsf->pa,
@@ -162,6 +529,11 @@ xcs_supervised_score(struct XCSF *xcsf, const struct Input *data,
                      const double *cover)
 {
     param_set_explore(xcsf, false);
+    if (cover != NULL) {
+        return xcs_supervised_infer_error(xcsf, data->x, data->y,
+                                          data->n_samples, cover) /
+            data->n_samples;
+    }
     double err = 0;
     for (int row = 0; row < data->n_samples; ++row) {
         const double *x = &data->x[row * data->x_dim];
@@ -190,6 +562,22 @@ xcs_supervised_score_n(struct XCSF *xcsf, const struct Input *data, const int N,
     }
     param_set_explore(xcsf, false);
     double err = 0;
+    if (cover != NULL) {
+        // gather the sampled rows to predict them together
+        double *x = malloc(sizeof(double) * N * data->x_dim);
+        double *y = malloc(sizeof(double) * N * data->y_dim);
+        for (int i = 0; i < N; ++i) {
+            const int row = xcs_supervised_sample(data, i, true);
+            memcpy(&x[i * data->x_dim], &data->x[row * data->x_dim],
+                   sizeof(double) * data->x_dim);
+            memcpy(&y[i * data->y_dim], &data->y[row * data->y_dim],
+                   sizeof(double) * data->y_dim);
+        }
+        err = xcs_supervised_infer_error(xcsf, x, y, N, cover);
+        free(x);
+        free(y);
+        return err / N;
+    }
     for (int i = 0; i < N; ++i) {
         const int row = xcs_supervised_sample(data, i, true);
         const double *x = &data->x[row * data->x_dim];
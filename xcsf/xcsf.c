@@ -17,13 +17,14 @@
  * @file xcsf.c
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2015--2020.
+ * @date 2015--2026.
  * @brief System-level functions for initialising, saving, loading, etc.
  */
 
 #include "cl.h"
 #include "clset.h"
 #include "cond_neural.h"
+#include "del_index.h"
 #include "loss.h"
 #include "pa.h"
 #include "param.h"
@@ -37,13 +38,20 @@ void
 xcsf_init(struct XCSF *xcsf)
 {
     xcsf->time = 0;
+    xcsf->input_stamp = 0;
+    xcsf->prev_stamp = 0;
     xcsf->error = xcsf->E0;
     xcsf->mset_size = 0;
     xcsf->aset_size = 0;
     xcsf->mfrac = 0;
     xcsf->explore = false;
+    xcsf->del_index = NULL;
     clset_init(&xcsf->pset);
     clset_init(&xcsf->prev_pset);
+    clset_init(&xcsf->mset);
+    clset_init(&xcsf->aset);
+    clset_init(&xcsf->kset);
+    clset_init(&xcsf->prev_aset);
     pa_init(xcsf);
     clset_pset_init(xcsf);
 }
@@ -63,6 +71,10 @@ xcsf_free(struct XCSF *xcsf)
     xcsf->explore = false;
     clset_kill(xcsf, &xcsf->pset);
     clset_kill(xcsf, &xcsf->prev_pset);
+    clset_free(&xcsf->mset);
+    clset_free(&xcsf->aset);
+    clset_free(&xcsf->prev_aset);
+    del_index_free(xcsf);
     pa_free(xcsf);
 }
 
@@ -150,15 +162,16 @@ xcsf_load(struct XCSF *xcsf, const char *filename)
 void
 xcsf_pred_expand(const struct XCSF *xcsf)
 {
-    const struct Clist *iter = xcsf->pset.list;
-    while (iter != NULL) {
-        pred_neural_expand(xcsf, iter->cl);
-        iter->cl->fit = xcsf->INIT_FITNESS;
-        iter->cl->err = xcsf->INIT_ERROR;
-        iter->cl->exp = 0;
-        iter->cl->time = xcsf->time;
-        iter = iter->next;
+    for (int i = 0; i < xcsf->pset.size; ++i) {
+        struct Cl *c = xcsf->pset.cl[i];
+        pred_neural_expand(xcsf, c);
+        c->fit = xcsf->INIT_FITNESS;
+        c->err = xcsf->INIT_ERROR;
+        c->exp = 0;
+        c->time = xcsf->time;
+        c->pred_stamp = 0;
     }
+    del_index_clear(xcsf);
 }
 
 /**
@@ -174,17 +187,18 @@ xcsf_ae_to_classifier(struct XCSF *xcsf, const int y_dim, const int n_del)
     param_set_y_dim(xcsf, y_dim);
     param_set_loss_func(xcsf, LOSS_ONEHOT);
     pa_init(xcsf);
-    const struct Clist *iter = xcsf->pset.list;
-    while (iter != NULL) {
-        free(iter->cl->prediction);
-        iter->cl->prediction = calloc(xcsf->y_dim, sizeof(double));
-        pred_neural_ae_to_classifier(xcsf, iter->cl, n_del);
-        iter->cl->fit = xcsf->INIT_FITNESS;
-        iter->cl->err = xcsf->INIT_ERROR;
-        iter->cl->exp = 0;
-        iter->cl->time = xcsf->time;
-        iter = iter->next;
+    for (int i = 0; i < xcsf->pset.size; ++i) {
+        struct Cl *c = xcsf->pset.cl[i];
+        free(c->prediction);
+        c->prediction = calloc(xcsf->y_dim, sizeof(double));
+        pred_neural_ae_to_classifier(xcsf, c, n_del);
+        c->fit = xcsf->INIT_FITNESS;
+        c->err = xcsf->INIT_ERROR;
+        c->exp = 0;
+        c->time = xcsf->time;
+        c->pred_stamp = 0;
     }
+    del_index_clear(xcsf);
 }
 
 /**
@@ -195,13 +209,11 @@ void
 xcsf_store_pset(struct XCSF *xcsf)
 {
     clset_kill(xcsf, &xcsf->prev_pset);
-    const struct Clist *iter = xcsf->pset.list;
-    while (iter != NULL) {
+    for (int i = 0; i < xcsf->pset.size; ++i) {
         struct Cl *new = malloc(sizeof(struct Cl));
-        const struct Cl *src = iter->cl;
+        const struct Cl *src = xcsf->pset.cl[i];
         cl_init_copy(xcsf, new, src);
         clset_add(&xcsf->prev_pset, new);
-        iter = iter->next;
     }
 }
 
@@ -17,7 +17,7 @@
  * @file xcsf.h
  * @author Richard Preen <rpreen@gmail.com>
  * @copyright The Authors.
- * @date 2019--2024.
+ * @date 2019--2026.
  * @brief XCSF data structures.
  */
 
@@ -36,8 +36,8 @@
 #include <string.h>
 
 static const int VERSION_MAJOR = 1; //!< XCSF major version number
-static const int VERSION_MINOR = 4; //!< XCSF minor version number
-static const int VERSION_BUILD = 7; //!< XCSF build version number
+static const int VERSION_MINOR = 5; //!< XCSF minor version number
+static const int VERSION_BUILD = 0; //!< XCSF build version number
 
 /**
  * @brief Classifier data structure.
@@ -60,23 +60,23 @@ struct Cl {
     int action; //!< Current classifier action
     int age; //!< Total number of times match testing been performed
     int mtotal; //!< Total number of times actually matched an input
-};
-
-/**
- * @brief Classifier linked list.
- */
-struct Clist {
-    struct Cl *cl; //!< Pointer to classifier data structure
-    struct Clist *next; //!< Pointer to the next list element
+    int cond_slot; //!< Slot held in the condition index, or -1 if none
+    int batch_slot; //!< Slot held in the neural condition batch, or -1 if none
+    int del_slot; //!< Slot held in the deletion index, or -1 if none
+    uint64_t pred_stamp; //!< Stamp of the input predicted, or 0 if none
 };
 
 /**
  * @brief Classifier set.
+ * @details Classifiers are referenced through a contiguous array of handles.
+ * Classifiers are never moved in memory, so a handle remains valid while the
+ * array is grown, compacted, or reordered.
  */
 struct Set {
-    struct Clist *list; //!< Linked list of classifiers
+    struct Cl **cl; //!< Array of classifier handles
     int size; //!< Number of macro-classifiers
     int num; //!< The total numerosity of classifiers
+    int capacity; //!< Number of handles allocated
 };
 
 /**
@@ -94,6 +94,7 @@ struct XCSF {
     struct ArgsPred *pred; //!< Prediction parameters
     struct ArgsEA *ea; //!< EA parameters
     struct EnvVtbl const *env_vptr; //!< Functions acting on environments
+    struct DelIndex *del_index; //!< Index of population deletion votes
     void *env; //!< Environment structure (for built-in problems)
     double error; //!< Average system error
     double mset_size; //!< Average match set size
@@ -104,6 +105,8 @@ struct XCSF {
     double *pa; //!< Prediction array (stores fitness weighted predictions)
     double *nr; //!< Prediction array (stores total fitness)
     double *prev_state; //!< Environment state on the previous step
+    uint64_t input_stamp; //!< Stamp of the input last matched
+    uint64_t prev_stamp; //!< Stamp of the state on the previous step, or 0
     double *cover; //!< Values to return for a prediction instead of covering
     int time; //!< Current number of EA executions
     int pa_size; //!< Prediction array size
@@ -137,6 +140,7 @@ struct XCSF {
     bool SET_SUBSUMPTION; //!< Whether to perform match set subsumption
     bool STATEFUL; //!< Whether classifiers should retain state across trials
     bool COMPACTION; //!< if sys err < E0: largest of 2 roulette spins deleted
+    bool FAST_ACTIVATIONS; //!< Approximate neural activations
     char *population_file; //!< Name of a JSON file containing an initial pop
 };
 